@@ -5,6 +5,14 @@
  * para un lenguaje muy sencillo que reconoce:
  *
  *   - Declaración de variables:   Entero a = 8, b, c = 5;
+ *                                 Flotante r = 2.5;  Caracter c = 'x';
+ *   - Vectores:                   Entero v[1000];  v[i] = v[i - 1] + 2;
+ *   - Matrices:                   Flotante m[100][200];  m[i][j] = 0.5;
+ *   - Funciones de vectores:      s = Suma(v);  Llenar(v, 0);
+ *                                 Ordenar(v);  i = Buscar(v, x);
+ *   - Funciones de matrices:      Multiplicar(c, a, b);  Trasponer(t, m);
+ *   - Diccionarios:               Diccionario d;  d[k] = d[k] + 1;
+ *                                 Contiene(d, k); Borrar(d, k); Claves(v, d);
  *   - Salida (Imprimir):          Imprimir( a + b );
  *   - Entrada (Leer):             Leer( x );
  *   - Asignación/ariméticas:      x = y * (z + 2) - 5;
@@ -25,34 +33,50 @@
  *                     | <if_stmt>
  *                     | <while_stmt>
  *                     | <block_stmt>
+ *                     | <call_stmt>
  *
  *   <decl_stmt>      ::= <type> <var_list> ';'
+ *                     | 'Diccionario' IDENT ( ',' IDENT )* ';'
  *   <type>           ::= 'Entero' | 'Caracter' | 'Flotante'
  *   <var_list>       ::= <var_decl> ( ',' <var_decl> )*
- *   <var_decl>       ::= IDENT [ '=' <expr> ]
+ *   <var_decl>       ::= IDENT [ '=' <expr> ] | IDENT '[' NUM ']' [ '[' NUM ']' ]
  *
  *   <print_stmt>     ::= 'Imprimir' '(' <expr> ')' ';'
- *   <read_stmt>      ::= 'Leer' '(' IDENT ')' ';'
+ *   <read_stmt>      ::= 'Leer' '(' <lvalue> ')' ';'
  *
- *   <assign_stmt>    ::= IDENT '=' <expr> ';'
+ *   <assign_stmt>    ::= <lvalue> '=' <expr> ';'
+ *   <lvalue>         ::= IDENT [ '[' <expr> ']' [ '[' <expr> ']' ] ]
  *
  *   <if_stmt>        ::= 'Si' '(' <expr> ')' <stmt> [ 'Sino' <stmt> ]
  *   <while_stmt>     ::= 'Mientras' '(' <expr> ')' <stmt>
  *
  *   <block_stmt>     ::= '{' <stmt_list> '}'
+ *   <call_stmt>      ::= 'Llenar' '(' IDENT ',' <expr> ')' ';'
+ *                     | 'Ordenar' '(' IDENT ')' ';'
+ *                     | 'Multiplicar' '(' IDENT ',' IDENT ',' IDENT ')' ';'
+ *                     | 'Trasponer' '(' IDENT ',' IDENT ')' ';'
+ *                     | 'Borrar' '(' IDENT ',' <expr> ')' ';'
+ *                     | 'Claves' '(' IDENT ',' IDENT ')' ';'
  *
  *   <expr>           ::= <rel_expr>
  *   <rel_expr>       ::= <add_expr> ( ( '==' | '!=' | '<' | '>' | '<=' | '>=' ) <add_expr> )*
  *   <add_expr>       ::= <mul_expr> ( ( '+' | '-' ) <mul_expr> )*
  *   <mul_expr>       ::= <unary_expr> ( ( '*' | '/' ) <unary_expr> )*
  *   <unary_expr>     ::= [ '-' ] <primary>
- *   <primary>        ::= '(' <expr> ')' | NUM | IDENT
+ *   <primary>        ::= '(' <expr> ')' | NUM | REAL | CHARLIT | <lvalue> | <vec_call>
+ *   <vec_call>       ::= ( 'Suma' | 'Minimo' | 'Maximo' ) '(' IDENT ')'
+ *                     | 'Producto' '(' IDENT ',' IDENT ')'
+ *                     | 'Buscar' '(' IDENT ',' <expr> ')'
+ *                     | 'Contiene' '(' IDENT ',' <expr> ')' | 'Tamano' '(' IDENT ')'
  *
  * Tokens léxicos:
- *   - IDENT: (Letra) (Letra|Dígito)*
- *   - NUM:   (Dígito)+
- *   - Palabras reservadas: Entero, Caracter, Flotante, Imprimir, Leer, Si, Sino, Mientras
- *   - Símbolos: ',' ';' '(' ')' '{' '}' 
+ *   - IDENT:   (Letra) (Letra|Dígito)*
+ *   - NUM:     (Dígito)+
+ *   - REAL:    (Dígito)+ '.' (Dígito)*
+ *   - CHARLIT: '\'' carácter '\''   (o '\n', '\t', '\\', '\'')
+ *   - Palabras reservadas: Entero, Caracter, Flotante, Diccionario, Imprimir, Leer,
+ *                          Si, Sino, Mientras
+ *   - Símbolos: ',' ';' '(' ')' '{' '}' '[' ']'
  *   - Operadores: '+' '-' '*' '/'
  *   - Relacionales: '==' '!=' '<' '>' '<=' '>='
  *   - Asignación: '='
@@ -78,6 +102,143 @@
  * Si todo es correcto, el intérprete leerá tu input (línea por línea)
  * e imprimirá los resultados correspondientes.  
  *
+ * El programa también puede venir de un archivo; entonces stdin
+ * queda libre para las sentencias Leer:
+ *      analyzer programa.txt
+ *
+ * Backend nativo (Linux x86-64): compila el programa entero a un
+ * ejecutable ELF estático, sin libc, que arranca sin lexer ni parser.
+ * Solo admite Entero y Caracter: sin libc no hay con qué escribir ni
+ * leer un Flotante igual que printf/strtod, así que un programa que
+ * use Flotante (o un vector de Flotante) se rechaza y se ejecuta sin
+ * -o ni -S:
+ *      analyzer -o programa programa.txt     (usa "cc", "as" y "ld")
+ *      analyzer -S programa.s programa.txt   (solo el ensamblador)
+ * Con -o solo, los intermedios van a temporales de $TMPDIR (o /tmp)
+ * que se borran al terminar; "cc", "as" y "ld" se buscan en el PATH.
+ * Ordenar, Buscar, Multiplicar, Trasponer y los diccionarios son las
+ * funciones de runtime.c, las mismas que usa el intérprete: -o lo
+ * compila la primera vez (el objeto se queda en la caché) y lo enlaza
+ * con el programa, y lo que sale de -S hay que enlazarlo con él.
+ * runtime.c se busca en $GAMA_RUNTIME o al lado de analyzer.c (o del
+ * ejecutable).
+ *
+ * Tipos: Entero (64 bits con signo), Caracter (8 bits con signo) y
+ * Flotante (double). El tipo de una variable es el de su primera declaración
+ * y no cambia; una variable que se asigna sin declarar es Entero.
+ * Caracter se opera como Entero; si un operando es Flotante, el otro
+ * se convierte y la operación es en Flotante (las comparaciones dan
+ * siempre Entero). Al asignar se convierte al tipo de la variable:
+ * Flotante → Entero trunca (y satura) y cualquier valor → Caracter se
+ * queda con sus 8 bits bajos. Imprimir muestra un Caracter como
+ * carácter y un Flotante con "%g"; Leer lee el tipo de la variable.
+ * El compilador resuelve los tipos y el IR ya sale con la operación
+ * de cada uno; en el intérprete de tokens cada valor lleva su tipo
+ * en los bits de un NaN (ver Value), así que mirarlo es un test de
+ * bits y no hace falta una estructura con etiqueta.
+ *
+ * Un vector tiene el tamaño fijo de su declaración y los elementos
+ * del tipo declarado, uno detrás de otro en memoria; sus índices van
+ * de 0 a tamaño-1 y salirse es un error de ejecución. Se declara (en
+ * el texto) antes de usarlo, no puede llamarse como una variable y
+ * su declaración, cada vez que se ejecuta, pone los elementos a 0.
+ * Donde el compilador demuestra que el índice está dentro (el típico
+ * Mientras (i < 1000) { v[i] = ...; i = i + 1; }) no se comprueba.
+ *
+ * Una matriz ("Entero m[100][200];") es un vector de filas × columnas
+ * elementos, fila tras fila: m[i][j] es el elemento i * columnas + j.
+ * Se usa siempre con los dos índices y cada uno se comprueba contra
+ * su dimensión: m[0][200] es un error aunque sea el sitio de m[1][0].
+ * En los bucles anidados el optimizador saca i * columnas del bucle
+ * interior y lo lleva sumando columnas en el exterior.
+ * Multiplicar(c, a, b); deja en c el producto de a y b, y
+ * Trasponer(t, m); la traspuesta de m en t; las dos recorren las
+ * matrices por bloques que caben en la caché (ver mat_mul()). Las
+ * funciones de vectores toman una matriz como el vector de todos sus
+ * elementos.
+ *
+ * Suma(v), Producto(a, b) (la suma de a[i] * b[i]; a y b del mismo
+ * tipo y tamaño), Minimo(v) y Maximo(v) recorren el vector entero, y
+ * Llenar(v, x); pone todos sus elementos a x. Van con núcleos AVX2 o
+ * SSE4.2 si la CPU los tiene (ver VecFunc); "--simd=sse4.2" o
+ * "--simd=no" limitan cuáles se usan. No son palabras reservadas.
+ *
+ * Ordenar(v); ordena de menor a mayor un vector de Entero o Caracter
+ * sin memoria aparte, y Buscar(v, x) da la posición del primer x en
+ * el vector ya ordenado, o -1 si no está (búsqueda binaria: unas
+ * pocas comparaciones aunque tenga millones de elementos). Ver
+ * vec_sort().
+ *
+ * Un Diccionario ("Diccionario d;") guarda Entero con claves Entero:
+ * d[k] = x; mete la clave k (o cambia su valor) y d[k] da su valor,
+ * o 0 si no está. Contiene(d, k) dice si está (1 o 0), Borrar(d, k);
+ * la quita, Tamano(d) da cuántas hay y Claves(v, d); las copia en
+ * v[0], v[1]... (un vector de Entero con sitio para todas), en un
+ * orden que no es el de las claves pero que sí es siempre el mismo.
+ * Como en un vector, su declaración, cada vez que se ejecuta, lo
+ * deja vacío, y un Flotante que se guarda se convierte a Entero. Es
+ * una tabla hash con los bytes de control de SwissTable, que se
+ * comparan de 16 en 16 con SSE2, y unos 20-40 bytes por clave (ver
+ * dict_slot()).
+ *
+ * Con -O3, un Mientras que solo opera elemento a elemento sobre
+ * vectores, sin que una vuelta lea lo que escribe otra (el típico
+ * Mientras (i < n) { c[i] = a[i] * k + b[i]; i = i + 1; }), se
+ * vectoriza: la VM hace las vueltas de cuatro en cuatro (AVX2 o
+ * SSE4.2; nada con --simd=no) y el ejecutable nativo de dos en dos
+ * con SSE2. Las que sobran, y cualquier tanda donde algo se desborda
+ * o un índice se sale, siguen por el bucle escalar, así que los
+ * errores salen igual y en la misma vuelta.
+ *
+ * Un Entero que se sale de 64 bits (al sumar, restar, multiplicar,
+ * cambiar de signo o dividir el mínimo entre -1) es un error de
+ * ejecución. "--wrap" cambia eso por la aritmética módulo 2^64 (como
+ * gcc -fwrapv): sin comprobaciones, y con más libertad para el
+ * optimizador. Sin --wrap, lo que el análisis de rangos demuestra
+ * que no se desborda tampoco se comprueba:
+ *      analyzer --wrap programa.txt
+ *
+ * Con "--bigint" un Entero no tiene límite: mientras cabe en 64 bits
+ * se opera igual que siempre y, cuando se sale, pasa a ser un entero
+ * de precisión arbitraria (ver BigInt). Los bucles calientes siguen
+ * en la VM y el JIT con 64 bits; si allí algo se desborda, la vuelta
+ * se repite en el intérprete. Los elementos de un vector de Entero,
+ * y las claves y los valores de un Diccionario, siguen siendo de 64
+ * bits. No sirve con -o ni usa la caché:
+ *      analyzer --bigint programa.txt
+ *
+ * Antes de ejecutar nada el programa se compila entero a IR y pasa
+ * por el optimizador, así que los errores de sintaxis y las
+ * divisiones entre una constante cero se detectan de antemano.
+ *
+ * Al interpretar, los Mientras que dan muchas vueltas se compilan a
+ * IR y sus bucles internos calientes a código máquina mediante un JIT
+ * de trazas (solo x86-64); "--no-jit" lo desactiva y "--stats"
+ * informa de qué se promovió y cuánto costó. "--dead-code" dice
+ * cuánto del programa no influye en la salida y se ha quitado.
+ *
+ * El IR optimizado se puede inspeccionar sin ejecutar el programa:
+ *      analyzer --dump-ir programa.txt       (tal como se ejecuta)
+ *      analyzer --dump-ssa programa.txt      (en forma SSA, con PHI)
+ *      analyzer --ir-roundtrip programa.txt  (volcar → leer → volcar)
+ *
+ * Qué pasadas de optimización corren se elige con -O0 … -O3 (por
+ * defecto -O3; -O0 no optimiza nada y compila antes los programas
+ * cortos) o una a una con --passes=const,gvn,…; "--time-passes"
+ * dice cuánto tardó cada una y cuánto cambió el IR:
+ *      analyzer -O1 --time-passes programa.txt
+ *
+ * Un programa que viene de un archivo se guarda ya compilado en la
+ * caché ($GAMA_CACHE, o ~/.cache/gama) como <hash>.gbc; si el
+ * fuente no cambia, la siguiente vez se ejecuta directamente en la
+ * VM sin tokenizar ni analizar nada. "--no-cache" la evita.
+ *
+ * Pruebas: tests/run.sh ejecuta cada programa de tests/ con -O0, -O3,
+ * --no-jit, --wrap, --bigint, desde la caché, como ejecutable nativo
+ * y con --ir-roundtrip, y compara con la salida esperada de al lado;
+ * los que prueban una pasada miran además en --stats (o en
+ * --dump-ir) que se aplicó.
+ *
  **************************************************************/
 
 
@@ -85,8 +246,49 @@
 
  #include <stdio.h>
  #include <stdlib.h>
+ #include <stddef.h>
  #include <string.h>
  #include <ctype.h>
+ #include <limits.h>
+ #include <errno.h>
+ #include <stdarg.h>
+ #include <time.h>
+ 
+ #if defined(__x86_64__) && !defined(_WIN32)
+ #define JIT_AVAILABLE 1
+ #include <sys/mman.h>
+ #else
+ #define JIT_AVAILABLE 0
+ #endif
+ 
+ #if !defined(_WIN32)
+ #define GBC_AVAILABLE 1
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <dirent.h>
+ #else
+ #define GBC_AVAILABLE 0
+ #endif
+ 
+ #if !defined(_WIN32)
+ #define SPAWN_AVAILABLE 1
+ #include <sys/wait.h>
+ #else
+ #define SPAWN_AVAILABLE 0
+ #endif
+ 
+ #if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+ #define SIMD_AVAILABLE 1
+ #include <immintrin.h>
+ #else
+ #define SIMD_AVAILABLE 0
+ #endif
+ 
+ /* Ordenar/Buscar, Multiplicar/Trasponer y los diccionarios: los
+  * mismos núcleos que enlaza el ejecutable nativo (ver runtime.c) */
+ #include "runtime.c"
  
  /*==============================================================
   *                       DEFINICIONES GLOBALES
@@ -97,23 +299,163 @@
  #define MAX_VARS          256
  
  /*--------------------------------------------------------------
-  * Tipo de datos para variables en la tabla de símbolos. 
-  * Para simplificar, todas son enteros (Entero, Caracter, Flotante 
-  * → se almacenan como int). 
+  * Tipos del lenguaje. Cada variable tiene el suyo desde que se
+  * declara, y su valor se guarda con la representación de ese tipo.
+  *-------------------------------------------------------------*/
+ typedef enum {
+     TYPE_INT,      // “Entero”:   long long (64 bits)
+     TYPE_CHAR,     // “Caracter”: 8 bits con signo
+     TYPE_FLOAT     // “Flotante”: double
+ } VarType;
+ 
+ static const char *const type_name[] = { "Entero", "Caracter", "Flotante" };
+ 
+ /*--------------------------------------------------------------
+  * Variable en la tabla de símbolos (su valor va aparte, en
+  * sym_value[]).
   *-------------------------------------------------------------*/
  typedef struct {
-     char   name[MAX_LEXEME_LEN];  // Identificador
-     int    value;                 // Valor
-     int    is_defined;            // 0 = no existe aún, 1 = ya existe
+     char    name[MAX_LEXEME_LEN];  // Identificador
+     VarType type;                  // fijado al declararla
  } Symbol;
  
+ /*--------------------------------------------------------------
+  * Valor del intérprete de tokens (variables y resultados de las
+  * expresiones): 64 bits "NaN-boxed".
+  *   - Un Flotante es su double tal cual. Los NaN se normalizan a
+  *     VAL_NAN, así ninguno cae en el espacio de las etiquetas.
+  *   - Lo demás va dentro de un NaN negativo: los 16 bits altos son
+  *     la etiqueta y los 48 bajos el dato (con signo):
+  *       0xFFF9 Entero, 0xFFFA Caracter, 0xFFFB sin valor (VAL_UNDEF),
+  *       0xFFFC Entero que no cabe en 48 bits: el dato es su índice
+  *              en wide_cell[].
+  *       0xFFFD Entero de --bigint que no cabe en 64 bits: el dato es
+  *              su índice en big_cell[].
+  * Saber el tipo es comparar los bits altos y cada variable ocupa 8
+  * bytes.
+  *
+  * Los Entero de más de 48 bits son raros (contadores enormes,
+  * productos que se acercan al límite), así que van aparte en un
+  * vector que no se libera celda a celda: al empezar cada sentencia
+  * solo sym_value[] guarda valores vivos y, si el vector se ha
+  * llenado hasta la mitad, wide_compact() se queda con los suyos.
+  *-------------------------------------------------------------*/
+ typedef unsigned long long Value;
+ 
+ #define VAL_TAG_INT   0xFFF9ULL
+ #define VAL_TAG_CHAR  0xFFFAULL
+ #define VAL_UNDEF     (0xFFFBULL << 48)
+ #define VAL_TAG_WIDE  0xFFFCULL
+ #define VAL_TAG_BIG   0xFFFDULL
+ #define VAL_NAN       0x7FF8000000000000ULL
+ #define VAL_PAYLOAD   0xFFFFFFFFFFFFULL
+ 
+ // Caben las variables (tras wide_compact(), la mitad como mucho) y
+ // los resultados intermedios de una sentencia (uno por token)
+ #define WIDE_CELLS    (2 * MAX_VARS + 2 * MAX_TOKENS)
+ 
+ static long long wide_cell[WIDE_CELLS];
+ static int       num_wide = 0;
+ 
+ static inline int val_is_float(Value v) {
+     return v < (VAL_TAG_INT << 48);
+ }
+ 
+ static inline int val_is_char(Value v) {
+     return (v >> 48) == VAL_TAG_CHAR;
+ }
+ 
+ static inline int val_is_big(Value v) {
+     return (v >> 48) == VAL_TAG_BIG;
+ }
+ 
+ static Value val_from_wide(long long i) {
+     if (num_wide >= WIDE_CELLS) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     wide_cell[num_wide] = i;
+     return (VAL_TAG_WIDE << 48) | (unsigned long long)num_wide++;
+ }
+ 
+ static inline Value val_from_int(long long i) {
+     if (i < -(1LL << 47) || i >= (1LL << 47)) {
+         return val_from_wide(i);
+     }
+     return (VAL_TAG_INT << 48) | ((unsigned long long)i & VAL_PAYLOAD);
+ }
+ 
+ static inline Value val_from_char(int c) {
+     return (VAL_TAG_CHAR << 48) | ((unsigned long long)(long long)(signed char)c & VAL_PAYLOAD);
+ }
+ 
+ static inline Value val_from_float(double x) {
+     Value v;
+     if (x != x) {
+         return VAL_NAN;
+     }
+     memcpy(&v, &x, sizeof(v));
+     return v;
+ }
+ 
+ // Entero o Caracter (promovido a Entero)
+ static inline long long val_int(Value v) {
+     if ((v >> 48) == VAL_TAG_WIDE) {
+         return wide_cell[v & VAL_PAYLOAD];
+     }
+     return (long long)(v << 16) >> 16;
+ }
+ 
+ static inline double val_float(Value v) {
+     double x;
+     memcpy(&x, &v, sizeof(x));
+     return x;
+ }
+ 
  /*--------------------------------------------------------------
   * Vector global para guardar variables: 
   *   symtab[0..num_vars-1] 
+  * y sus valores, juntos para que quepan más por línea de caché:
+  *   sym_value[0..num_vars-1]   (VAL_UNDEF si aún no tiene)
   *-------------------------------------------------------------*/
  static Symbol symtab[MAX_VARS];
+ static Value  sym_value[MAX_VARS];
  static int    num_vars = 0;
  
+ /*--------------------------------------------------------------
+  * Vectores ("Entero v[1000];") y matrices ("Entero m[10][20];", un
+  * vector de 200 con cols = 20). No están en symtab ni tienen
+  * registro en el IR: cada uno es un solo bloque de memoria con sus
+  * elementos seguidos, long long para Entero (y los bits del double
+  * para Flotante) o signed char para Caracter. Se dan de alta al
+  * compilar el programa entero, antes de ejecutar nada, y el bloque
+  * no se mueve nunca: el intérprete, la VM y las trazas leen y
+  * escriben en el mismo sitio, así que cambiar de nivel no copia
+  * nada.
+  *-------------------------------------------------------------*/
+ #define MAX_ARRAY_LEN INT_MAX
+ 
+ typedef struct {
+     char       name[MAX_LEXEME_LEN];
+     VarType    type;                // el de los elementos
+     long long  len;                 // 1..MAX_ARRAY_LEN
+     long long  cols;                // columnas de una matriz; 0 en un vector
+     void      *data;
+ } Array;
+ 
+ static Array arrays[MAX_VARS];
+ static int   num_arrays = 0;
+ 
+ /*--------------------------------------------------------------
+  * Diccionarios ("Diccionario d;"), de Entero a Entero. Como los
+  * vectores, no están en symtab ni tienen registro en el IR y se dan
+  * de alta al compilar; el Dict no se mueve, aunque sus casillas se
+  * cambian de sitio cuando crece. Ver dict_slot().
+  *-------------------------------------------------------------*/
+ static Dict dicts[MAX_VARS];                         // ver runtime.c
+ static char dict_names[MAX_VARS][MAX_LEXEME_LEN];
+ static int  num_dicts = 0;
+ 
  /*--------------------------------------------------------------
   * Enumeración de tokens (TOK_XXX) 
   *-------------------------------------------------------------*/
@@ -127,10 +469,13 @@
      TOK_IF,        // “Si”
      TOK_ELSE,      // “Sino”
      TOK_WHILE,     // “Mientras”
+     TOK_DICT,      // “Diccionario”
  
      // identificador y número
      TOK_IDENT,     // identificador: letra( letra|dígito )*
      TOK_NUM,       // número: dígito+
+     TOK_REAL,      // número con decimales: dígito+ '.' dígito*
+     TOK_CHARLIT,   // carácter entre comillas simples
  
      // operadores y símbolos
      TOK_COMMA,     // ‘,’
@@ -139,6 +484,8 @@
      TOK_RPAREN,    // ‘)’
      TOK_LBRACE,    // ‘{’
      TOK_RBRACE,    // ‘}’
+     TOK_LBRACKET,  // ‘[’
+     TOK_RBRACKET,  // ‘]’
  
      TOK_ASSIGN,    // ‘=’
      TOK_EQ,        // ‘==’
@@ -163,6 +510,7 @@
  typedef struct {
      TokenType type;
      char      lexeme[MAX_LEXEME_LEN];
+     int       line;                 // línea de origen (1..N)
  } Token;
  
  /*--------------------------------------------------------------
@@ -177,7 +525,563 @@
  static int   num_tokens = 0;
  static int   cur_token  = 0;
  
+ /*
+  * stmt_end[i]: si en el token i empieza un <stmt>, índice del token
+  * siguiente a ese <stmt> (0 si no se sabe). Lo rellena el generador
+  * de código; el intérprete lo usa para saltarse ramas sin recorrerlas.
+  */
+ static int   stmt_end[MAX_TOKENS];
+ 
+ /*
+  * read_is_safe[i]: 1 si la variable leída en el token i tiene valor
+  * en todos los caminos (lo demuestra opt_definite_assignment); esa
+  * lectura no necesita comprobar si tiene valor.
+  */
+ static char  read_is_safe[MAX_TOKENS];
+ 
+ /*
+  * region_big[v]: con --bigint, 1 si la región que se está compilando
+  * recibe v como BigInt. La VM no la tiene (le llega como VM_UNDEF),
+  * así que cada lectura de v lleva su CHKDEF, que en ese caso vuelve
+  * al intérprete. NULL al compilar el programa entero.
+  */
+ static const char *region_big;
+ 
+ /*
+  * div_is_safe[i]: 1 si el divisor del '/' del token i nunca es cero
+  * (lo demuestra opt_ranges); esa división no necesita comprobarlo.
+  */
+ static char  div_is_safe[MAX_TOKENS];
+ 
+ /*
+  * idx_is_safe[i]: 1 si el índice que abre el '[' del token i siempre
+  * está dentro de su vector (lo demuestra opt_ranges); ese acceso no
+  * necesita comprobarlo.
+  */
+ static char  idx_is_safe[MAX_TOKENS];
+ 
+ /*
+  * warn_enabled: 1 si los avisos de compilación (un error seguro en
+  * una rama que quizá no se ejecuta) tienen que salir. El programa
+  * entero se compila más de una vez y solo avisa la primera.
+  */
+ static int   warn_enabled = 1;
+ 
+ /*
+  * int_wrap: 1 con --wrap (un Entero que se sale de 64 bits da la
+  * vuelta); 0 si eso es un error. El intérprete lo mira en cada
+  * operación y el generador de IR elige con él entre las operaciones
+  * comprobadas (OP_ADDO...) y las que no.
+  */
+ static int   int_wrap = 0;
+ 
+ /*
+  * int_big: 1 con --bigint (un Entero que se sale de 64 bits pasa a
+  * ser un BigInt). Las operaciones comprobadas siguen siendo las del
+  * IR; lo que cambia es qué pasa cuando se desbordan.
+  */
+ static int   int_big = 0;
+ 
+ /*
+  * tok_type[i]: si el token i es un IDENT, el VarType que le dio el
+  * compilador a su variable. El intérprete lo usa para crear con su
+  * tipo una variable que se asigna sin declarar (del resto de los
+  * tipos se entera por los bits de cada Value).
+  */
+ static unsigned char tok_type[MAX_TOKENS];
+ 
+ /*
+  * stmt_dead[i]: 1 si la asignación que empieza en el token i no
+  * cambia nada observable y no puede fallar (lo demuestra
+  * opt_dead_stores); el intérprete se la salta.
+  */
+ static char  stmt_dead[MAX_TOKENS];
+ static long long stmt_dead_skips = 0;   // veces que se saltó una
+ 
+ /*--------------------------------------------------------------
+  * Fuente del programa: stdin por defecto, o el archivo pasado
+  * por línea de comandos (así stdin queda libre para Leer).
+  * src_line lleva la línea actual para los tokens.
+  *-------------------------------------------------------------*/
+ static FILE *src      = NULL;
+ static int   src_line = 1;
+ 
+ 
+ /*==============================================================
+  *                 ENTEROS GRANDES (--bigint)
+  *=============================================================*/
+ 
+ /*--------------------------------------------------------------
+  * Con --bigint un Entero que cabe en 64 bits es el de siempre (en
+  * el Value o en wide_cell[]) y solo cuando una operación se sale
+  * pasa a un BigInt: magnitud en base 2^32 en el heap y signo aparte.
+  * big_make() devuelve el Entero de 64 bits si el resultado cabe, así
+  * que un BigInt nunca cabe en 64 bits (ni vale 0) y el camino rápido
+  * del intérprete solo tiene que mirar la etiqueta.
+  *
+  * Como wide_cell[], big_cell[] no se libera celda a celda: al
+  * empezar una sentencia, si va por la mitad, big_compact() libera
+  * los que no son de ninguna variable. Un BigInt no cambia nunca
+  * (cada operación crea uno nuevo), así que dos variables pueden
+  * compartir el mismo.
+  *
+  * Multiplicar es O(n·m) hasta KARATSUBA_MIN cifras y Karatsuba a
+  * partir de ahí; dividir es el algoritmo D de Knuth.
+  *-------------------------------------------------------------*/
+ 
+ #define KARATSUBA_MIN  32
+ 
+ typedef struct {
+     int          neg;        // 1 si es negativo
+     int          len;        // cifras (limb[len - 1] != 0)
+     unsigned int limb[];     // magnitud, de menor a mayor peso
+ } BigInt;
+ 
+ static BigInt *big_cell[WIDE_CELLS];
+ static int     num_big = 0;
+ 
+ /**
+  * big_alloc(old, size):
+  *   realloc(old, size) que no vuelve sin memoria: todo lo que piden
+  *   los BigInt (las cifras y los temporales de multiplicar, dividir
+  *   y pasar a decimal) sale de aquí.
+  */
+ static void *big_alloc(void *old, size_t size) {
+     void *p = realloc(old, size);
+     if (p == NULL) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     return p;
+ }
+ 
+ /* Un operando: un BigInt o un Entero de 64 bits visto igual */
+ typedef struct {
+     int                 neg, len;
+     const unsigned int *d;
+     unsigned int        small[2];
+ } BigArg;
+ 
+ static void big_arg(Value v, BigArg *x) {
+     if (val_is_big(v)) {
+         const BigInt *b = big_cell[v & VAL_PAYLOAD];
+         x->neg = b->neg;
+         x->len = b->len;
+         x->d   = b->limb;
+         return;
+     }
+     long long i = val_int(v);
+     unsigned long long m = (i < 0) ? -(unsigned long long)i : (unsigned long long)i;
+     x->neg      = (i < 0);
+     x->small[0] = (unsigned int)m;
+     x->small[1] = (unsigned int)(m >> 32);
+     x->len      = (m >> 32) ? 2 : (m != 0);
+     x->d        = x->small;
+ }
+ 
+ /**
+  * big_make(neg, d, len):
+  *   El Entero de signo neg y magnitud d[0..len-1]: de 64 bits si
+  *   cabe y si no un BigInt nuevo (d se copia).
+  */
+ static Value big_make(int neg, const unsigned int *d, int len) {
+     while (len > 0 && d[len - 1] == 0) {
+         len--;
+     }
+     if (len <= 2) {
+         unsigned long long m = (len > 0 ? d[0] : 0) |
+                                ((unsigned long long)(len > 1 ? d[1] : 0) << 32);
+         if (!neg && m <= (unsigned long long)LLONG_MAX) {
+             return val_from_int((long long)m);
+         }
+         if (neg && m <= (unsigned long long)LLONG_MAX + 1) {
+             return val_from_int(m == 0 ? 0 : -(long long)(m - 1) - 1);
+         }
+     }
+     BigInt *b = big_alloc(NULL, sizeof(BigInt) + len * sizeof(unsigned int));
+     if (num_big >= WIDE_CELLS) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     b->neg = neg;
+     b->len = len;
+     memcpy(b->limb, d, len * sizeof(unsigned int));
+     big_cell[num_big] = b;
+     return (VAL_TAG_BIG << 48) | (unsigned long long)num_big++;
+ }
+ 
+ /* Comparación de magnitudes: <0, 0 o >0 */
+ static int mag_cmp(const unsigned int *a, int na, const unsigned int *b, int nb) {
+     if (na != nb) {
+         return (na < nb) ? -1 : 1;
+     }
+     for (int i = na - 1; i >= 0; i--) {
+         if (a[i] != b[i]) {
+             return (a[i] < b[i]) ? -1 : 1;
+         }
+     }
+     return 0;
+ }
+ 
+ /* r[0..nr-1] += x[0..nx-1]; el resultado cabe en nr cifras */
+ static void mag_add_at(unsigned int *r, int nr, const unsigned int *x, int nx) {
+     unsigned long long c = 0;
+     for (int i = 0; i < nr && (i < nx || c != 0); i++) {
+         c += (unsigned long long)r[i] + (i < nx ? x[i] : 0);
+         r[i] = (unsigned int)c;
+         c >>= 32;
+     }
+ }
+ 
+ /* r[0..nr-1] -= x[0..nx-1], con r >= x */
+ static void mag_sub_at(unsigned int *r, int nr, const unsigned int *x, int nx) {
+     unsigned long long borrow = 0;
+     for (int i = 0; i < nr && (i < nx || borrow != 0); i++) {
+         unsigned long long d = (unsigned long long)r[i] - (i < nx ? x[i] : 0) - borrow;
+         r[i] = (unsigned int)d;
+         borrow = d >> 63;
+     }
+ }
+ 
+ /**
+  * mag_mul(a, na, b, nb, r):
+  *   r[0..na+nb-1] = a · b (r no se solapa con a ni con b). Con las
+  *   dos por encima de KARATSUBA_MIN cifras parte en a1·B^h + a0 y
+  *   b1·B^h + b0 y hace tres productos en vez de cuatro:
+  *     a·b = z2·B^2h + ((a0 + a1)(b0 + b1) - z2 - z0)·B^h + z0
+  *   Si una es mucho más corta, la larga se multiplica a trozos.
+  */
+ static void mag_mul(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *r) {
+     if (na < nb) {
+         const unsigned int *t = a;
+         int nt = na;
+         a = b; na = nb;
+         b = t; nb = nt;
+     }
+     memset(r, 0, (na + nb) * sizeof(unsigned int));
+     if (nb < KARATSUBA_MIN) {
+         for (int j = 0; j < nb; j++) {
+             unsigned long long c = 0;
+             for (int i = 0; i < na; i++) {
+                 c += (unsigned long long)a[i] * b[j] + r[i + j];
+                 r[i + j] = (unsigned int)c;
+                 c >>= 32;
+             }
+             r[na + j] = (unsigned int)c;
+         }
+         return;
+     }
+     int h = (na + 1) / 2;
+     if (nb <= h) {
+         unsigned int *t = big_alloc(NULL, 2 * nb * sizeof(unsigned int));
+         for (int i = 0; i < na; i += nb) {
+             int k = (na - i < nb) ? na - i : nb;
+             mag_mul(a + i, k, b, nb, t);
+             mag_add_at(r + i, na + nb - i, t, k + nb);
+         }
+         free(t);
+         return;
+     }
+     int na1 = na - h, nb1 = nb - h;
+     unsigned int *sa = big_alloc(NULL, (h + 1) * sizeof(unsigned int));
+     unsigned int *sb = big_alloc(NULL, (h + 1) * sizeof(unsigned int));
+     unsigned int *z1 = big_alloc(NULL, 2 * (h + 1) * sizeof(unsigned int));
+     memcpy(sa, a, h * sizeof(unsigned int));
+     sa[h] = 0;
+     mag_add_at(sa, h + 1, a + h, na1);
+     memcpy(sb, b, h * sizeof(unsigned int));
+     sb[h] = 0;
+     mag_add_at(sb, h + 1, b + h, nb1);
+     mag_mul(sa, h + 1, sb, h + 1, z1);
+     mag_mul(a, h, b, h, r);                          // z0
+     mag_mul(a + h, na1, b + h, nb1, r + 2 * h);      // z2
+     mag_sub_at(z1, 2 * h + 2, r, 2 * h);
+     mag_sub_at(z1, 2 * h + 2, r + 2 * h, na1 + nb1);
+     int nz = 2 * h + 2;
+     while (nz > 0 && z1[nz - 1] == 0) {
+         nz--;
+     }
+     mag_add_at(r + h, na + nb - h, z1, nz);
+     free(sa);
+     free(sb);
+     free(z1);
+ }
+ 
+ /**
+  * mag_div(a, na, b, nb, q):
+  *   q[0..na-nb] = a / b truncado, con a >= b y b[nb-1] != 0
+  *   (algoritmo D de Knuth: normaliza b para que cada cifra del
+  *   cociente se pueda estimar con las dos cifras altas).
+  */
+ static void mag_div(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *q) {
+     if (nb == 1) {
+         unsigned long long r = 0;
+         for (int i = na - 1; i >= 0; i--) {
+             r = (r << 32) | a[i];
+             q[i] = (unsigned int)(r / b[0]);
+             r %= b[0];
+         }
+         return;
+     }
+     int s = __builtin_clz(b[nb - 1]);
+     unsigned int *u = big_alloc(NULL, (na + 1) * sizeof(unsigned int));
+     unsigned int *v = big_alloc(NULL, nb * sizeof(unsigned int));
+     for (int i = nb - 1; i > 0; i--) {
+         v[i] = (b[i] << s) | (s ? b[i - 1] >> (32 - s) : 0);
+     }
+     v[0] = b[0] << s;
+     u[na] = s ? a[na - 1] >> (32 - s) : 0;
+     for (int i = na - 1; i > 0; i--) {
+         u[i] = (a[i] << s) | (s ? a[i - 1] >> (32 - s) : 0);
+     }
+     u[0] = a[0] << s;
+ 
+     for (int j = na - nb; j >= 0; j--) {
+         unsigned long long num  = ((unsigned long long)u[j + nb] << 32) | u[j + nb - 1];
+         unsigned long long qhat = num / v[nb - 1];
+         unsigned long long rhat = num % v[nb - 1];
+         while (qhat >> 32 ||
+                qhat * v[nb - 2] > ((rhat << 32) | u[j + nb - 2])) {
+             qhat--;
+             rhat += v[nb - 1];
+             if (rhat >> 32) {
+                 break;
+             }
+         }
+         // u[j..j+nb] -= qhat · v
+         unsigned long long carry = 0, borrow = 0;
+         for (int i = 0; i < nb; i++) {
+             unsigned long long p = qhat * v[i] + carry;
+             unsigned long long t = (unsigned long long)u[i + j] - (p & 0xFFFFFFFFULL) - borrow;
+             carry  = p >> 32;
+             u[i + j] = (unsigned int)t;
+             borrow = t >> 63;
+         }
+         unsigned long long t = (unsigned long long)u[j + nb] - carry - borrow;
+         u[j + nb] = (unsigned int)t;
+         if (t >> 63) {
+             // qhat era uno de más: se devuelve v
+             qhat--;
+             mag_add_at(u + j, nb + 1, v, nb);
+         }
+         q[j] = (unsigned int)qhat;
+     }
+     free(u);
+     free(v);
+ }
+ 
+ /**
+  * big_binary(t, x, y):
+  *   x t y exacto, para Entero (BigInt o no) con --bigint.
+  */
+ static Value big_binary(TokenType t, Value x, Value y) {
+     BigArg a, b;
+     big_arg(x, &a);
+     big_arg(y, &b);
+     if (t == TOK_MINUS) {
+         b.neg = !b.neg;
+     }
+     if (t == TOK_PLUS || t == TOK_MINUS) {
+         int cmp = mag_cmp(a.d, a.len, b.d, b.len);
+         const BigArg *big = (cmp >= 0) ? &a : &b, *sml = (cmp >= 0) ? &b : &a;
+         unsigned int *r = big_alloc(NULL, (big->len + 1) * sizeof(unsigned int));
+         memcpy(r, big->d, big->len * sizeof(unsigned int));
+         r[big->len] = 0;
+         if (a.neg == b.neg) {
+             mag_add_at(r, big->len + 1, sml->d, sml->len);
+         } else {
+             mag_sub_at(r, big->len + 1, sml->d, sml->len);
+         }
+         Value v = big_make(big->neg, r, big->len + 1);
+         free(r);
+         return v;
+     }
+     if (t == TOK_MULT) {
+         unsigned int *r = big_alloc(NULL, (a.len + b.len + 1) * sizeof(unsigned int));
+         mag_mul(a.d, a.len, b.d, b.len, r);
+         Value v = big_make(a.neg != b.neg, r, a.len + b.len);
+         free(r);
+         return v;
+     }
+     if (t == TOK_DIV) {
+         if (b.len == 0) {
+             fprintf(stderr, "Error: división por cero.\n");
+             exit(1);
+         }
+         if (mag_cmp(a.d, a.len, b.d, b.len) < 0) {
+             return val_from_int(0);
+         }
+         unsigned int *q = big_alloc(NULL, (a.len - b.len + 1) * sizeof(unsigned int));
+         mag_div(a.d, a.len, b.d, b.len, q);
+         Value v = big_make(a.neg != b.neg, q, a.len - b.len + 1);
+         free(q);
+         return v;
+     }
+     // Comparaciones (el 0 siempre lleva neg = 0)
+     int cmp = (a.neg != b.neg) ? (a.neg ? -1 : 1)
+             : a.neg ? -mag_cmp(a.d, a.len, b.d, b.len) : mag_cmp(a.d, a.len, b.d, b.len);
+     switch (t) {
+         case TOK_EQ:  return val_from_int(cmp == 0);
+         case TOK_NEQ: return val_from_int(cmp != 0);
+         case TOK_LT:  return val_from_int(cmp <  0);
+         case TOK_GT:  return val_from_int(cmp >  0);
+         case TOK_LE:  return val_from_int(cmp <= 0);
+         case TOK_GE:  return val_from_int(cmp >= 0);
+         default:      return val_from_int(0);
+     }
+ }
+ 
+ /**
+  * val_to_double(v):
+  *   Un Entero (también un BigInt) o Caracter como Flotante.
+  */
+ static double val_to_double(Value v) {
+     if (val_is_big(v)) {
+         const BigInt *b = big_cell[v & VAL_PAYLOAD];
+         double x = 0.0;
+         for (int i = b->len - 1; i >= 0; i--) {
+             x = x * 4294967296.0 + b->limb[i];
+         }
+         return b->neg ? -x : x;
+     }
+     return (double)val_int(v);
+ }
+ 
+ /**
+  * big_wrap(v):
+  *   Los 64 bits bajos (en complemento a 2) de un BigInt: lo que queda
+  *   al convertirlo a Caracter.
+  */
+ static long long big_wrap(Value v) {
+     const BigInt *b = big_cell[v & VAL_PAYLOAD];
+     unsigned long long m = b->limb[0] | ((unsigned long long)b->limb[1] << 32);
+     return (long long)(b->neg ? 0 - m : m);
+ }
+ 
+ /**
+  * big_to_string(v):
+  *   El BigInt v en decimal (lo libera el llamador). Va sacando
+  *   grupos de 9 cifras dividiendo entre 10^9.
+  */
+ static char *big_to_string(Value v) {
+     const BigInt *b = big_cell[v & VAL_PAYLOAD];
+     int n = b->len, ng = 0;
+     unsigned int *m     = big_alloc(NULL, n * sizeof(unsigned int));
+     unsigned int *group = big_alloc(NULL, (n * 10 / 9 + 2) * sizeof(unsigned int));
+     memcpy(m, b->limb, n * sizeof(unsigned int));
+     do {
+         unsigned long long r = 0;
+         for (int i = n - 1; i >= 0; i--) {
+             r = (r << 32) | m[i];
+             m[i] = (unsigned int)(r / 1000000000U);
+             r %= 1000000000U;
+         }
+         group[ng++] = (unsigned int)r;
+         while (n > 0 && m[n - 1] == 0) {
+             n--;
+         }
+     } while (n > 0);
+     char *s = big_alloc(NULL, ng * 9 + 2);
+     int   k = sprintf(s, "%s%u", b->neg ? "-" : "", group[ng - 1]);
+     for (int i = ng - 2; i >= 0; i--) {
+         k += sprintf(s + k, "%09u", group[i]);
+     }
+     free(m);
+     free(group);
+     return s;
+ }
+ 
+ /**
+  * big_read(val):
+  *   Lee un Entero de cualquier tamaño (como "%lld": blancos, signo
+  *   opcional y cifras). Devuelve 0 si no hay número.
+  */
+ static int big_read(Value *val) {
+     int c, neg = 0, n = 0, cap = 32;
+     do {
+         c = getchar();
+     } while (c != EOF && isspace(c));
+     if (c == '-' || c == '+') {
+         neg = (c == '-');
+         c = getchar();
+     }
+     char *digits = big_alloc(NULL, cap);
+     while (c != EOF && isdigit(c)) {
+         if (n + 1 >= cap) {
+             cap *= 2;
+             digits = big_alloc(digits, cap);
+         }
+         digits[n++] = (char)c;
+         c = getchar();
+     }
+     if (c != EOF) {
+         ungetc(c, stdin);
+     }
+     if (n == 0) {
+         free(digits);
+         return 0;
+     }
+     // m = m · 10^9 + grupo, de 9 en 9 cifras (el primero, lo que sobra)
+     unsigned int *m = big_alloc(NULL, (n / 9 + 2) * sizeof(unsigned int));
+     memset(m, 0, (n / 9 + 2) * sizeof(unsigned int));
+     int len = 0;
+     for (int i = 0; i < n; ) {
+         int k = (i == 0 && n % 9 != 0) ? n % 9 : 9;
+         unsigned long long c2 = 0, mul = 1;
+         for (int j = 0; j < k; j++) {
+             c2  = c2 * 10 + (unsigned)(digits[i + j] - '0');
+             mul *= 10;
+         }
+         for (int j = 0; j < len; j++) {
+             c2  += (unsigned long long)m[j] * mul;
+             m[j] = (unsigned int)c2;
+             c2 >>= 32;
+         }
+         if (c2 != 0) {
+             m[len++] = (unsigned int)c2;
+         }
+         i += k;
+     }
+     *val = big_make(neg, m, len);
+     free(m);
+     free(digits);
+     return 1;
+ }
+ 
+ /**
+  * big_compact():
+  *   Al empezar una sentencia: si big_cell[] va por la mitad, libera
+  *   los BigInt que no son de ninguna variable.
+  */
+ static void big_compact(void) {
+     static int where[WIDE_CELLS];
+     BigInt *kept[MAX_VARS];
+     int     n = 0;
+     if (num_big < WIDE_CELLS / 2) {
+         return;
+     }
+     for (int k = 0; k < num_big; k++) {
+         where[k] = -1;
+     }
+     for (int v = 0; v < num_vars; v++) {
+         if (val_is_big(sym_value[v])) {
+             int k = (int)(sym_value[v] & VAL_PAYLOAD);
+             if (where[k] < 0) {
+                 where[k]  = n;
+                 kept[n++] = big_cell[k];
+                 big_cell[k] = NULL;
+             }
+             sym_value[v] = (VAL_TAG_BIG << 48) | (unsigned long long)where[k];
+         }
+     }
+     for (int k = 0; k < num_big; k++) {
+         free(big_cell[k]);
+     }
+     memcpy(big_cell, kept, n * sizeof(BigInt *));
+     num_big = n;
+ }
  
+
  /*==============================================================
   *                   FUNCIONES DE TABLA DE SÍMBOLOS
   *=============================================================*/
@@ -199,8 +1103,8 @@
  
  /**
   * add_symbol(nombre):
-  *   Agrega una nueva variable a la tabla de símbolos con 
-  *   valor 0 e is_defined=0. Devuelve el índice donde la insertó. 
+  *   Agrega una nueva variable (Entero) a la tabla de símbolos, sin
+  *   valor (VAL_UNDEF). Devuelve el índice donde la insertó. 
   *   Si ya existe o si no hay espacio, aborta con error.
   */
  static int add_symbol(const char *nombre) {
@@ -214,999 +1118,12923 @@
          return idx;
      }
      strcpy(symtab[num_vars].name, nombre);
-     symtab[num_vars].value = 0;
-     symtab[num_vars].is_defined = 0;
+     symtab[num_vars].type = TYPE_INT;
+     sym_value[num_vars] = VAL_UNDEF;
      num_vars++;
      return num_vars - 1;
  }
  
  /**
-  * set_symbol_value(nombre, val):
+  * float_to_int(x):
+  *   Flotante → Entero truncando hacia cero. Fuera de rango se satura
+  *   (y NaN da 0): así la conversión nunca es comportamiento indefinido
+  *   y da lo mismo en todos los niveles de ejecución.
+  */
+ static long long float_to_int(double x) {
+     if (x != x) {
+         return 0;
+     }
+     if (x >= 9223372036854775808.0) {
+         return LLONG_MAX;
+     }
+     if (x <= -9223372036854775808.0) {
+         return LLONG_MIN;
+     }
+     return (long long)x;
+ }
+ 
+ /**
+  * int_overflow():
+  *   Error de un Entero que no cabe en 64 bits (sin --wrap). Lo dan
+  *   igual todos los niveles de ejecución.
+  */
+ static void int_overflow(void) {
+     fprintf(stderr, "Error: desbordamiento de Entero.\n");
+     exit(1);
+ }
+ 
+ /**
+  * convert_value(v, to):
+  *   Convierte v al tipo to, como al asignar.
+  */
+ static Value convert_value(Value v, VarType to) {
+     if (to == TYPE_FLOAT) {
+         return val_is_float(v) ? v : val_from_float(val_to_double(v));
+     }
+     if (to == TYPE_INT && !val_is_float(v) && !val_is_char(v)) {
+         return v;
+     }
+     long long i = val_is_float(v) ? float_to_int(val_float(v))
+                 : val_is_big(v)   ? big_wrap(v) : val_int(v);
+     return (to == TYPE_CHAR) ? val_from_char((int)i) : val_from_int(i);
+ }
+ 
+ /**
+  * wide_compact():
+  *   Al empezar una sentencia: si wide_cell[] va por la mitad, deja
+  *   en él solo los Entero anchos de las variables.
+  */
+ static void wide_compact(void) {
+     long long kept[MAX_VARS];
+     int       n = 0;
+     if (num_wide < WIDE_CELLS / 2) {
+         return;
+     }
+     for (int v = 0; v < num_vars; v++) {
+         if ((sym_value[v] >> 48) == VAL_TAG_WIDE) {
+             kept[n] = val_int(sym_value[v]);
+             sym_value[v] = (VAL_TAG_WIDE << 48) | (unsigned long long)n++;
+         }
+     }
+     memcpy(wide_cell, kept, n * sizeof(long long));
+     num_wide = n;
+ }
+ 
+ /**
+  * set_symbol_value(nombre, type, val):
   *   Busca la variable “nombre” en la tabla. Si no existe, la crea
-  *   y luego le asigna el valor “val”. Si existe, simplemente actualiza
-  *   su valor. Marca is_defined=1.
+  *   (de tipo “type”) y luego le asigna el valor “val”, que ya es de
+  *   ese tipo. Si existe, simplemente actualiza su valor.
   */
- static void set_symbol_value(const char *nombre, int val) {
+ static void set_symbol_value(const char *nombre, VarType type, Value val) {
      int idx = lookup_symbol(nombre);
      if (idx < 0) {
          idx = add_symbol(nombre);
+         symtab[idx].type = type;
      }
-     symtab[idx].value = val;
-     symtab[idx].is_defined = 1;
+     sym_value[idx] = val;
  }
  
  /**
   * get_symbol_value(nombre):
-  *   Devuelve el valor entero de la variable “nombre”. Si no existe
-  *   o no fue inicializada (is_defined=0), da error y termina.
+  *   Devuelve el valor de la variable “nombre”. Si no existe o no
+  *   fue inicializada (VAL_UNDEF), da error y termina.
   */
- static int get_symbol_value(const char *nombre) {
+ static Value get_symbol_value(const char *nombre) {
      int idx = lookup_symbol(nombre);
      if (idx < 0) {
          fprintf(stderr, "Error: variable '%s' no declarada.\n", nombre);
          exit(1);
      }
-     if (symtab[idx].is_defined == 0) {
+     if (sym_value[idx] == VAL_UNDEF) {
          fprintf(stderr, "Error: variable '%s' no inicializada.\n", nombre);
          exit(1);
      }
-     return symtab[idx].value;
- }
- 
- 
- /*==============================================================
-  *                      ANALIZADOR LÉXICO
-  *=============================================================*/
- 
- /**
-  * next_char():
-  *   Lee un carácter de stdin (getchar). Devuelve EOF si ya no hay nada.
-  */
- static int next_char(void) {
-     int c = getchar();
-     return (c == EOF ? EOF : c);
+     return sym_value[idx];
  }
  
  /**
-  * unget_char(c):
-  *   “Devuelve” c al flujo de entrada, para que next_char lo lea de nuevo.
+  * lookup_array(nombre):
+  *   Índice del vector “nombre” en arrays[], o -1 si no hay ninguno.
   */
- static void unget_char(int c) {
-     if (c != EOF) {
-         ungetc(c, stdin);
+ static int lookup_array(const char *nombre) {
+     for (int i = 0; i < num_arrays; i++) {
+         if (strcmp(arrays[i].name, nombre) == 0) {
+             return i;
+         }
      }
+     return -1;
  }
  
  /**
-  * add_token(type, lexe):
-  *   Agrega al arreglo “tokens” un nuevo token con tipo “type” y texto “lexe”.
+  * add_array(nombre, type, len, cols):
+  *   Da de alta el vector o, si ya estaba, devuelve el que hay. Lo
+  *   llama el compilador: el mismo Entero v[10] se vuelve a compilar
+  *   en cada región que lo contiene. Una matriz es un vector de len
+  *   elementos con cols > 0. Los elementos no se reservan aquí sino
+  *   en arrays_alloc(), al empezar a ejecutar: compilar con -o o
+  *   comprobar un programa no necesita la memoria de sus vectores.
   */
- static void add_token(TokenType type, const char *lexe) {
-     if (num_tokens >= MAX_TOKENS) {
-         fprintf(stderr, "Error: demasiados tokens (>= %d).\n", MAX_TOKENS);
+ static int add_array(const char *nombre, VarType type, long long len, long long cols) {
+     int idx = lookup_array(nombre);
+     if (idx >= 0) {
+         return idx;
+     }
+     if (num_arrays >= MAX_VARS) {
+         fprintf(stderr, "Error: demasiados vectores (>= %d).\n", MAX_VARS);
          exit(1);
      }
-     tokens[num_tokens].type = type;
-     strncpy(tokens[num_tokens].lexeme, lexe, MAX_LEXEME_LEN - 1);
-     tokens[num_tokens].lexeme[MAX_LEXEME_LEN - 1] = '\0';
-     num_tokens++;
+     Array *a = &arrays[num_arrays];
+     strcpy(a->name, nombre);
+     a->type = type;
+     a->len  = len;
+     a->cols = cols;
+     a->data = NULL;
+     return num_arrays++;
  }
  
  /**
-  * yylex():
-  *   Reconoce un solo token de la entrada estándar y lo añade a tokens[].
-  *   Retorna el TokenType. Espacios/tab/newline se saltan:
-  *    - Palabra que empieza con letra    → IDENT o palabra reservada
-  *    - Secuencia de dígitos             → NUM
-  *    - “==”, “!=”, “<=”, “>=”            → TOK_EQ/TOK_NEQ/TOK_LE/TOK_GE
-  *    - ‘<’, ‘>’, ‘=’ (asign.)           → TOK_LT/TOK_GT/TOK_ASSIGN
-  *    - Símbolos simples: ',', ';', '(', ')', '{', '}' 
-  *    - Operadores: '+', '-', '*', '/'
-  *    - EOF → TOK_EOF
-  *    - Cualquier otro → TOK_UNKNOWN
+  * arrays_alloc():
+  *   Reserva (a 0) los elementos de los vectores que aún no los tienen.
+  *   Se llama justo antes de ejecutar el programa.
   */
- static TokenType yylex(void) {
-     int c;
-     char buffer[MAX_LEXEME_LEN];
-     int len;
- 
-     // 1) Saltar espacios en blanco y newline
-     do {
-         c = next_char();
-     } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
- 
-     if (c == EOF) {
-         return TOK_EOF;
-     }
- 
-     // 2) Si comienza con letra → identificador o palabra reservada
-     if (isalpha(c)) {
-         len = 0;
-         do {
-             if (len < MAX_LEXEME_LEN - 1) {
-                 buffer[len++] = (char)c;
+ static void arrays_alloc(void) {
+     for (int i = 0; i < num_arrays; i++) {
+         Array *a = &arrays[i];
+         if (a->data == NULL) {
+             a->data = calloc((size_t)a->len, a->type == TYPE_CHAR ? 1 : sizeof(long long));
+             if (a->data == NULL) {
+                 fprintf(stderr, "Error: memoria insuficiente.\n");
+                 exit(1);
              }
-             c = next_char();
-         } while (isalpha(c) || isdigit(c));
-         buffer[len] = '\0';
-         unget_char(c);
- 
-         // Creamos una copia en minúsculas para comparar sin distinción de mayúsculas/minúsculas
-         char tmp[MAX_LEXEME_LEN];
-         for (int i = 0; buffer[i]; i++) {
-             tmp[i] = tolower((unsigned char)buffer[i]);
-         }
-         tmp[len] = '\0';
- 
-         // Verificamos si es una palabra reservada en español
-         if (strcmp(tmp, "entero") == 0) {
-             add_token(TOK_INT, buffer);
-             return TOK_INT;
-         }
-         if (strcmp(tmp, "caracter") == 0) {
-             add_token(TOK_CHAR, buffer);
-             return TOK_CHAR;
-         }
-         if (strcmp(tmp, "flotante") == 0) {
-             add_token(TOK_FLOAT, buffer);
-             return TOK_FLOAT;
-         }
-         if (strcmp(tmp, "imprimir") == 0) {
-             add_token(TOK_PRINT, buffer);
-             return TOK_PRINT;
-         }
-         if (strcmp(tmp, "leer") == 0) {
-             add_token(TOK_READ, buffer);
-             return TOK_READ;
-         }
-         if (strcmp(tmp, "si") == 0) {
-             add_token(TOK_IF, buffer);
-             return TOK_IF;
-         }
-         if (strcmp(tmp, "sino") == 0) {
-             add_token(TOK_ELSE, buffer);
-             return TOK_ELSE;
-         }
-         if (strcmp(tmp, "mientras") == 0) {
-             add_token(TOK_WHILE, buffer);
-             return TOK_WHILE;
          }
-         // Si no es palabra reservada, es un IDENT
-         add_token(TOK_IDENT, buffer);
-         return TOK_IDENT;
-     }
- 
-     // 3) Si comienza con dígito → NUM
-     if (isdigit(c)) {
-         len = 0;
-         do {
-             if (len < MAX_LEXEME_LEN - 1) {
-                 buffer[len++] = (char)c;
-             }
-             c = next_char();
-         } while (isdigit(c));
-         buffer[len] = '\0';
-         unget_char(c);
- 
-         add_token(TOK_NUM, buffer);
-         return TOK_NUM;
      }
+ }
  
-     // 4) Reconocer operadores relacionales de dos caracteres:
-     if (c == '=') {
-         int next = next_char();
-         if (next == '=') {
-             add_token(TOK_EQ, "==");
-             return TOK_EQ;
-         } else {
-             unget_char(next);
-             add_token(TOK_ASSIGN, "=");
-             return TOK_ASSIGN;
-         }
-     }
-     if (c == '!') {
-         int next = next_char();
-         if (next == '=') {
-             add_token(TOK_NEQ, "!=");
-             return TOK_NEQ;
-         } else {
-             unget_char(next);
-             add_token(TOK_UNKNOWN, "!");
-             return TOK_UNKNOWN;
+ /**
+  * lookup_dict(nombre):
+  *   Índice del diccionario “nombre” en dicts[], o -1 si no hay ninguno.
+  */
+ static int lookup_dict(const char *nombre) {
+     for (int i = 0; i < num_dicts; i++) {
+         if (strcmp(dict_names[i], nombre) == 0) {
+             return i;
          }
      }
-     if (c == '<') {
-         int next = next_char();
-         if (next == '=') {
-             add_token(TOK_LE, "<=");
-             return TOK_LE;
-         } else {
-             unget_char(next);
-             add_token(TOK_LT, "<");
-             return TOK_LT;
-         }
+     return -1;
+ }
+ 
+ /**
+  * add_dict(nombre):
+  *   Da de alta el diccionario (vacío y sin casillas: las reserva la
+  *   primera clave) o, si ya estaba, devuelve el que hay.
+  */
+ static int add_dict(const char *nombre) {
+     int idx = lookup_dict(nombre);
+     if (idx >= 0) {
+         return idx;
      }
-     if (c == '>') {
-         int next = next_char();
-         if (next == '=') {
-             add_token(TOK_GE, ">=");
-             return TOK_GE;
-         } else {
-             unget_char(next);
-             add_token(TOK_GT, ">");
-             return TOK_GT;
-         }
+     if (num_dicts >= MAX_VARS) {
+         fprintf(stderr, "Error: demasiados diccionarios (>= %d).\n", MAX_VARS);
+         exit(1);
      }
+     memset(&dicts[num_dicts], 0, sizeof(Dict));
+     strcpy(dict_names[num_dicts], nombre);
+     return num_dicts++;
+ }
  
-     // 5) Símbolos simples y operadores de un solo carácter
-     switch (c) {
-         case ',':
-             add_token(TOK_COMMA, ",");
-             return TOK_COMMA;
-         case ';':
-             add_token(TOK_SEMI, ";");
-             return TOK_SEMI;
-         case '(':
-             add_token(TOK_LPAREN, "(");
-             return TOK_LPAREN;
-         case ')':
-             add_token(TOK_RPAREN, ")");
-             return TOK_RPAREN;
-         case '{':
-             add_token(TOK_LBRACE, "{");
-             return TOK_LBRACE;
-         case '}':
-             add_token(TOK_RBRACE, "}");
-             return TOK_RBRACE;
-         case '+':
-             add_token(TOK_PLUS, "+");
-             return TOK_PLUS;
-         case '-':
-             add_token(TOK_MINUS, "-");
-             return TOK_MINUS;
-         case '*':
-             add_token(TOK_MULT, "*");
-             return TOK_MULT;
-         case '/':
-             add_token(TOK_DIV, "/");
-             return TOK_DIV;
-         default:
-             // Cualquier otro carácter → TOK_UNKNOWN
-             buffer[0] = (char)c;
-             buffer[1] = '\0';
-             add_token(TOK_UNKNOWN, buffer);
-             return TOK_UNKNOWN;
-     }
+ /**
+  * array_bytes(a):
+  *   Lo que ocupan los elementos del vector a.
+  */
+ static size_t array_bytes(const Array *a) {
+     return (size_t)a->len * (a->type == TYPE_CHAR ? 1 : sizeof(long long));
  }
  
  /**
-  * tokenize_input():
-  *   Lee toda la entrada estándar (stdin) hasta EOF, llamando a yylex()
-  *   repetidamente. Cuando yylex() devuelve TOK_EOF, sale del bucle y
-  *   añade al final un único token TOK_EOF.
+  * array_dim(a, d):
+  *   Hasta dónde llega un índice de a: su tamaño (d = 0) o, en una
+  *   matriz, sus filas (d = 1) o sus columnas (d = 2).
   */
- static void tokenize_input(void) {
-     TokenType t;
-     do {
-         t = yylex();
-     } while (t != TOK_EOF);
-     add_token(TOK_EOF, "EOF");
+ static long long array_dim(const Array *a, int d) {
+     return (d == 0) ? a->len : (d == 1) ? a->len / a->cols : a->cols;
  }
  
+ /**
+  * array_shape(a, buf):
+  *   "[10]" o "[10][20]", para los mensajes de error.
+  */
+ static const char *array_shape(const Array *a, char buf[48]) {
+     if (a->cols == 0) {
+         snprintf(buf, 48, "[%lld]", a->len);
+     } else {
+         snprintf(buf, 48, "[%lld][%lld]", a->len / a->cols, a->cols);
+     }
+     return buf;
+ }
  
- /*==============================================================
-  *                  FUNCIONES AUXILIARES DEL PARSER
-  *=============================================================*/
+ /**
+  * index_error(a):
+  *   Error de un índice fuera del vector a; lo dan igual todos los
+  *   niveles de ejecución.
+  */
+ static void index_error(const Array *a) {
+     fprintf(stderr, "Error: índice fuera del vector '%s'.\n", a->name);
+     exit(1);
+ }
  
  /**
-  * lookahead():
-  *   Devuelve el TokenType de tokens[cur_token], o TOK_EOF si
-  *   cur_token >= num_tokens.
+  * array_bits(a, val):
+  *   val (ya del tipo del vector a) como los bits de un elemento: el
+  *   double de un Flotante, el Entero de 64 bits o el Caracter con
+  *   signo.
   */
- static TokenType lookahead(void) {
-     if (cur_token < num_tokens) {
-         return tokens[cur_token].type;
+ static long long array_bits(const Array *a, Value val) {
+     if (a->type == TYPE_FLOAT) {
+         double    f = val_float(val);
+         long long x;
+         memcpy(&x, &f, sizeof(x));
+         return x;
      }
-     return TOK_EOF;
+     if (val_is_big(val)) {
+         int_overflow();                         // los elementos son de 64 bits
+     }
+     return val_int(val);
  }
  
  /**
-  * match(expected):
-  *   Si lookahead()==expected, avanza cur_token++ (consume el token).
-  *   Si no coincide, imprime un mensaje de error y termina con exit(1).
+  * array_load(a, i) / array_store(a, i, val):
+  *   Elemento i del vector a como Value y al revés (val ya es del
+  *   tipo de a; i ya está dentro).
   */
- static void match(TokenType expected) {
-     if (lookahead() == expected) {
-         cur_token++;
+ static Value array_load(const Array *a, long long i) {
+     if (a->type == TYPE_CHAR) {
+         return val_from_char(((const signed char *)a->data)[i]);
+     }
+     long long x = ((const long long *)a->data)[i];
+     if (a->type == TYPE_FLOAT) {
+         double f;
+         memcpy(&f, &x, sizeof(f));
+         return val_from_float(f);
+     }
+     return val_from_int(x);
+ }
+ 
+ static void array_store(Array *a, long long i, Value val) {
+     if (a->type == TYPE_CHAR) {
+         ((signed char *)a->data)[i] = (signed char)val_int(val);
      } else {
-         fprintf(stderr,
-                 "Error de sintaxis: se esperaba token %d ('%s'), "
-                 "pero vino token %d ('%s').\n",
-                 expected,
-                 tokens[cur_token].lexeme,
-                 lookahead(),
-                 tokens[cur_token].lexeme);
+         ((long long *)a->data)[i] = array_bits(a, val);
+     }
+ }
+ 
+ /*--------------------------------------------------------------
+  * Funciones de vectores: Suma(v), Producto(a, b), Minimo(v),
+  * Maximo(v), Buscar(v, x) y las sentencias Llenar(v, x), Ordenar(v)
+  * (ver vec_sort()), Multiplicar(c, a, b) y Trasponer(t, m) (estas
+  * dos, de matrices: ver mat_mul()). No son palabras reservadas: un
+  * IDENT seguido de '(' solo puede ser una de ellas, así que "suma"
+  * sigue valiendo como nombre de variable.
+  *
+  * Los núcleos de abajo los comparten el intérprete, la VM y el JIT,
+  * así que dan lo mismo en todos los niveles. Cada uno tiene una
+  * versión AVX2, otra SSE4.2 y otra escalar; simd_init() elige al
+  * arrancar la mejor que tiene la CPU (o la de --simd=). El backend
+  * nativo, sin libc ni detección de CPU, llama a bucles escalares
+  * de su runtime (__gama_vsum...).
+  *
+  * Entero: Suma y Producto dan el resultado exacto, da igual en qué
+  * orden se sume. Las versiones SIMD suman por carriles de 64 bits y,
+  * si alguno se desborda (o en Producto algún elemento no cabe en 32
+  * bits, que es lo que multiplica vpmuldq), la cuenta se repite en
+  * escalar: en 64 bits mientras cabe y, si no, en un acumulador de
+  * 192 bits (VecAcc). Si el exacto no cabe en 64 bits es el error de
+  * siempre (o, con --wrap, módulo 2^64).
+  *
+  * Flotante: el orden cambia el redondeo, así que está fijado y es el
+  * mismo en todas las versiones. El carril k empieza con el elemento
+  * k y se queda con k + VEC_LANES, k + 2·VEC_LANES... mientras quedan
+  * VEC_LANES enteros; luego los carriles se juntan por parejas (k con
+  * k + 4, k + 2 y k + 1) y el resto se añade en orden. Minimo y Maximo
+  * igual: con un nan, o con -0.0 frente a 0.0, el orden decide. No se
+  * usa FMA, que redondearía distinto.
+  *-------------------------------------------------------------*/
+ 
+ typedef enum {
+     VEC_SUM,       // Suma(v)
+     VEC_DOT,       // Producto(a, b): suma de a[i] * b[i]
+     VEC_MIN,       // Minimo(v)
+     VEC_MAX,       // Maximo(v)
+     VEC_FIND,      // Buscar(v, x): dónde está x en v ordenado, o -1
+     VEC_FILL,      // Llenar(v, x);         De VEC_FILL en adelante,
+     VEC_SORT,      // Ordenar(v);            sentencias
+     VEC_MATMUL,    // Multiplicar(c, a, b);
+     VEC_TRANSP,    // Trasponer(t, m);
+     VEC_NONE
+ } VecFunc;
+ 
+ static const char *const vec_func_name[] = { "Suma", "Producto", "Minimo", "Maximo", "Buscar",
+                                              "Llenar", "Ordenar", "Multiplicar", "Trasponer" };
+ 
+ #define SIMD_SCALAR 0
+ #define SIMD_SSE42  1
+ #define SIMD_AVX2   2
+ 
+ static const char *const simd_name[] = { "escalar", "SSE4.2", "AVX2" };
+ static int simd_level = SIMD_SCALAR;
+ 
+ #define VEC_LANES   8       // carriles de un Flotante (ver arriba)
+ 
+ /**
+  * func_lookup(nombre, names, n):
+  *   Posición de nombre en names[0..n-1] (sin distinguir mayúsculas,
+  *   como las palabras reservadas), o n si no está.
+  */
+ static int func_lookup(const char *nombre, const char *const *names, int n) {
+     for (int f = 0; f < n; f++) {
+         const char *s = names[f];
+         int k = 0;
+         while (s[k] != '\0' && tolower((unsigned char)nombre[k]) == tolower((unsigned char)s[k])) {
+             k++;
+         }
+         if (s[k] == '\0' && nombre[k] == '\0') {
+             return f;
+         }
+     }
+     return n;
+ }
+ 
+ /**
+  * vec_func(nombre):
+  *   La función de vectores que se llama así, o VEC_NONE.
+  */
+ static VecFunc vec_func(const char *nombre) {
+     return (VecFunc)func_lookup(nombre, vec_func_name, VEC_NONE);
+ }
+ 
+ /**
+  * simd_init(max):
+  *   Elige la versión de los núcleos: la mejor que tiene la CPU sin
+  *   pasar de max.
+  */
+ static void simd_init(int max) {
+     int level = SIMD_SCALAR;
+ #if SIMD_AVAILABLE
+     __builtin_cpu_init();
+     if (__builtin_cpu_supports("avx2")) {
+         level = SIMD_AVX2;
+     } else if (__builtin_cpu_supports("sse4.2")) {
+         level = SIMD_SSE42;
+     }
+ #endif
+     simd_level = (level < max) ? level : max;
+ }
+ 
+ /* Lo que runtime.c pide a quien lo incluye */
+ static void *rt_alloc(long long bytes) {
+     void *p = malloc((size_t)bytes);
+     if (p == NULL) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     return p;
+ }
+ 
+ static void rt_free(void *p, long long bytes) {
+     (void)bytes;
+     free(p);
+ }
+ 
+ static int rt_simd(void) {
+     return simd_level > SIMD_SCALAR;
+ }
+ 
+ /* El valor exacto, como BigInt si hace falta (--bigint) */
+ static Value acc_value(const VecAcc *s) {
+     int neg = ((long long)s->w[2] < 0);
+     unsigned long long m[3] = { s->w[0], s->w[1], s->w[2] };
+     if (neg) {
+         unsigned long long carry = 1;
+         for (int k = 0; k < 3; k++) {
+             m[k]  = ~m[k] + carry;
+             carry = (carry && m[k] == 0);
+         }
+     }
+     unsigned int d[6];
+     for (int k = 0; k < 3; k++) {
+         d[2 * k]     = (unsigned int)m[k];
+         d[2 * k + 1] = (unsigned int)(m[k] >> 32);
+     }
+     return big_make(neg, d, 6);
+ }
+ 
+ #if SIMD_AVAILABLE
+ 
+ /*
+  * Versiones AVX2 y SSE4.2. Cada una recorre los bloques enteros que
+  * le caben y devuelve cuántos elementos se ha quedado (0 si no ha
+  * podido: entonces todo lo hace la escalar); lo que sobra lo acaba
+  * vec_reduce() en escalar.
+  */
+ 
+ /* Suma de Entero por carriles: 0 si alguno se desborda */
+ __attribute__((target("avx2")))
+ static long long sum_int_avx2(const long long *x, long long n, long long *lane) {
+     __m256i s0 = _mm256_setzero_si256(), s1 = s0, o = s0;
+     long long i = 0;
+     for (; i + 8 <= n; i += 8) {
+         __m256i a  = _mm256_loadu_si256((const __m256i *)(x + i));
+         __m256i b  = _mm256_loadu_si256((const __m256i *)(x + i + 4));
+         __m256i t0 = _mm256_add_epi64(s0, a);
+         __m256i t1 = _mm256_add_epi64(s1, b);
+         // Se desborda si los dos sumandos tienen un signo y el resultado otro
+         o  = _mm256_or_si256(o, _mm256_and_si256(_mm256_xor_si256(s0, t0), _mm256_xor_si256(a, t0)));
+         o  = _mm256_or_si256(o, _mm256_and_si256(_mm256_xor_si256(s1, t1), _mm256_xor_si256(b, t1)));
+         s0 = t0;
+         s1 = t1;
+     }
+     if (_mm256_movemask_pd(_mm256_castsi256_pd(o)) != 0) {
+         return 0;
+     }
+     _mm256_storeu_si256((__m256i *)lane, s0);
+     _mm256_storeu_si256((__m256i *)(lane + 4), s1);
+     return i;
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static long long sum_int_sse(const long long *x, long long n, long long *lane) {
+     __m128i s0 = _mm_setzero_si128(), s1 = s0, o = s0;
+     long long i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m128i a  = _mm_loadu_si128((const __m128i *)(x + i));
+         __m128i b  = _mm_loadu_si128((const __m128i *)(x + i + 2));
+         __m128i t0 = _mm_add_epi64(s0, a);
+         __m128i t1 = _mm_add_epi64(s1, b);
+         o  = _mm_or_si128(o, _mm_and_si128(_mm_xor_si128(s0, t0), _mm_xor_si128(a, t0)));
+         o  = _mm_or_si128(o, _mm_and_si128(_mm_xor_si128(s1, t1), _mm_xor_si128(b, t1)));
+         s0 = t0;
+         s1 = t1;
+     }
+     if (_mm_movemask_pd(_mm_castsi128_pd(o)) != 0) {
+         return 0;
+     }
+     _mm_storeu_si128((__m128i *)lane, s0);
+     _mm_storeu_si128((__m128i *)(lane + 2), s1);
+     return i;
+ }
+ 
+ /* Producto de Entero con vpmuldq: 0 si algún elemento no cabe en 32
+    bits o algún carril se desborda */
+ __attribute__((target("avx2")))
+ static long long dot_int_avx2(const long long *x, const long long *y, long long n,
+                               long long *lane) {
+     const __m256i bias = _mm256_set1_epi64x(0x80000000LL);
+     const __m256i high = _mm256_set1_epi64x((long long)0xFFFFFFFF00000000ULL);
+     __m256i s = _mm256_setzero_si256(), o = s, wide = s;
+     long long i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+         __m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+         // x cabe en 32 bits con signo si x + 2^31 no pasa de los 32 bajos
+         wide = _mm256_or_si256(wide, _mm256_or_si256(_mm256_add_epi64(a, bias),
+                                                      _mm256_add_epi64(b, bias)));
+         __m256i p = _mm256_mul_epi32(a, b);
+         __m256i t = _mm256_add_epi64(s, p);
+         o = _mm256_or_si256(o, _mm256_and_si256(_mm256_xor_si256(s, t), _mm256_xor_si256(p, t)));
+         s = t;
+     }
+     if (!_mm256_testz_si256(wide, high) || _mm256_movemask_pd(_mm256_castsi256_pd(o)) != 0) {
+         return 0;
+     }
+     _mm256_storeu_si256((__m256i *)lane, s);
+     return i;
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static long long dot_int_sse(const long long *x, const long long *y, long long n,
+                              long long *lane) {
+     const __m128i bias = _mm_set1_epi64x(0x80000000LL);
+     const __m128i high = _mm_set1_epi64x((long long)0xFFFFFFFF00000000ULL);
+     __m128i s = _mm_setzero_si128(), o = s, wide = s;
+     long long i = 0;
+     for (; i + 2 <= n; i += 2) {
+         __m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+         __m128i b = _mm_loadu_si128((const __m128i *)(y + i));
+         wide = _mm_or_si128(wide, _mm_or_si128(_mm_add_epi64(a, bias), _mm_add_epi64(b, bias)));
+         __m128i p = _mm_mul_epi32(a, b);
+         __m128i t = _mm_add_epi64(s, p);
+         o = _mm_or_si128(o, _mm_and_si128(_mm_xor_si128(s, t), _mm_xor_si128(p, t)));
+         s = t;
+     }
+     if (!_mm_testz_si128(wide, high) || _mm_movemask_pd(_mm_castsi128_pd(o)) != 0) {
+         return 0;
+     }
+     _mm_storeu_si128((__m128i *)lane, s);
+     return i;
+ }
+ 
+ /* Mínimo (o máximo) de Entero por carriles; *r el de los carriles */
+ __attribute__((target("avx2")))
+ static long long minmax_int_avx2(const long long *x, long long n, int max, long long *r) {
+     if (n < 8) {
+         return 0;
+     }
+     __m256i m0 = _mm256_loadu_si256((const __m256i *)x);
+     __m256i m1 = _mm256_loadu_si256((const __m256i *)(x + 4));
+     long long i = 8;
+     for (; i + 8 <= n; i += 8) {
+         __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+         __m256i b = _mm256_loadu_si256((const __m256i *)(x + i + 4));
+         m0 = _mm256_blendv_epi8(m0, a, max ? _mm256_cmpgt_epi64(a, m0) : _mm256_cmpgt_epi64(m0, a));
+         m1 = _mm256_blendv_epi8(m1, b, max ? _mm256_cmpgt_epi64(b, m1) : _mm256_cmpgt_epi64(m1, b));
+     }
+     m0 = _mm256_blendv_epi8(m0, m1, max ? _mm256_cmpgt_epi64(m1, m0) : _mm256_cmpgt_epi64(m0, m1));
+     long long lane[4];
+     _mm256_storeu_si256((__m256i *)lane, m0);
+     *r = lane[0];
+     for (int k = 1; k < 4; k++) {
+         *r = (max ? lane[k] > *r : lane[k] < *r) ? lane[k] : *r;
+     }
+     return i;
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static long long minmax_int_sse(const long long *x, long long n, int max, long long *r) {
+     if (n < 4) {
+         return 0;
+     }
+     __m128i m0 = _mm_loadu_si128((const __m128i *)x);
+     __m128i m1 = _mm_loadu_si128((const __m128i *)(x + 2));
+     long long i = 4;
+     for (; i + 4 <= n; i += 4) {
+         __m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+         __m128i b = _mm_loadu_si128((const __m128i *)(x + i + 2));
+         m0 = _mm_blendv_epi8(m0, a, max ? _mm_cmpgt_epi64(a, m0) : _mm_cmpgt_epi64(m0, a));
+         m1 = _mm_blendv_epi8(m1, b, max ? _mm_cmpgt_epi64(b, m1) : _mm_cmpgt_epi64(m1, b));
+     }
+     m0 = _mm_blendv_epi8(m0, m1, max ? _mm_cmpgt_epi64(m1, m0) : _mm_cmpgt_epi64(m0, m1));
+     long long lane[2];
+     _mm_storeu_si128((__m128i *)lane, m0);
+     *r = (max ? lane[1] > lane[0] : lane[1] < lane[0]) ? lane[1] : lane[0];
+     return i;
+ }
+ 
+ /* Suma de Caracter: psadbw suma bytes sin signo, así que se les da
+    la vuelta al bit de signo (x + 128) y se resta después */
+ __attribute__((target("avx2")))
+ static long long sum_char_avx2(const signed char *x, long long n, long long *r) {
+     const __m256i flip = _mm256_set1_epi8((char)0x80);
+     __m256i s = _mm256_setzero_si256();
+     long long i = 0;
+     for (; i + 32 <= n; i += 32) {
+         __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(x + i)), flip);
+         s = _mm256_add_epi64(s, _mm256_sad_epu8(a, _mm256_setzero_si256()));
+     }
+     long long lane[4];
+     _mm256_storeu_si256((__m256i *)lane, s);
+     *r = lane[0] + lane[1] + lane[2] + lane[3] - 128 * i;
+     return i;
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static long long sum_char_sse(const signed char *x, long long n, long long *r) {
+     const __m128i flip = _mm_set1_epi8((char)0x80);
+     __m128i s = _mm_setzero_si128();
+     long long i = 0;
+     for (; i + 16 <= n; i += 16) {
+         __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(x + i)), flip);
+         s = _mm_add_epi64(s, _mm_sad_epu8(a, _mm_setzero_si128()));
+     }
+     long long lane[2];
+     _mm_storeu_si128((__m128i *)lane, s);
+     *r = lane[0] + lane[1] - 128 * i;
+     return i;
+ }
+ 
+ /* Producto de Caracter: a 16 bits, pmaddwd (pares de productos en 32
+    bits) y a 64 bits para acumular */
+ __attribute__((target("avx2")))
+ static long long dot_char_avx2(const signed char *x, const signed char *y, long long n,
+                                long long *r) {
+     __m256i s = _mm256_setzero_si256();
+     long long i = 0;
+     for (; i + 16 <= n; i += 16) {
+         __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(x + i)));
+         __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(y + i)));
+         __m256i p = _mm256_madd_epi16(a, b);
+         s = _mm256_add_epi64(s, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p)));
+         s = _mm256_add_epi64(s, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1)));
+     }
+     long long lane[4];
+     _mm256_storeu_si256((__m256i *)lane, s);
+     *r = lane[0] + lane[1] + lane[2] + lane[3];
+     return i;
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static long long dot_char_sse(const signed char *x, const signed char *y, long long n,
+                               long long *r) {
+     __m128i s = _mm_setzero_si128();
+     long long i = 0;
+     for (; i + 8 <= n; i += 8) {
+         __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(x + i)));
+         __m128i b = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(y + i)));
+         __m128i p = _mm_madd_epi16(a, b);
+         s = _mm_add_epi64(s, _mm_cvtepi32_epi64(p));
+         s = _mm_add_epi64(s, _mm_cvtepi32_epi64(_mm_srli_si128(p, 8)));
+     }
+     long long lane[2];
+     _mm_storeu_si128((__m128i *)lane, s);
+     *r = lane[0] + lane[1];
+     return i;
+ }
+ 
+ /* Mínimo (o máximo) de Caracter */
+ __attribute__((target("avx2")))
+ static long long minmax_char_avx2(const signed char *x, long long n, int max, long long *r) {
+     if (n < 32) {
+         return 0;
+     }
+     __m256i m = _mm256_loadu_si256((const __m256i *)x);
+     long long i = 32;
+     for (; i + 32 <= n; i += 32) {
+         __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+         m = max ? _mm256_max_epi8(m, a) : _mm256_min_epi8(m, a);
+     }
+     signed char lane[32];
+     _mm256_storeu_si256((__m256i *)lane, m);
+     *r = lane[0];
+     for (int k = 1; k < 32; k++) {
+         *r = (max ? lane[k] > *r : lane[k] < *r) ? lane[k] : *r;
+     }
+     return i;
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static long long minmax_char_sse(const signed char *x, long long n, int max, long long *r) {
+     if (n < 16) {
+         return 0;
+     }
+     __m128i m = _mm_loadu_si128((const __m128i *)x);
+     long long i = 16;
+     for (; i + 16 <= n; i += 16) {
+         __m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+         m = max ? _mm_max_epi8(m, a) : _mm_min_epi8(m, a);
+     }
+     signed char lane[16];
+     _mm_storeu_si128((__m128i *)lane, m);
+     *r = lane[0];
+     for (int k = 1; k < 16; k++) {
+         *r = (max ? lane[k] > *r : lane[k] < *r) ? lane[k] : *r;
+     }
+     return i;
+ }
+ 
+ /* Flotante: los VEC_LANES carriles sobre los n8 primeros elementos
+    (n8 múltiplo de VEC_LANES y >= VEC_LANES); y, si no es NULL, los
+    multiplica antes por y. minpd a, m es a < m ? a : m, justo lo que
+    hace float_step() */
+ __attribute__((target("avx2")))
+ static void lanes_float_avx2(const double *x, const double *y, long long n8, VecFunc f,
+                              double *lane) {
+     __m256d l0 = _mm256_loadu_pd(x), l1 = _mm256_loadu_pd(x + 4);
+     if (y != NULL) {
+         l0 = _mm256_mul_pd(l0, _mm256_loadu_pd(y));
+         l1 = _mm256_mul_pd(l1, _mm256_loadu_pd(y + 4));
+     }
+     for (long long i = VEC_LANES; i < n8; i += VEC_LANES) {
+         __m256d a = _mm256_loadu_pd(x + i), b = _mm256_loadu_pd(x + i + 4);
+         if (y != NULL) {
+             a = _mm256_mul_pd(a, _mm256_loadu_pd(y + i));
+             b = _mm256_mul_pd(b, _mm256_loadu_pd(y + i + 4));
+         }
+         if (f == VEC_MIN) {
+             l0 = _mm256_min_pd(a, l0);
+             l1 = _mm256_min_pd(b, l1);
+         } else if (f == VEC_MAX) {
+             l0 = _mm256_max_pd(a, l0);
+             l1 = _mm256_max_pd(b, l1);
+         } else {
+             l0 = _mm256_add_pd(l0, a);
+             l1 = _mm256_add_pd(l1, b);
+         }
+     }
+     _mm256_storeu_pd(lane, l0);
+     _mm256_storeu_pd(lane + 4, l1);
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static void lanes_float_sse(const double *x, const double *y, long long n8, VecFunc f,
+                             double *lane) {
+     __m128d l[4];
+     for (int k = 0; k < 4; k++) {
+         l[k] = _mm_loadu_pd(x + 2 * k);
+         if (y != NULL) {
+             l[k] = _mm_mul_pd(l[k], _mm_loadu_pd(y + 2 * k));
+         }
+     }
+     for (long long i = VEC_LANES; i < n8; i += VEC_LANES) {
+         for (int k = 0; k < 4; k++) {
+             __m128d a = _mm_loadu_pd(x + i + 2 * k);
+             if (y != NULL) {
+                 a = _mm_mul_pd(a, _mm_loadu_pd(y + i + 2 * k));
+             }
+             l[k] = (f == VEC_MIN) ? _mm_min_pd(a, l[k])
+                  : (f == VEC_MAX) ? _mm_max_pd(a, l[k]) : _mm_add_pd(l[k], a);
+         }
+     }
+     for (int k = 0; k < 4; k++) {
+         _mm_storeu_pd(lane + 2 * k, l[k]);
+     }
+ }
+ 
+ /* Llenar un vector de 8 bytes con x */
+ __attribute__((target("avx2")))
+ static void fill_avx2(long long *d, long long n, long long x) {
+     __m256i v = _mm256_set1_epi64x(x);
+     long long i = 0;
+     for (; i + 4 <= n; i += 4) {
+         _mm256_storeu_si256((__m256i *)(d + i), v);
+     }
+     for (; i < n; i++) {
+         d[i] = x;
+     }
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static void fill_sse(long long *d, long long n, long long x) {
+     __m128i v = _mm_set1_epi64x(x);
+     long long i = 0;
+     for (; i + 2 <= n; i += 2) {
+         _mm_storeu_si128((__m128i *)(d + i), v);
+     }
+     for (; i < n; i++) {
+         d[i] = x;
+     }
+ }
+ 
+ #endif
+ 
+ /* Un paso de Suma (o Producto), Minimo o Maximo de Flotante, en el
+    orden que siguen también minpd/maxpd y addpd */
+ static double float_step(VecFunc f, double m, double x) {
+     return (f == VEC_MIN) ? ((x < m) ? x : m)
+          : (f == VEC_MAX) ? ((x > m) ? x : m) : m + x;
+ }
+ 
+ /**
+  * reduce_float(f, x, y, n):
+  *   Suma (f = VEC_SUM, o VEC_DOT con y), Minimo o Maximo de los n
+  *   elementos Flotante de x, en el orden fijado arriba.
+  */
+ static double reduce_float(VecFunc f, const double *x, const double *y, long long n) {
+     VecFunc   g  = (f == VEC_DOT) ? VEC_SUM : f;
+     long long n8 = n - n % VEC_LANES;
+     long long i  = 1;
+     double    r  = (y != NULL) ? x[0] * y[0] : x[0];
+     if (n8 > 0) {
+         double lane[VEC_LANES];
+         if (simd_level == SIMD_SCALAR) {
+             for (int k = 0; k < VEC_LANES; k++) {
+                 lane[k] = (y != NULL) ? x[k] * y[k] : x[k];
+             }
+             for (long long j = VEC_LANES; j < n8; j += VEC_LANES) {
+                 for (int k = 0; k < VEC_LANES; k++) {
+                     lane[k] = float_step(g, lane[k], (y != NULL) ? x[j + k] * y[j + k] : x[j + k]);
+                 }
+             }
+         }
+ #if SIMD_AVAILABLE
+         else if (simd_level == SIMD_AVX2) {
+             lanes_float_avx2(x, y, n8, g, lane);
+         } else {
+             lanes_float_sse(x, y, n8, g, lane);
+         }
+ #endif
+         for (int w = VEC_LANES / 2; w > 0; w /= 2) {
+             for (int k = 0; k < w; k++) {
+                 lane[k] = float_step(g, lane[k], lane[k + w]);
+             }
+         }
+         r = lane[0];
+         i = n8;
+     }
+     for (; i < n; i++) {
+         r = float_step(g, r, (y != NULL) ? x[i] * y[i] : x[i]);
+     }
+     return r;
+ }
+ 
+ /**
+  * vec_reduce(f, a, b, ovf):
+  *   Suma, Producto (con b), Minimo o Maximo del vector a, en los bits
+  *   de un registro de la VM: un double si a es Flotante. Suma y
+  *   Producto de Entero dejan *ovf = 1 si el exacto no cabe en 64
+  *   bits (y devuelven el resultado módulo 2^64).
+  */
+ static long long vec_reduce(VecFunc f, const Array *a, const Array *b, int *ovf) {
+     long long n = a->len, i = 0, r = 0;
+     *ovf = 0;
+     if (a->type == TYPE_FLOAT) {
+         double x = reduce_float(f, (const double *)a->data,
+                                 f == VEC_DOT ? (const double *)b->data : NULL, n);
+         memcpy(&r, &x, sizeof(r));
+         return r;
+     }
+     if (a->type == TYPE_CHAR) {
+         const signed char *x = (const signed char *)a->data;
+         const signed char *y = (f == VEC_DOT) ? (const signed char *)b->data : NULL;
+ #if SIMD_AVAILABLE
+         if (simd_level == SIMD_AVX2) {
+             i = (f == VEC_SUM) ? sum_char_avx2(x, n, &r)
+               : (f == VEC_DOT) ? dot_char_avx2(x, y, n, &r)
+                                : minmax_char_avx2(x, n, f == VEC_MAX, &r);
+         } else if (simd_level == SIMD_SSE42) {
+             i = (f == VEC_SUM) ? sum_char_sse(x, n, &r)
+               : (f == VEC_DOT) ? dot_char_sse(x, y, n, &r)
+                                : minmax_char_sse(x, n, f == VEC_MAX, &r);
+         }
+ #endif
+         if (i == 0 && (f == VEC_MIN || f == VEC_MAX)) {
+             r = x[i++];
+         }
+         for (; i < n; i++) {                    // en 64 bits no se desborda
+             r = (f == VEC_SUM) ? r + x[i]
+               : (f == VEC_DOT) ? r + x[i] * y[i]
+               : (f == VEC_MAX) ? (x[i] > r ? x[i] : r) : (x[i] < r ? x[i] : r);
+         }
+         return r;
+     }
+ 
+     const long long *x = (const long long *)a->data;
+     const long long *y = (f == VEC_DOT) ? (const long long *)b->data : NULL;
+     if (f == VEC_MIN || f == VEC_MAX) {
+ #if SIMD_AVAILABLE
+         if (simd_level == SIMD_AVX2) {
+             i = minmax_int_avx2(x, n, f == VEC_MAX, &r);
+         } else if (simd_level == SIMD_SSE42) {
+             i = minmax_int_sse(x, n, f == VEC_MAX, &r);
+         }
+ #endif
+         if (i == 0) {
+             r = x[i++];
+         }
+         for (; i < n; i++) {
+             r = (f == VEC_MAX) ? (x[i] > r ? x[i] : r) : (x[i] < r ? x[i] : r);
+         }
+         return r;
+     }
+     long long lane[VEC_LANES] = { 0 };
+     VecAcc    s = { { 0, 0, 0 } };
+ #if SIMD_AVAILABLE
+     if (simd_level == SIMD_AVX2) {
+         i = (f == VEC_SUM) ? sum_int_avx2(x, n, lane) : dot_int_avx2(x, y, n, lane);
+     } else if (simd_level == SIMD_SSE42) {
+         i = (f == VEC_SUM) ? sum_int_sse(x, n, lane) : dot_int_sse(x, y, n, lane);
+     }
+ #endif
+     for (int k = 0; k < VEC_LANES; k++) {
+         acc_add_int(&s, lane[k]);
+     }
+     long long t = 0;                            // el resto, en 64 bits mientras quepa
+     for (; i < n; i++) {
+         long long p;
+         if (f == VEC_SUM ? !__builtin_add_overflow(t, x[i], &p)
+                          : !__builtin_mul_overflow(x[i], y[i], &p) &&
+                            !__builtin_add_overflow(t, p, &p)) {
+             t = p;
+             continue;
+         }
+         acc_add_int(&s, t);
+         t = 0;
+         if (f == VEC_SUM) {
+             acc_add_int(&s, x[i]);
+         } else {
+             acc_add_mul(&s, x[i], y[i]);
+         }
+     }
+     acc_add_int(&s, t);
+     return acc_result(&s, ovf);
+ }
+ 
+ /**
+  * vec_exact(f, a, b):
+  *   Suma o Producto de Entero que no cabe en 64 bits, como BigInt
+  *   (--bigint; se cuenta otra vez, en escalar).
+  */
+ static Value vec_exact(VecFunc f, const Array *a, const Array *b) {
+     const long long *x = (const long long *)a->data;
+     VecAcc s = { { 0, 0, 0 } };
+     for (long long i = 0; i < a->len; i++) {
+         if (f == VEC_SUM) {
+             acc_add_int(&s, x[i]);
+         } else {
+             acc_add_mul(&s, x[i], ((const long long *)b->data)[i]);
+         }
+     }
+     return acc_value(&s);
+ }
+ 
+ /**
+  * vec_value(f, a, b):
+  *   vec_reduce() como Value para el intérprete: Minimo y Maximo de un
+  *   Caracter son Caracter y, con --bigint, una Suma o un Producto que
+  *   no cabe en 64 bits es un BigInt.
+  */
+ static Value vec_value(VecFunc f, const Array *a, const Array *b) {
+     int       ovf;
+     long long r = vec_reduce(f, a, b, &ovf);
+     if (a->type == TYPE_FLOAT) {
+         double x;
+         memcpy(&x, &r, sizeof(x));
+         return val_from_float(x);
+     }
+     if (a->type == TYPE_CHAR && (f == VEC_MIN || f == VEC_MAX)) {
+         return val_from_char((int)r);
+     }
+     if (ovf && !int_wrap) {
+         if (!int_big) {
+             int_overflow();
+         }
+         return vec_exact(f, a, b);
+     }
+     return val_from_int(r);
+ }
+ 
+ /**
+  * vec_fill(a, x):
+  *   Pone todos los elementos del vector a a x (los bits de un
+  *   elemento: ver array_bits()).
+  */
+ static void vec_fill(Array *a, long long x) {
+     if (a->type == TYPE_CHAR || x == 0) {
+         memset(a->data, (int)(x & 0xFF), array_bytes(a));
+         return;
+     }
+     long long *d = (long long *)a->data;
+ #if SIMD_AVAILABLE
+     if (simd_level == SIMD_AVX2) {
+         fill_avx2(d, a->len, x);
+         return;
+     }
+     if (simd_level == SIMD_SSE42) {
+         fill_sse(d, a->len, x);
+         return;
+     }
+ #endif
+     for (long long i = 0; i < a->len; i++) {
+         d[i] = x;
+     }
+ }
+ 
+ /*--------------------------------------------------------------
+  * Multiplicar(c, a, b); y Trasponer(t, m);: los núcleos por bloques
+  * son los de runtime.c (mat_mul_rows(), mat_transpose_cells()), que
+  * son también los del nativo. Aquí está la fila de Flotante, con
+  * AVX2 o SSE4.2, que el nativo no necesita.
+  *-------------------------------------------------------------*/
+ 
+ #if SIMD_AVAILABLE
+ 
+ /* c[j] += x * b[j] para j < n, en Flotante */
+ __attribute__((target("avx2")))
+ static void axpy_float_avx2(double *c, double x, const double *b, long long n) {
+     __m256d v = _mm256_set1_pd(x);
+     long long j = 0;
+     for (; j + 8 <= n; j += 8) {
+         __m256d c0 = _mm256_add_pd(_mm256_loadu_pd(c + j),
+                                    _mm256_mul_pd(v, _mm256_loadu_pd(b + j)));
+         __m256d c1 = _mm256_add_pd(_mm256_loadu_pd(c + j + 4),
+                                    _mm256_mul_pd(v, _mm256_loadu_pd(b + j + 4)));
+         _mm256_storeu_pd(c + j, c0);
+         _mm256_storeu_pd(c + j + 4, c1);
+     }
+     for (; j < n; j++) {
+         c[j] += x * b[j];
+     }
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static void axpy_float_sse(double *c, double x, const double *b, long long n) {
+     __m128d v = _mm_set1_pd(x);
+     long long j = 0;
+     for (; j + 4 <= n; j += 4) {
+         __m128d c0 = _mm_add_pd(_mm_loadu_pd(c + j), _mm_mul_pd(v, _mm_loadu_pd(b + j)));
+         __m128d c1 = _mm_add_pd(_mm_loadu_pd(c + j + 2), _mm_mul_pd(v, _mm_loadu_pd(b + j + 2)));
+         _mm_storeu_pd(c + j, c0);
+         _mm_storeu_pd(c + j + 2, c1);
+     }
+     for (; j < n; j++) {
+         c[j] += x * b[j];
+     }
+ }
+ 
+ #endif
+ 
+ /* c[j] += x * b[j] para j < n, con x y c de Flotante (sus bits) */
+ static int mat_row_float(long long *c, long long x, const long long *b, long long n) {
+     double *cf = (double *)c, xf;
+     const double *bf = (const double *)b;
+     memcpy(&xf, &x, sizeof(xf));
+ #if SIMD_AVAILABLE
+     if (simd_level == SIMD_AVX2) {
+         axpy_float_avx2(cf, xf, bf, n);
+         return 0;
+     }
+     if (simd_level == SIMD_SSE42) {
+         axpy_float_sse(cf, xf, bf, n);
+         return 0;
+     }
+ #endif
+     for (long long j = 0; j < n; j++) {
+         cf[j] += xf * bf[j];
+     }
+     return 0;
+ }
+ 
+ /**
+  * mat_mul(c, a, b):
+  *   Multiplicar(c, a, b): c = a × b (el compilador ya comprobó tipos
+  *   y dimensiones y que c no es ni a ni b). Devuelve 1 si algún
+  *   elemento Entero no cabe en 64 bits (sin --wrap; c se queda con
+  *   el resultado módulo 2^64).
+  */
+ static int mat_mul(Array *c, const Array *a, const Array *b) {
+     MatRow row = (a->type == TYPE_FLOAT) ? mat_row_float
+                : int_wrap                ? mat_row_wrap : mat_row_checked;
+     return mat_mul_rows((long long *)c->data, (const long long *)a->data,
+                         (const long long *)b->data, a->len / a->cols, a->cols, b->cols, row);
+ }
+ 
+ /**
+  * mat_transpose(t, a):
+  *   Trasponer(t, a): t[j][i] = a[i][j], por baldosas.
+  */
+ static void mat_transpose(Array *t, const Array *a) {
+     mat_transpose_cells(t->data, a->data, a->len / a->cols, a->cols,
+                         (a->type == TYPE_CHAR) ? 1 : 8);
+ }
+ 
+ /*--------------------------------------------------------------
+  * Ordenar(v); y Buscar(v, x): radix y búsqueda binaria sin saltos,
+  * de runtime.c (sort_ints(), find_int()...).
+  *-------------------------------------------------------------*/
+ 
+ /**
+  * vec_sort(a):
+  *   Ordenar(a): el vector a de menor a mayor (Entero o Caracter), en
+  *   su sitio. Ver sort_ints() en runtime.c.
+  */
+ static void vec_sort(Array *a) {
+     if (a->type == TYPE_CHAR) {
+         sort_chars((signed char *)a->data, a->len);
+     } else {
+         sort_ints((long long *)a->data, a->len);
+     }
+ }
+ 
+ /**
+  * vec_find(a, x):
+  *   Buscar(a, x): la posición del primer elemento igual a x del
+  *   vector ordenado a, o -1 si no hay ninguno.
+  */
+ static long long vec_find(const Array *a, long long x) {
+     if (a->type == TYPE_CHAR) {
+         return find_char((const signed char *)a->data, a->len, x);
+     }
+     return find_int((const long long *)a->data, a->len, x);
+ }
+ 
+ /*--------------------------------------------------------------
+  * Diccionarios: la tabla hash (Dict, dict_slot()...) es la de
+  * runtime.c; aquí van las funciones del lenguaje y el error de
+  * Claves, que lleva los nombres.
+  *-------------------------------------------------------------*/
+ 
+ typedef enum {
+     DICT_HAS,      // Contiene(d, k): 1 si k es una clave de d
+     DICT_LEN,      // Tamano(d): cuántas claves tiene
+     DICT_DEL,      // Borrar(d, k);     De DICT_DEL en adelante,
+     DICT_KEYS,     // Claves(v, d);      sentencias
+     DICT_NONE
+ } DictFunc;
+ 
+ static const char *const dict_func_name[] = { "Contiene", "Tamano", "Borrar", "Claves" };
+ 
+ /**
+  * dict_func(nombre):
+  *   La función de diccionarios que se llama así, o DICT_NONE.
+  */
+ static DictFunc dict_func(const char *nombre) {
+     return (DictFunc)func_lookup(nombre, dict_func_name, DICT_NONE);
+ }
+ 
+ /**
+  * dict_keys(a, d):
+  *   Claves(v, d);: las claves de d en a[0], a[1]... (ver
+  *   dict_copy_keys() en runtime.c). Es un error que no quepan todas.
+  */
+ static void dict_keys(Array *a, const Dict *d) {
+     if (d->len > a->len) {
+         fprintf(stderr, "Error: las %lld claves de '%s' no caben en el vector '%s'.\n",
+                 d->len, dict_names[d - dicts], a->name);
          exit(1);
      }
+     dict_copy_keys((long long *)a->data, d);
+ }
+ 
+ 
+ /*==============================================================
+  *                      ANALIZADOR LÉXICO
+  *=============================================================*/
+ 
+ /**
+  * next_char():
+  *   Lee un carácter de la fuente (src). Devuelve EOF si ya no hay nada.
+  */
+ static int next_char(void) {
+     int c = getc(src);
+     if (c == '\n') {
+         src_line++;
+     }
+     return (c == EOF ? EOF : c);
+ }
+ 
+ /**
+  * unget_char(c):
+  *   “Devuelve” c al flujo de entrada, para que next_char lo lea de nuevo.
+  */
+ static void unget_char(int c) {
+     if (c != EOF) {
+         if (c == '\n') {
+             src_line--;
+         }
+         ungetc(c, src);
+     }
+ }
+ 
+ /**
+  * add_token(type, lexe):
+  *   Agrega al arreglo “tokens” un nuevo token con tipo “type” y texto “lexe”.
+  */
+ static void add_token(TokenType type, const char *lexe) {
+     if (num_tokens >= MAX_TOKENS) {
+         fprintf(stderr, "Error: demasiados tokens (>= %d).\n", MAX_TOKENS);
+         exit(1);
+     }
+     tokens[num_tokens].type = type;
+     strncpy(tokens[num_tokens].lexeme, lexe, MAX_LEXEME_LEN - 1);
+     tokens[num_tokens].lexeme[MAX_LEXEME_LEN - 1] = '\0';
+     tokens[num_tokens].line = src_line;
+     num_tokens++;
+ }
+ 
+ /**
+  * yylex():
+  *   Reconoce un solo token de la entrada estándar y lo añade a tokens[].
+  *   Retorna el TokenType. Espacios/tab/newline se saltan:
+  *    - Palabra que empieza con letra    → IDENT o palabra reservada
+  *    - Secuencia de dígitos             → NUM (REAL si lleva un '.')
+  *    - 'c' (o '\n', '\t', '\\', '\'')   → CHARLIT
+  *    - “==”, “!=”, “<=”, “>=”            → TOK_EQ/TOK_NEQ/TOK_LE/TOK_GE
+  *    - ‘<’, ‘>’, ‘=’ (asign.)           → TOK_LT/TOK_GT/TOK_ASSIGN
+  *    - Símbolos simples: ',', ';', '(', ')', '{', '}' 
+  *    - Operadores: '+', '-', '*', '/'
+  *    - EOF → TOK_EOF
+  *    - Cualquier otro → TOK_UNKNOWN
+  */
+ static TokenType yylex(void) {
+     int c;
+     char buffer[MAX_LEXEME_LEN];
+     int len;
+ 
+     // 1) Saltar espacios en blanco y newline
+     do {
+         c = next_char();
+     } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+ 
+     if (c == EOF) {
+         return TOK_EOF;
+     }
+ 
+     // 2) Si comienza con letra → identificador o palabra reservada
+     if (isalpha(c)) {
+         len = 0;
+         do {
+             if (len < MAX_LEXEME_LEN - 1) {
+                 buffer[len++] = (char)c;
+             }
+             c = next_char();
+         } while (isalpha(c) || isdigit(c));
+         buffer[len] = '\0';
+         unget_char(c);
+ 
+         // Creamos una copia en minúsculas para comparar sin distinción de mayúsculas/minúsculas
+         char tmp[MAX_LEXEME_LEN];
+         for (int i = 0; buffer[i]; i++) {
+             tmp[i] = tolower((unsigned char)buffer[i]);
+         }
+         tmp[len] = '\0';
+ 
+         // Verificamos si es una palabra reservada en español
+         if (strcmp(tmp, "entero") == 0) {
+             add_token(TOK_INT, buffer);
+             return TOK_INT;
+         }
+         if (strcmp(tmp, "caracter") == 0) {
+             add_token(TOK_CHAR, buffer);
+             return TOK_CHAR;
+         }
+         if (strcmp(tmp, "flotante") == 0) {
+             add_token(TOK_FLOAT, buffer);
+             return TOK_FLOAT;
+         }
+         if (strcmp(tmp, "imprimir") == 0) {
+             add_token(TOK_PRINT, buffer);
+             return TOK_PRINT;
+         }
+         if (strcmp(tmp, "leer") == 0) {
+             add_token(TOK_READ, buffer);
+             return TOK_READ;
+         }
+         if (strcmp(tmp, "si") == 0) {
+             add_token(TOK_IF, buffer);
+             return TOK_IF;
+         }
+         if (strcmp(tmp, "sino") == 0) {
+             add_token(TOK_ELSE, buffer);
+             return TOK_ELSE;
+         }
+         if (strcmp(tmp, "mientras") == 0) {
+             add_token(TOK_WHILE, buffer);
+             return TOK_WHILE;
+         }
+         if (strcmp(tmp, "diccionario") == 0) {
+             add_token(TOK_DICT, buffer);
+             return TOK_DICT;
+         }
+         // Si no es palabra reservada, es un IDENT
+         add_token(TOK_IDENT, buffer);
+         return TOK_IDENT;
+     }
+ 
+     // 3) Si comienza con dígito → NUM, o REAL si lleva '.'
+     if (isdigit(c)) {
+         TokenType type = TOK_NUM;
+         len = 0;
+         do {
+             if (len < MAX_LEXEME_LEN - 1) {
+                 buffer[len++] = (char)c;
+             }
+             c = next_char();
+             if (c == '.' && type == TOK_NUM) {
+                 type = TOK_REAL;
+                 if (len < MAX_LEXEME_LEN - 1) {
+                     buffer[len++] = (char)c;
+                 }
+                 c = next_char();
+             }
+         } while (isdigit(c));
+         buffer[len] = '\0';
+         unget_char(c);
+ 
+         // Un literal Entero tiene que caber en 64 bits
+         if (type == TOK_NUM) {
+             errno = 0;
+             strtoll(buffer, NULL, 10);
+             if (errno == ERANGE || len == MAX_LEXEME_LEN - 1) {
+                 fprintf(stderr, "Error (línea %d): el número %s no cabe en un Entero.\n",
+                         src_line, buffer);
+                 exit(1);
+             }
+         }
+         add_token(type, buffer);
+         return type;
+     }
+ 
+     // 3b) Carácter entre comillas simples → CHARLIT (lexema con las
+     //     comillas; su valor lo da char_literal())
+     if (c == '\'') {
+         len = 0;
+         buffer[len++] = (char)c;
+         c = next_char();
+         if (c == '\\') {
+             buffer[len++] = (char)c;
+             c = next_char();
+             if (c != 'n' && c != 't' && c != '\\' && c != '\'') {
+                 c = EOF;
+             }
+         }
+         if (c != EOF && c != '\n' && (c != '\'' || len == 2)) {
+             buffer[len++] = (char)c;
+             c = next_char();
+             if (c == '\'') {
+                 buffer[len++] = (char)c;
+                 buffer[len] = '\0';
+                 add_token(TOK_CHARLIT, buffer);
+                 return TOK_CHARLIT;
+             }
+         }
+         unget_char(c);
+         buffer[len] = '\0';
+         add_token(TOK_UNKNOWN, buffer);
+         return TOK_UNKNOWN;
+     }
+ 
+     // 4) Reconocer operadores relacionales de dos caracteres:
+     if (c == '=') {
+         int next = next_char();
+         if (next == '=') {
+             add_token(TOK_EQ, "==");
+             return TOK_EQ;
+         } else {
+             unget_char(next);
+             add_token(TOK_ASSIGN, "=");
+             return TOK_ASSIGN;
+         }
+     }
+     if (c == '!') {
+         int next = next_char();
+         if (next == '=') {
+             add_token(TOK_NEQ, "!=");
+             return TOK_NEQ;
+         } else {
+             unget_char(next);
+             add_token(TOK_UNKNOWN, "!");
+             return TOK_UNKNOWN;
+         }
+     }
+     if (c == '<') {
+         int next = next_char();
+         if (next == '=') {
+             add_token(TOK_LE, "<=");
+             return TOK_LE;
+         } else {
+             unget_char(next);
+             add_token(TOK_LT, "<");
+             return TOK_LT;
+         }
+     }
+     if (c == '>') {
+         int next = next_char();
+         if (next == '=') {
+             add_token(TOK_GE, ">=");
+             return TOK_GE;
+         } else {
+             unget_char(next);
+             add_token(TOK_GT, ">");
+             return TOK_GT;
+         }
+     }
+ 
+     // 5) Símbolos simples y operadores de un solo carácter
+     switch (c) {
+         case ',':
+             add_token(TOK_COMMA, ",");
+             return TOK_COMMA;
+         case ';':
+             add_token(TOK_SEMI, ";");
+             return TOK_SEMI;
+         case '(':
+             add_token(TOK_LPAREN, "(");
+             return TOK_LPAREN;
+         case ')':
+             add_token(TOK_RPAREN, ")");
+             return TOK_RPAREN;
+         case '{':
+             add_token(TOK_LBRACE, "{");
+             return TOK_LBRACE;
+         case '}':
+             add_token(TOK_RBRACE, "}");
+             return TOK_RBRACE;
+         case '[':
+             add_token(TOK_LBRACKET, "[");
+             return TOK_LBRACKET;
+         case ']':
+             add_token(TOK_RBRACKET, "]");
+             return TOK_RBRACKET;
+         case '+':
+             add_token(TOK_PLUS, "+");
+             return TOK_PLUS;
+         case '-':
+             add_token(TOK_MINUS, "-");
+             return TOK_MINUS;
+         case '*':
+             add_token(TOK_MULT, "*");
+             return TOK_MULT;
+         case '/':
+             add_token(TOK_DIV, "/");
+             return TOK_DIV;
+         default:
+             // Cualquier otro carácter → TOK_UNKNOWN
+             buffer[0] = (char)c;
+             buffer[1] = '\0';
+             add_token(TOK_UNKNOWN, buffer);
+             return TOK_UNKNOWN;
+     }
+ }
+ 
+ /**
+  * tokenize_input():
+  *   Lee toda la fuente (stdin o archivo) hasta EOF, llamando a yylex()
+  *   repetidamente. Cuando yylex() devuelve TOK_EOF, sale del bucle y
+  *   añade al final un único token TOK_EOF.
+  */
+ static void tokenize_input(void) {
+     TokenType t;
+     do {
+         t = yylex();
+     } while (t != TOK_EOF);
+     add_token(TOK_EOF, "EOF");
+ }
+ 
+ 
+ /*==============================================================
+  *                  FUNCIONES AUXILIARES DEL PARSER
+  *=============================================================*/
+ 
+ /**
+  * lookahead():
+  *   Devuelve el TokenType de tokens[cur_token], o TOK_EOF si
+  *   cur_token >= num_tokens.
+  */
+ static TokenType lookahead(void) {
+     if (cur_token < num_tokens) {
+         return tokens[cur_token].type;
+     }
+     return TOK_EOF;
+ }
+ 
+ /**
+  * match(expected):
+  *   Si lookahead()==expected, avanza cur_token++ (consume el token).
+  *   Si no coincide, imprime un mensaje de error y termina con exit(1).
+  */
+ static void match(TokenType expected) {
+     if (lookahead() == expected) {
+         cur_token++;
+     } else {
+         fprintf(stderr,
+                 "Error de sintaxis: se esperaba token %d ('%s'), "
+                 "pero vino token %d ('%s').\n",
+                 expected,
+                 tokens[cur_token].lexeme,
+                 lookahead(),
+                 tokens[cur_token].lexeme);
+         exit(1);
+     }
+ }
+ 
+ /**
+  * expect_ident():
+  *   Verifica que el token actual sea TOK_IDENT. Si lo es, devuelve
+  *   el lexema (tokens[cur_token].lexeme) y avanza cur_token++. Si no,
+  *   error.
+  */
+ static char *expect_ident(void) {
+     if (lookahead() == TOK_IDENT) {
+         char *name = tokens[cur_token].lexeme;
+         cur_token++;
+         return name;
+     } else {
+         fprintf(stderr,
+                 "Error de sintaxis: se esperaba IDENT, "
+                 "pero vino '%s'.\n",
+                 tokens[cur_token].lexeme);
+         exit(1);
+     }
+     return NULL; // solo para evitar warning
+ }
+ 
+ /**
+  * char_literal(lexeme):
+  *   Valor (Caracter, con signo) del lexema de un CHARLIT: 'c' o una
+  *   de las secuencias '\n', '\t', '\\', '\''.
+  */
+ static int char_literal(const char *lexeme) {
+     if (lexeme[1] != '\\') {
+         return (signed char)lexeme[1];
+     }
+     return lexeme[2] == 'n' ? '\n' : lexeme[2] == 't' ? '\t' : lexeme[2];
+ }
+ 
+ 
+ /*==============================================================
+  *          PARSER DE EXPRESIONES (EVALUACIÓN EN TIEMPO REAL)
+  *=============================================================*/
+ 
+ /**
+  * Prototipos (se definen más abajo):
+  */
+ static Value parse_expr(void);
+ static Value parse_rel_expr(void);
+ static Value parse_add_expr(void);
+ static Value parse_mul_expr(void);
+ static Value parse_unary_expr(void);
+ static Value parse_primary(void);
+ 
+ /**
+  * int_overflow_at(t, x, y):
+  *   x t y no cabe en 64 bits: sin --bigint es el error de siempre y
+  *   con él, el resultado exacto.
+  */
+ static Value int_overflow_at(TokenType t, Value x, Value y) {
+     if (!int_big) {
+         int_overflow();
+     }
+     return big_binary(t, x, y);
+ }
+ 
+ /**
+  * eval_binary(t, pos, x, y):
+  *   Aplica el operador t (token pos) a x e y: en Flotante si alguno
+  *   de los dos lo es y si no en Entero.
+  */
+ static Value eval_binary(TokenType t, int pos, Value x, Value y) {
+     if (val_is_float(x) || val_is_float(y)) {
+         double a = val_is_float(x) ? val_float(x) : val_to_double(x);
+         double b = val_is_float(y) ? val_float(y) : val_to_double(y);
+         switch (t) {
+             case TOK_PLUS:  return val_from_float(a + b);
+             case TOK_MINUS: return val_from_float(a - b);
+             case TOK_MULT:  return val_from_float(a * b);
+             case TOK_DIV:   return val_from_float(a / b);
+             case TOK_EQ:    return val_from_int(a == b);
+             case TOK_NEQ:   return val_from_int(a != b);
+             case TOK_LT:    return val_from_int(a < b);
+             case TOK_GT:    return val_from_int(a > b);
+             case TOK_LE:    return val_from_int(a <= b);
+             case TOK_GE:    return val_from_int(a >= b);
+             default:        return val_from_int(0);
+         }
+     }
+     if (val_is_big(x) || val_is_big(y)) {
+         return big_binary(t, x, y);
+     }
+     // Los __builtin_*_overflow dejan en r el resultado módulo 2^64:
+     // justo lo que da --wrap
+     long long a = val_int(x), b = val_int(y), r;
+     switch (t) {
+         case TOK_PLUS:
+             if (__builtin_add_overflow(a, b, &r) && !int_wrap) {
+                 return int_overflow_at(t, x, y);
+             }
+             return val_from_int(r);
+         case TOK_MINUS:
+             if (__builtin_sub_overflow(a, b, &r) && !int_wrap) {
+                 return int_overflow_at(t, x, y);
+             }
+             return val_from_int(r);
+         case TOK_MULT:
+             if (__builtin_mul_overflow(a, b, &r) && !int_wrap) {
+                 return int_overflow_at(t, x, y);
+             }
+             return val_from_int(r);
+         case TOK_DIV:
+             if (!div_is_safe[pos] && b == 0) {
+                 fprintf(stderr, "Error: división por cero.\n");
+                 exit(1);
+             }
+             if (b == -1) {
+                 // LLONG_MIN / -1 es el único cociente que no cabe
+                 if (__builtin_sub_overflow(0, a, &r) && !int_wrap) {
+                     return int_overflow_at(t, x, y);
+                 }
+                 return val_from_int(r);
+             }
+             return val_from_int(a / b);
+         case TOK_EQ:    return val_from_int(a == b);
+         case TOK_NEQ:   return val_from_int(a != b);
+         case TOK_LT:    return val_from_int(a < b);
+         case TOK_GT:    return val_from_int(a > b);
+         case TOK_LE:    return val_from_int(a <= b);
+         case TOK_GE:    return val_from_int(a >= b);
+         default:        return val_from_int(0);
+     }
+ }
+ 
+ /*
+  * parse_expr():
+  *   En esta gramática, <expr> ::= <rel_expr>
+  */
+ static Value parse_expr(void) {
+     return parse_rel_expr();
+ }
+ 
+ /*
+  * <rel_expr> ::= <add_expr> { ( '==' | '!=' | '<' | '>' | '<=' | '>=' ) <add_expr> }
+  */
+ static Value parse_rel_expr(void) {
+     Value left = parse_add_expr();
+ 
+     while (1) {
+         TokenType t = lookahead();
+         if (t == TOK_EQ || t == TOK_NEQ || t == TOK_LT ||
+             t == TOK_GT || t == TOK_LE || t == TOK_GE) {
+             int pos = cur_token++;
+             Value right = parse_add_expr();
+             left = eval_binary(t, pos, left, right);
+         } else {
+             break;
+         }
+     }
+     return left;
+ }
+ 
+ /*
+  * <add_expr> ::= <mul_expr> { ( '+' | '-' ) <mul_expr> }
+  */
+ static Value parse_add_expr(void) {
+     Value left = parse_mul_expr();
+ 
+     while (1) {
+         TokenType t = lookahead();
+         if (t == TOK_PLUS || t == TOK_MINUS) {
+             int pos = cur_token++;
+             Value right = parse_mul_expr();
+             left = eval_binary(t, pos, left, right);
+         } else {
+             break;
+         }
+     }
+     return left;
+ }
+ 
+ /*
+  * <mul_expr> ::= <unary_expr> { ( '*' | '/' ) <unary_expr> }
+  */
+ static Value parse_mul_expr(void) {
+     Value left = parse_unary_expr();
+ 
+     while (1) {
+         TokenType t = lookahead();
+         if (t == TOK_MULT || t == TOK_DIV) {
+             int pos = cur_token++;
+             Value right = parse_unary_expr();
+             left = eval_binary(t, pos, left, right);
+         } else {
+             break;
+         }
+     }
+     return left;
+ }
+ 
+ /*
+  * <unary_expr> ::= [ '-' ] <primary>
+  */
+ static Value parse_unary_expr(void) {
+     if (lookahead() == TOK_MINUS) {
+         cur_token++;
+         Value val = parse_primary();
+         long long r;
+         if (val_is_float(val)) {
+             return val_from_float(-val_float(val));
+         }
+         if (val_is_big(val)) {
+             return big_binary(TOK_MINUS, val_from_int(0), val);
+         }
+         if (__builtin_sub_overflow(0, val_int(val), &r) && !int_wrap) {
+             return int_overflow_at(TOK_MINUS, val_from_int(0), val);
+         }
+         return val_from_int(r);
+     }
+     return parse_primary();
+ }
+ 
+ /**
+  * parse_subscript(a, d):
+  *   '[' <expr> ']' de la dimensión d de a (ver array_dim()): el
+  *   índice, ya comprobado salvo que el compilador haya demostrado que
+  *   no hace falta (idx_is_safe[]). Con --bigint un índice que no cabe
+  *   en 64 bits está, claro, fuera.
+  */
+ static long long parse_subscript(const Array *a, int d) {
+     int pos = cur_token;
+     match(TOK_LBRACKET);
+     Value v = parse_expr();
+     match(TOK_RBRACKET);
+     if (idx_is_safe[pos]) {
+         return val_int(v);
+     }
+     if (val_is_big(v) || (unsigned long long)val_int(v) >= (unsigned long long)array_dim(a, d)) {
+         index_error(a);
+     }
+     return val_int(v);
+ }
+ 
+ /**
+  * parse_index(a):
+  *   Los índices del vector o la matriz a: el elemento al que se
+  *   refieren.
+  */
+ static long long parse_index(const Array *a) {
+     if (a->cols == 0) {
+         return parse_subscript(a, 0);
+     }
+     long long i = parse_subscript(a, 1);
+     return i * a->cols + parse_subscript(a, 2);
+ }
+ 
+ /**
+  * parse_vec_call(f):
+  *   '(' IDENT [ ',' IDENT ] ')' de Suma, Producto, Minimo o Maximo,
+  *   o '(' IDENT ',' <expr> ')' de Buscar (el compilador ya comprobó
+  *   los argumentos).
+  */
+ static Value parse_vec_call(VecFunc f) {
+     match(TOK_LPAREN);
+     const Array *a = &arrays[lookup_array(expect_ident())];
+     const Array *b = NULL;
+     if (f == VEC_FIND) {
+         match(TOK_COMMA);
+         Value x = parse_expr();
+         match(TOK_RPAREN);
+         // Un BigInt (--bigint) no cabe en ningún elemento: no está
+         return val_from_int(val_is_big(x) ? -1 : vec_find(a, val_int(x)));
+     }
+     if (f == VEC_DOT) {
+         match(TOK_COMMA);
+         b = &arrays[lookup_array(expect_ident())];
+     }
+     match(TOK_RPAREN);
+     return vec_value(f, a, b);
+ }
+ 
+ /**
+  * dict_bits(val):
+  *   Una clave o un valor (Entero o Caracter) de un diccionario, en
+  *   64 bits como los elementos de un vector.
+  */
+ static long long dict_bits(Value val) {
+     if (val_is_big(val)) {
+         int_overflow();
+     }
+     return val_int(val);
+ }
+ 
+ /**
+  * parse_dict_key():
+  *   '[' <expr> ']' de d[k]: la clave (Entero o Caracter; el
+  *   compilador ya comprobó que no es Flotante).
+  */
+ static Value parse_dict_key(void) {
+     match(TOK_LBRACKET);
+     Value k = parse_expr();
+     match(TOK_RBRACKET);
+     return k;
+ }
+ 
+ /**
+  * parse_dict_call(f):
+  *   '(' IDENT ',' <expr> ')' de Contiene o '(' IDENT ')' de Tamano.
+  *   Un BigInt (--bigint) no es ninguna clave.
+  */
+ static Value parse_dict_call(DictFunc f) {
+     match(TOK_LPAREN);
+     const Dict *d = &dicts[lookup_dict(expect_ident())];
+     long long   r = d->len;
+     if (f == DICT_HAS) {
+         match(TOK_COMMA);
+         Value k = parse_expr();
+         r = !val_is_big(k) && dict_slot(d, val_int(k)) != NULL;
+     }
+     match(TOK_RPAREN);
+     return val_from_int(r);
+ }
+ 
+ /*
+  * <primary> ::= '(' <expr> ')' | NUM | REAL | CHARLIT | <lvalue> | <vec_call>
+  */
+ static Value parse_primary(void) {
+     Value val;
+     if (lookahead() == TOK_LPAREN) {
+         match(TOK_LPAREN);
+         val = parse_expr();
+         match(TOK_RPAREN);
+         return val;
+     } else if (lookahead() == TOK_NUM) {
+         val = val_from_int(strtoll(tokens[cur_token].lexeme, NULL, 10));
+         cur_token++;
+         return val;
+     } else if (lookahead() == TOK_REAL) {
+         val = val_from_float(strtod(tokens[cur_token].lexeme, NULL));
+         cur_token++;
+         return val;
+     } else if (lookahead() == TOK_CHARLIT) {
+         val = val_from_char(char_literal(tokens[cur_token].lexeme));
+         cur_token++;
+         return val;
+     } else if (lookahead() == TOK_IDENT) {
+         // Variable: obtenemos su valor de la tabla de símbolos
+         char *name = tokens[cur_token].lexeme;
+         int   pos  = cur_token;
+         cur_token++;
+         if (lookahead() == TOK_LBRACKET) {
+             int d = lookup_dict(name);
+             if (d >= 0) {
+                 Value k = parse_dict_key();
+                 return val_from_int(val_is_big(k) ? 0 : dict_get(&dicts[d], val_int(k)));
+             }
+             Array *a = &arrays[lookup_array(name)];
+             return array_load(a, parse_index(a));
+         }
+         if (lookahead() == TOK_LPAREN) {
+             DictFunc g = dict_func(name);
+             return (g != DICT_NONE) ? parse_dict_call(g) : parse_vec_call(vec_func(name));
+         }
+         if (read_is_safe[pos]) {
+             return sym_value[lookup_symbol(name)];
+         }
+         return get_symbol_value(name);
+     } else {
+         fprintf(stderr,
+                 "Error de sintaxis en <primary>: se esperaba "
+                 "NUM, REAL, CHARLIT, IDENT o '(', pero vino '%s'.\n",
+                 tokens[cur_token].lexeme);
+         exit(1);
+     }
+     return val_from_int(0); // para evitar warning
+ }
+ 
+ 
+ /*==============================================================
+  *         PARSER DE DECLARACIONES (DECL_STMT)
+  *=============================================================*/
+ 
+ /*
+  * <decl_stmt> ::= <type> <var_list> ';'
+  * <type>       ::= 'Entero' | 'Caracter' | 'Flotante'
+  * <var_list>   ::= <var_decl> ( ',' <var_decl> )*
+  * <var_decl>   ::= IDENT [ '=' <expr> ] | IDENT '[' NUM ']'
+  *
+  * Semántica:
+  *    - Cada identificador se agrega a la tabla de símbolos con el
+  *      tipo de la declaración, sin valor (VAL_UNDEF).
+  *    - Si hay “= <expr>”, entonces evaluamos <expr>, lo convertimos
+  *      al tipo de la variable y se lo asignamos.
+  *    - Si no hay “=”, la variable queda definida sin valor (error si
+  *      se usa antes de asignar).
+  *    - Un vector ya lo dio de alta el compilador; declararlo pone
+  *      sus elementos a 0.
+  */
+ static void parse_decl_stmt(void) {
+     // 1) <type>
+     TokenType t = lookahead();
+     VarType   type = TYPE_INT;
+     if (t == TOK_INT || t == TOK_CHAR || t == TOK_FLOAT) {
+         type = (t == TOK_FLOAT) ? TYPE_FLOAT : (t == TOK_CHAR) ? TYPE_CHAR : TYPE_INT;
+         cur_token++;
+     } else {
+         fprintf(stderr,
+                 "Error de sintaxis en <decl_stmt>: se esperaba tipo 'Entero', 'Caracter' o 'Flotante', "
+                 "pero vino '%s'.\n",
+                 tokens[cur_token].lexeme);
+         exit(1);
+     }
+ 
+     // 2) <var_list> ::= <var_decl> (',' <var_decl> )*
+     while (1) {
+         // <var_decl> ::= IDENT [ '=' <expr> ] | IDENT '[' NUM ']' [ '[' NUM ']' ]
+         if (lookahead() == TOK_IDENT && tokens[cur_token + 1].type == TOK_LBRACKET) {
+             Array *a = &arrays[lookup_array(tokens[cur_token].lexeme)];
+             memset(a->data, 0, array_bytes(a));
+             cur_token += (a->cols > 0) ? 7 : 4;
+         } else if (lookahead() == TOK_IDENT) {
+             char *varname = tokens[cur_token].lexeme;
+             int idx = add_symbol(varname);  // crea o recupera índice
+             symtab[idx].type = type;
+             sym_value[idx]   = VAL_UNDEF;   // aún no asignado
+ 
+             cur_token++;
+             if (lookahead() == TOK_ASSIGN) {
+                 match(TOK_ASSIGN);
+                 sym_value[idx] = convert_value(parse_expr(), type);
+             }
+         } else {
+             fprintf(stderr,
+                     "Error de sintaxis en <var_list>: se esperaba IDENT, "
+                     "pero vino '%s'.\n",
+                     tokens[cur_token].lexeme);
+             exit(1);
+         }
+ 
+         // Si viene coma, se repite el var_decl
+         if (lookahead() == TOK_COMMA) {
+             match(TOK_COMMA);
+         } else {
+             break;
+         }
+     }
+ 
+     // 3) Consumir ';'
+     match(TOK_SEMI);
+ }
+ 
+ /*
+  * <decl_stmt> ::= 'Diccionario' IDENT ( ',' IDENT )* ';'
+  * Semántica: el compilador ya dio de alta cada diccionario;
+  * declararlo lo deja vacío.
+  */
+ static void parse_dict_decl(void) {
+     match(TOK_DICT);
+     while (1) {
+         dict_clear(&dicts[lookup_dict(expect_ident())]);
+         if (lookahead() != TOK_COMMA) {
+             break;
+         }
+         match(TOK_COMMA);
+     }
+     match(TOK_SEMI);
+ }
+ 
+ 
+ /*==============================================================
+  *            PARSER DE INSTRUCCIONES (STMT)
+  *=============================================================*/
+ 
+ /*
+  * Prototipos recursivos:
+  */
+ static void parse_stmt(void);
+ static void parse_print_stmt(void);
+ static void parse_read_stmt(void);
+ static void parse_assign_stmt(void);
+ static void parse_call_stmt(void);
+ static void parse_if_stmt(void);
+ static void parse_while_stmt(void);
+ static void parse_block_stmt(void);
+ static void skip_stmt(void);
+ static int  loop_is_hot(int while_pos);
+ static void profile_branch(int if_pos, int cond);
+ static int  run_hot_loop(int while_pos);
+ 
+ /*
+  * <stmt> ::= <decl_stmt>
+  *          | <print_stmt>
+  *          | <read_stmt>
+  *          | <assign_stmt>
+  *          | <if_stmt>
+  *          | <while_stmt>
+  *          | <block_stmt>
+  *          | <call_stmt>
+  */
+ static void parse_stmt(void) {
+     wide_compact();
+     big_compact();
+     switch (lookahead()) {
+         case TOK_INT:
+         case TOK_CHAR:
+         case TOK_FLOAT:
+             parse_decl_stmt();
+             break;
+ 
+         case TOK_DICT:
+             parse_dict_decl();
+             break;
+ 
+         case TOK_PRINT:
+             parse_print_stmt();
+             break;
+ 
+         case TOK_READ:
+             parse_read_stmt();
+             break;
+ 
+         case TOK_IDENT:
+             if (tokens[cur_token + 1].type == TOK_LPAREN) {
+                 parse_call_stmt();
+                 break;
+             }
+             if (stmt_dead[cur_token]) {
+                 cur_token = stmt_end[cur_token];
+                 stmt_dead_skips++;
+                 break;
+             }
+             parse_assign_stmt();
+             break;
+ 
+         case TOK_IF:
+             parse_if_stmt();
+             break;
+ 
+         case TOK_WHILE:
+             parse_while_stmt();
+             break;
+ 
+         case TOK_LBRACE:
+             parse_block_stmt();
+             break;
+ 
+         default:
+             fprintf(stderr,
+                     "Error de sintaxis en <stmt>: token inesperado '%s'.\n",
+                     tokens[cur_token].lexeme);
+             exit(1);
+     }
+ }
+ 
+ /*
+  * Salida de Imprimir. Con out_hold (la VM con --bigint) lo que se
+  * imprime se queda en out_held hasta out_commit(): si la vuelta del
+  * bucle se tiene que repetir en el intérprete, out_discard() lo
+  * olvida y no sale dos veces.
+  */
+ static int    out_hold = 0;
+ static char  *out_held = NULL;
+ static size_t out_held_len = 0, out_held_cap = 0;
+ 
+ static void out_printf(const char *fmt, ...) {
+     va_list ap;
+     va_start(ap, fmt);
+     if (!out_hold) {
+         vprintf(fmt, ap);
+         va_end(ap);
+         return;
+     }
+     va_list ap2;
+     va_copy(ap2, ap);
+     size_t n = (size_t)vsnprintf(NULL, 0, fmt, ap);
+     if (out_held_len + n + 1 > out_held_cap) {
+         out_held_cap = 2 * (out_held_len + n + 1);
+         out_held = realloc(out_held, out_held_cap);
+         if (out_held == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     vsnprintf(out_held + out_held_len, n + 1, fmt, ap2);
+     out_held_len += n;
+     va_end(ap2);
+     va_end(ap);
+ }
+ 
+ static void out_commit(void) {
+     if (out_held_len > 0) {
+         fwrite(out_held, 1, out_held_len, stdout);
+         out_held_len = 0;
+     }
+ }
+ 
+ static void out_discard(void) {
+     out_held_len = 0;
+ }
+ 
+ /**
+  * print_value(val) / read_value(type):
+  *   Salida de un valor (según su tipo) y entrada de uno del tipo
+  *   dado; las usan también la VM y el JIT, así todos los niveles
+  *   escriben y leen igual.
+  */
+ static void print_value(Value val) {
+     if (val_is_float(val)) {
+         out_printf("%g\n", val_float(val));
+     } else if (val_is_char(val)) {
+         out_printf("%c\n", (char)val_int(val));
+     } else if (val_is_big(val)) {
+         char *s = big_to_string(val);
+         out_printf("%s\n", s);
+         free(s);
+     } else {
+         out_printf("%lld\n", val_int(val));
+     }
+ }
+ 
+ static Value read_value(VarType type) {
+     Value  val;
+     double x = 0;
+     char   c = 0;
+     long long i = 0;
+     int    ok;
+     switch (type) {
+         case TYPE_FLOAT:
+             ok  = (scanf("%lf", &x) == 1);
+             val = val_from_float(x);
+             break;
+         case TYPE_CHAR:
+             ok  = (scanf(" %c", &c) == 1);
+             val = val_from_char(c);
+             break;
+         default:
+             // Sin --bigint, un Entero que no cabe en 64 bits tampoco
+             // se puede leer
+             if (int_big) {
+                 ok = big_read(&val);
+                 break;
+             }
+             errno = 0;
+             ok  = (scanf("%lld", &i) == 1 && errno != ERANGE);
+             val = val_from_int(i);
+             break;
+     }
+     if (!ok) {
+         fprintf(stderr, "Error de runtime: no se pudo leer %s.\n",
+                 type == TYPE_FLOAT ? "un número" : type == TYPE_CHAR ? "un carácter"
+                                                                      : "un entero");
+         exit(1);
+     }
+     return val;
+ }
+ 
+ /*
+  * <print_stmt> ::= 'Imprimir' '(' <expr> ')' ';'
+  * Semántica: evalúa <expr> y muestra su valor por stdout (seguido de
+  * newline): un Caracter como carácter y un Flotante con "%g".
+  */
+ static void parse_print_stmt(void) {
+     match(TOK_PRINT);
+     match(TOK_LPAREN);
+     Value val = parse_expr();
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     print_value(val);
+ }
+ 
+ /*
+  * <read_stmt> ::= 'Leer' '(' <lvalue> ')' ';'
+  * Semántica: lee de stdin un valor del tipo de la variable (o del
+  * vector; Entero en un diccionario) y se lo asigna.
+  */
+ static void parse_read_stmt(void) {
+     match(TOK_READ);
+     match(TOK_LPAREN);
+     int   pos     = cur_token;
+     char *varname = expect_ident();
+     int   d       = lookup_dict(varname);
+     if (lookahead() == TOK_LBRACKET && d >= 0) {
+         long long k = dict_bits(parse_dict_key());
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         dict_set(&dicts[d], k, dict_bits(read_value(TYPE_INT)));
+         return;
+     }
+     if (lookahead() == TOK_LBRACKET) {
+         Array    *a = &arrays[lookup_array(varname)];
+         long long i = parse_index(a);
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         array_store(a, i, read_value(a->type));
+         return;
+     }
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+ 
+     VarType type = (VarType)tok_type[pos];
+     set_symbol_value(varname, type, read_value(type));
+ }
+ 
+ /*
+  * <assign_stmt> ::= <lvalue> '=' <expr> ';'
+  * Semántica: evalúa <expr> y asigna el resultado, convertido al tipo
+  * de la variable (o del vector; su índice se comprueba antes de
+  * evaluar <expr>). En un diccionario, convertido a Entero.
+  */
+ static void parse_assign_stmt(void) {
+     int   pos     = cur_token;
+     char *varname = expect_ident();
+     int   d       = lookup_dict(varname);
+     if (lookahead() == TOK_LBRACKET && d >= 0) {
+         long long k = dict_bits(parse_dict_key());
+         match(TOK_ASSIGN);
+         Value val = parse_expr();
+         match(TOK_SEMI);
+         dict_set(&dicts[d], k, dict_bits(convert_value(val, TYPE_INT)));
+         return;
+     }
+     if (lookahead() == TOK_LBRACKET) {
+         Array    *a = &arrays[lookup_array(varname)];
+         long long i = parse_index(a);
+         match(TOK_ASSIGN);
+         Value val = parse_expr();
+         match(TOK_SEMI);
+         array_store(a, i, convert_value(val, a->type));
+         return;
+     }
+     match(TOK_ASSIGN);
+     Value val = parse_expr();
+     match(TOK_SEMI);
+     VarType type = (VarType)tok_type[pos];
+     set_symbol_value(varname, type, convert_value(val, type));
+ }
+ 
+ /*
+  * <call_stmt> ::= 'Borrar' '(' IDENT ',' <expr> ')' ';'
+  *              | 'Claves' '(' IDENT ',' IDENT ')' ';'
+  * Semántica: ver dict_delete() y dict_keys() (un BigInt de
+  * --bigint no es ninguna clave: no hay nada que borrar).
+  */
+ static void parse_dict_stmt(DictFunc f) {
+     match(TOK_LPAREN);
+     char *name = expect_ident();
+     match(TOK_COMMA);
+     if (f == DICT_KEYS) {
+         Array      *a = &arrays[lookup_array(name)];
+         const Dict *d = &dicts[lookup_dict(expect_ident())];
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         dict_keys(a, d);
+         return;
+     }
+     Dict *d = &dicts[lookup_dict(name)];
+     Value k = parse_expr();
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     if (!val_is_big(k)) {
+         dict_delete(d, val_int(k));
+     }
+ }
+ 
+ /*
+  * <call_stmt> ::= 'Llenar' '(' IDENT ',' <expr> ')' ';'
+  *              | 'Ordenar' '(' IDENT ')' ';'
+  *              | 'Multiplicar' '(' IDENT ',' IDENT ',' IDENT ')' ';'
+  *              | 'Trasponer' '(' IDENT ',' IDENT ')' ';'
+  * Semántica: Llenar convierte <expr> al tipo del vector y lo copia
+  * en todos sus elementos; Ordenar(v), ver vec_sort();
+  * Multiplicar(c, a, b) y Trasponer(t, m), ver mat_mul() (el
+  * compilador ya comprobó los argumentos).
+  */
+ static void parse_call_stmt(void) {
+     char    *name = expect_ident();
+     DictFunc g    = dict_func(name);
+     if (g != DICT_NONE) {
+         parse_dict_stmt(g);
+         return;
+     }
+     VecFunc f = vec_func(name);
+     match(TOK_LPAREN);
+     Array *a = &arrays[lookup_array(expect_ident())];
+     if (f == VEC_SORT) {
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         vec_sort(a);
+         return;
+     }
+     match(TOK_COMMA);
+     if (f == VEC_FILL) {
+         Value val = parse_expr();
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         vec_fill(a, array_bits(a, convert_value(val, a->type)));
+         return;
+     }
+     const Array *b = &arrays[lookup_array(expect_ident())];
+     if (f == VEC_TRANSP) {
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         mat_transpose(a, b);
+         return;
+     }
+     match(TOK_COMMA);
+     const Array *c = &arrays[lookup_array(expect_ident())];
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     if (mat_mul(a, b, c)) {
+         int_overflow();
+     }
+ }
+ 
+ /**
+  * value_is_true(val):
+  *   Una condición se cumple si es distinta de cero (0.0 en Flotante).
+  */
+ static int value_is_true(Value val) {
+     return val_is_float(val) ? (val_float(val) != 0.0)
+                              : (val_is_big(val) || val_int(val) != 0);
+ }
+ 
+ /*
+  * <if_stmt> ::= 'Si' '(' <expr> ')' <stmt> [ 'Sino' <stmt> ]
+  *
+  * Semántica:
+  *   - Si cond ≠ 0: ejecutar <stmt> de la rama THEN y descartar la rama 'Sino'.
+  *   - Si cond == 0: descartar <stmt> de la rama THEN y, si existe 'Sino', ejecutar la rama ELSE.
+  */
+ static void parse_if_stmt(void) {
+     int if_pos = cur_token;
+     match(TOK_IF);           // consume 'Si'
+     match(TOK_LPAREN);       // consume '('
+     int cond = value_is_true(parse_expr());
+     match(TOK_RPAREN);       // consume ')'
+     profile_branch(if_pos, cond);
+ 
+     if (cond) {
+         // === rama THEN ===
+         parse_stmt();
+         // Si hay 'Sino', descartamos sin ejecutarla la rama ELSE
+         if (lookahead() == TOK_ELSE) {
+             match(TOK_ELSE);
+             skip_stmt();
+         }
+     }
+     else {
+         // cond == 0 → descartamos la rama THEN y, si hay "Sino", ejecutamos la rama ELSE
+         skip_stmt();
+         if (lookahead() == TOK_ELSE) {
+             match(TOK_ELSE);
+             parse_stmt();
+         }
+         // Si no hay 'Sino', continuamos adelante
+     }
+ }
+ 
+ /*
+  * <while_stmt> ::= 'Mientras' '(' <expr> ')' <stmt>
+  * Semántica: evalúa <expr>; mientras ≠0, ejecuta <stmt> y repite.
+  *
+  * Cuando el bucle se calienta (loop_is_hot), lo que queda de él se
+  * compila y se ejecuta en la VM / JIT de trazas (run_hot_loop), que
+  * devuelve el token siguiente al bucle (o -1 si, con --bigint, el
+  * bucle tiene que seguir aquí).
+  */
+ static void parse_while_stmt(void) {
+     int while_pos = cur_token;
+     match(TOK_WHILE);
+     match(TOK_LPAREN);
+ 
+     // Para “repetir” el bucle, guardamos la posición de cur_token justo después de '('
+     int cond_pos = cur_token;
+     int valor_cond = value_is_true(parse_expr());
+     match(TOK_RPAREN);
+     int body_pos = cur_token;
+ 
+     while (valor_cond) {
+         if (loop_is_hot(while_pos)) {
+             int next = run_hot_loop(while_pos);
+             if (next >= 0) {
+                 cur_token = next;
+                 return;
+             }
+             cur_token  = cond_pos;
+             valor_cond = value_is_true(parse_expr());
+             match(TOK_RPAREN);
+             if (!valor_cond) {
+                 break;
+             }
+         }
+         cur_token = body_pos;
+         parse_stmt();
+         cur_token = cond_pos;
+         valor_cond = value_is_true(parse_expr());
+         match(TOK_RPAREN);
+     }
+ 
+     // cond == 0 → descartamos el <stmt> sin ejecutarlo
+     cur_token = body_pos;
+     skip_stmt();
+ }
+ 
+ /*
+  * <block_stmt> ::= '{' <stmt_list> '}'
+  * Semántica: simplemente ejecuta cada stmt hasta cerrar llave
+  */
+ static void parse_block_stmt(void) {
+     match(TOK_LBRACE);
+     while (lookahead() != TOK_RBRACE && lookahead() != TOK_EOF) {
+         parse_stmt();
+     }
+     match(TOK_RBRACE);
+ }
+ 
+ /**
+  * skip_stmt():
+  *   Avanza cur_token sobre un <stmt> completo sin ejecutar nada.
+  *   Con stmt_end (ya compilado el programa) es un solo salto; si no,
+  *   se recorren los tokens.
+  */
+ static void skip_stmt(void) {
+     if (stmt_end[cur_token] > cur_token) {
+         cur_token = stmt_end[cur_token];
+         return;
+     }
+     switch (lookahead()) {
+         case TOK_IF:
+         case TOK_WHILE: {
+             int is_if = (lookahead() == TOK_IF);
+             cur_token++;
+             match(TOK_LPAREN);
+             int nivel_p = 1;
+             while (nivel_p > 0 && lookahead() != TOK_EOF) {
+                 if (lookahead() == TOK_LPAREN) nivel_p++;
+                 else if (lookahead() == TOK_RPAREN) nivel_p--;
+                 cur_token++;
+             }
+             skip_stmt();
+             if (is_if && lookahead() == TOK_ELSE) {
+                 match(TOK_ELSE);
+                 skip_stmt();
+             }
+             break;
+         }
+ 
+         case TOK_LBRACE:
+             match(TOK_LBRACE);
+             while (lookahead() != TOK_RBRACE && lookahead() != TOK_EOF) {
+                 skip_stmt();
+             }
+             match(TOK_RBRACE);
+             break;
+ 
+         case TOK_INT:
+         case TOK_CHAR:
+         case TOK_FLOAT:
+         case TOK_DICT:
+         case TOK_PRINT:
+         case TOK_READ:
+         case TOK_IDENT:
+             // decl, Imprimir, Leer, asignación y Llenar terminan en ';'
+             while (lookahead() != TOK_SEMI && lookahead() != TOK_EOF) {
+                 cur_token++;
+             }
+             match(TOK_SEMI);
+             break;
+ 
+         default:
+             fprintf(stderr,
+                     "Error de sintaxis en <stmt>: token inesperado '%s'.\n",
+                     tokens[cur_token].lexeme);
+             exit(1);
+     }
+ }
+ 
+ 
+ /*==============================================================
+  *               PARSER PRINCIPAL DE <program>
+  *=============================================================*/
+ 
+ /*
+  * <program> ::= <stmt_list> EOF
+  */
+ static void parse_program(void) {
+     while (lookahead() != TOK_EOF) {
+         parse_stmt();
+     }
+     match(TOK_EOF);
+ }
+ 
+ 
+ /*==============================================================
+  *          CÓDIGO INTERMEDIO (IR DE TRES DIRECCIONES)
+  *=============================================================*/
+ 
+ /*--------------------------------------------------------------
+  * Para compilar el programa (en lugar de interpretarlo sobre los
+  * tokens), el mismo descenso recursivo genera una lista lineal de
+  * instrucciones de tres direcciones. Los operandos son registros
+  * virtuales:
+  *
+  *   r0 .. num_vars-1   → variables de la tabla de símbolos
+  *   num_vars ..        → temporales de las expresiones
+  *
+  * Durante la generación los temporales se numeran a partir de
+  * MAX_VARS (todavía no sabemos cuántas variables habrá) y
+  * ir_finalize() los compacta detrás de las variables.
+  *-------------------------------------------------------------*/
+ typedef enum {
+     OP_CONST,      // a = consts[b]
+     OP_MOV,        // a = b
+     OP_ADD,        // a = b + c     De OP_ADD a OP_NEG: módulo 2^64
+     OP_SUB,        // a = b - c     (--wrap, o el análisis de rangos
+     OP_MUL,        // a = b * c     demostró que no se desborda)
+     OP_DIV,        // a = b / c   (c ya pasó su CHKDIV)
+     OP_NEG,        // a = -b
+     OP_EQ,         // a = (b == c)
+     OP_NE,         // a = (b != c)
+     OP_LT,         // a = (b <  c)
+     OP_LE,         // a = (b <= c)
+     OP_GT,         // a = (b >  c)
+     OP_GE,         // a = (b >= c)
+     OP_JMP,        // salta a la instrucción a
+     OP_JZ,         // si a == 0, salta a la instrucción b
+     OP_PRINT,      // imprime a
+     OP_READ,       // lee un entero en a
+     OP_UNDEF,      // a queda sin inicializar (declaración sin '=')
+     OP_CHKDEF,     // error si a no está inicializada (b=1: no declarada;
+                    // c = token de la lectura)
+     OP_CHKDIV,     // error si a == 0 (divisor; b = token del '/')
+     OP_TRIPS,      // a = vueltas de un bucle "b REL c" con paso fijo
+                    // (d = paso*8 + REL-OP_EQ); 0 si no se puede saber
+     OP_POWSUM,     // a = suma de k^c para 0 <= k < b (b sin signo)
+     OP_BOUND,      // a = |b| + |c| (d=1: |b|·|c|) sin signo, como mucho
+                    // 2^63 (LLONG_MIN): una cota que no cabe es negativa
+     OP_DIV32,      // a = b / c como OP_DIV, pero opt_ranges demostró que
+                    // b y c caben en 32 bits (b != INT_MIN): idivl
+     OP_FCONST,     // a = fconsts[b]
+     OP_FADD,       // a = b + c     De OP_FADD a OP_FGE: lo mismo que
+     OP_FSUB,       // a = b - c     OP_ADD..OP_GE (y en el mismo orden)
+     OP_FMUL,       // a = b * c     pero en Flotante. Las comparaciones
+     OP_FDIV,       // a = b / c     dan Entero; dividir entre 0.0 no es
+     OP_FNEG,       // a = -b        un error (da inf o nan).
+     OP_FEQ,        // a = (b == c)
+     OP_FNE,        // a = (b != c)
+     OP_FLT,        // a = (b <  c)
+     OP_FLE,        // a = (b <= c)
+     OP_FGT,        // a = (b >  c)
+     OP_FGE,        // a = (b >= c)
+     OP_ITOF,       // a = (Flotante) b
+     OP_FTOI,       // a = (Entero) b  (float_to_int)
+     OP_PRINTF,     // imprime a (Flotante)
+     OP_READF,      // lee un Flotante en a
+     OP_TOCHR,      // a = (Caracter) b: los 8 bits bajos, con signo
+     OP_PRINTC,     // imprime a como carácter
+     OP_READC,      // lee un carácter en a
+     OP_ADDO,       // a = b + c     De OP_ADDO a OP_NEGO: lo mismo que
+     OP_SUBO,       // a = b - c     OP_ADD..OP_NEG (y en el mismo orden)
+     OP_MULO,       // a = b * c     pero un resultado que no cabe en 64
+     OP_DIVO,       // a = b / c     bits es un error de ejecución
+     OP_NEGO,       // a = -b
+     OP_LOAD,       // a = vector c [b]      (Entero o Flotante: 8 bytes)
+     OP_LOADC,      // a = vector c [b]      (Caracter: 1 byte con signo)
+     OP_STORE,      // vector a [b] = c
+     OP_STOREC,     // vector a [b] = c      (sus 8 bits bajos)
+     OP_CHKIDX,     // error si a no es un índice del vector b (c = token
+                    // del '['; d = dimensión, ver array_dim()); LOAD y
+                    // STORE ya no comprueban nada
+     OP_ZERO,       // pone a 0 los elementos del vector a
+     OP_ASUM,       // a = Suma(vector b)    De OP_ASUM a OP_TRANSP: las
+     OP_ADOT,       // a = Producto(vector b, vector c)    VecFunc (y en
+     OP_AMIN,       // a = Minimo(vector b)                el mismo orden);
+     OP_AMAX,       // a = Maximo(vector b)                un Entero que no
+     OP_AFIND,      // a = Buscar(vector c, b)             cabe es un error
+     OP_FILL,       // Llenar(vector a, b)
+     OP_SORT,       // Ordenar(vector a)
+     OP_MATMUL,     // Multiplicar(matriz a, matriz b, matriz c)
+     OP_TRANSP,     // Trasponer(matriz a, matriz b)
+     OP_DNEW,       // vacía el diccionario a (su declaración)
+     OP_DGET,       // a = diccionario c [b]   (0 si no está)
+     OP_DSET,       // diccionario a [b] = c
+     OP_DHAS,       // a = Contiene(diccionario c, b)
+     OP_DDEL,       // Borrar(diccionario a, b)
+     OP_DLEN,       // a = Tamano(diccionario b)
+     OP_DKEYS,      // Claves(vector a, diccionario b)
+     OP_VLOOP,      // ejecuta por carriles vueltas del bucle que empieza
+                    // detrás (JMP de vuelta en pc + a; b y c la
+                    // condición y d como en OP_TRIPS); puede no hacer nada
+     OP_PHI,        // a = phi_args[b + j] si se llegó por el predecesor j
+                    // (c predecesores; solo en forma SSA)
+     OP_HALT        // fin del programa
+ } OpCode;
+ 
+ typedef struct {
+     OpCode op;
+     int    a, b, c;
+     int    line;           // línea de origen (mensajes de error)
+     int    d;              // operando extra de OP_TRIPS; en la escritura
+                            // de una asignación, su token + 1 (o 0)
+ } Instr;
+ 
+ typedef struct {
+     Instr *code;           // code[0..num_code-1]
+     int    num_code, cap_code;
+     long long *consts;     // tabla de constantes enteras
+     int    num_consts, cap_consts;
+     double *fconsts;       // tabla de constantes Flotante
+     int    num_fconsts, cap_fconsts;
+     int    num_temps;      // temporales usados
+     int    num_regs;       // variables + temporales (tras ir_finalize)
+     int    whole_program;  // 1: programa entero (las variables empiezan sin
+                            // valor); 0: región de bucle (vienen de fuera)
+     int   *phi_args;       // argumentos de las PHI (forma SSA)
+     int    num_phi_args, cap_phi_args;
+     int   *ssa_var;        // forma SSA: variable de la que es versión cada
+                            // registro (-1 si no lo es); NULL fuera de SSA
+     int   *peep_saved;     // instrucciones que la mirilla quitó del bloque
+                            // de cada una (se ejecutaban con ella); o NULL
+ } IRProgram;
+ 
+ static IRProgram *ir       = NULL;  // programa que se está generando
+ static int        gen_line = 0;     // línea de la sentencia en curso
+ 
+ /**
+  * ir_new():
+  *   Reserva un IRProgram vacío.
+  */
+ static IRProgram *ir_new(void) {
+     IRProgram *p = calloc(1, sizeof(IRProgram));
+     if (p == NULL) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     return p;
+ }
+ 
+ static void vloop_forget(const IRProgram *p);
+ 
+ /**
+  * ir_free(p):
+  *   Libera un IRProgram y sus tablas.
+  */
+ static void ir_free(IRProgram *p) {
+     if (p == NULL) {
+         return;
+     }
+     vloop_forget(p);
+     free(p->code);
+     free(p->consts);
+     free(p->fconsts);
+     free(p->phi_args);
+     free(p->ssa_var);
+     free(p->peep_saved);
+     free(p);
+ }
+ 
+ /**
+  * ir_dup(src, n, size):
+  *   Copia de las n primeras entradas de la tabla src (NULL si n es 0).
+  */
+ static void *ir_dup(const void *src, int n, size_t size) {
+     if (n <= 0) {
+         return NULL;
+     }
+     void *dst = malloc((size_t)n * size);
+     if (dst == NULL) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     return memcpy(dst, src, (size_t)n * size);
+ }
+ 
+ /**
+  * ir_copy(p):
+  *   Copia independiente de p, recién compilado (sin SSA ni lo que
+  *   anota la mirilla), con sus tablas.
+  */
+ static IRProgram *ir_copy(const IRProgram *p) {
+     IRProgram *q = ir_new();
+     q->code          = ir_dup(p->code, p->num_code, sizeof(Instr));
+     q->num_code      = p->num_code;
+     q->cap_code      = p->num_code;
+     q->consts        = ir_dup(p->consts, p->num_consts, sizeof(long long));
+     q->num_consts    = p->num_consts;
+     q->cap_consts    = p->num_consts;
+     q->fconsts       = ir_dup(p->fconsts, p->num_fconsts, sizeof(double));
+     q->num_fconsts   = p->num_fconsts;
+     q->cap_fconsts   = p->num_fconsts;
+     q->num_temps     = p->num_temps;
+     q->num_regs      = p->num_regs;
+     q->whole_program = p->whole_program;
+     return q;
+ }
+ 
+ /**
+  * ir_emit(op, a, b, c):
+  *   Añade una instrucción al final de ir->code y devuelve su índice
+  *   (útil para parchear después el destino de un salto).
+  */
+ static int ir_emit(OpCode op, int a, int b, int c) {
+     if (ir->num_code >= ir->cap_code) {
+         ir->cap_code = ir->cap_code ? ir->cap_code * 2 : 256;
+         ir->code = realloc(ir->code, ir->cap_code * sizeof(Instr));
+         if (ir->code == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     Instr *in = &ir->code[ir->num_code];
+     in->op   = op;
+     in->a    = a;
+     in->b    = b;
+     in->c    = c;
+     in->line = gen_line;
+     in->d    = 0;
+     return ir->num_code++;
+ }
+ 
+ /**
+  * ir_const_in(p, val):
+  *   Devuelve el índice de val en la tabla de constantes de p,
+  *   añadiéndola si todavía no está.
+  */
+ static int ir_const_in(IRProgram *p, long long val) {
+     for (int i = 0; i < p->num_consts; i++) {
+         if (p->consts[i] == val) {
+             return i;
+         }
+     }
+     if (p->num_consts >= p->cap_consts) {
+         p->cap_consts = p->cap_consts ? p->cap_consts * 2 : 64;
+         p->consts = realloc(p->consts, p->cap_consts * sizeof(long long));
+         if (p->consts == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     p->consts[p->num_consts] = val;
+     return p->num_consts++;
+ }
+ 
+ static int ir_const(long long val) {
+     return ir_const_in(ir, val);
+ }
+ 
+ /**
+  * ir_fconst_in(p, val):
+  *   Lo mismo para la tabla de constantes Flotante (se comparan los
+  *   bits, así 0.0 y -0.0 son dos constantes).
+  */
+ static int ir_fconst_in(IRProgram *p, double val) {
+     for (int i = 0; i < p->num_fconsts; i++) {
+         if (memcmp(&p->fconsts[i], &val, sizeof(double)) == 0) {
+             return i;
+         }
+     }
+     if (p->num_fconsts >= p->cap_fconsts) {
+         p->cap_fconsts = p->cap_fconsts ? p->cap_fconsts * 2 : 16;
+         p->fconsts = realloc(p->fconsts, p->cap_fconsts * sizeof(double));
+         if (p->fconsts == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     p->fconsts[p->num_fconsts] = val;
+     return p->num_fconsts++;
+ }
+ 
+ /**
+  * new_temp():
+  *   Reserva un registro temporal nuevo (numerado desde MAX_VARS).
+  */
+ static int new_temp(void) {
+     return MAX_VARS + ir->num_temps++;
+ }
+ 
+ /**
+  * ir_is_jump(op):
+  *   1 si la instrucción transfiere el control (JMP/JZ).
+  */
+ static int ir_is_jump(OpCode op) {
+     return op == OP_JMP || op == OP_JZ;
+ }
+ 
+ /**
+  * ir_jump_target(in):
+  *   Destino de un salto (JMP lo guarda en a, JZ en b).
+  */
+ static int ir_jump_target(const Instr *in) {
+     return in->op == OP_JMP ? in->a : in->b;
+ }
+ 
+ /**
+  * ir_def(in):
+  *   Registro que escribe la instrucción, o -1 si no escribe ninguno.
+  *   OP_VLOOP no cuenta: las variables que adelanta las escribe también
+  *   el bucle que va detrás.
+  */
+ static int ir_def(const Instr *in) {
+     switch (in->op) {
+         case OP_CONST: case OP_MOV:
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_NEG:
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+         case OP_READ: case OP_UNDEF: case OP_TRIPS: case OP_POWSUM: case OP_PHI:
+         case OP_BOUND: case OP_DIV32:
+         case OP_FCONST: case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV:
+         case OP_FNEG: case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE:
+         case OP_FGT: case OP_FGE: case OP_ITOF: case OP_FTOI: case OP_READF:
+         case OP_TOCHR: case OP_READC:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_DIVO: case OP_NEGO:
+         case OP_LOAD: case OP_LOADC:
+         case OP_ASUM: case OP_ADOT: case OP_AMIN: case OP_AMAX: case OP_AFIND:
+         case OP_DGET: case OP_DHAS: case OP_DLEN:
+             return in->a;
+         default:
+             return -1;
+     }
+ }
+ 
+ /**
+  * ir_uses(in, uses):
+  *   Escribe en uses[] los registros que lee la instrucción y devuelve
+  *   cuántos son (como mucho 2). Los argumentos de una PHI no cuentan:
+  *   se leen en el borde de cada predecesor (ver p->phi_args).
+  */
+ static int ir_uses(const Instr *in, int uses[2]) {
+     switch (in->op) {
+         case OP_MOV: case OP_NEG: case OP_POWSUM:
+         case OP_FNEG: case OP_ITOF: case OP_FTOI: case OP_TOCHR: case OP_NEGO:
+         case OP_LOAD: case OP_LOADC: case OP_FILL: case OP_AFIND:
+         case OP_DGET: case OP_DHAS: case OP_DDEL:
+             uses[0] = in->b;
+             return 1;
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_DIVO:
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+         case OP_TRIPS: case OP_BOUND: case OP_DIV32:
+         case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV:
+         case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+         case OP_STORE: case OP_STOREC: case OP_VLOOP: case OP_DSET:
+             uses[0] = in->b;
+             uses[1] = in->c;
+             return 2;
+         case OP_JZ: case OP_PRINT: case OP_CHKDEF: case OP_CHKDIV:
+         case OP_PRINTF: case OP_PRINTC: case OP_CHKIDX:
+             uses[0] = in->a;
+             return 1;
+         default:
+             return 0;
+     }
+ }
+ 
+ /**
+  * ir_reads_a(op):
+  *   1 si la instrucción no escribe nada y lee su único registro en
+  *   a (saltos condicionales, Imprimir y comprobaciones).
+  */
+ static int ir_reads_a(OpCode op) {
+     return op == OP_JZ || op == OP_PRINT || op == OP_PRINTF || op == OP_PRINTC ||
+            op == OP_CHKDEF || op == OP_CHKDIV || op == OP_CHKIDX;
+ }
+ 
+ /**
+  * ir_is_read(op):
+  *   1 si la instrucción es un Leer (escribe un registro, pero consume
+  *   la entrada: no se puede quitar aunque nadie lea el resultado).
+  */
+ static int ir_is_read(OpCode op) {
+     return op == OP_READ || op == OP_READF || op == OP_READC;
+ }
+ 
+ /**
+  * ir_is_checked(op):
+  *   1 si es una operación comprobada (OP_ADDO..OP_NEGO): como un
+  *   Leer, no se puede quitar aunque nadie lea el resultado, porque
+  *   puede acabar el programa con un error.
+  */
+ static int ir_is_checked(OpCode op) {
+     return op >= OP_ADDO && op <= OP_NEGO;
+ }
+ 
+ /**
+  * ir_may_fail(op):
+  *   1 si la instrucción escribe un registro pero no se puede quitar
+  *   aunque nadie lo lea: un Leer, una operación comprobada o una
+  *   Suma o un Producto de un vector (también se pueden desbordar).
+  */
+ static int ir_may_fail(OpCode op) {
+     return ir_is_read(op) || ir_is_checked(op) || op == OP_ASUM || op == OP_ADOT;
+ }
+ 
+ /**
+  * ir_unchecked(op):
+  *   La operación sin comprobar que corresponde a op (op si ya lo es).
+  */
+ static OpCode ir_unchecked(OpCode op) {
+     return ir_is_checked(op) ? (OpCode)(OP_ADD + (op - OP_ADDO)) : op;
+ }
+ 
+ /**
+  * ir_finalize():
+  *   Compacta los temporales detrás de las variables: un temporal
+  *   MAX_VARS+k pasa a ser num_vars+k. Fija ir->num_regs.
+  */
+ static void ir_finalize(void) {
+     for (int i = 0; i < ir->num_code; i++) {
+         Instr *in = &ir->code[i];
+         int uses[2];
+         int n = ir_uses(in, uses);
+         int d = ir_def(in);
+         if (d >= MAX_VARS) {
+             in->a = d - MAX_VARS + num_vars;
+         }
+         for (int k = 0; k < n; k++) {
+             if (uses[k] < MAX_VARS) {
+                 continue;
+             }
+             int r = uses[k] - MAX_VARS + num_vars;
+             if (ir_reads_a(in->op)) {
+                 in->a = r;
+             } else if (k == 0) {
+                 in->b = r;
+             } else {
+                 in->c = r;
+             }
+         }
+     }
+     ir->num_regs = num_vars + ir->num_temps;
+ }
+ 
+ 
+ /*==============================================================
+  *      GENERADOR DE CÓDIGO (DESCENSO RECURSIVO SOBRE TOKENS)
+  *=============================================================*/
+ 
+ /*
+  * Las funciones gen_* siguen exactamente la gramática de las parse_*,
+  * pero en vez de evaluar emiten IR. Las de expresiones devuelven el
+  * registro donde queda el resultado y dejan en *type su tipo.
+  *
+  * Aquí se resuelven los tipos: cada operación se emite ya con la
+  * instrucción de su tipo (ADD o FADD…, con ITOF delante del operando
+  * entero si hace falta), así la VM y el JIT no comprueban nada al
+  * ejecutar.
+  */
+ static int  gen_expr(VarType *type);
+ static int  gen_rel_expr(VarType *type);
+ static int  gen_add_expr(VarType *type);
+ static int  gen_mul_expr(VarType *type);
+ static int  gen_unary_expr(VarType *type);
+ static int  gen_primary(VarType *type);
+ static int  gen_vec_call(int pos, VarType *type);
+ static int  gen_dict_call(int pos, VarType *type);
+ static void gen_stmt(void);
+ 
+ /*
+  * gen_move(dst, src):
+  *   Copia src en dst. Si src es el temporal que acaba de calcular la
+  *   última instrucción, se reescribe su destino y nos ahorramos el MOV.
+  */
+ static void gen_move(int dst, int src) {
+     if (src >= MAX_VARS && ir->num_code > 0 &&
+         ir_def(&ir->code[ir->num_code - 1]) == src) {
+         ir->code[ir->num_code - 1].a = dst;
+         return;
+     }
+     ir_emit(OP_MOV, dst, src, 0);
+ }
+ 
+ /**
+  * gen_convert(r, from, to):
+  *   Registro con el valor de r (de tipo from) convertido a to.
+  */
+ static int gen_convert(int r, VarType from, VarType to) {
+     if (from == to || (from == TYPE_CHAR && to == TYPE_INT)) {
+         return r;
+     }
+     int dst = new_temp();
+     if (to == TYPE_FLOAT) {
+         ir_emit(OP_ITOF, dst, r, 0);
+         return dst;
+     }
+     if (from == TYPE_FLOAT) {
+         ir_emit(OP_FTOI, dst, r, 0);
+         if (to == TYPE_INT) {
+             return dst;
+         }
+         r   = dst;
+         dst = new_temp();
+     }
+     ir_emit(OP_TOCHR, dst, r, 0);
+     return dst;
+ }
+ 
+ /**
+  * gen_symbol(pos):
+  *   Registro de la variable del IDENT del token pos. Si todavía no
+  *   existe se crea con el tipo que le dio la compilación del programa
+  *   entero (Entero si no se había visto). Anota su tipo en tok_type.
+  */
+ static int gen_symbol(int pos) {
+     if (lookup_array(tokens[pos].lexeme) >= 0) {
+         fprintf(stderr, "Error (línea %d): el vector '%s' se usa sin índice.\n",
+                 tokens[pos].line, tokens[pos].lexeme);
+         exit(1);
+     }
+     if (lookup_dict(tokens[pos].lexeme) >= 0) {
+         fprintf(stderr, "Error (línea %d): el diccionario '%s' se usa sin clave.\n",
+                 tokens[pos].line, tokens[pos].lexeme);
+         exit(1);
+     }
+     int idx = lookup_symbol(tokens[pos].lexeme);
+     if (idx < 0) {
+         idx = add_symbol(tokens[pos].lexeme);
+         symtab[idx].type = (VarType)tok_type[pos];
+     }
+     tok_type[pos] = (unsigned char)symtab[idx].type;
+     return idx;
+ }
+ 
+ /**
+  * gen_array(pos):
+  *   Vector del IDENT del token pos (seguido de '[', o argumento de
+  *   una función de vectores); tiene que estar declarado antes en el
+  *   texto.
+  */
+ static int gen_array(int pos) {
+     int a = lookup_array(tokens[pos].lexeme);
+     if (a < 0) {
+         fprintf(stderr, "Error (línea %d): '%s' no es un vector.\n",
+                 tokens[pos].line, tokens[pos].lexeme);
+         exit(1);
+     }
+     return a;
+ }
+ 
+ /**
+  * gen_subscript(a, d):
+  *   '[' <expr> ']' de la dimensión d del vector a (ver array_dim()):
+  *   registro con el índice, con su CHKIDX salvo que el programa
+  *   entero ya lo haya descartado (idx_is_safe[]).
+  */
+ static int gen_subscript(int a, int d) {
+     int pos = cur_token;
+     match(TOK_LBRACKET);
+     VarType type;
+     int r = gen_expr(&type);
+     match(TOK_RBRACKET);
+     if (type == TYPE_FLOAT) {
+         fprintf(stderr, "Error (línea %d): el índice de un vector tiene que ser Entero.\n",
+                 tokens[pos].line);
+         exit(1);
+     }
+     if (!idx_is_safe[pos]) {
+         ir_emit(OP_CHKIDX, r, a, pos);
+         ir->code[ir->num_code - 1].d = d;
+     }
+     return r;
+ }
+ 
+ /**
+  * gen_index(a):
+  *   Los índices del vector o la matriz a: registro con el elemento.
+  *   El de m[i][j] es i * columnas + j sin comprobar (los dos índices
+  *   ya están dentro); el MUL por una constante es lo que LICM saca
+  *   del bucle de j y la pasada de inducción reduce en el de i.
+  */
+ static int gen_index(int a) {
+     if (arrays[a].cols == 0) {
+         return gen_subscript(a, 0);
+     }
+     int i = gen_subscript(a, 1);
+     if (lookahead() != TOK_LBRACKET) {
+         fprintf(stderr, "Error (línea %d): la matriz '%s' necesita dos índices.\n",
+                 tokens[cur_token].line, arrays[a].name);
+         exit(1);
+     }
+     int j    = gen_subscript(a, 2);
+     int cols = new_temp();
+     int row  = new_temp();
+     int dst  = new_temp();
+     ir_emit(OP_CONST, cols, ir_const(arrays[a].cols), 0);
+     ir_emit(OP_MUL, row, i, cols);
+     ir_emit(OP_ADD, dst, row, j);
+     return dst;
+ }
+ 
+ /**
+  * gen_dict(pos):
+  *   Diccionario del IDENT del token pos; tiene que estar declarado
+  *   antes en el texto.
+  */
+ static int gen_dict(int pos) {
+     int d = lookup_dict(tokens[pos].lexeme);
+     if (d < 0) {
+         fprintf(stderr, "Error (línea %d): '%s' no es un diccionario.\n",
+                 tokens[pos].line, tokens[pos].lexeme);
+         exit(1);
+     }
+     return d;
+ }
+ 
+ /**
+  * gen_dict_key():
+  *   <expr> de una clave: registro con ella. Una clave es un Entero
+  *   (o un Caracter, que ya lo es), nunca un Flotante.
+  */
+ static int gen_dict_key(void) {
+     int pos = cur_token;
+     VarType type;
+     int r = gen_expr(&type);
+     if (type == TYPE_FLOAT) {
+         fprintf(stderr, "Error (línea %d): la clave de un diccionario tiene que ser Entero.\n",
+                 tokens[pos].line);
+         exit(1);
+     }
+     return r;
+ }
+ 
+ /**
+  * gen_dict_subscript():
+  *   '[' <expr> ']' de d[k]: registro con la clave.
+  */
+ static int gen_dict_subscript(void) {
+     match(TOK_LBRACKET);
+     int k = gen_dict_key();
+     match(TOK_RBRACKET);
+     return k;
+ }
+ 
+ /**
+  * gen_binary(op, pos, left, lt, right, rt, type):
+  *   Emite "left op right" (op entre OP_ADD y OP_GE, token pos). Si
+  *   algún operando es Flotante la operación es la F* equivalente y
+  *   el otro operando se convierte; si no, sin --wrap la aritmética
+  *   es la comprobada (OP_ADDO...).
+  */
+ static int gen_binary(OpCode op, int pos, int left, VarType lt, int right, VarType rt,
+                       VarType *type) {
+     int is_float = (lt == TYPE_FLOAT || rt == TYPE_FLOAT);
+     *type = (is_float && op < OP_EQ) ? TYPE_FLOAT : TYPE_INT;
+     if (is_float) {
+         left  = gen_convert(left, lt, TYPE_FLOAT);
+         right = gen_convert(right, rt, TYPE_FLOAT);
+         op    = (OpCode)(OP_FADD + (op - OP_ADD));
+     } else {
+         if (op == OP_DIV && !div_is_safe[pos]) {
+             ir_emit(OP_CHKDIV, right, pos, 0);
+         }
+         if (op <= OP_DIV && !int_wrap) {
+             op = (OpCode)(OP_ADDO + (op - OP_ADD));
+         }
+     }
+     int dst = new_temp();
+     ir_emit(op, dst, left, right);
+     return dst;
+ }
+ 
+ static int gen_expr(VarType *type) {
+     return gen_rel_expr(type);
+ }
+ 
+ static int gen_rel_expr(VarType *type) {
+     int left = gen_add_expr(type);
+ 
+     while (1) {
+         TokenType t = lookahead();
+         OpCode op;
+         switch (t) {
+             case TOK_EQ:  op = OP_EQ; break;
+             case TOK_NEQ: op = OP_NE; break;
+             case TOK_LT:  op = OP_LT; break;
+             case TOK_GT:  op = OP_GT; break;
+             case TOK_LE:  op = OP_LE; break;
+             case TOK_GE:  op = OP_GE; break;
+             default:      return left;
+         }
+         int pos = cur_token++;
+         VarType rt;
+         int right = gen_add_expr(&rt);
+         left = gen_binary(op, pos, left, *type, right, rt, type);
+     }
+ }
+ 
+ static int gen_add_expr(VarType *type) {
+     int left = gen_mul_expr(type);
+ 
+     while (lookahead() == TOK_PLUS || lookahead() == TOK_MINUS) {
+         OpCode op = (lookahead() == TOK_PLUS) ? OP_ADD : OP_SUB;
+         int pos = cur_token++;
+         VarType rt;
+         int right = gen_mul_expr(&rt);
+         left = gen_binary(op, pos, left, *type, right, rt, type);
+     }
+     return left;
+ }
+ 
+ static int gen_mul_expr(VarType *type) {
+     int left = gen_unary_expr(type);
+ 
+     while (lookahead() == TOK_MULT || lookahead() == TOK_DIV) {
+         OpCode op = (lookahead() == TOK_MULT) ? OP_MUL : OP_DIV;
+         int pos = cur_token++;
+         VarType rt;
+         int right = gen_unary_expr(&rt);
+         left = gen_binary(op, pos, left, *type, right, rt, type);
+     }
+     return left;
+ }
+ 
+ static int gen_unary_expr(VarType *type) {
+     if (lookahead() == TOK_MINUS) {
+         cur_token++;
+         int val = gen_primary(type);
+         int dst = new_temp();
+         if (*type == TYPE_FLOAT) {
+             ir_emit(OP_FNEG, dst, val, 0);
+         } else {
+             *type = TYPE_INT;
+             ir_emit(int_wrap ? OP_NEG : OP_NEGO, dst, val, 0);
+         }
+         return dst;
+     }
+     return gen_primary(type);
+ }
+ 
+ static int gen_primary(VarType *type) {
+     *type = TYPE_INT;
+     if (lookahead() == TOK_LPAREN) {
+         match(TOK_LPAREN);
+         int r = gen_expr(type);
+         match(TOK_RPAREN);
+         return r;
+     } else if (lookahead() == TOK_NUM || lookahead() == TOK_CHARLIT) {
+         int dst = new_temp();
+         long long val = strtoll(tokens[cur_token].lexeme, NULL, 10);
+         if (lookahead() == TOK_CHARLIT) {
+             val   = char_literal(tokens[cur_token].lexeme);
+             *type = TYPE_CHAR;
+         }
+         ir_emit(OP_CONST, dst, ir_const(val), 0);
+         cur_token++;
+         return dst;
+     } else if (lookahead() == TOK_REAL) {
+         int dst = new_temp();
+         ir_emit(OP_FCONST, dst, ir_fconst_in(ir, strtod(tokens[cur_token].lexeme, NULL)), 0);
+         cur_token++;
+         *type = TYPE_FLOAT;
+         return dst;
+     } else if (lookahead() == TOK_IDENT) {
+         // Leemos directamente el registro de la variable; CHKDEF
+         // reproduce el error de get_symbol_value() si no tiene valor
+         // (en una región sobra si el programa entero ya lo descartó).
+         int pos = cur_token;
+         cur_token++;
+         if (lookahead() == TOK_LBRACKET && lookup_dict(tokens[pos].lexeme) >= 0) {
+             int d   = lookup_dict(tokens[pos].lexeme);
+             int k   = gen_dict_subscript();
+             int dst = new_temp();
+             ir_emit(OP_DGET, dst, k, d);
+             *type = TYPE_INT;
+             return dst;
+         }
+         if (lookahead() == TOK_LBRACKET) {
+             int a   = gen_array(pos);
+             int i   = gen_index(a);
+             int dst = new_temp();
+             ir_emit(arrays[a].type == TYPE_CHAR ? OP_LOADC : OP_LOAD, dst, i, a);
+             *type = arrays[a].type;
+             return dst;
+         }
+         if (lookahead() == TOK_LPAREN) {
+             return (dict_func(tokens[pos].lexeme) != DICT_NONE) ? gen_dict_call(pos, type)
+                                                                 : gen_vec_call(pos, type);
+         }
+         int undeclared = (lookup_symbol(tokens[pos].lexeme) < 0);
+         int idx = gen_symbol(pos);
+         if (undeclared || !read_is_safe[pos] || (region_big != NULL && region_big[idx])) {
+             ir_emit(OP_CHKDEF, idx, undeclared, pos);
+         }
+         *type = symtab[idx].type;
+         return idx;
+     } else {
+         fprintf(stderr,
+                 "Error de sintaxis en <primary>: se esperaba "
+                 "NUM, REAL, CHARLIT, IDENT o '(', pero vino '%s'.\n",
+                 tokens[cur_token].lexeme);
+         exit(1);
+     }
+     return -1; // para evitar warning
+ }
+ 
+ /**
+  * gen_vec_arg():
+  *   Un argumento de una función de vectores: el nombre de un vector.
+  */
+ static int gen_vec_arg(void) {
+     int pos = cur_token;
+     expect_ident();
+     return gen_array(pos);
+ }
+ 
+ /**
+  * gen_sort_arg(pos, f, a, xt):
+  *   Ordenar y Buscar (la llamada del token pos) solo ordenan enteros:
+  *   el vector a y, en Buscar, el valor x (de tipo xt) no pueden ser
+  *   de Flotante.
+  */
+ static void gen_sort_arg(int pos, VecFunc f, int a, VarType xt) {
+     if (arrays[a].type == TYPE_FLOAT || xt == TYPE_FLOAT) {
+         fprintf(stderr, "Error (línea %d): %s necesita un vector de Entero o Caracter%s "
+                         "('%s' es %s).\n",
+                 tokens[pos].line, vec_func_name[f],
+                 (f == VEC_FIND) ? " y un valor que no sea Flotante" : "",
+                 arrays[a].name, type_name[arrays[a].type]);
+         exit(1);
+     }
+ }
+ 
+ /**
+  * gen_vec_call(pos, type):
+  *   '(' ... ')' de la llamada del token pos. Suma y Producto de un
+  *   Caracter dan Entero (la suma no cabe en 8 bits), y Buscar, la
+  *   posición; el resto, el tipo de los elementos.
+  */
+ static int gen_vec_call(int pos, VarType *type) {
+     VecFunc f = vec_func(tokens[pos].lexeme);
+     if (f >= VEC_FILL) {
+         fprintf(stderr, "Error (línea %d): '%s' no es una función%s.\n", tokens[pos].line,
+                 tokens[pos].lexeme, (f != VEC_NONE) ? " que dé un valor" : "");
+         exit(1);
+     }
+     match(TOK_LPAREN);
+     int a = gen_vec_arg();
+     int b = 0;
+     if (f == VEC_FIND) {
+         match(TOK_COMMA);
+         VarType xt;
+         int x = gen_expr(&xt);
+         match(TOK_RPAREN);
+         gen_sort_arg(pos, f, a, xt);
+         int dst = new_temp();
+         ir_emit(OP_AFIND, dst, x, a);
+         *type = TYPE_INT;
+         return dst;
+     }
+     if (f == VEC_DOT) {
+         match(TOK_COMMA);
+         b = gen_vec_arg();
+         if (arrays[a].type != arrays[b].type || arrays[a].len != arrays[b].len) {
+             char sa[48], sb[48];
+             fprintf(stderr, "Error (línea %d): Producto necesita dos vectores del mismo "
+                             "tipo y tamaño ('%s' es %s%s y '%s' es %s%s).\n",
+                     tokens[pos].line, arrays[a].name, type_name[arrays[a].type],
+                     array_shape(&arrays[a], sa), arrays[b].name, type_name[arrays[b].type],
+                     array_shape(&arrays[b], sb));
+             exit(1);
+         }
+     }
+     match(TOK_RPAREN);
+     int dst = new_temp();
+     ir_emit((OpCode)(OP_ASUM + f), dst, a, b);
+     *type = arrays[a].type;
+     if (*type == TYPE_CHAR && (f == VEC_SUM || f == VEC_DOT)) {
+         *type = TYPE_INT;
+     }
+     return dst;
+ }
+ 
+ /**
+  * gen_dict_arg():
+  *   Un argumento de una función de diccionarios: el nombre de un
+  *   diccionario.
+  */
+ static int gen_dict_arg(void) {
+     int pos = cur_token;
+     expect_ident();
+     return gen_dict(pos);
+ }
+ 
+ /**
+  * gen_dict_call(pos, type):
+  *   '(' ... ')' de Contiene o Tamano, la llamada del token pos; las
+  *   dos dan Entero.
+  */
+ static int gen_dict_call(int pos, VarType *type) {
+     DictFunc f = dict_func(tokens[pos].lexeme);
+     if (f >= DICT_DEL) {
+         fprintf(stderr, "Error (línea %d): '%s' no es una función que dé un valor.\n",
+                 tokens[pos].line, tokens[pos].lexeme);
+         exit(1);
+     }
+     match(TOK_LPAREN);
+     int d   = gen_dict_arg();
+     int dst = new_temp();
+     if (f == DICT_HAS) {
+         match(TOK_COMMA);
+         int k = gen_dict_key();
+         ir_emit(OP_DHAS, dst, k, d);
+     } else {
+         ir_emit(OP_DLEN, dst, d, 0);
+     }
+     match(TOK_RPAREN);
+     *type = TYPE_INT;
+     return dst;
+ }
+ 
+ /**
+  * gen_cond():
+  *   Condición de un Si o un Mientras. La de tipo Flotante se compara
+  *   con 0.0, así el JZ siempre es entero.
+  */
+ static int gen_cond(void) {
+     VarType type;
+     int r = gen_expr(&type);
+     if (type != TYPE_FLOAT) {
+         return r;
+     }
+     int zero = new_temp();
+     int dst  = new_temp();
+     ir_emit(OP_FCONST, zero, ir_fconst_in(ir, 0.0), 0);
+     ir_emit(OP_FNE, dst, r, zero);
+     return dst;
+ }
+ 
+ /**
+  * gen_array_size(varname):
+  *   '[' NUM ']' de la declaración del vector varname.
+  */
+ static long long gen_array_size(const char *varname) {
+     match(TOK_LBRACKET);
+     long long len = strtoll(tokens[cur_token].lexeme, NULL, 10);
+     if (lookahead() != TOK_NUM || len < 1 || len > MAX_ARRAY_LEN) {
+         fprintf(stderr, "Error (línea %d): el tamaño del vector '%s' tiene que ser "
+                         "un número entre 1 y %d.\n", gen_line, varname, MAX_ARRAY_LEN);
+         exit(1);
+     }
+     cur_token++;
+     match(TOK_RBRACKET);
+     return len;
+ }
+ 
+ /**
+  * gen_array_decl(varname, type):
+  *   '[' NUM ']' [ '[' NUM ']' ] de la declaración del vector (o la
+  *   matriz) varname.
+  */
+ static void gen_array_decl(const char *varname, VarType type) {
+     long long len  = gen_array_size(varname);
+     long long cols = 0;
+     if (lookahead() == TOK_LBRACKET) {
+         cols = gen_array_size(varname);
+         if (len > MAX_ARRAY_LEN / cols) {
+             fprintf(stderr, "Error (línea %d): la matriz '%s' tiene más de %d elementos.\n",
+                     gen_line, varname, MAX_ARRAY_LEN);
+             exit(1);
+         }
+         len *= cols;
+     }
+     if (lookup_symbol(varname) >= 0 || lookup_dict(varname) >= 0) {
+         fprintf(stderr, "Error (línea %d): '%s' ya es %s; no se puede "
+                         "declarar como vector.\n", gen_line, varname,
+                 (lookup_dict(varname) >= 0) ? "un diccionario" : "una variable");
+         exit(1);
+     }
+     int a = lookup_array(varname);
+     if (a >= 0 && (arrays[a].type != type || arrays[a].len != len || arrays[a].cols != cols)) {
+         Array want = { "", type, len, cols, NULL };
+         char  sa[48], sw[48];
+         fprintf(stderr, "Error (línea %d): el vector '%s' ya es %s%s; no se "
+                         "puede declarar %s%s.\n", gen_line, varname,
+                 type_name[arrays[a].type], array_shape(&arrays[a], sa),
+                 type_name[type], array_shape(&want, sw));
+         exit(1);
+     }
+     ir_emit(OP_ZERO, add_array(varname, type, len, cols), 0, 0);
+ }
+ 
+ /*
+  * <decl_stmt>: cada variable se declara con UNDEF y, si tiene
+  * inicializador, se le asigna a continuación. Aquí se fija el tipo
+  * de la variable; declararla otra vez con otro tipo es un error.
+  * Un vector se da de alta aquí (add_array) y su declaración es un
+  * ZERO; otra con otro tipo o tamaño también es un error.
+  */
+ static void gen_decl_stmt(void) {
+     TokenType t = lookahead();
+     VarType   type = TYPE_INT;
+     if (t == TOK_INT || t == TOK_CHAR || t == TOK_FLOAT) {
+         type = (t == TOK_FLOAT) ? TYPE_FLOAT : (t == TOK_CHAR) ? TYPE_CHAR : TYPE_INT;
+         cur_token++;
+     } else {
+         fprintf(stderr,
+                 "Error de sintaxis en <decl_stmt>: se esperaba tipo 'Entero', 'Caracter' o 'Flotante', "
+                 "pero vino '%s'.\n",
+                 tokens[cur_token].lexeme);
+         exit(1);
+     }
+ 
+     while (1) {
+         int   pos     = cur_token;
+         char *varname = expect_ident();
+         int   idx     = lookup_symbol(varname);
+         if (lookahead() == TOK_LBRACKET) {
+             gen_array_decl(varname, type);
+         } else {
+             if (lookup_array(varname) >= 0 || lookup_dict(varname) >= 0) {
+                 fprintf(stderr, "Error (línea %d): '%s' ya es %s; no se puede "
+                                 "declarar como variable.\n", gen_line, varname,
+                         (lookup_dict(varname) >= 0) ? "un diccionario" : "un vector");
+                 exit(1);
+             }
+             if (idx >= 0 && symtab[idx].type != type) {
+                 fprintf(stderr, "Error (línea %d): la variable '%s' ya es %s; no se puede "
+                                 "declarar %s.\n",
+                         gen_line, varname, type_name[symtab[idx].type], type_name[type]);
+                 exit(1);
+             }
+             idx = add_symbol(varname);
+             symtab[idx].type = type;
+             tok_type[pos]    = (unsigned char)type;
+             ir_emit(OP_UNDEF, idx, 0, 0);
+             if (lookahead() == TOK_ASSIGN) {
+                 match(TOK_ASSIGN);
+                 VarType et;
+                 int r = gen_expr(&et);
+                 gen_move(idx, gen_convert(r, et, type));
+             }
+         }
+         if (lookahead() == TOK_COMMA) {
+             match(TOK_COMMA);
+         } else {
+             break;
+         }
+     }
+     match(TOK_SEMI);
+ }
+ 
+ /*
+  * <decl_stmt> de diccionarios: cada uno se da de alta aquí
+  * (add_dict) y su declaración es un DNEW, que lo vacía.
+  */
+ static void gen_dict_decl(void) {
+     match(TOK_DICT);
+     while (1) {
+         char *name = expect_ident();
+         if (lookup_symbol(name) >= 0 || lookup_array(name) >= 0) {
+             fprintf(stderr, "Error (línea %d): '%s' ya es %s; no se puede "
+                             "declarar como diccionario.\n", gen_line, name,
+                     (lookup_array(name) >= 0) ? "un vector" : "una variable");
+             exit(1);
+         }
+         ir_emit(OP_DNEW, add_dict(name), 0, 0);
+         if (lookahead() != TOK_COMMA) {
+             break;
+         }
+         match(TOK_COMMA);
+     }
+     match(TOK_SEMI);
+ }
+ 
+ static void gen_print_stmt(void) {
+     static const OpCode print_op[] = { OP_PRINT, OP_PRINTC, OP_PRINTF };
+     match(TOK_PRINT);
+     match(TOK_LPAREN);
+     VarType type;
+     int r = gen_expr(&type);
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     ir_emit(print_op[type], r, 0, 0);
+ }
+ 
+ static void gen_read_stmt(void) {
+     static const OpCode read_op[] = { OP_READ, OP_READC, OP_READF };
+     match(TOK_READ);
+     match(TOK_LPAREN);
+     int pos = cur_token;
+     expect_ident();
+     if (lookahead() == TOK_LBRACKET && lookup_dict(tokens[pos].lexeme) >= 0) {
+         int d = lookup_dict(tokens[pos].lexeme);
+         int k = gen_dict_subscript();
+         int t = new_temp();
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         ir_emit(OP_READ, t, 0, 0);
+         ir_emit(OP_DSET, d, k, t);
+         return;
+     }
+     if (lookahead() == TOK_LBRACKET) {
+         int a = gen_array(pos);
+         int i = gen_index(a);
+         int t = new_temp();
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         ir_emit(read_op[arrays[a].type], t, 0, 0);
+         ir_emit(arrays[a].type == TYPE_CHAR ? OP_STOREC : OP_STORE, a, i, t);
+         return;
+     }
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     int idx = gen_symbol(pos);
+     ir_emit(read_op[symtab[idx].type], idx, 0, 0);
+ }
+ 
+ /**
+  * gen_matrix_args(pos, f, m, n):
+  *   Comprueba los n argumentos m[] de Multiplicar (c, a, b) o
+  *   Trasponer (t, a), la llamada del token pos: matrices del mismo
+  *   tipo, con las dimensiones que casan y el resultado aparte de las
+  *   otras (se escribe mientras se leen).
+  */
+ static void gen_matrix_args(int pos, VecFunc f, const int *m, int n) {
+     const Array *c = &arrays[m[0]], *a = &arrays[m[1]];
+     const Array *b = (n == 3) ? &arrays[m[2]] : a;
+     for (int k = 0; k < n; k++) {
+         if (arrays[m[k]].cols == 0) {
+             fprintf(stderr, "Error (línea %d): '%s' no es una matriz.\n",
+                     tokens[pos].line, arrays[m[k]].name);
+             exit(1);
+         }
+         if (k > 0 && m[k] == m[0]) {
+             fprintf(stderr, "Error (línea %d): el resultado de %s no puede ser también "
+                             "un argumento ('%s').\n",
+                     tokens[pos].line, vec_func_name[f], c->name);
+             exit(1);
+         }
+     }
+     long long rows_a = a->len / a->cols, rows_b = b->len / b->cols;
+     int ok = (c->type == a->type && b->type == a->type);
+     if (f == VEC_MATMUL) {
+         ok = ok && a->type != TYPE_CHAR && a->cols == rows_b &&
+              c->len / c->cols == rows_a && c->cols == b->cols;
+     } else {
+         ok = ok && c->len / c->cols == a->cols && c->cols == rows_a;
+     }
+     if (!ok) {
+         char sc[48], sa[48], sb[48];
+         fprintf(stderr, "Error (línea %d): %s necesita %s ('%s' es %s%s, '%s' es %s%s",
+                 tokens[pos].line, vec_func_name[f],
+                 (f == VEC_MATMUL) ? "matrices de Entero o Flotante c[N][M], a[N][K] y b[K][M]"
+                                   : "matrices del mismo tipo t[M][N] y a[N][M]",
+                 c->name, type_name[c->type], array_shape(c, sc),
+                 a->name, type_name[a->type], array_shape(a, sa));
+         if (n == 3) {
+             fprintf(stderr, " y '%s' es %s%s", b->name, type_name[b->type], array_shape(b, sb));
+         }
+         fprintf(stderr, ").\n");
+         exit(1);
+     }
+ }
+ 
+ /*
+  * <call_stmt> de diccionarios: Borrar es un DDEL y Claves, un DKEYS
+  * (en un vector de Entero: una clave no cabe en un Caracter).
+  */
+ static void gen_dict_stmt(int pos, DictFunc f) {
+     match(TOK_LPAREN);
+     if (f == DICT_KEYS) {
+         int a = gen_vec_arg();
+         match(TOK_COMMA);
+         int d = gen_dict_arg();
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         if (arrays[a].type != TYPE_INT) {
+             fprintf(stderr, "Error (línea %d): Claves necesita un vector de Entero "
+                             "('%s' es %s).\n",
+                     tokens[pos].line, arrays[a].name, type_name[arrays[a].type]);
+             exit(1);
+         }
+         ir_emit(OP_DKEYS, a, d, 0);
+         return;
+     }
+     int d = gen_dict_arg();
+     match(TOK_COMMA);
+     int k = gen_dict_key();
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     ir_emit(OP_DDEL, d, k, 0);
+ }
+ 
+ /*
+  * <call_stmt>: Llenar es un FILL con el valor convertido como en la
+  * escritura de un elemento (FILL de un Caracter también se queda
+  * con sus 8 bits bajos); Ordenar, SORT, y Multiplicar y Trasponer,
+  * MATMUL y TRANSP. Las de diccionarios van por gen_dict_stmt().
+  */
+ static void gen_call_stmt(void) {
+     int pos = cur_token;
+     expect_ident();
+     VecFunc  f = vec_func(tokens[pos].lexeme);
+     DictFunc g = dict_func(tokens[pos].lexeme);
+     if ((f < VEC_FILL || f == VEC_NONE) && (g < DICT_DEL || g == DICT_NONE)) {
+         fprintf(stderr, "Error (línea %d): '%s' no es una sentencia; las llamadas "
+                         "que pueden ir solas son Llenar(v, x), Ordenar(v), "
+                         "Multiplicar(c, a, b), Trasponer(t, m), Borrar(d, k) "
+                         "y Claves(v, d).\n",
+                 tokens[pos].line, tokens[pos].lexeme);
+         exit(1);
+     }
+     if (g != DICT_NONE) {
+         gen_dict_stmt(pos, g);
+         return;
+     }
+     match(TOK_LPAREN);
+     int a = gen_vec_arg();
+     if (f == VEC_SORT) {
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         gen_sort_arg(pos, f, a, TYPE_INT);
+         ir_emit(OP_SORT, a, 0, 0);
+         return;
+     }
+     match(TOK_COMMA);
+     if (f == VEC_FILL) {
+         VarType type;
+         int val = gen_expr(&type);
+         match(TOK_RPAREN);
+         match(TOK_SEMI);
+         VarType to = (arrays[a].type == TYPE_CHAR && type != TYPE_FLOAT) ? type : arrays[a].type;
+         ir_emit(OP_FILL, a, gen_convert(val, type, to), 0);
+         return;
+     }
+     int m[3] = { a, gen_vec_arg(), 0 };
+     if (f == VEC_MATMUL) {
+         match(TOK_COMMA);
+         m[2] = gen_vec_arg();
+     }
+     match(TOK_RPAREN);
+     match(TOK_SEMI);
+     gen_matrix_args(pos, f, m, (f == VEC_MATMUL) ? 3 : 2);
+     ir_emit((OpCode)(OP_ASUM + f), m[0], m[1], m[2]);
+ }
+ 
+ static void gen_assign_stmt(void) {
+     int start = cur_token;
+     expect_ident();
+     if (lookahead() == TOK_LBRACKET && lookup_dict(tokens[start].lexeme) >= 0) {
+         // Como un Entero: el valor se convierte y la clave ya lo es
+         int d = lookup_dict(tokens[start].lexeme);
+         int k = gen_dict_subscript();
+         match(TOK_ASSIGN);
+         VarType type;
+         int val = gen_expr(&type);
+         match(TOK_SEMI);
+         ir_emit(OP_DSET, d, k, gen_convert(val, type, TYPE_INT));
+         return;
+     }
+     if (lookahead() == TOK_LBRACKET) {
+         // El índice se comprueba antes de evaluar la expresión, como
+         // en parse_assign_stmt(); STOREC ya se queda con los 8 bits
+         // bajos, así que un Entero no necesita su TOCHR
+         int a = gen_array(start);
+         int i = gen_index(a);
+         match(TOK_ASSIGN);
+         VarType type;
+         int val = gen_expr(&type);
+         match(TOK_SEMI);
+         VarType to = (arrays[a].type == TYPE_CHAR && type != TYPE_FLOAT) ? type : arrays[a].type;
+         ir_emit(arrays[a].type == TYPE_CHAR ? OP_STOREC : OP_STORE, a, i,
+                 gen_convert(val, type, to));
+         return;
+     }
+     match(TOK_ASSIGN);
+     // Igual que set_symbol_value(): la variable se crea después de
+     // evaluar la expresión, así "x = x + 1" sin declarar sigue
+     // fallando como "no declarada".
+     VarType type;
+     int val = gen_expr(&type);
+     match(TOK_SEMI);
+     int idx = gen_symbol(start);
+     gen_move(idx, gen_convert(val, type, symtab[idx].type));
+     ir->code[ir->num_code - 1].d = start + 1;
+ }
+ 
+ /*
+  * <if_stmt>:
+  *        cond
+  *        JZ cond, L_sino
+  *        <stmt THEN>
+  *        JMP L_fin          (solo si hay 'Sino')
+  *   L_sino:
+  *        <stmt ELSE>
+  *   L_fin:
+  */
+ static void gen_if_stmt(void) {
+     match(TOK_IF);
+     match(TOK_LPAREN);
+     int cond = gen_cond();
+     match(TOK_RPAREN);
+ 
+     int jz = ir_emit(OP_JZ, cond, -1, 0);
+     gen_stmt();
+     if (lookahead() == TOK_ELSE) {
+         match(TOK_ELSE);
+         int jmp = ir_emit(OP_JMP, -1, 0, 0);
+         ir->code[jz].b = ir->num_code;
+         gen_stmt();
+         ir->code[jmp].a = ir->num_code;
+     } else {
+         ir->code[jz].b = ir->num_code;
+     }
+ }
+ 
+ /*
+  * <while_stmt>:
+  *   L_cond:
+  *        cond
+  *        JZ cond, L_fin
+  *        <stmt>
+  *        JMP L_cond
+  *   L_fin:
+  */
+ static void gen_while_stmt(void) {
+     match(TOK_WHILE);
+     match(TOK_LPAREN);
+     int head = ir->num_code;
+     int cond = gen_cond();
+     match(TOK_RPAREN);
+ 
+     int jz = ir_emit(OP_JZ, cond, -1, 0);
+     gen_stmt();
+     ir_emit(OP_JMP, head, 0, 0);
+     ir->code[jz].b = ir->num_code;
+ }
+ 
+ static void gen_block_stmt(void) {
+     match(TOK_LBRACE);
+     while (lookahead() != TOK_RBRACE && lookahead() != TOK_EOF) {
+         gen_stmt();
+     }
+     match(TOK_RBRACE);
+ }
+ 
+ static void gen_stmt(void) {
+     int start = cur_token;
+     gen_line = tokens[cur_token].line;
+     switch (lookahead()) {
+         case TOK_INT:
+         case TOK_CHAR:
+         case TOK_FLOAT:
+             gen_decl_stmt();
+             break;
+         case TOK_DICT:
+             gen_dict_decl();
+             break;
+         case TOK_PRINT:
+             gen_print_stmt();
+             break;
+         case TOK_READ:
+             gen_read_stmt();
+             break;
+         case TOK_IDENT:
+             if (tokens[cur_token + 1].type == TOK_LPAREN) {
+                 gen_call_stmt();
+                 break;
+             }
+             gen_assign_stmt();
+             break;
+         case TOK_IF:
+             gen_if_stmt();
+             break;
+         case TOK_WHILE:
+             gen_while_stmt();
+             break;
+         case TOK_LBRACE:
+             gen_block_stmt();
+             break;
+         default:
+             fprintf(stderr,
+                     "Error de sintaxis en <stmt>: token inesperado '%s'.\n",
+                     tokens[cur_token].lexeme);
+             exit(1);
+     }
+     stmt_end[start] = cur_token;
+ }
+ 
+ /**
+  * compile_program():
+  *   Genera el IR de todo el programa (desde cur_token hasta EOF),
+  *   terminado en HALT.
+  */
+ static IRProgram *compile_program(void) {
+     ir = ir_new();
+     while (lookahead() != TOK_EOF) {
+         gen_stmt();
+     }
+     match(TOK_EOF);
+     ir_emit(OP_HALT, 0, 0, 0);
+     ir_finalize();
+     ir->whole_program = 1;
+     return ir;
+ }
+ 
+ 
+ /*==============================================================
+  *                     OPTIMIZADOR DEL IR
+  *=============================================================*/
+ 
+ /*--------------------------------------------------------------
+  * Grafo de flujo de control: bloques básicos del IR. Un bloque
+  * empieza en la instrucción 0, en cada destino de salto y detrás
+  * de cada salto o HALT.
+  *-------------------------------------------------------------*/
+ typedef struct {
+     int  start, end;        // instrucciones [start, end)
+     int  succ[2];
+     int  num_succ;
+     int *preds;
+     int  num_preds;
+ } BasicBlock;
+ 
+ typedef struct {
+     BasicBlock *blocks;
+     int         num_blocks;
+     int        *block_of;   // instrucción -> bloque
+ } CFG;
+ 
+ /**
+  * cfg_build(p):
+  *   Parte p en bloques básicos y enlaza sucesores y predecesores.
+  */
+ static CFG *cfg_build(const IRProgram *p) {
+     CFG  *g      = calloc(1, sizeof(CFG));
+     char *leader = calloc(p->num_code + 1, 1);
+     leader[0] = 1;
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         if (ir_is_jump(in->op)) {
+             leader[ir_jump_target(in)] = 1;
+         }
+         if (ir_is_jump(in->op) || in->op == OP_HALT) {
+             leader[i + 1] = 1;
+         }
+     }
+     for (int i = 0; i < p->num_code; i++) {
+         g->num_blocks += leader[i];
+     }
+ 
+     g->blocks   = calloc(g->num_blocks, sizeof(BasicBlock));
+     g->block_of = malloc(p->num_code * sizeof(int));
+     int b = -1;
+     for (int i = 0; i < p->num_code; i++) {
+         if (leader[i]) {
+             b++;
+             g->blocks[b].start = i;
+         }
+         g->blocks[b].end = i + 1;
+         g->block_of[i] = b;
+     }
+     free(leader);
+ 
+     for (b = 0; b < g->num_blocks; b++) {
+         BasicBlock *bb = &g->blocks[b];
+         const Instr *last = &p->code[bb->end - 1];
+         if (last->op == OP_JMP) {
+             bb->succ[bb->num_succ++] = g->block_of[last->a];
+         } else if (last->op != OP_HALT && bb->end < p->num_code) {
+             bb->succ[bb->num_succ++] = b + 1;
+         }
+         if (last->op == OP_JZ) {
+             bb->succ[bb->num_succ++] = g->block_of[last->b];
+         }
+     }
+     for (b = 0; b < g->num_blocks; b++) {
+         for (int k = 0; k < g->blocks[b].num_succ; k++) {
+             g->blocks[g->blocks[b].succ[k]].num_preds++;
+         }
+     }
+     for (b = 0; b < g->num_blocks; b++) {
+         g->blocks[b].preds = malloc((g->blocks[b].num_preds + 1) * sizeof(int));
+         g->blocks[b].num_preds = 0;
+     }
+     for (b = 0; b < g->num_blocks; b++) {
+         for (int k = 0; k < g->blocks[b].num_succ; k++) {
+             BasicBlock *s = &g->blocks[g->blocks[b].succ[k]];
+             s->preds[s->num_preds++] = b;
+         }
+     }
+     return g;
+ }
+ 
+ static void cfg_free(CFG *g) {
+     for (int b = 0; b < g->num_blocks; b++) {
+         free(g->blocks[b].preds);
+     }
+     free(g->blocks);
+     free(g->block_of);
+     free(g);
+ }
+ 
+ /**
+  * cfg_always_reached(g, reached, b):
+  *   1 si todo camino de la entrada al final del programa pasa por el
+  *   bloque b (b posdomina a la entrada), contando solo los bloques
+  *   marcados en reached[]: sin b, el final no se alcanza.
+  */
+ static int cfg_always_reached(const CFG *g, const char *reached, int b) {
+     int   nb    = g->num_blocks;
+     char *seen  = calloc(nb, 1);
+     int  *stack = malloc(nb * sizeof(int));
+     int   sp    = 0;
+     int   always = 1;
+ 
+     if (b != 0) {
+         seen[0] = 1;
+         stack[sp++] = 0;
+     }
+     while (sp > 0 && always) {
+         const BasicBlock *x = &g->blocks[stack[--sp]];
+         always = (x->num_succ > 0);
+         for (int k = 0; k < x->num_succ; k++) {
+             int y = x->succ[k];
+             if (y != b && reached[y] && !seen[y]) {
+                 seen[y] = 1;
+                 stack[sp++] = y;
+             }
+         }
+     }
+     free(stack);
+     free(seen);
+     return always;
+ }
+ 
+ /**
+  * loop_blocks(g, h, b):
+  *   Marca los bloques del bucle b -> h: h y los que llegan a b sin
+  *   pasar por h. El vector (uno por bloque) lo libera el llamador.
+  */
+ static char *loop_blocks(const CFG *g, int h, int b) {
+     int   nb      = g->num_blocks;
+     char *in_loop = calloc(nb, 1);
+     int  *stack   = malloc(nb * sizeof(int));
+     int   sp      = 0;
+ 
+     in_loop[h] = 1;
+     if (!in_loop[b]) {
+         in_loop[b] = 1;
+         stack[sp++] = b;
+     }
+     while (sp > 0) {
+         int x = stack[--sp];
+         for (int k = 0; k < g->blocks[x].num_preds; k++) {
+             int y = g->blocks[x].preds[k];
+             if (!in_loop[y]) {
+                 in_loop[y] = 1;
+                 stack[sp++] = y;
+             }
+         }
+     }
+     free(stack);
+     return in_loop;
+ }
+ 
+ /**
+  * cfg_dominators(g, order, idom):
+  *   Dominadores inmediatos (Cooper, Harvey y Kennedy): se recorren
+  *   los bloques en orden posterior inverso hasta que nada cambia.
+  *   Deja ese orden en order[] (solo los bloques alcanzables desde la
+  *   entrada; devuelve cuántos son) y en idom[b] el dominador
+  *   inmediato de b (la entrada es el suyo; -1 si b no se alcanza).
+  */
+ static int cfg_dominators(const CFG *g, int *order, int *idom) {
+     int  nb    = g->num_blocks;
+     int *pos   = malloc(nb * sizeof(int));
+     int *stack = malloc(nb * sizeof(int));
+     int *next  = calloc(nb, sizeof(int));
+     int  sp    = 0;
+     int  np    = 0;
+ 
+     for (int b = 0; b < nb; b++) {
+         idom[b] = -1;
+         pos[b]  = -1;
+     }
+     if (nb == 0) {
+         free(pos);
+         free(stack);
+         free(next);
+         return 0;
+     }
+     // Orden posterior con una pila explícita; pos[] marca lo visto
+     pos[0] = 0;
+     stack[sp++] = 0;
+     while (sp > 0) {
+         int x = stack[sp - 1];
+         if (next[x] < g->blocks[x].num_succ) {
+             int y = g->blocks[x].succ[next[x]++];
+             if (pos[y] < 0) {
+                 pos[y] = 0;
+                 stack[sp++] = y;
+             }
+         } else {
+             order[np++] = x;
+             sp--;
+         }
+     }
+     for (int k = 0; k < np / 2; k++) {
+         int t = order[k];
+         order[k] = order[np - 1 - k];
+         order[np - 1 - k] = t;
+     }
+     for (int k = 0; k < np; k++) {
+         pos[order[k]] = k;
+     }
+ 
+     idom[order[0]] = order[0];
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         for (int k = 1; k < np; k++) {
+             int b = order[k];
+             int d = -1;
+             for (int j = 0; j < g->blocks[b].num_preds; j++) {
+                 int x = g->blocks[b].preds[j];
+                 if (idom[x] < 0) {
+                     continue;
+                 }
+                 int y = d;
+                 if (y < 0) {
+                     d = x;
+                     continue;
+                 }
+                 while (x != y) {
+                     while (pos[x] > pos[y]) {
+                         x = idom[x];
+                     }
+                     while (pos[y] > pos[x]) {
+                         y = idom[y];
+                     }
+                 }
+                 d = x;
+             }
+             if (idom[b] != d) {
+                 idom[b] = d;
+                 changed = 1;
+             }
+         }
+     }
+ 
+     free(pos);
+     free(stack);
+     free(next);
+     return np;
+ }
+ 
+ /**
+  * ir_compact(p, keep):
+  *   Elimina las instrucciones con keep[i] == 0. Un salto a una
+  *   instrucción eliminada pasa a la siguiente que se conserva.
+  */
+ static void ir_compact(IRProgram *p, const char *keep) {
+     int *new_idx = malloc((p->num_code + 1) * sizeof(int));
+     int n = 0;
+     for (int i = 0; i < p->num_code; i++) {
+         new_idx[i] = n;
+         n += keep[i] ? 1 : 0;
+     }
+     new_idx[p->num_code] = n;
+ 
+     int j = 0;
+     for (int i = 0; i < p->num_code; i++) {
+         if (!keep[i]) {
+             continue;
+         }
+         Instr in = p->code[i];
+         if (in.op == OP_JMP) {
+             in.a = new_idx[in.a];
+         } else if (in.op == OP_JZ) {
+             in.b = new_idx[in.b];
+         }
+         if (p->peep_saved != NULL) {
+             p->peep_saved[j] = p->peep_saved[i];
+         }
+         p->code[j++] = in;
+     }
+     p->num_code = n;
+     free(new_idx);
+ }
+ 
+ /**
+  * ir_num_vars(p):
+  *   Registros de p que son variables del programa (el resto son
+  *   temporales).
+  */
+ static int ir_num_vars(const IRProgram *p) {
+     return p->num_regs - p->num_temps;
+ }
+ 
+ /**
+  * ir_replace_use(in, from, to):
+  *   Cambia por to los operandos de in que leen from.
+  */
+ static void ir_replace_use(Instr *in, int from, int to) {
+     int uses[2];
+     int nu = ir_uses(in, uses);
+     for (int k = 0; k < nu; k++) {
+         if (uses[k] != from) {
+             continue;
+         }
+         if (ir_reads_a(in->op)) {
+             in->a = to;
+         } else if (k == 0) {
+             in->b = to;
+         } else {
+             in->c = to;
+         }
+     }
+ }
+ 
+ /**
+  * ir_new_temp(p):
+  *   Reserva un temporal nuevo en un IR ya finalizado.
+  */
+ static int ir_new_temp(IRProgram *p) {
+     p->num_temps++;
+     return p->num_regs++;
+ }
+ 
+ /**
+  * cfg_dom_children(g, order, idom, np, start):
+  *   Hijos de cada bloque en el árbol de dominadores, en orden
+  *   posterior inverso: los de b son children[start[b] .. start[b+1]-1].
+  *   Devuelve children; start debe tener sitio para nb+1 enteros.
+  */
+ static int *cfg_dom_children(const CFG *g, const int *order, const int *idom, int np,
+                              int *start) {
+     int  nb       = g->num_blocks;
+     int *children = malloc((nb + 1) * sizeof(int));
+     int *fill     = malloc((nb + 1) * sizeof(int));
+     memset(start, 0, (nb + 1) * sizeof(int));
+     for (int k = 1; k < np; k++) {
+         start[idom[order[k]] + 1]++;
+     }
+     for (int b = 0; b < nb; b++) {
+         start[b + 1] += start[b];
+     }
+     memcpy(fill, start, nb * sizeof(int));
+     for (int k = 1; k < np; k++) {
+         children[fill[idom[order[k]]]++] = order[k];
+     }
+     free(fill);
+     return children;
+ }
+ 
+ 
+ /*--------------------------------------------------------------
+  * Forma SSA.
+  *
+  * En SSA cada registro se escribe una sola vez. Los temporales casi
+  * siempre lo cumplen; cada asignación a una variable (o a uno de
+  * los pocos temporales que se escriben varias veces, como los que
+  * deja la reducción de fuerza) pasa a escribir una versión nueva:
+  * un registro más, con ssa_var[r] = el registro original. Donde se
+  * juntan versiones distintas se pone
+  *
+  *     PHI x.7, x.3, x.6        (un argumento por predecesor)
+  *
+  * Construcción de Cytron et al.: las PHI van en la frontera de
+  * dominancia iterada de los bloques que asignan la variable (solo
+  * si la variable se lee en un bloque que no la ha escrito antes:
+  * SSA "semipodada") y el renombrado recorre el árbol de
+  * dominadores. La versión de entrada es el propio registro: para
+  * una variable, sin valor en un programa entero y el de fuera en
+  * una región.
+  *
+  * Las pasadas que trabajan en SSA no mueven asignaciones a
+  * variables ni alargan la vida de sus versiones, así que dos
+  * versiones del mismo registro nunca están vivas a la vez: salir
+  * de SSA es volver a llamarlas por su registro y quitar las PHI.
+  *-------------------------------------------------------------*/
+ 
+ /**
+  * ir_map_regs(in, map):
+  *   Cambia cada registro r que escribe o lee in por map[r].
+  */
+ static void ir_map_regs(Instr *in, const int *map) {
+     int uses[2];
+     int nu = ir_uses(in, uses);
+     if (ir_reads_a(in->op)) {
+         in->a = map[in->a];
+         return;
+     }
+     if (ir_def(in) >= 0) {
+         in->a = map[in->a];
+     }
+     if (nu >= 1) {
+         in->b = map[in->b];
+     }
+     if (nu >= 2) {
+         in->c = map[in->c];
+     }
+ }
+ 
+ /**
+  * ssa_build(p):
+  *   Pasa p a forma SSA (p->ssa_var deja de ser NULL).
+  */
+ static void ssa_build(IRProgram *p) {
+     CFG  *g     = cfg_build(p);
+     int   nb    = g->num_blocks;
+     int   nv    = ir_num_vars(p);
+     int   nr    = p->num_regs;
+     int   n     = p->num_code;
+     int  *order = malloc((nb + 1) * sizeof(int));
+     int  *idom  = malloc((nb + 1) * sizeof(int));
+     int   np    = cfg_dominators(g, order, idom);
+ 
+     // Frontera de dominancia: desde cada predecesor de una unión se
+     // sube por el árbol hasta el dominador inmediato de la unión
+     int **df     = calloc(nb + 1, sizeof(int *));
+     int  *num_df = calloc(nb + 1, sizeof(int));
+     for (int b = 0; b < nb; b++) {
+         if (idom[b] < 0 || g->blocks[b].num_preds < 2) {
+             continue;
+         }
+         for (int j = 0; j < g->blocks[b].num_preds; j++) {
+             int x = g->blocks[b].preds[j];
+             while (idom[x] >= 0 && x != idom[b]) {
+                 if (num_df[x] == 0 || df[x][num_df[x] - 1] != b) {
+                     df[x] = realloc(df[x], (num_df[x] + 1) * sizeof(int));
+                     df[x][num_df[x]++] = b;
+                 }
+                 x = idom[x];
+             }
+         }
+     }
+ 
+     // Registros que hay que renombrar: las variables y los
+     // temporales escritos más de una vez (ren[] los numera de 0 a nv-1)
+     int *ren = malloc((nr + 1) * sizeof(int));
+     for (int r = 0; r < nr; r++) {
+         ren[r] = (r < nv) ? r : -1;
+     }
+     for (int i = 0; i < n; i++) {
+         int d = ir_def(&p->code[i]);
+         if (d >= nv) {
+             ren[d] = (ren[d] == -1) ? -2 : -3;
+         }
+     }
+     int *orig = malloc((nr + 1) * sizeof(int));
+     for (int r = 0; r < nv; r++) {
+         orig[r] = r;
+     }
+     for (int r = nv; r < nr; r++) {
+         if (ren[r] == -3) {
+             orig[nv] = r;
+             ren[r]   = nv++;
+         } else {
+             ren[r] = -1;
+         }
+     }
+ 
+     // Registros globales y bloques que asignan cada uno
+     char *global = calloc(nv + 1, 1);
+     char *defs   = calloc((size_t)nb * nv + 1, 1);
+     char *killed = malloc(nv + 1);
+     for (int b = 0; b < nb; b++) {
+         memset(killed, 0, nv + 1);
+         for (int i = g->blocks[b].start; i < g->blocks[b].end; i++) {
+             int uses[2];
+             int nu = ir_uses(&p->code[i], uses);
+             for (int k = 0; k < nu; k++) {
+                 int v = ren[uses[k]];
+                 if (v >= 0 && !killed[v]) {
+                     global[v] = 1;
+                 }
+             }
+             int d = ir_def(&p->code[i]);
+             if (d >= 0 && ren[d] >= 0) {
+                 killed[ren[d]] = 1;
+                 defs[(size_t)b * nv + ren[d]] = 1;
+             }
+         }
+     }
+ 
+     // PHI en la frontera de dominancia iterada
+     char *has_phi  = calloc((size_t)nb * nv + 1, 1);
+     int  *work     = malloc((nb + 1) * sizeof(int));
+     char *queued   = malloc(nb + 1);
+     int   num_phis = 0;
+     for (int v = 0; v < nv; v++) {
+         if (!global[v]) {
+             continue;
+         }
+         int nw = 0;
+         memset(queued, 0, nb + 1);
+         for (int b = 0; b < nb; b++) {
+             if (defs[(size_t)b * nv + v]) {
+                 queued[b] = 1;
+                 work[nw++] = b;
+             }
+         }
+         while (nw > 0) {
+             int x = work[--nw];
+             for (int k = 0; k < num_df[x]; k++) {
+                 int y = df[x][k];
+                 if (!has_phi[(size_t)y * nv + v]) {
+                     has_phi[(size_t)y * nv + v] = 1;
+                     num_phis++;
+                     if (!queued[y]) {
+                         queued[y] = 1;
+                         work[nw++] = y;
+                     }
+                 }
+             }
+         }
+     }
+ 
+     // Código nuevo: las PHI de cada bloque delante de él. Los saltos
+     // al bloque pasan a su primera PHI.
+     Instr *code  = malloc((n + num_phis + 1) * sizeof(Instr));
+     int   *where = malloc((n + 1) * sizeof(int));
+     int    m     = 0;
+     p->num_phi_args = 0;
+     for (int b = 0; b < nb; b++) {
+         const BasicBlock *bb = &g->blocks[b];
+         where[bb->start] = m;
+         for (int v = 0; v < nv; v++) {
+             if (!has_phi[(size_t)b * nv + v]) {
+                 continue;
+             }
+             if (p->num_phi_args + bb->num_preds > p->cap_phi_args) {
+                 p->cap_phi_args = (p->num_phi_args + bb->num_preds) * 2;
+                 p->phi_args = realloc(p->phi_args, p->cap_phi_args * sizeof(int));
+                 if (p->phi_args == NULL) {
+                     fprintf(stderr, "Error: memoria insuficiente.\n");
+                     exit(1);
+                 }
+             }
+             Instr *phi = &code[m++];
+             phi->op   = OP_PHI;
+             phi->a    = orig[v];
+             phi->b    = p->num_phi_args;
+             phi->c    = bb->num_preds;
+             phi->line = p->code[bb->start].line;
+             phi->d    = 0;
+             for (int j = 0; j < bb->num_preds; j++) {
+                 p->phi_args[p->num_phi_args++] = orig[v];
+             }
+         }
+         for (int i = bb->start; i < bb->end; i++) {
+             if (i > bb->start) {
+                 where[i] = m;
+             }
+             code[m++] = p->code[i];
+         }
+     }
+     where[n] = m;
+     for (int i = 0; i < m; i++) {
+         if (ir_is_jump(code[i].op)) {
+             int *target = (code[i].op == OP_JMP) ? &code[i].a : &code[i].b;
+             *target = where[*target];
+         }
+     }
+     free(p->code);
+     p->code     = code;
+     p->num_code = m;
+     p->cap_code = n + num_phis + 1;
+     free(where);
+     cfg_free(g);
+     g = cfg_build(p);                   // mismos bloques, con las PHI
+ 
+     // Renombrado en preorden del árbol de dominadores. Cada versión
+     // nueva guarda la anterior en prev[] para deshacerla al salir.
+     int num_defs = 0;
+     for (int i = 0; i < m; i++) {
+         int d = ir_def(&p->code[i]);
+         num_defs += (d >= 0 && ren[d] >= 0);
+     }
+     p->ssa_var = malloc((nr + num_defs + 1) * sizeof(int));
+     for (int r = 0; r < nr + num_defs; r++) {
+         p->ssa_var[r] = -1;
+     }
+     int *cur  = malloc((nv + 1) * sizeof(int));
+     int *prev = malloc((nr + num_defs + 1) * sizeof(int));
+     for (int v = 0; v < nv; v++) {
+         cur[v] = orig[v];
+     }
+ 
+     int *start    = malloc((nb + 1) * sizeof(int));
+     int *children = cfg_dom_children(g, order, idom, np, start);
+     int *stack    = malloc((4 * nb + 2) * sizeof(int));
+     int  sp       = 0;
+     if (np > 0) {
+         stack[sp++] = order[0];
+         stack[sp++] = 0;
+     }
+     while (sp > 0) {
+         int leaving = stack[--sp];
+         int b       = stack[--sp];
+         const BasicBlock *bb = &g->blocks[b];
+         if (leaving) {
+             for (int i = bb->end - 1; i >= bb->start; i--) {
+                 int d = ir_def(&p->code[i]);
+                 if (d >= 0 && p->ssa_var[d] >= 0) {
+                     cur[ren[p->ssa_var[d]]] = prev[d];
+                 }
+             }
+             continue;
+         }
+         for (int i = bb->start; i < bb->end; i++) {
+             Instr *in = &p->code[i];
+             if (in->op != OP_PHI) {
+                 int uses[2];
+                 int nu = ir_uses(in, uses);
+                 for (int k = 0; k < nu; k++) {
+                     if (ren[uses[k]] >= 0) {
+                         ir_replace_use(in, uses[k], cur[ren[uses[k]]]);
+                     }
+                 }
+             }
+             int d = ir_def(in);
+             if (d >= 0 && ren[d] >= 0) {
+                 int r = ir_new_temp(p);
+                 p->ssa_var[r] = d;
+                 prev[r] = cur[ren[d]];
+                 cur[ren[d]] = r;
+                 in->a = r;
+             }
+         }
+         for (int k = 0; k < bb->num_succ; k++) {
+             const BasicBlock *s = &g->blocks[bb->succ[k]];
+             for (int j = 0; j < s->num_preds; j++) {
+                 if (s->preds[j] != b) {
+                     continue;
+                 }
+                 for (int i = s->start; i < s->end && p->code[i].op == OP_PHI; i++) {
+                     int a = p->code[i].a;
+                     a = (a < nr && p->ssa_var[a] < 0) ? a : p->ssa_var[a];
+                     p->phi_args[p->code[i].b + j] = cur[ren[a]];
+                 }
+             }
+         }
+         stack[sp++] = b;
+         stack[sp++] = 1;
+         for (int c = start[b + 1] - 1; c >= start[b]; c--) {
+             stack[sp++] = children[c];
+             stack[sp++] = 0;
+         }
+     }
+ 
+     free(stack);
+     free(children);
+     free(start);
+     free(prev);
+     free(cur);
+     free(queued);
+     free(work);
+     free(has_phi);
+     free(killed);
+     free(defs);
+     free(global);
+     free(orig);
+     free(ren);
+     for (int b = 0; b < nb; b++) {
+         free(df[b]);
+     }
+     free(df);
+     free(num_df);
+     free(order);
+     free(idom);
+     cfg_free(g);
+ }
+ 
+ /**
+  * ssa_destroy(p):
+  *   Sale de SSA: cada versión vuelve a ser su registro, se quitan
+  *   las PHI y los temporales se renumeran sin huecos.
+  */
+ static void ssa_destroy(IRProgram *p) {
+     int   nv   = ir_num_vars(p);
+     int  *map  = malloc((p->num_regs + 1) * sizeof(int));
+     char *keep = malloc(p->num_code + 1);
+     int   nt   = 0;
+     for (int r = 0; r < p->num_regs; r++) {
+         map[r] = (r < nv) ? r : (p->ssa_var[r] >= 0) ? -1 : nv + nt++;
+     }
+     for (int r = nv; r < p->num_regs; r++) {
+         if (map[r] < 0) {
+             map[r] = map[p->ssa_var[r]];
+         }
+     }
+     for (int i = 0; i < p->num_code; i++) {
+         keep[i] = (p->code[i].op != OP_PHI);
+         ir_map_regs(&p->code[i], map);
+     }
+     ir_compact(p, keep);
+     p->num_regs     = nv + nt;
+     p->num_temps    = nt;
+     p->num_phi_args = 0;
+     free(p->ssa_var);
+     p->ssa_var = NULL;
+     free(keep);
+     free(map);
+ }
+ 
+ 
+ /*--------------------------------------------------------------
+  * Plegado y propagación de constantes.
+  *
+  * Propagación condicional dispersa de Wegman-Zadeck (SCCP) sobre la
+  * forma SSA, con el retículo clásico por registro:
+  *     TOP (sin valor todavía) > constante c > BOTTOM (variable)
+  * Como cada registro tiene una sola definición, basta un valor por
+  * registro (no uno por bloque y registro): cuando baja, solo se
+  * vuelven a mirar las instrucciones que lo leen. Y solo se siguen
+  * las aristas ejecutables: un JZ cuya condición ya es constante
+  * solo propaga a uno de sus sucesores, y una PHI solo junta lo que
+  * llega por aristas ejecutables.
+  *
+  * Una variable recién declarada sin valor (UNDEF) es TOP: leerla
+  * dispara antes su CHKDEF, así que da igual qué constante supongamos.
+  * En una región de bucle las variables llegan de fuera (BOTTOM).
+  *
+  * Con eso opt_constants() reescribe como CONST cada instrucción
+  * cuyo resultado es constante (y opt_dead_temps() quita los
+  * temporales que ya nadie lee) y opt_dead_branches() quita los
+  * saltos decididos y los bloques a los que no se llega. En el
+  * programa entero, dividir entre una constante cero en código
+  * alcanzable es un error de compilación.
+  *-------------------------------------------------------------*/
+ 
+ typedef enum { LAT_TOP = 0, LAT_CONST, LAT_BOTTOM } LatKind;
+ 
+ typedef struct {
+     LatKind   kind;
+     long long val;
+ } LatVal;
+ 
+ /**
+  * fold_op(op, x, y, out):
+  *   Calcula "x op y" (o "op x") con la aritmética de 64 bits de la
+  *   VM. Devuelve 0 si no se puede plegar (división por cero, o una
+  *   operación comprobada que se desborda: se dejan para tiempo de
+  *   ejecución, que es quien da el error).
+  */
+ static int fold_op(OpCode op, long long x, long long y, long long *out) {
+     unsigned long long ux = (unsigned long long)x, uy = (unsigned long long)y;
+     switch (op) {
+         case OP_ADD: *out = (long long)(ux + uy); return 1;
+         case OP_SUB: *out = (long long)(ux - uy); return 1;
+         case OP_MUL: *out = (long long)(ux * uy); return 1;
+         case OP_NEG: *out = (long long)(0ULL - ux); return 1;
+         case OP_ADDO: return !__builtin_add_overflow(x, y, out);
+         case OP_SUBO: return !__builtin_sub_overflow(x, y, out);
+         case OP_MULO: return !__builtin_mul_overflow(x, y, out);
+         case OP_NEGO: return !__builtin_sub_overflow(0, x, out);
+         case OP_TOCHR: *out = (signed char)x; return 1;
+         case OP_DIV: case OP_DIVO: case OP_DIV32:
+             if (y == 0 || (x == LLONG_MIN && y == -1 && op == OP_DIVO)) {
+                 return 0;
+             }
+             *out = (y == -1) ? (long long)(0ULL - ux) : x / y;
+             return 1;
+         case OP_EQ: *out = (x == y); return 1;
+         case OP_NE: *out = (x != y); return 1;
+         case OP_LT: *out = (x <  y); return 1;
+         case OP_LE: *out = (x <= y); return 1;
+         case OP_GT: *out = (x >  y); return 1;
+         case OP_GE: *out = (x >= y); return 1;
+         default:
+             return 0;
+     }
+ }
+ 
+ static int lat_is_const(LatVal v, long long c) {
+     return v.kind == LAT_CONST && v.val == c;
+ }
+ 
+ /**
+  * lat_step(p, in, st):
+  *   Aplica la instrucción al estado abstracto st[] (un LatVal por
+  *   registro).
+  */
+ static void lat_step(const IRProgram *p, const Instr *in, LatVal *st) {
+     LatVal r = { LAT_BOTTOM, 0 };
+     switch (in->op) {
+         case OP_CONST:
+             r.kind = LAT_CONST;
+             r.val  = p->consts[in->b];
+             break;
+         case OP_MOV:
+             r = st[in->b];
+             break;
+         case OP_NEG: case OP_TOCHR: case OP_NEGO:
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_DIV32:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_DIVO:
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE: {
+             LatVal x = st[in->b];
+             LatVal y = (in->op == OP_NEG || in->op == OP_NEGO || in->op == OP_TOCHR) ? x
+                                                                                      : st[in->c];
+             if (ir_unchecked(in->op) == OP_MUL && (lat_is_const(x, 0) || lat_is_const(y, 0))) {
+                 r.kind = LAT_CONST;
+                 r.val  = 0;
+             } else if (x.kind == LAT_BOTTOM || y.kind == LAT_BOTTOM) {
+                 r.kind = LAT_BOTTOM;
+             } else if (x.kind == LAT_TOP || y.kind == LAT_TOP) {
+                 r.kind = LAT_TOP;
+             } else if (fold_op(in->op, x.val, y.val, &r.val)) {
+                 r.kind = LAT_CONST;
+             }
+             break;
+         }
+         case OP_READ: case OP_TRIPS: case OP_POWSUM: case OP_BOUND: case OP_READC:
+         case OP_LOAD: case OP_LOADC:
+         case OP_ASUM: case OP_ADOT: case OP_AMIN: case OP_AMAX: case OP_AFIND:
+         case OP_DGET: case OP_DHAS: case OP_DLEN:
+             break;
+         case OP_FCONST: case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV:
+         case OP_FNEG: case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE:
+         case OP_FGT: case OP_FGE: case OP_ITOF: case OP_FTOI: case OP_READF:
+             break;                          // lo de tipo Flotante no se pliega
+         case OP_UNDEF:
+             r.kind = LAT_TOP;
+             break;
+         default:
+             return;
+     }
+     st[in->a] = r;
+ }
+ 
+ /**
+  * lat_meet(a, b):
+  *   a ∧ b.
+  */
+ static LatVal lat_meet(LatVal a, LatVal b) {
+     if (a.kind == LAT_TOP) {
+         return b;
+     }
+     if (b.kind == LAT_TOP || (a.kind == LAT_CONST && b.kind == LAT_CONST && a.val == b.val)) {
+         return a;
+     }
+     a.kind = LAT_BOTTOM;
+     a.val  = 0;
+     return a;
+ }
+ 
+ /* Estado de sccp(): pilas de aristas y de registros por revisar */
+ typedef struct {
+     const IRProgram *p;
+     const CFG       *g;
+     LatVal          *val;         // uno por registro
+     char            *reached;     // bloques alcanzados
+     char            *edge_ok;     // aristas ejecutables, por destino y predecesor
+     int             *edge_at;     // primera arista de cada bloque en edge_ok
+     int             *use_at;      // usos de r: use_list[use_at[r] .. use_at[r+1])
+     int             *use_list;
+     int             *edges, num_edges, cap_edges;  // pares (bloque, predecesor)
+     int             *regs, num_regs, cap_regs;
+ } Sccp;
+ 
+ static void sccp_push(int **stack, int *num, int *cap, int x) {
+     if (*num >= *cap) {
+         *cap   = 2 * *cap + 16;
+         *stack = realloc(*stack, *cap * sizeof(int));
+         if (*stack == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     (*stack)[(*num)++] = x;
+ }
+ 
+ /**
+  * sccp_set(s, r, v):
+  *   val[r] = v; si cambia, r queda pendiente para sus usos.
+  */
+ static void sccp_set(Sccp *s, int r, LatVal v) {
+     LatVal old = s->val[r];
+     if (old.kind != v.kind || old.val != v.val) {
+         s->val[r] = v;
+         sccp_push(&s->regs, &s->num_regs, &s->cap_regs, r);
+     }
+ }
+ 
+ /**
+  * sccp_succs(s, b):
+  *   Apunta como ejecutables las aristas que salen de b según su
+  *   último salto.
+  */
+ static void sccp_succs(Sccp *s, int b) {
+     const BasicBlock *bb   = &s->g->blocks[b];
+     const Instr      *last = &s->p->code[bb->end - 1];
+     for (int k = 0; k < bb->num_succ; k++) {
+         int t = bb->succ[k];
+         if (last->op == OP_JZ) {
+             LatVal c = s->val[last->a];
+             int to_target = (t == s->g->block_of[last->b]);
+             int to_next   = (t == b + 1);
+             if (c.kind == LAT_TOP ||
+                 (c.kind == LAT_CONST && c.val == 0 && !to_target) ||
+                 (c.kind == LAT_CONST && c.val != 0 && !to_next)) {
+                 continue;
+             }
+         }
+         const BasicBlock *tb = &s->g->blocks[t];
+         for (int j = 0; j < tb->num_preds; j++) {
+             if (tb->preds[j] == b && !s->edge_ok[s->edge_at[t] + j]) {
+                 sccp_push(&s->edges, &s->num_edges, &s->cap_edges, t);
+                 sccp_push(&s->edges, &s->num_edges, &s->cap_edges, j);
+             }
+         }
+     }
+ }
+ 
+ /**
+  * sccp_eval(s, i):
+  *   Vuelve a calcular la instrucción i (de un bloque alcanzado).
+  */
+ static void sccp_eval(Sccp *s, int i) {
+     const Instr *in = &s->p->code[i];
+     int b = s->g->block_of[i];
+     if (in->op == OP_PHI) {
+         LatVal v = { LAT_TOP, 0 };
+         for (int j = 0; j < in->c; j++) {
+             if (s->edge_ok[s->edge_at[b] + j]) {
+                 v = lat_meet(v, s->val[s->p->phi_args[in->b + j]]);
+             }
+         }
+         sccp_set(s, in->a, v);
+     } else if (in->op == OP_JZ) {
+         sccp_succs(s, b);
+     } else if (ir_def(in) >= 0) {
+         // lat_step escribe val[a]; lo que no sabe calcular es BOTTOM
+         LatVal old = s->val[in->a];
+         s->val[in->a].kind = LAT_BOTTOM;
+         s->val[in->a].val  = 0;
+         lat_step(s->p, in, s->val);
+         LatVal v = s->val[in->a];
+         s->val[in->a] = old;
+         sccp_set(s, in->a, v);
+     }
+ }
+ 
+ /**
+  * sccp(p, g, val, reached):
+  *   SCCP sobre p en SSA (ver arriba): deja en val[r] lo que vale cada
+  *   registro y marca en reached[] los bloques alcanzables.
+  */
+ static void sccp(const IRProgram *p, const CFG *g, LatVal *val, char *reached) {
+     int nb = g->num_blocks;
+     int nr = p->num_regs;
+     Sccp s;
+     memset(&s, 0, sizeof(s));
+     s.p       = p;
+     s.g       = g;
+     s.val     = val;
+     s.reached = reached;
+     s.edge_at = malloc((nb + 1) * sizeof(int));
+     s.edge_at[0] = 0;
+     for (int b = 0; b < nb; b++) {
+         s.edge_at[b + 1] = s.edge_at[b] + g->blocks[b].num_preds;
+     }
+     s.edge_ok = calloc(s.edge_at[nb] + 1, 1);
+ 
+     // Usos de cada registro (los argumentos de las PHI también)
+     s.use_at = calloc(nr + 2, sizeof(int));
+     for (int pass = 0; pass < 2; pass++) {
+         for (int i = 0; i < p->num_code; i++) {
+             const Instr *in = &p->code[i];
+             int uses[2];
+             int nu = ir_uses(in, uses);
+             for (int k = 0; k < nu + (in->op == OP_PHI ? in->c : 0); k++) {
+                 int r = (k < nu) ? uses[k] : p->phi_args[in->b + k - nu];
+                 if (pass == 0) {
+                     s.use_at[r + 2]++;
+                 } else {
+                     s.use_list[s.use_at[r + 1]++] = i;
+                 }
+             }
+         }
+         if (pass == 0) {
+             for (int r = 0; r < nr; r++) {
+                 s.use_at[r + 2] += s.use_at[r + 1];
+             }
+             s.use_list = malloc((s.use_at[nr + 1] + 1) * sizeof(int));
+         }
+     }
+ 
+     for (int r = 0; r < nr; r++) {
+         val[r].kind = LAT_TOP;
+         val[r].val  = 0;
+     }
+     if (!p->whole_program) {
+         for (int v = 0; v < ir_num_vars(p); v++) {
+             val[v].kind = LAT_BOTTOM;
+         }
+     }
+     memset(reached, 0, nb);
+ 
+     int first = (nb > 0);                       // el bloque de entrada
+     while (first || s.num_edges > 0 || s.num_regs > 0) {
+         if (first || s.num_edges > 0) {
+             int b, j = -1;
+             if (first) {
+                 b = 0;
+                 first = 0;
+             } else {
+                 j = s.edges[--s.num_edges];
+                 b = s.edges[--s.num_edges];
+                 if (s.edge_ok[s.edge_at[b] + j]) {
+                     continue;
+                 }
+                 s.edge_ok[s.edge_at[b] + j] = 1;
+             }
+             const BasicBlock *bb = &g->blocks[b];
+             if (reached[b]) {                   // arista nueva: solo sus PHI
+                 for (int i = bb->start; i < bb->end && p->code[i].op == OP_PHI; i++) {
+                     sccp_eval(&s, i);
+                 }
+                 continue;
+             }
+             reached[b] = 1;
+             for (int i = bb->start; i < bb->end; i++) {
+                 sccp_eval(&s, i);
+             }
+             if (p->code[bb->end - 1].op != OP_JZ) {
+                 sccp_succs(&s, b);
+             }
+             continue;
+         }
+         int r = s.regs[--s.num_regs];
+         for (int k = s.use_at[r]; k < s.use_at[r + 1]; k++) {
+             int i = s.use_list[k];
+             if (reached[g->block_of[i]]) {
+                 sccp_eval(&s, i);
+             }
+         }
+     }
+ 
+     free(s.regs);
+     free(s.edges);
+     free(s.use_list);
+     free(s.use_at);
+     free(s.edge_ok);
+     free(s.edge_at);
+ }
+ 
+ /**
+  * opt_constants(p):
+  *   Plegado y propagación de constantes (ver arriba) sobre p en SSA.
+  *   Devuelve el número de instrucciones reescritas como CONST.
+  */
+ static int opt_constants(IRProgram *p) {
+     CFG    *g       = cfg_build(p);
+     char   *reached = calloc(g->num_blocks + 1, 1);
+     LatVal *val     = malloc((p->num_regs + 1) * sizeof(LatVal));
+     int     folded  = 0;
+     sccp(p, g, val, reached);
+ 
+     for (int b = 0; b < g->num_blocks; b++) {
+         if (!reached[b]) {
+             continue;
+         }
+         const BasicBlock *bb = &g->blocks[b];
+         for (int i = bb->start; i < bb->end; i++) {
+             Instr *in = &p->code[i];
+             if (in->op == OP_CHKDIV && lat_is_const(val[in->a], 0) && p->whole_program) {
+                 // Solo es un error si se ejecuta seguro; si no, el
+                 // CHKDIV se queda y avisa al llegar
+                 if (cfg_always_reached(g, reached, b)) {
+                     fprintf(stderr, "Error (línea %d): división por cero.\n", in->line);
+                     exit(1);
+                 }
+                 if (warn_enabled) {
+                     fprintf(stderr, "Aviso (línea %d): división por cero si se llega a "
+                                     "ejecutar.\n", in->line);
+                 }
+             }
+             int d = ir_def(in);
+             if (d >= 0 && in->op != OP_CONST && in->op != OP_PHI && !ir_is_read(in->op) &&
+                 in->op != OP_UNDEF && val[d].kind == LAT_CONST) {
+                 in->op = OP_CONST;
+                 in->b  = ir_const_in(p, val[d].val);
+                 in->c  = 0;
+                 folded++;
+             }
+         }
+     }
+     free(val);
+     free(reached);
+     cfg_free(g);
+     return folded;
+ }
+ 
+ /**
+  * opt_dead_temps(p):
+  *   Quita las instrucciones sin efectos que escriben un temporal que
+  *   nadie lee. Devuelve cuántas quitó.
+  */
+ static int opt_dead_temps(IRProgram *p) {
+     int   nvars   = ir_num_vars(p);
+     int  *num_use = calloc(p->num_regs, sizeof(int));
+     char *keep    = malloc(p->num_code);
+     int   removed = 0;
+ 
+     for (int i = 0; i < p->num_code; i++) {
+         int uses[2];
+         int n = ir_uses(&p->code[i], uses);
+         for (int k = 0; k < n; k++) {
+             num_use[uses[k]]++;
+         }
+         keep[i] = 1;
+     }
+ 
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         for (int i = p->num_code - 1; i >= 0; i--) {
+             Instr *in = &p->code[i];
+             int d = ir_def(in);
+             if (!keep[i] || d < nvars || num_use[d] > 0 || ir_may_fail(in->op)) {
+                 continue;
+             }
+             int uses[2];
+             int n = ir_uses(in, uses);
+             for (int k = 0; k < n; k++) {
+                 num_use[uses[k]]--;
+             }
+             keep[i] = 0;
+             removed++;
+             changed = 1;
+         }
+     }
+     if (removed > 0) {
+         ir_compact(p, keep);
+     }
+     free(num_use);
+     free(keep);
+     return removed;
+ }
+ 
+ /**
+  * opt_dead_branches(p):
+  *   Elimina las ramas muertas de p en SSA: un JZ cuya condición es
+  *   constante se convierte en JMP (o desaparece) y los bloques
+  *   inalcanzables, con ellos los Si y Mientras cuya condición nunca
+  *   se cumple, se borran. Las PHI pierden los argumentos de las
+  *   aristas que ya no están. Luego quita
+  *   los JMP a la instrucción siguiente que hayan quedado. Devuelve
+  *   el número de instrucciones eliminadas.
+  *
+  *   Las instrucciones que calculan la condición (y sus CHKDEF) se
+  *   quedan: solo desaparece el salto.
+  */
+ static int opt_dead_branches(IRProgram *p) {
+     CFG    *g       = cfg_build(p);
+     int     nb      = g->num_blocks;
+     char   *reached = calloc(nb + 1, 1);
+     LatVal *val     = malloc((p->num_regs + 1) * sizeof(LatVal));
+     char   *keep    = malloc(p->num_code);
+     int     before  = p->num_code;
+     sccp(p, g, val, reached);
+ 
+     // Aristas que quedan, en el orden de los predecesores de cfg_build
+     int  *edge_at = malloc((nb + 1) * sizeof(int));
+     int  *filled  = calloc(nb + 1, sizeof(int));
+     edge_at[0] = 0;
+     for (int b = 0; b < nb; b++) {
+         edge_at[b + 1] = edge_at[b] + g->blocks[b].num_preds;
+     }
+     char *alive = calloc(edge_at[nb] + 1, 1);
+     for (int b = 0; b < nb; b++) {
+         const BasicBlock *bb   = &g->blocks[b];
+         const Instr      *last = &p->code[bb->end - 1];
+         for (int k = 0; k < bb->num_succ; k++) {
+             int    t  = bb->succ[k];
+             LatVal c  = (last->op == OP_JZ) ? val[last->a] : val[0];
+             int    ok = reached[b];
+             if (last->op == OP_JZ && c.kind == LAT_CONST) {
+                 ok = ok && (k == 0) == (c.val != 0);  // succ[0] sigue, succ[1] salta
+             }
+             alive[edge_at[t] + filled[t]++] = (char)ok;
+         }
+     }
+ 
+     for (int b = 0; b < nb; b++) {
+         const BasicBlock *bb = &g->blocks[b];
+         memset(keep + bb->start, reached[b], bb->end - bb->start);
+         if (!reached[b]) {
+             continue;
+         }
+         for (int i = bb->start; i < bb->end && p->code[i].op == OP_PHI; i++) {
+             Instr *phi = &p->code[i];
+             int    n   = 0;
+             for (int j = 0; j < phi->c; j++) {
+                 if (alive[edge_at[b] + j]) {
+                     p->phi_args[phi->b + n++] = p->phi_args[phi->b + j];
+                 }
+             }
+             phi->c = n;
+         }
+         Instr *last = &p->code[bb->end - 1];
+         if (last->op == OP_JZ && val[last->a].kind == LAT_CONST) {
+             if (val[last->a].val != 0) {
+                 keep[bb->end - 1] = 0;          // nunca salta
+             } else {
+                 last->op = OP_JMP;              // siempre salta
+                 last->a  = last->b;
+                 last->b  = 0;
+             }
+         }
+     }
+     keep[p->num_code - 1] = 1;                  // el HALT final se queda
+     ir_compact(p, keep);
+ 
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         for (int i = 0; i < p->num_code; i++) {
+             keep[i] = !(p->code[i].op == OP_JMP && p->code[i].a == i + 1);
+             changed |= !keep[i];
+         }
+         if (changed) {
+             ir_compact(p, keep);
+         }
+     }
+ 
+     free(alive);
+     free(filled);
+     free(edge_at);
+     free(keep);
+     free(val);
+     free(reached);
+     cfg_free(g);
+     return before - p->num_code;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Análisis de rangos.
+  *
+  * Otro análisis hacia delante, ahora con un intervalo [lo, hi] por
+  * registro (vacío si lo > hi: el registro no puede tener valor ahí,
+  * p. ej. una variable recién declarada). En la unión de caminos se
+  * toma el intervalo que cubre ambos y, para que los bucles acaben,
+  * en los saltos hacia atrás a partir de la tercera visita a la
+  * cabecera el extremo que siga moviéndose salta directamente a
+  * LLONG_MIN o LLONG_MAX.
+  *
+  * Cada arista de un JZ acota además su condición: por la que salta
+  * vale 0 y por la otra no. Si la condición es una comparación del
+  * mismo bloque cuyos operandos no cambian antes del salto, también
+  * se acotan ellos; así en
+  *     Mientras (i > 0) { x = 100 / i; ... }
+  * el cuerpo sabe que i >= 1.
+  *
+  * Con eso:
+  *   - sobra todo CHKDIV cuyo divisor no puede ser cero (y, en el
+  *     programa entero, el intérprete tampoco lo comprueba);
+  *   - igual, todo CHKIDX cuyo índice ya está entre 0 y el tamaño
+  *     del vector menos 1: en
+  *         Mientras (i < 1000) { v[i] = ...; i = i + 1; }
+  *     con i desde 0 y v[1000], ningún nivel comprueba v[i];
+  *   - una comparación cuyo resultado ya se sabe pasa a CONST;
+  *   - una operación comprobada (OP_ADDO...) cuyo resultado exacto
+  *     cabe siempre en 64 bits pasa a la que no comprueba: ese es el
+  *     camino rápido del modo sin --wrap. Las que quedan comprobadas
+  *     acotan igual su resultado, porque si se desbordan el programa
+  *     ya no sigue;
+  *   - una división cuyos dos operandos caben en 32 bits (y el
+  *     dividendo no es INT_MIN, así que entre -1 tampoco se sale)
+  *     pasa a OP_DIV32: los backends usan idivl, bastante más
+  *     barato que idivq en la mayoría de los x86-64. Con la
+  *     multiplicación no se gana nada (imull e imulq tardan lo
+  *     mismo), así que se queda en 64 bits;
+  *   - se cuentan las operaciones cuyo resultado exacto cabe en 64
+  *     bits, para --stats.
+  *-------------------------------------------------------------*/
+ 
+ typedef struct {
+     long long lo, hi;
+ } Range;
+ 
+ /* Lo que demostró la pasada en el programa entero (para --stats) */
+ typedef struct {
+     int arith;             // ADD, SUB, MUL, NEG y DIV alcanzables
+     int no_overflow;       // de ellas, con el resultado dentro de 64 bits
+     int unchecked;         // comprobadas que pasaron a no comprobarse
+     int decided;           // comparaciones que pasaron a CONST
+     int narrow;            // divisiones que pasaron a OP_DIV32
+     int indices;           // CHKIDX alcanzables
+     int safe_indices;      // de ellos, quitados
+ } RangeReport;
+ 
+ static RangeReport range_report;
+ 
+ static const Range RANGE_FULL  = { LLONG_MIN, LLONG_MAX };
+ static const Range RANGE_EMPTY = { 1, 0 };
+ 
+ static int range_empty(Range r) {
+     return r.lo > r.hi;
+ }
+ 
+ /**
+  * range_corner(op, x, y, exact):
+  *   "x op y" para una esquina de range_arith(). Si no cabe en 64 bits
+  *   deja *exact = 0 y satura hacia el lado por el que se salió.
+  */
+ static long long range_corner(OpCode op, long long x, long long y, int *exact) {
+     long long r = 0;
+     int       up;                                 // 1: se salió por arriba
+     switch (op) {
+         case OP_ADD:
+             if (!__builtin_add_overflow(x, y, &r)) return r;
+             up = (x > 0);
+             break;
+         case OP_SUB:
+             if (!__builtin_sub_overflow(x, y, &r)) return r;
+             up = (x >= 0);
+             break;
+         case OP_MUL:
+             if (!__builtin_mul_overflow(x, y, &r)) return r;
+             up = ((x < 0) == (y < 0));
+             break;
+         default:                                  // OP_NEG y OP_DIV: -x y x / y
+             if (op == OP_NEG ? x != LLONG_MIN : !(x == LLONG_MIN && y == -1)) {
+                 return (op == OP_NEG) ? -x : x / y;
+             }
+             up = 1;
+             break;
+     }
+     *exact = 0;
+     return up ? LLONG_MAX : LLONG_MIN;
+ }
+ 
+ /**
+  * range_arith(op, x, y, exact):
+  *   Intervalo de "x op y" (o "op x", op sin comprobar). Si el
+  *   resultado exacto puede salirse de 64 bits deja *exact = 0 y
+  *   devuelve el intervalo de los resultados que sí caben.
+  */
+ static Range range_arith(OpCode op, Range x, Range y, int *exact) {
+     *exact = 1;
+     if (range_empty(x) || range_empty(y)) {
+         return RANGE_EMPTY;
+     }
+     long long c[4];
+     if (op == OP_DIV && !(y.lo > 0 || y.hi < 0)) {
+         // |x / y| <= |x| (el cero ya lo paró su CHKDIV), salvo
+         // LLONG_MIN / -1
+         if (x.lo == LLONG_MIN) {
+             c[0] = LLONG_MIN, c[1] = LLONG_MAX;
+             *exact = !(y.lo <= -1 && y.hi >= -1);
+         } else {
+             long long m = (-x.lo > x.hi) ? -x.lo : x.hi;
+             c[0] = -m, c[1] = m;
+         }
+         c[2] = c[0], c[3] = c[1];
+     } else if (op == OP_MUL || op == OP_DIV) {
+         // En MUL y en DIV con el signo del divisor fijo el resultado
+         // es monótono en cada operando: bastan las esquinas
+         c[0] = range_corner(op, x.lo, y.lo, exact);
+         c[1] = range_corner(op, x.lo, y.hi, exact);
+         c[2] = range_corner(op, x.hi, y.lo, exact);
+         c[3] = range_corner(op, x.hi, y.hi, exact);
+     } else {
+         c[0] = range_corner(op, x.lo, (op == OP_SUB) ? y.hi : y.lo, exact);
+         c[1] = range_corner(op, x.hi, (op == OP_SUB) ? y.lo : y.hi, exact);
+         if (op == OP_NEG) {
+             long long t = c[0];
+             c[0] = c[1], c[1] = t;
+         }
+         c[2] = c[0], c[3] = c[1];
+     }
+     Range r = { c[0], c[0] };
+     for (int k = 1; k < 4; k++) {
+         r.lo = (c[k] < r.lo) ? c[k] : r.lo;
+         r.hi = (c[k] > r.hi) ? c[k] : r.hi;
+     }
+     return r;
+ }
+ 
+ /**
+  * range_compare(op, x, y):
+  *   1 o 0 si "x op y" vale siempre eso, -1 si depende.
+  */
+ static int range_compare(OpCode op, Range x, Range y) {
+     switch (op) {
+         case OP_EQ:
+             if (x.lo == x.hi && y.lo == y.hi && x.lo == y.lo) return 1;
+             return (x.hi < y.lo || y.hi < x.lo) ? 0 : -1;
+         case OP_NE:
+             if (x.lo == x.hi && y.lo == y.hi && x.lo == y.lo) return 0;
+             return (x.hi < y.lo || y.hi < x.lo) ? 1 : -1;
+         case OP_LT: return (x.hi <  y.lo) ? 1 : (x.lo >= y.hi) ? 0 : -1;
+         case OP_LE: return (x.hi <= y.lo) ? 1 : (x.lo >  y.hi) ? 0 : -1;
+         case OP_GT: return (x.lo >  y.hi) ? 1 : (x.hi <= y.lo) ? 0 : -1;
+         case OP_GE: return (x.lo >= y.hi) ? 1 : (x.hi <  y.lo) ? 0 : -1;
+         default:    return -1;
+     }
+ }
+ 
+ /* Quita v de los extremos de *r (un intervalo no tiene agujeros) */
+ static void range_exclude(Range *r, long long v) {
+     if (r->lo == v && r->hi == v) {
+         *r = RANGE_EMPTY;
+         return;
+     }
+     if (r->lo == v) {
+         r->lo++;
+     }
+     if (r->hi == v) {
+         r->hi--;
+     }
+ }
+ 
+ /**
+  * range_step(p, in, st, exact):
+  *   Aplica la instrucción al estado st[] (un Range por registro).
+  *   Para la aritmética deja en *exact si el resultado cabe en 64
+  *   bits; si no, la que da la vuelta puede valer cualquier cosa.
+  */
+ static void range_step(const IRProgram *p, const Instr *in, Range *st, int *exact) {
+     Range r = RANGE_FULL;
+     *exact = 1;
+     switch (in->op) {
+         case OP_CONST:
+             r.lo = r.hi = p->consts[in->b];
+             break;
+         case OP_MOV:
+             r = st[in->b];
+             break;
+         case OP_NEG: case OP_NEGO:
+             r = range_arith(ir_unchecked(in->op), st[in->b], st[in->b], exact);
+             break;
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_DIVO:
+             r = range_arith(ir_unchecked(in->op), st[in->b], st[in->c], exact);
+             break;
+         case OP_DIV32:
+             r = range_arith(OP_DIV, st[in->b], st[in->c], exact);
+             break;
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE: {
+             Range x = st[in->b], y = st[in->c];
+             int v = range_compare(in->op, x, y);
+             if (range_empty(x) || range_empty(y)) {
+                 r = RANGE_EMPTY;
+             } else {
+                 r.lo = (v < 0) ? 0 : v;
+                 r.hi = (v < 0) ? 1 : v;
+             }
+             break;
+         }
+         case OP_CHKDIV:                               // si sigue, no es cero
+             range_exclude(&st[in->a], 0);
+             return;
+         case OP_CHKIDX: {                             // si sigue, está dentro
+             long long n = array_dim(&arrays[in->b], in->d);
+             st[in->a].lo = (st[in->a].lo > 0) ? st[in->a].lo : 0;
+             st[in->a].hi = (st[in->a].hi < n - 1) ? st[in->a].hi : n - 1;
+             return;
+         }
+         case OP_UNDEF:
+             r = RANGE_EMPTY;
+             break;
+         case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+             r.lo = 0;
+             r.hi = 1;
+             break;
+         case OP_TOCHR: case OP_READC: case OP_LOADC:
+             r.lo = SCHAR_MIN;
+             r.hi = SCHAR_MAX;
+             if (in->op == OP_TOCHR && st[in->b].lo >= r.lo && st[in->b].hi <= r.hi) {
+                 r = st[in->b];
+             }
+             break;
+         case OP_ASUM: case OP_ADOT: case OP_AMIN: case OP_AMAX:
+             if (arrays[in->b].type == TYPE_CHAR) {     // cada término cabe en 16 bits
+                 long long k = (in->op == OP_ASUM) ? 1 : (in->op == OP_ADOT) ? -SCHAR_MIN : 0;
+                 r.lo = (k == 0) ? SCHAR_MIN : SCHAR_MIN * k * arrays[in->b].len;
+                 r.hi = (k == 0) ? SCHAR_MAX : -SCHAR_MIN * k * arrays[in->b].len;
+             }
+             break;
+         case OP_AFIND:                                // una posición o -1
+             r.lo = -1;
+             r.hi = arrays[in->c].len - 1;
+             break;
+         case OP_DHAS:
+             r.lo = 0;
+             r.hi = 1;
+             break;
+         case OP_DLEN:
+             r.lo = 0;
+             break;
+         case OP_READ: case OP_TRIPS: case OP_POWSUM: case OP_BOUND:
+         case OP_LOAD: case OP_DGET:
+         case OP_FCONST: case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV:
+         case OP_FNEG: case OP_ITOF: case OP_FTOI: case OP_READF:
+             break;
+         default:
+             return;
+     }
+     if (!*exact && !ir_is_checked(in->op)) {
+         r = RANGE_FULL;
+     }
+     st[in->a] = r;
+ }
+ 
+ /**
+  * range_refine(rel, x, y):
+  *   Acota x e y sabiendo que "x rel y" se cumple.
+  */
+ static void range_refine(OpCode rel, Range *x, Range *y) {
+     switch (rel) {
+         case OP_EQ:
+             x->lo = y->lo = (x->lo > y->lo) ? x->lo : y->lo;
+             x->hi = y->hi = (x->hi < y->hi) ? x->hi : y->hi;
+             break;
+         case OP_NE:
+             if (y->lo == y->hi) {
+                 range_exclude(x, y->lo);
+             } else if (x->lo == x->hi) {
+                 range_exclude(y, x->lo);
+             }
+             break;
+         case OP_LT: case OP_LE: {
+             long long gap = (rel == OP_LT);
+             if (gap && (y->hi == LLONG_MIN || x->lo == LLONG_MAX)) {
+                 *x = *y = RANGE_EMPTY;                // nada es < LLONG_MIN
+                 break;
+             }
+             if (x->hi > y->hi - gap) {
+                 x->hi = y->hi - gap;
+             }
+             if (y->lo < x->lo + gap) {
+                 y->lo = x->lo + gap;
+             }
+             break;
+         }
+         case OP_GT: range_refine(OP_LT, y, x); break;
+         case OP_GE: range_refine(OP_LE, y, x); break;
+         default: break;
+     }
+ }
+ 
+ /**
+  * range_edge(p, bb, st, taken):
+  *   Acota st[] (el estado al final de bb) para la arista del JZ
+  *   final que salta (taken) o sigue.
+  */
+ static void range_edge(const IRProgram *p, const BasicBlock *bb, Range *st, int taken) {
+     static const OpCode negated[] = { OP_NE, OP_EQ, OP_GE, OP_GT, OP_LE, OP_LT };
+     const Instr *jz = &p->code[bb->end - 1];
+     int c = jz->a;
+ 
+     // La comparación que da la condición, si sus operandos siguen
+     // valiendo lo mismo en el salto
+     const Instr *cmp = NULL;
+     for (int i = bb->end - 2; i >= bb->start; i--) {
+         const Instr *in = &p->code[i];
+         if (ir_def(in) == c) {
+             if (in->op >= OP_EQ && in->op <= OP_GE && in->b != in->c && in->b != c &&
+                 in->c != c) {
+                 cmp = in;
+             }
+             break;
+         }
+     }
+     for (const Instr *in = cmp + 1; cmp != NULL && in < jz; in++) {
+         int d = ir_def(in);
+         if (d == cmp->b || d == cmp->c) {
+             cmp = NULL;
+         }
+     }
+     if (cmp != NULL) {
+         OpCode rel = taken ? negated[cmp->op - OP_EQ] : cmp->op;
+         range_refine(rel, &st[cmp->b], &st[cmp->c]);
+     }
+ 
+     if (taken) {
+         st[c].lo = (st[c].lo > 0) ? st[c].lo : 0;
+         st[c].hi = (st[c].hi < 0) ? st[c].hi : 0;
+     } else {
+         range_exclude(&st[c], 0);
+     }
+ }
+ 
+ /**
+  * range_join(dst, src, n, widen):
+  *   dst[] = dst[] ∪ src[]; con widen, el extremo que crezca se va al
+  *   límite. Devuelve 1 si dst cambió.
+  */
+ static int range_join(Range *dst, const Range *src, int n, int widen) {
+     int changed = 0;
+     for (int r = 0; r < n; r++) {
+         Range a = dst[r], b = src[r];
+         if (range_empty(b)) {
+             continue;
+         }
+         if (range_empty(a)) {
+             dst[r] = b;
+             changed = 1;
+             continue;
+         }
+         if (b.lo < a.lo) {
+             dst[r].lo = widen ? LLONG_MIN : b.lo;
+             changed = 1;
+         }
+         if (b.hi > a.hi) {
+             dst[r].hi = widen ? LLONG_MAX : b.hi;
+             changed = 1;
+         }
+     }
+     return changed;
+ }
+ 
+ /**
+  * range_analysis(p, g, reached):
+  *   Estado de entrada de cada bloque (matriz num_blocks x num_regs);
+  *   marca en reached[] los bloques alcanzables.
+  */
+ static Range *range_analysis(const IRProgram *p, const CFG *g, char *reached) {
+     int    nr     = p->num_regs;
+     Range *in_st  = malloc(((size_t)g->num_blocks * nr + 1) * sizeof(Range));
+     Range *cur    = malloc((nr + 1) * sizeof(Range));
+     Range *edge   = malloc((nr + 1) * sizeof(Range));
+     int   *work   = malloc(g->num_blocks * sizeof(int));
+     int   *visits = calloc(g->num_blocks, sizeof(int));
+     char  *queued = calloc(g->num_blocks, 1);
+     int    num_work = 0;
+ 
+     // A la entrada cualquier registro puede valer cualquier cosa: las
+     // variables de una región llegan de fuera y las del programa
+     // entero reciben su UNDEF al declararse
+     for (int r = 0; r < nr; r++) {
+         in_st[r] = RANGE_FULL;
+     }
+     reached[0] = 1;
+     work[num_work++] = 0;
+     queued[0] = 1;
+ 
+     while (num_work > 0) {
+         int b = work[--num_work];
+         queued[b] = 0;
+         visits[b]++;
+         const BasicBlock *bb = &g->blocks[b];
+         memcpy(cur, &in_st[(size_t)b * nr], nr * sizeof(Range));
+         for (int i = bb->start; i < bb->end; i++) {
+             int exact;
+             range_step(p, &p->code[i], cur, &exact);
+         }
+ 
+         const Instr *last = &p->code[bb->end - 1];
+         for (int k = 0; k < bb->num_succ; k++) {
+             int s = bb->succ[k];
+             memcpy(edge, cur, nr * sizeof(Range));
+             if (last->op == OP_JZ) {
+                 int to_target = (s == g->block_of[last->b]);
+                 int to_next   = (s == b + 1);
+                 if (to_target && to_next) {
+                     // Salta a la siguiente: no se puede acotar nada
+                 } else {
+                     range_edge(p, bb, edge, to_target);
+                     if (range_empty(edge[last->a])) {
+                         continue;
+                     }
+                 }
+             }
+             Range *dst = &in_st[(size_t)s * nr];
+             int changed;
+             if (!reached[s]) {
+                 reached[s] = 1;
+                 memcpy(dst, edge, nr * sizeof(Range));
+                 changed = 1;
+             } else {
+                 changed = range_join(dst, edge, nr, s <= b && visits[s] >= 3);
+             }
+             if (changed && !queued[s]) {
+                 queued[s] = 1;
+                 work[num_work++] = s;
+             }
+         }
+     }
+     free(cur);
+     free(edge);
+     free(work);
+     free(visits);
+     free(queued);
+     return in_st;
+ }
+ 
+ /**
+  * opt_ranges(p):
+  *   Quita los CHKDIV y CHKIDX que sobran, deja sin comprobar la aritmética
+  *   que no se desborda y decide las comparaciones que ya se saben
+  *   (ver arriba). Devuelve cuántas comprobaciones quitó.
+  */
+ static int opt_ranges(IRProgram *p) {
+     // Con --bigint el intérprete no se queda en 64 bits y lo que se
+     // deduce aquí no le vale; en las regiones sí, porque la VM vuelve
+     // al intérprete antes de salirse
+     if (p->whole_program && int_big) {
+         return 0;
+     }
+     CFG   *g       = cfg_build(p);
+     char  *reached = calloc(g->num_blocks, 1);
+     Range *in_st   = range_analysis(p, g, reached);
+     Range *cur     = malloc((p->num_regs + 1) * sizeof(Range));
+     char  *keep    = malloc(p->num_code + 1);
+     RangeReport rep = { 0, 0, 0, 0, 0, 0, 0 };
+     int    removed = 0;
+ 
+     memset(keep, 1, p->num_code);
+     for (int b = 0; b < g->num_blocks; b++) {
+         if (!reached[b]) {
+             continue;
+         }
+         const BasicBlock *bb = &g->blocks[b];
+         memcpy(cur, &in_st[(size_t)b * p->num_regs], p->num_regs * sizeof(Range));
+         for (int i = bb->start; i < bb->end; i++) {
+             Instr *in = &p->code[i];
+             Range  d  = (in->op == OP_CHKDIV || in->op == OP_CHKIDX) ? cur[in->a]
+                                                                       : RANGE_EMPTY;
+             int narrow = (ir_unchecked(in->op) == OP_DIV &&
+                           cur[in->b].lo > INT_MIN && cur[in->b].hi <= INT_MAX &&
+                           cur[in->c].lo >= INT_MIN && cur[in->c].hi <= INT_MAX);
+             int exact;
+             range_step(p, in, cur, &exact);
+             if (in->op == OP_CHKDIV && (d.lo > 0 || d.hi < 0)) {
+                 keep[i] = 0;
+                 removed++;
+             } else if (in->op == OP_CHKIDX) {
+                 rep.indices++;
+                 if (d.lo >= 0 && d.hi < array_dim(&arrays[in->b], in->d)) {
+                     keep[i] = 0;
+                     removed++;
+                     rep.safe_indices++;
+                 }
+             } else if (ir_unchecked(in->op) >= OP_ADD && ir_unchecked(in->op) <= OP_NEG) {
+                 rep.arith++;
+                 rep.no_overflow += exact;
+                 if (exact && ir_is_checked(in->op)) {
+                     in->op = ir_unchecked(in->op);
+                     rep.unchecked++;
+                 }
+                 if (narrow) {
+                     in->op = OP_DIV32;
+                     rep.narrow++;
+                 }
+             } else if (in->op >= OP_EQ && in->op <= OP_GE &&
+                        cur[in->a].lo == cur[in->a].hi) {
+                 in->op = OP_CONST;
+                 in->b  = ir_const_in(p, cur[in->a].lo);
+                 in->c  = 0;
+                 rep.decided++;
+             }
+         }
+     }
+ 
+     if (p->whole_program) {
+         // Un '/' puede haber dado más de un CHKDIV: el intérprete solo
+         // se ahorra la comprobación si sobran todos
+         for (int i = 0; i < p->num_code; i++) {
+             if (p->code[i].op == OP_CHKDIV && !keep[i]) {
+                 div_is_safe[p->code[i].b] = 1;
+             }
+         }
+         for (int i = 0; i < p->num_code; i++) {
+             if (p->code[i].op == OP_CHKDIV && keep[i]) {
+                 div_is_safe[p->code[i].b] = 0;
+             }
+         }
+         for (int i = 0; i < p->num_code; i++) {
+             if (p->code[i].op == OP_CHKIDX && !keep[i]) {
+                 idx_is_safe[p->code[i].c] = 1;
+             }
+         }
+         for (int i = 0; i < p->num_code; i++) {
+             if (p->code[i].op == OP_CHKIDX && keep[i]) {
+                 idx_is_safe[p->code[i].c] = 0;
+             }
+         }
+         range_report = rep;
+     }
+     if (removed > 0) {
+         ir_compact(p, keep);
+     }
+     free(keep);
+     free(cur);
+     free(in_st);
+     free(reached);
+     cfg_free(g);
+     return removed + rep.unchecked;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Asignación definitiva.
+  *
+  * Para cada variable y cada punto del programa se calcula si puede
+  * estar sin valor (DA_UNDEF) y si puede tenerlo (DA_DEF): análisis
+  * hacia delante en el que la unión de caminos es un OR de bits.
+  * Declarar sin '=' deja DA_UNDEF; cualquier escritura (asignación,
+  * Leer) deja DA_DEF, y también pasar un CHKDEF (si no, el programa
+  * ya habría terminado).
+  *
+  *   - CHKDEF con solo DA_DEF: sobra, se elimina.
+  *   - CHKDEF con solo DA_UNDEF: esa lectura falla siempre que se
+  *     ejecute. En el programa entero es un error de compilación si
+  *     se ejecuta seguro (cfg_always_reached); si no, un aviso y el
+  *     CHKDEF se queda.
+  *   - en otro caso el CHKDEF se queda.
+  *-------------------------------------------------------------*/
+ 
+ #define DA_UNDEF 1
+ #define DA_DEF   2
+ 
+ static void da_step(const Instr *in, unsigned char *st, int nvars) {
+     if (in->op == OP_UNDEF) {
+         st[in->a] = DA_UNDEF;
+     } else if (in->op == OP_CHKDEF) {
+         st[in->a] = DA_DEF;
+     } else {
+         int d = ir_def(in);
+         if (d >= 0 && d < nvars) {
+             st[d] = DA_DEF;
+         }
+     }
+ }
+ 
+ /**
+  * da_analysis(p, g, reached):
+  *   Estado DA_* de cada variable a la entrada de cada bloque:
+  *   in_st[b * nv + v]. Marca en reached[] los bloques alcanzables.
+  *   Devuelve in_st, que libera el llamador.
+  */
+ static unsigned char *da_analysis(const IRProgram *p, const CFG *g, char *reached) {
+     int   nv    = ir_num_vars(p);
+     int   nb    = g->num_blocks;
+     unsigned char *in_st = calloc((size_t)nb * nv + 1, 1);
+     unsigned char *cur   = malloc(nv + 1);
+     char *queued  = calloc(nb, 1);
+     int  *work    = malloc(nb * sizeof(int));
+     int   num_work = 0;
+ 
+     for (int v = 0; v < nv; v++) {
+         in_st[v] = p->whole_program ? DA_UNDEF : (DA_UNDEF | DA_DEF);
+     }
+     reached[0] = queued[0] = 1;
+     work[num_work++] = 0;
+     while (num_work > 0) {
+         int b = work[--num_work];
+         queued[b] = 0;
+         memcpy(cur, &in_st[(size_t)b * nv], nv);
+         for (int i = g->blocks[b].start; i < g->blocks[b].end; i++) {
+             da_step(&p->code[i], cur, nv);
+         }
+         for (int k = 0; k < g->blocks[b].num_succ; k++) {
+             int s = g->blocks[b].succ[k];
+             unsigned char *dst = &in_st[(size_t)s * nv];
+             int changed = !reached[s];
+             reached[s] = 1;
+             for (int v = 0; v < nv; v++) {
+                 if ((dst[v] | cur[v]) != dst[v]) {
+                     dst[v] |= cur[v];
+                     changed = 1;
+                 }
+             }
+             if (changed && !queued[s]) {
+                 queued[s] = 1;
+                 work[num_work++] = s;
+             }
+         }
+     }
+     free(work);
+     free(queued);
+     free(cur);
+     return in_st;
+ }
+ 
+ /**
+  * opt_definite_assignment(p):
+  *   Quita los CHKDEF que el análisis demuestra innecesarios (ver
+  *   arriba) y, en el programa entero, marca esas lecturas en
+  *   read_is_safe[] para el intérprete. Devuelve cuántos quitó.
+  */
+ static int opt_definite_assignment(IRProgram *p) {
+     CFG  *g     = cfg_build(p);
+     int   nv    = ir_num_vars(p);
+     int   nb    = g->num_blocks;
+     char *reached = calloc(nb + 1, 1);
+     unsigned char *in_st = da_analysis(p, g, reached);
+     unsigned char *cur   = malloc(nv + 1);
+ 
+     char *keep    = malloc(p->num_code);
+     int   removed = 0;
+     memset(keep, 1, p->num_code);
+     for (int b = 0; b < nb; b++) {
+         if (!reached[b]) {
+             continue;
+         }
+         memcpy(cur, &in_st[(size_t)b * nv], nv);
+         for (int i = g->blocks[b].start; i < g->blocks[b].end; i++) {
+             const Instr *in = &p->code[i];
+             if (in->op == OP_CHKDEF && cur[in->a] == DA_DEF) {
+                 keep[i] = 0;
+                 removed++;
+                 if (p->whole_program) {
+                     read_is_safe[in->c] = 1;
+                 }
+             } else if (in->op == OP_CHKDEF && cur[in->a] == DA_UNDEF && p->whole_program) {
+                 if (cfg_always_reached(g, reached, b)) {
+                     fprintf(stderr, "Error (línea %d): variable '%s' no %s.\n", in->line,
+                             symtab[in->a].name, in->b ? "declarada" : "inicializada");
+                     exit(1);
+                 }
+                 if (warn_enabled) {
+                     fprintf(stderr, "Aviso (línea %d): variable '%s' no %s si se llega a "
+                                     "ejecutar.\n", in->line, symtab[in->a].name,
+                             in->b ? "declarada" : "inicializada");
+                 }
+             }
+             da_step(in, cur, nv);
+         }
+     }
+     if (removed > 0) {
+         ir_compact(p, keep);
+     }
+ 
+     free(keep);
+     free(reached);
+     free(cur);
+     free(in_st);
+     cfg_free(g);
+     return removed;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Numeración global de valores (GVN) y subexpresiones comunes.
+  *
+  * Trabaja sobre la forma SSA: cada registro recibe un número de
+  * valor y dos registros con el mismo número valen lo mismo. Una
+  * operación sin efectos se identifica por (op, números de sus
+  * operandos); si ya se calculó en un bloque que domina al actual y
+  * el resultado está en un temporal, se reutiliza:
+  *
+  *   - si escribía un temporal, la instrucción desaparece y sus usos
+  *     leen el temporal anterior;
+  *   - si escribía una versión de variable, queda "MOV x.N, temporal".
+  *
+  * Solo los temporales guardan valores para reutilizar: alargar la
+  * vida de una versión de variable rompería la salida de SSA. Una
+  * PHI hereda el número de sus argumentos si todos lo tienen y
+  * coinciden (en la cabecera de un bucle, el de la vuelta todavía
+  * no se conoce y el número es nuevo).
+  *
+  * Los bloques se recorren en preorden del árbol de dominadores; la
+  * tabla de expresiones se deshace al salir de cada subárbol.
+  *
+  * DIV y las operaciones comprobadas (ADDO...) también se reutilizan:
+  * si la primera no falló, la segunda (mismos valores) tampoco lo
+  * haría.
+  *-------------------------------------------------------------*/
+ 
+ typedef struct {
+     OpCode op;
+     int    x, y;       // números de valor de los operandos (CONST: el
+                        // índice de la constante, que no se repite)
+     int    vn;         // número de valor del resultado
+     int    holder;     // temporal que lo guarda, o -1
+     int    next;       // siguiente entrada de la misma cubeta
+ } VNEntry;
+ 
+ static int gvn_pure(OpCode op) {
+     switch (op) {
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_NEG:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_DIVO: case OP_NEGO:
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+         case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV: case OP_FNEG:
+         case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+         case OP_ITOF: case OP_FTOI: case OP_TOCHR: case OP_DIV32:
+             return 1;
+         default:
+             return 0;
+     }
+ }
+ 
+ static unsigned gvn_hash(OpCode op, int x, int y, int mask) {
+     unsigned h = (unsigned)op * 2654435761u ^ (unsigned)x * 40503u ^ (unsigned)y * 9973u;
+     return (h ^ (h >> 15)) & (unsigned)mask;
+ }
+ 
+ /**
+  * opt_gvn(p):
+  *   Elimina las operaciones (y los CONST a temporales) que repiten
+  *   un valor ya calculado en un bloque dominante (p en forma SSA).
+  *   Devuelve cuántas evaluaciones se ahorró.
+  */
+ static int opt_gvn(IRProgram *p) {
+     CFG *g  = cfg_build(p);
+     int  nb = g->num_blocks;
+     int  nv = ir_num_vars(p);
+     int  nr = p->num_regs;
+     if (nb <= 0) {
+         cfg_free(g);
+         return 0;
+     }
+ 
+     int *order    = malloc(nb * sizeof(int));
+     int *idom     = malloc(nb * sizeof(int));
+     int  np       = cfg_dominators(g, order, idom);
+     int *start    = malloc((nb + 1) * sizeof(int));
+     int *children = cfg_dom_children(g, order, idom, np, start);
+ 
+     int      mask    = 1;
+     while (mask < 2 * p->num_code) {
+         mask <<= 1;
+     }
+     int     *bucket  = malloc(mask * sizeof(int));
+     VNEntry *entries = malloc((p->num_code + 1) * sizeof(VNEntry));
+     int      num_ent = 0;
+     mask--;
+     for (int k = 0; k <= mask; k++) {
+         bucket[k] = -1;
+     }
+ 
+     int  *vn      = calloc(nr, sizeof(int));
+     int  *repl    = malloc(nr * sizeof(int));
+     char *keep    = malloc(p->num_code);
+     int   next_vn = 1;
+     int   saved   = 0;
+     for (int r = 0; r < nr; r++) {
+         repl[r] = r;
+     }
+     for (int r = 0; r < nr; r++) {
+         if (p->ssa_var[r] < 0) {
+             vn[r] = next_vn++;                 // valor de entrada
+         }
+     }
+     memset(keep, 1, p->num_code);
+ 
+     // Preorden del árbol con pila: (bloque, marca de la tabla) al salir
+     int *stack = malloc(4 * nb * sizeof(int));
+     int  sp    = 0;
+     stack[sp++] = order[0];
+     stack[sp++] = -1;
+     while (sp > 0) {
+         int mark = stack[--sp];
+         int b    = stack[--sp];
+         if (mark >= 0) {                       // salida: deshacer la tabla
+             while (num_ent > mark) {
+                 VNEntry *e = &entries[--num_ent];
+                 bucket[gvn_hash(e->op, e->x, e->y, mask)] = e->next;
+             }
+             continue;
+         }
+ 
+         stack[sp++] = b;
+         stack[sp++] = num_ent;
+         for (int i = g->blocks[b].start; i < g->blocks[b].end; i++) {
+             Instr *in = &p->code[i];
+             int uses[2];
+             int nu = ir_uses(in, uses);
+             for (int k = 0; k < nu; k++) {
+                 if (repl[uses[k]] != uses[k]) {
+                     ir_replace_use(in, uses[k], repl[uses[k]]);
+                 }
+             }
+             int d = ir_def(in);
+             if (d < 0) {
+                 continue;
+             }
+             if (in->op == OP_PHI) {
+                 int common = vn[p->phi_args[in->b]];
+                 for (int k = 1; k < in->c && common > 0; k++) {
+                     common = (vn[p->phi_args[in->b + k]] == common) ? common : 0;
+                 }
+                 vn[d] = (common > 0) ? common : next_vn++;
+                 continue;
+             }
+             if (in->op == OP_MOV) {
+                 vn[d] = vn[in->b];
+                 continue;
+             }
+             if (in->op != OP_CONST && !gvn_pure(in->op)) {
+                 vn[d] = next_vn++;
+                 continue;
+             }
+ 
+             OpCode op  = in->op;
+             int    tmp = (d >= nv && p->ssa_var[d] < 0);
+             int    x   = (op == OP_CONST) ? in->b : vn[in->b];
+             int    y   = (op == OP_CONST || nu == 1) ? 0 : vn[in->c];
+             if ((op == OP_ADD || op == OP_MUL || op == OP_ADDO || op == OP_MULO ||
+                  op == OP_EQ || op == OP_NE) && x > y) {
+                 int t = x;
+                 x = y;
+                 y = t;
+             }
+             unsigned h     = gvn_hash(op, x, y, mask);
+             int      found = -1, holder = -1;
+             for (int e = bucket[h]; e >= 0 && holder < 0; e = entries[e].next) {
+                 if (entries[e].op == op && entries[e].x == x && entries[e].y == y) {
+                     found  = entries[e].vn;
+                     holder = entries[e].holder;
+                 }
+             }
+             if (holder >= 0 && (tmp || op != OP_CONST)) {
+                 vn[d] = found;
+                 saved++;
+                 if (tmp) {
+                     repl[d] = holder;
+                     keep[i] = 0;
+                 } else {
+                     in->op = OP_MOV;
+                     in->b  = holder;
+                     in->c  = 0;
+                 }
+                 continue;
+             }
+             vn[d] = (found > 0) ? found : next_vn++;
+             if (found < 0 || (tmp && holder < 0)) {
+                 VNEntry *e = &entries[num_ent];
+                 e->op     = op;
+                 e->x      = x;
+                 e->y      = y;
+                 e->vn     = vn[d];
+                 e->holder = tmp ? d : -1;
+                 e->next   = bucket[h];
+                 bucket[h] = num_ent++;
+             }
+         }
+ 
+         for (int c = start[b + 1] - 1; c >= start[b]; c--) {
+             stack[sp++] = children[c];
+             stack[sp++] = -1;
+         }
+     }
+ 
+     if (saved > 0) {
+         for (int i = 0; i < p->num_code; i++) {
+             int uses[2];
+             int nu = ir_uses(&p->code[i], uses);
+             for (int k = 0; k < nu; k++) {
+                 ir_replace_use(&p->code[i], uses[k], repl[uses[k]]);
+             }
+         }
+         ir_compact(p, keep);
+     }
+ 
+     free(stack);
+     free(keep);
+     free(repl);
+     free(vn);
+     free(entries);
+     free(bucket);
+     free(children);
+     free(start);
+     free(idom);
+     free(order);
+     cfg_free(g);
+     return saved;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Movimiento de código invariante (LICM).
+  *
+  * Un bucle es un salto hacia atrás b -> h (todo Mientras acaba en
+  * "JMP cabecera"); su cuerpo son los bloques desde los que se llega
+  * a b sin pasar por h. Una instrucción del cuerpo es invariante si
+  * no tiene efectos y sus operandos no se escriben en el bucle (o
+  * los escribe otra instrucción invariante). Las invariantes se
+  * copian, en orden, a un preheader delante de la cabecera, por el
+  * que pasan todas las entradas desde fuera del bucle:
+  *
+  *   - si escriben un temporal, salen del bucle;
+  *   - si escriben una variable, el cálculo sale a un temporal nuevo
+  *     y en su sitio queda "MOV variable, temporal".
+  *
+  * Calcular de más no tiene efectos visibles (la aritmética no falla
+  * y leer una variable sin valor solo da basura que su CHKDEF, que
+  * sigue en el bucle, nunca deja usar). La excepción es DIV: solo se
+  * mueve si el divisor es una constante distinta de cero, porque su
+  * CHKDIV se queda en el bucle y dividir antes entre cero no daría
+  * el error, sino que abortaría el programa.
+  *-------------------------------------------------------------*/
+ 
+ /**
+  * temp_const(p, r, val):
+  *   1 si el temporal r se define (una sola vez) con CONST; deja el
+  *   valor en *val.
+  */
+ static int temp_const(const IRProgram *p, int r, long long *val) {
+     if (r < ir_num_vars(p)) {
+         return 0;
+     }
+     for (int i = 0; i < p->num_code; i++) {
+         if (ir_def(&p->code[i]) == r) {
+             if (p->code[i].op != OP_CONST) {
+                 return 0;
+             }
+             *val = p->consts[p->code[i].b];
+             return 1;
+         }
+     }
+     return 0;
+ }
+ 
+ static int licm_candidate(const IRProgram *p, const Instr *in) {
+     int d = ir_def(in);
+     switch (in->op) {
+         case OP_CONST:
+         case OP_FCONST:
+         case OP_MOV:
+             return d >= ir_num_vars(p);        // copiar una variable no gana nada
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_NEG:
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+         case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV: case OP_FNEG:
+         case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+         case OP_ITOF: case OP_FTOI: case OP_TOCHR:
+             return 1;
+         case OP_DIV: case OP_DIV32: {
+             long long c;
+             return temp_const(p, in->c, &c) && c != 0;
+         }
+         default:
+             return 0;
+     }
+ }
+ 
+ /**
+  * loop_insert_preheader(p, head, inside, drop, pre, num_pre):
+  *   Reescribe p como [0, head) + pre + [head, n), quitando las
+  *   instrucciones con drop[i] (drop puede ser NULL). Los saltos de
+  *   fuera del bucle (inside[j] == 0) hacia la cabecera entran por
+  *   pre; los saltos dentro de pre llevan índices del código viejo.
+  *   Devuelve where[] (índice viejo -> nuevo), que libera el llamador.
+  */
+ static int *loop_insert_preheader(IRProgram *p, int head, const char *inside,
+                                   const char *drop, const Instr *pre, int num_pre) {
+     int    n     = p->num_code;
+     Instr *code  = malloc((n + num_pre) * sizeof(Instr));
+     int   *where = malloc((n + 1) * sizeof(int));
+     int    m     = 0;
+     for (int i = 0; i < head; i++) {
+         where[i] = m;
+         code[m++] = p->code[i];
+     }
+     int pre_start = m;
+     memcpy(&code[m], pre, num_pre * sizeof(Instr));
+     m += num_pre;
+     for (int i = head; i < n; i++) {
+         where[i] = m;
+         if (drop == NULL || !drop[i]) {
+             code[m++] = p->code[i];
+         }
+     }
+     where[n] = m;
+ 
+     for (int j = 0; j < n; j++) {
+         if ((drop != NULL && drop[j]) || !ir_is_jump(p->code[j].op)) {
+             continue;
+         }
+         Instr *in = &code[where[j]];
+         int *target = (in->op == OP_JMP) ? &in->a : &in->b;
+         if (*target == head && !inside[j]) {
+             *target = pre_start;
+         } else {
+             *target = where[*target];
+         }
+     }
+     for (int j = pre_start; j < pre_start + num_pre; j++) {
+         if (ir_is_jump(code[j].op)) {
+             int *target = (code[j].op == OP_JMP) ? &code[j].a : &code[j].b;
+             *target = where[*target];
+         }
+     }
+ 
+     free(p->code);
+     p->code     = code;
+     p->num_code = m;
+     p->cap_code = n + num_pre;
+     return where;
+ }
+ 
+ /**
+  * licm_loop(p, g, h, b):
+  *   Saca del bucle b -> h lo que sea invariante. Devuelve cuántas
+  *   instrucciones movió (si movió alguna, p ha cambiado y g ya no
+  *   sirve).
+  */
+ static int licm_loop(IRProgram *p, const CFG *g, int h, int b) {
+     char *in_loop = loop_blocks(g, h, b);
+     int   n       = p->num_code;
+     char *inside  = calloc(n, 1);
+     char *inv     = calloc(n, 1);
+     int  *ndefs   = calloc(p->num_regs, sizeof(int));
+     int  *def_at  = malloc(p->num_regs * sizeof(int));
+     for (int i = 0; i < n; i++) {
+         inside[i] = in_loop[g->block_of[i]];
+         int d = ir_def(&p->code[i]);
+         if (inside[i] && d >= 0) {
+             ndefs[d]++;
+             def_at[d] = i;
+         }
+     }
+     free(in_loop);
+ 
+     int count   = 0;
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         for (int i = 0; i < n; i++) {
+             const Instr *in = &p->code[i];
+             if (!inside[i] || inv[i] || !licm_candidate(p, in)) {
+                 continue;
+             }
+             int uses[2];
+             int nu = ir_uses(in, uses);
+             int ok = 1;
+             for (int k = 0; k < nu && ok; k++) {
+                 int r = uses[k];
+                 ok = (ndefs[r] == 0) ||
+                      (r >= ir_num_vars(p) && ndefs[r] == 1 && inv[def_at[r]]);
+             }
+             if (ok) {
+                 inv[i] = 1;
+                 count++;
+                 changed = 1;
+             }
+         }
+     }
+     free(ndefs);
+     free(def_at);
+     if (count == 0) {
+         free(inside);
+         free(inv);
+         return 0;
+     }
+ 
+     // Preheader con las invariantes, en orden; las que escriben una
+     // variable dejan un MOV en su sitio
+     int    head = g->blocks[h].start;
+     Instr *pre  = malloc(count * sizeof(Instr));
+     int    m    = 0;
+     for (int i = head; i < n; i++) {
+         if (!inv[i]) {
+             continue;
+         }
+         pre[m] = p->code[i];
+         if (ir_def(&p->code[i]) < ir_num_vars(p)) {
+             int t = ir_new_temp(p);
+             pre[m].a = t;
+             pre[m].d = 0;
+             p->code[i].op = OP_MOV;         // se queda en el bucle
+             p->code[i].b  = t;
+             p->code[i].c  = 0;
+             inv[i] = 0;
+         }
+         m++;
+     }
+     free(loop_insert_preheader(p, head, inside, inv, pre, m));
+     free(pre);
+     free(inside);
+     free(inv);
+     return count;
+ }
+ 
+ /**
+  * opt_licm(p):
+  *   Aplica licm_loop() a cada bucle, de los más internos (menos
+  *   instrucciones) a los más externos, hasta que no queda nada que
+  *   mover. Devuelve el total de instrucciones movidas.
+  */
+ static int opt_licm(IRProgram *p) {
+     int total = 0;
+     int moved = 1;
+     while (moved) {
+         moved = 0;
+         CFG *g = cfg_build(p);
+         // Probamos los bucles de menor a mayor (tamaño, cabecera)
+         // hasta que uno mueva algo
+         long long tried = -1;
+         while (!moved) {
+             long long best = LLONG_MAX;
+             int best_h = -1, best_b = -1;
+             for (int b = 0; b < g->num_blocks; b++) {
+                 for (int k = 0; k < g->blocks[b].num_succ; k++) {
+                     int h = g->blocks[b].succ[k];
+                     long long key = (long long)(g->blocks[b].end - g->blocks[h].start)
+                                     * (g->num_blocks + 1) + h;
+                     if (h <= b && key > tried && key < best) {
+                         best   = key;
+                         best_h = h;
+                         best_b = b;
+                     }
+                 }
+             }
+             if (best_h < 0) {
+                 break;
+             }
+             tried = best;
+             int c = licm_loop(p, g, best_h, best_b);
+             total += c;
+             moved = (c > 0);
+         }
+         cfg_free(g);
+     }
+     return total;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Variables de inducción (evolución escalar).
+  *
+  * Una variable de inducción básica de un bucle es una variable con
+  * una sola asignación en él, "v = v ± paso" con paso constante, que
+  * se ejecuta en todas las vueltas. Lo que depende de ella se
+  * describe por su evolución: en la vuelta k, v vale v0 + k·paso.
+  *
+  *   - Reducción de fuerza: "t = v * c" (c constante) pasa a leer un
+  *     registro w que vale siempre v*c y que se mantiene sumando
+  *     paso*c justo detrás de la asignación de v.
+  *
+  *   - Forma cerrada: si el bucle es "Mientras (v REL n) { ... }"
+  *     con un cuerpo sin saltos, sin imprimir, leer ni dividir, y sus
+  *     demás asignaciones son acumuladores "s = s ± P(k)" (P un
+  *     polinomio de grado <= 3 en la vuelta k que no lee s), el bucle
+  *     se sustituye por su resultado:
+  *
+  *         T = vueltas(v0, n)
+  *         s = s ± Σ_j c_j · Σ_{k<T} k^j
+  *         v = v0 + T·paso
+  *
+  *     Las sumas de potencias tienen fórmula cerrada exacta módulo
+  *     2^64, que es la aritmética de OP_ADD..OP_NEG, así que el
+  *     resultado es el mismo. Con aritmética comprobada (sin --wrap)
+  *     la forma cerrada calcula además, con OP_BOUND, una cota de
+  *     cada valor comprobado en todas las vueltas (|v0| + T·|paso|,
+  *     |s0| + T·cota(P), ...); si alguna no cabe en un Entero se
+  *     ejecuta el bucle, que da el error en la vuelta que toca. Si
+  *     todas caben, ninguna vuelta se desborda y el resultado módulo
+  *     2^64 es el exacto. El bucle queda detrás como respaldo para
+  *     eso y para cuando T no se puede calcular (0).
+  *-------------------------------------------------------------*/
+ 
+ /**
+  * ir_trips(x, n, d):
+  *   Vueltas de "Mientras (v REL n) ... v = v + paso" desde v = x,
+  *   con d = paso*8 + (REL - OP_EQ). Devuelve 0 si no entra en el
+  *   bucle o si no se puede saber: paso en la dirección contraria,
+  *   "!=" con |paso| != 1, o v saldría del rango de 64 bits (daría la
+  *   vuelta) antes de terminar.
+  */
+ static long long ir_trips(long long x, long long n, int d) {
+     int                rel  = d & 7;
+     long long          step = (d - rel) / 8;
+     unsigned long long t;
+     long long          moved, last;
+     switch (OP_EQ + rel) {
+         case OP_EQ:
+             return x == n;
+         case OP_NE:
+             if (x == n || (step != 1 && step != -1)) {
+                 return 0;
+             }
+             t = ((unsigned long long)n - (unsigned long long)x) * (unsigned long long)step;
+             break;
+         case OP_LT: case OP_LE:
+             if (step <= 0 || x > n || (x == n && OP_EQ + rel == OP_LT)) {
+                 return 0;
+             }
+             // n - x no cabe en un long long, pero sí sin signo
+             t = (unsigned long long)n - (unsigned long long)x;
+             t = (OP_EQ + rel == OP_LT) ? (t - 1) / step + 1 : t / step + 1;
+             break;
+         case OP_GT: case OP_GE:
+             if (step >= 0 || x < n || (x == n && OP_EQ + rel == OP_GT)) {
+                 return 0;
+             }
+             t = (unsigned long long)x - (unsigned long long)n;
+             t = (OP_EQ + rel == OP_GT) ? (t - 1) / -step + 1 : t / -step + 1;
+             break;
+         default:
+             return 0;
+     }
+     if (t > LLONG_MAX || __builtin_mul_overflow((long long)t, step, &moved) ||
+         __builtin_add_overflow(x, moved, &last)) {
+         return 0;
+     }
+     return (long long)t;
+ }
+ 
+ /**
+  * ir_powsum(t, e):
+  *   Σ k^e para 0 <= k < t (e de 1 a 3), módulo 2^64. Se divide antes
+  *   de multiplicar para que las fórmulas sean exactas:
+  *     Σ k   = t(t-1)/2 = s1
+  *     Σ k^2 = t(t-1)(2t-1)/6   (2 divide a t o a t-1; 3, a uno
+  *                               de los tres)
+  *     Σ k^3 = s1^2
+  */
+ static long long ir_powsum(unsigned long long t, int e) {
+     unsigned long long a = t, b = t - 1, c = 2 * t - 1;
+     if (t == 0) {
+         return 0;
+     }
+     if (a % 2 == 0) {
+         a /= 2;
+     } else {
+         b /= 2;
+     }
+     switch (e) {
+         case 1:
+             return (long long)(a * b);
+         case 2:
+             if (a % 3 == 0) {
+                 a /= 3;
+             } else if (b % 3 == 0) {
+                 b /= 3;
+             } else {
+                 c /= 3;
+             }
+             return (long long)(a * b * c);
+         default:
+             return (long long)(a * b * a * b);
+     }
+ }
+ 
+ /**
+  * ir_bound(x, y, mul):
+  *   OP_BOUND: |x| + |y| (|x|·|y| si mul) sin signo, como mucho 2^63.
+  *   Sirve igual para valores que para cotas: una cota que no cabe en
+  *   un Entero sale negativa (2^63) y su valor absoluto es ella misma.
+  */
+ static long long ir_bound(long long x, long long y, int mul) {
+     unsigned long long ux = (x < 0) ? -(unsigned long long)x : (unsigned long long)x;
+     unsigned long long uy = (y < 0) ? -(unsigned long long)y : (unsigned long long)y;
+     unsigned long long r;
+     if ((mul ? __builtin_mul_overflow(ux, uy, &r) : __builtin_add_overflow(ux, uy, &r)) ||
+         r > 1ULL << 63) {
+         r = 1ULL << 63;
+     }
+     return (long long)r;
+ }
+ 
+ /* Código que se va acumulando para el preheader de un bucle */
+ typedef struct {
+     Instr *code;
+     int    num, cap;
+     int    line;       // línea con la que se emite
+ } InstrBuf;
+ 
+ static int ibuf_emit(InstrBuf *q, OpCode op, int a, int b, int c) {
+     if (q->num >= q->cap) {
+         q->cap  = q->cap ? q->cap * 2 : 32;
+         q->code = realloc(q->code, q->cap * sizeof(Instr));
+         if (q->code == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     Instr *in = &q->code[q->num];
+     in->op   = op;
+     in->a    = a;
+     in->b    = b;
+     in->c    = c;
+     in->line = q->line;
+     in->d    = 0;
+     return q->num++;
+ }
+ 
+ /* Emite "t = b op c" en un temporal nuevo y lo devuelve */
+ static int ibuf_temp(IRProgram *p, InstrBuf *q, OpCode op, int b, int c) {
+     int t = ir_new_temp(p);
+     ibuf_emit(q, op, t, b, c);
+     return t;
+ }
+ 
+ /* Emite "t = BOUND b, c" (mul: |b|·|c|) en un temporal nuevo */
+ static int ibuf_bound(IRProgram *p, InstrBuf *q, int b, int c, int mul) {
+     int t = ibuf_temp(p, q, OP_BOUND, b, c);
+     q->code[q->num - 1].d = mul;
+     return t;
+ }
+ 
+ /**
+  * biv_step(p, in, v, step):
+  *   1 si in es "v = v + c", "v = c + v" o "v = v - c" (comprobada o
+  *   no) con c un temporal constante (paso distinto de 0 y pequeño,
+  *   para que quepa en el operando d de OP_TRIPS); deja el paso en
+  *   *step.
+  */
+ static int biv_step(const IRProgram *p, const Instr *in, int v, int *step) {
+     int       r;
+     long long c;
+     if (in->a != v) {
+         return 0;
+     }
+     OpCode op = ir_unchecked(in->op);
+     if (op == OP_ADD && in->b == v && in->c != v) {
+         r = in->c;
+     } else if (op == OP_ADD && in->c == v && in->b != v) {
+         r = in->b;
+     } else if (op == OP_SUB && in->b == v && in->c != v) {
+         r = in->c;
+     } else {
+         return 0;
+     }
+     if (!temp_const(p, r, &c) || c == 0 || c <= -(1 << 27) || c >= (1 << 27)) {
+         return 0;
+     }
+     *step = (int)((op == OP_SUB) ? -c : c);
+     return 1;
+ }
+ 
+ /*
+  * Polinomio en la vuelta k: c[j] es el registro con el coeficiente
+  * de k^j, o -1 si es cero.
+  */
+ typedef struct {
+     int c[4];
+ } Poly;
+ 
+ static Poly poly_reg(int r) {
+     Poly x = { { r, -1, -1, -1 } };
+     return x;
+ }
+ 
+ static Poly poly_add(IRProgram *p, InstrBuf *q, const Poly *x, const Poly *y, int sub) {
+     Poly r;
+     for (int j = 0; j < 4; j++) {
+         if (y->c[j] < 0) {
+             r.c[j] = x->c[j];
+         } else if (x->c[j] < 0) {
+             r.c[j] = sub ? ibuf_temp(p, q, OP_NEG, y->c[j], 0) : y->c[j];
+         } else {
+             r.c[j] = ibuf_temp(p, q, sub ? OP_SUB : OP_ADD, x->c[j], y->c[j]);
+         }
+     }
+     return r;
+ }
+ 
+ static Poly poly_neg(IRProgram *p, InstrBuf *q, const Poly *x) {
+     Poly r;
+     for (int j = 0; j < 4; j++) {
+         r.c[j] = (x->c[j] < 0) ? -1 : ibuf_temp(p, q, OP_NEG, x->c[j], 0);
+     }
+     return r;
+ }
+ 
+ /* x*y; 0 si el grado pasa de 3 */
+ static int poly_mul(IRProgram *p, InstrBuf *q, const Poly *x, const Poly *y, Poly *r) {
+     for (int j = 0; j < 4; j++) {
+         r->c[j] = -1;
+     }
+     for (int i = 0; i < 4; i++) {
+         for (int j = 0; j < 4; j++) {
+             if (x->c[i] < 0 || y->c[j] < 0) {
+                 continue;
+             }
+             if (i + j > 3) {
+                 return 0;
+             }
+             int t = ibuf_temp(p, q, OP_MUL, x->c[i], y->c[j]);
+             r->c[i + j] = (r->c[i + j] < 0) ? t : ibuf_temp(p, q, OP_ADD, r->c[i + j], t);
+         }
+     }
+     return 1;
+ }
+ 
+ /**
+  * closed_form_done(p, head):
+  *   1 si delante de la cabecera ya hay una forma cerrada (un
+  *   "JZ vueltas, cabecera" justo detrás de su OP_TRIPS).
+  */
+ static int closed_form_done(const IRProgram *p, int head) {
+     for (int i = 1; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         if (in->op == OP_JZ && in->b == head && p->code[i - 1].op == OP_TRIPS &&
+             p->code[i - 1].a == in->a) {
+             return 1;
+         }
+     }
+     return 0;
+ }
+ 
+ /**
+  * closed_form_loop(p, g, h, b):
+  *   Pone delante del bucle b -> h su forma cerrada, si la tiene.
+  *   Devuelve 1 si cambió p.
+  */
+ static int closed_form_loop(IRProgram *p, const CFG *g, int h, int b) {
+     const BasicBlock *H = &g->blocks[h];
+     const BasicBlock *B = &g->blocks[b];
+     if (b != h + 1) {
+         return 0;
+     }
+     const Instr *jz   = &p->code[H->end - 1];
+     const Instr *back = &p->code[B->end - 1];
+     if (jz->op != OP_JZ || jz->b != B->end || back->op != OP_JMP ||
+         back->a != H->start || closed_form_done(p, H->start)) {
+         return 0;
+     }
+ 
+     int  nv     = ir_num_vars(p);
+     int  nr     = p->num_regs;
+     int *ndefs  = calloc(nr, sizeof(int));
+     int *def_at = malloc(nr * sizeof(int));
+     for (int i = H->start; i < B->end; i++) {
+         int d = ir_def(&p->code[i]);
+         if (d >= 0) {
+             ndefs[d]++;
+             def_at[d] = i;
+         }
+     }
+ 
+     // Cabecera: CHKDEF y temporales sin efectos; la condición es
+     // "v REL n" con v de inducción y n invariante
+     const Instr *cond = NULL;
+     int ok = 1;
+     for (int i = H->start; i < H->end - 1 && ok; i++) {
+         const Instr *in = &p->code[i];
+         int d = ir_def(in);
+         if (in->op == OP_CHKDEF) {
+             continue;
+         }
+         ok = (d >= nv && in->op != OP_DIV && in->op != OP_DIV32 && !ir_may_fail(in->op));
+         if (d == jz->a) {
+             cond = in;
+         }
+     }
+     int v = -1, n = -1, rel = 0, step = 0;
+     if (ok && cond != NULL && cond->op >= OP_EQ && cond->op <= OP_GE) {
+         static const OpCode swapped[] = { OP_EQ, OP_NE, OP_GT, OP_GE, OP_LT, OP_LE };
+         int x = cond->b, y = cond->c;
+         if (x < nv && ndefs[x] == 1 && biv_step(p, &p->code[def_at[x]], x, &step)) {
+             v = x, n = y, rel = cond->op;
+         } else if (y < nv && ndefs[y] == 1 && biv_step(p, &p->code[def_at[y]], y, &step)) {
+             v = y, n = x, rel = swapped[cond->op - OP_EQ];
+         }
+     }
+     if (v < 0 || ndefs[n] != 0 || g->block_of[def_at[v]] != b) {
+         free(ndefs);
+         free(def_at);
+         return 0;
+     }
+ 
+     InstrBuf q   = { NULL, 0, 0, jz->line };
+     int     *acc = malloc(nr * sizeof(int));         // acumuladores
+     Poly    *sum = malloc(nr * sizeof(Poly));        // lo que suma cada uno
+     Poly    *ev  = malloc(nr * sizeof(Poly));        // evolución por registro
+     int     *accof = malloc(nr * sizeof(int));       // acumulador que lleva
+     char    *known = calloc(nr, 1);
+     int     *bnd   = malloc(nr * sizeof(int));       // cota (sin acumulador)
+     int     *chk   = malloc(nr * sizeof(int));       // valores comprobados
+     int     *chkof = malloc(nr * sizeof(int));       // y su acumulador
+     int      num_acc = 0, num_chk = 0, checked = 0;
+ 
+     for (int i = B->start; i < B->end; i++) {
+         checked |= ir_is_checked(p->code[i].op);
+     }
+     for (int r = 0; r < nr; r++) {
+         bnd[r] = -1;
+     }
+ 
+     for (int i = H->start; i < H->end - 1; i++) {
+         if (p->code[i].op == OP_CHKDEF) {
+             ibuf_emit(&q, OP_CHKDEF, p->code[i].a, p->code[i].b, p->code[i].c);
+         }
+     }
+     int trips = ibuf_temp(p, &q, OP_TRIPS, v, n);
+     q.code[q.num - 1].d = step * 8 + (rel - OP_EQ);
+     ibuf_emit(&q, OP_JZ, trips, H->start, 0);
+     int sreg = ibuf_temp(p, &q, OP_CONST, ir_const_in(p, step), 0);
+     int zero = -1;
+     ev[v]      = poly_reg(v);
+     ev[v].c[1] = sreg;
+     accof[v]   = -1;
+     known[v]   = 1;
+     if (checked) {
+         zero   = ibuf_temp(p, &q, OP_CONST, ir_const_in(p, 0), 0);
+         bnd[v] = ibuf_bound(p, &q, v, ibuf_bound(p, &q, trips, sreg, 1), 0);
+     }
+ 
+     // Cuerpo: evolución de cada temporal en función de k. Un
+     // temporal puede llevar además (con coeficiente 1) el valor de
+     // un acumulador leído antes de su asignación.
+     for (int i = B->start; i < B->end - 1 && ok; i++) {
+         const Instr *in = &p->code[i];
+         int d = ir_def(in);
+         int uses[2];
+         int nu = ir_uses(in, uses);
+         Poly op[2];
+         int  opacc[2] = { -1, -1 };
+         int  ob[2]    = { zero, zero };
+         if (in->op == OP_CHKDEF) {
+             ibuf_emit(&q, OP_CHKDEF, in->a, in->b, in->c);
+             continue;
+         }
+         if (d == v) {                                 // v = v ± paso
+             Poly s = poly_reg(sreg);
+             ev[v] = poly_add(p, &q, &ev[v], &s, 0);
+             continue;
+         }
+         for (int k = 0; k < nu && ok; k++) {
+             int r = uses[k];
+             if (ndefs[r] == 0) {
+                 op[k] = poly_reg(r);
+                 if (checked && bnd[r] < 0) {
+                     bnd[r] = ibuf_bound(p, &q, r, zero, 0);
+                 }
+                 ob[k] = bnd[r];
+             } else if (known[r]) {
+                 op[k]    = ev[r];
+                 opacc[k] = accof[r];
+                 ob[k]    = bnd[r];
+             } else if (r < nv && def_at[r] >= i) {
+                 op[k]    = poly_reg(-1);
+                 opacc[k] = r;
+             } else {
+                 ok = 0;
+             }
+         }
+         if (!ok) {
+             break;
+         }
+         // Cota de |P(k)| (sin el acumulador), si hace falta
+         Poly   res;
+         int    racc = -1, rb = -1;
+         OpCode opc  = ir_unchecked(in->op);
+         switch (opc) {
+             case OP_CONST:
+                 res = poly_reg(ibuf_temp(p, &q, OP_CONST, in->b, 0));
+                 if (checked) {
+                     rb = ibuf_bound(p, &q, res.c[0], zero, 0);
+                 }
+                 break;
+             case OP_MOV:
+                 res  = op[0];
+                 racc = opacc[0];
+                 rb   = ob[0];
+                 break;
+             case OP_ADD: case OP_SUB:
+                 ok   = (opacc[1] < 0 || (opc == OP_ADD && opacc[0] < 0));
+                 racc = (opacc[0] >= 0) ? opacc[0] : opacc[1];
+                 res  = poly_add(p, &q, &op[0], &op[1], opc == OP_SUB);
+                 if (checked) {
+                     rb = ibuf_bound(p, &q, ob[0], ob[1], 0);
+                 }
+                 break;
+             case OP_NEG:
+                 ok  = (opacc[0] < 0);
+                 res = poly_neg(p, &q, &op[0]);
+                 rb  = ob[0];
+                 break;
+             case OP_MUL:
+                 ok = (opacc[0] < 0 && opacc[1] < 0) && poly_mul(p, &q, &op[0], &op[1], &res);
+                 if (ok && checked) {
+                     rb = ibuf_bound(p, &q, ob[0], ob[1], 1);
+                 }
+                 break;
+             default:
+                 ok = 0;
+                 break;
+         }
+         if (!ok) {
+             break;
+         }
+         if (ir_is_checked(in->op)) {
+             chk[num_chk]     = rb;
+             chkof[num_chk++] = racc;
+         }
+         if (d < nv) {                                 // s = s ± P(k)
+             ok = (racc == d);
+             sum[num_acc]   = res;
+             bnd[d]         = rb;
+             acc[num_acc++] = d;
+         } else {
+             ev[d]    = res;
+             accof[d] = racc;
+             bnd[d]   = rb;
+             known[d] = 1;
+         }
+     }
+ 
+     if (ok && num_chk > 0) {
+         // Con T vueltas un acumulador no pasa de |s0| + T·cota(P);
+         // si un valor comprobado puede no caber, se ejecuta el bucle
+         int *accb = malloc(nr * sizeof(int));
+         for (int a = 0; a < num_acc; a++) {
+             accb[acc[a]] = ibuf_bound(p, &q, acc[a],
+                                       ibuf_bound(p, &q, trips, bnd[acc[a]], 1), 0);
+         }
+         for (int c = 0; c < num_chk; c++) {
+             int t = (chkof[c] >= 0) ? ibuf_bound(p, &q, accb[chkof[c]], chk[c], 0) : chk[c];
+             ibuf_emit(&q, OP_JZ, ibuf_temp(p, &q, OP_GE, t, zero), H->start, 0);
+         }
+         free(accb);
+     }
+     if (ok) {
+         // s = s ± Σ c_j·Σ_{k<T} k^j; al final v = v0 + T·paso
+         int pw[4] = { trips, -1, -1, -1 };
+         for (int a = 0; a < num_acc; a++) {
+             int total = -1;
+             for (int j = 0; j < 4; j++) {
+                 if (sum[a].c[j] < 0) {
+                     continue;
+                 }
+                 if (pw[j] < 0) {
+                     pw[j] = ibuf_temp(p, &q, OP_POWSUM, trips, j);
+                 }
+                 int t = ibuf_temp(p, &q, OP_MUL, sum[a].c[j], pw[j]);
+                 total = (total < 0) ? t : ibuf_temp(p, &q, OP_ADD, total, t);
+             }
+             if (total >= 0) {
+                 ibuf_emit(&q, OP_ADD, acc[a], acc[a], total);
+             }
+         }
+         int moved = ibuf_temp(p, &q, OP_MUL, trips, sreg);
+         ibuf_emit(&q, OP_ADD, v, v, moved);
+         ibuf_emit(&q, OP_JMP, B->end, 0, 0);
+ 
+         char *inside = calloc(p->num_code, 1);
+         for (int i = H->start; i < B->end; i++) {
+             inside[i] = 1;
+         }
+         free(loop_insert_preheader(p, H->start, inside, NULL, q.code, q.num));
+         free(inside);
+     } else {
+         p->num_temps -= p->num_regs - nr;     // los temporales no se usan
+         p->num_regs   = nr;
+     }
+ 
+     free(q.code);
+     free(acc);
+     free(sum);
+     free(ev);
+     free(accof);
+     free(known);
+     free(bnd);
+     free(chk);
+     free(chkof);
+     free(ndefs);
+     free(def_at);
+     return ok;
+ }
+ 
+ /**
+  * dominates_latch(g, in_loop, h, x, b):
+  *   1 si todo camino de h a b dentro del bucle pasa por el bloque x
+  *   (lo que hay en x se ejecuta en todas las vueltas).
+  */
+ static int dominates_latch(const CFG *g, const char *in_loop, int h, int x, int b) {
+     if (x == h || x == b) {
+         return 1;
+     }
+     char *seen  = calloc(g->num_blocks, 1);
+     int  *stack = malloc(g->num_blocks * sizeof(int));
+     int   sp    = 0;
+     int   found = 0;
+     seen[h] = 1;
+     stack[sp++] = h;
+     while (sp > 0 && !found) {
+         int y = stack[--sp];
+         for (int k = 0; k < g->blocks[y].num_succ; k++) {
+             int z = g->blocks[y].succ[k];
+             if (in_loop[z] && !seen[z] && z != x) {
+                 seen[z] = 1;
+                 stack[sp++] = z;
+                 found |= (z == b);
+             }
+         }
+     }
+     free(seen);
+     free(stack);
+     return !found;
+ }
+ 
+ /**
+  * ir_insert_after(p, pos, ins, count):
+  *   Inserta ins[0..count-1] detrás de code[pos]. Solo se ejecutan al
+  *   pasar por pos: los saltos a pos+1 siguen yendo a lo que había.
+  */
+ static void ir_insert_after(IRProgram *p, int pos, const Instr *ins, int count) {
+     if (p->num_code + count > p->cap_code) {
+         p->cap_code = p->num_code + count;
+         p->code = realloc(p->code, p->cap_code * sizeof(Instr));
+         if (p->code == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     memmove(&p->code[pos + 1 + count], &p->code[pos + 1],
+             (p->num_code - pos - 1) * sizeof(Instr));
+     memcpy(&p->code[pos + 1], ins, count * sizeof(Instr));
+     p->num_code += count;
+     for (int i = 0; i < p->num_code; i++) {
+         if (i > pos && i <= pos + count) {
+             continue;
+         }
+         Instr *in = &p->code[i];
+         int *target = (in->op == OP_JMP) ? &in->a : &in->b;
+         if (ir_is_jump(in->op) && *target > pos) {
+             *target += count;
+         }
+     }
+ }
+ 
+ /**
+  * strength_reduce_loop(p, g, h, b):
+  *   Cambia la primera multiplicación "t = v * c" del bucle b -> h
+  *   (v de inducción, c constante) por un registro que se actualiza
+  *   con sumas. Devuelve 1 si cambió p.
+  */
+ static int strength_reduce_loop(IRProgram *p, const CFG *g, int h, int b) {
+     char *in_loop = loop_blocks(g, h, b);
+     int   n       = p->num_code;
+     int   nv      = ir_num_vars(p);
+     char *inside  = calloc(n, 1);
+     int  *ndefs   = calloc(p->num_regs, sizeof(int));
+     int  *def_at  = malloc(p->num_regs * sizeof(int));
+     for (int i = 0; i < n; i++) {
+         inside[i] = in_loop[g->block_of[i]];
+         int d = ir_def(&p->code[i]);
+         if (inside[i] && d >= 0) {
+             ndefs[d]++;
+             def_at[d] = i;
+         }
+     }
+ 
+     int       mul = -1, v = -1, step = 0;
+     long long k = 0;
+     for (int i = 0; i < n && mul < 0; i++) {
+         const Instr *in = &p->code[i];
+         if (!inside[i] || in->op != OP_MUL || in->a < nv) {
+             continue;
+         }
+         for (int s = 0; s < 2 && mul < 0; s++) {
+             int x = s ? in->c : in->b;
+             int y = s ? in->b : in->c;
+             if (x < nv && ndefs[x] == 1 && ndefs[y] == 0 && temp_const(p, y, &k) &&
+                 biv_step(p, &p->code[def_at[x]], x, &step) &&
+                 dominates_latch(g, in_loop, h, g->block_of[def_at[x]], b)) {
+                 mul = i;
+                 v   = x;
+             }
+         }
+     }
+     free(in_loop);
+     if (mul < 0) {
+         free(inside);
+         free(ndefs);
+         free(def_at);
+         return 0;
+     }
+ 
+     // Preheader: w = v * c. Si t solo se lee más abajo en su bloque
+     // sin pasar por la asignación de v, se lee w directamente.
+     int t  = p->code[mul].a;
+     int w  = ir_new_temp(p);
+     int vd = def_at[v];
+     InstrBuf q = { NULL, 0, 0, p->code[mul].line };
+     int kr = ibuf_temp(p, &q, OP_CONST, ir_const_in(p, k), 0);
+     ibuf_emit(&q, OP_MUL, w, v, kr);
+     int sk = ibuf_temp(p, &q, OP_CONST,
+                        ir_const_in(p, (long long)((unsigned long long)step *
+                                                   (unsigned long long)k)), 0);
+ 
+     int propagate = 1;
+     for (int j = 0; j < n && propagate; j++) {
+         int uses[2];
+         int nu = ir_uses(&p->code[j], uses);
+         for (int u = 0; u < nu; u++) {
+             if (uses[u] == t && (j <= mul || g->block_of[j] != g->block_of[mul] ||
+                                  (vd > mul && vd < j))) {
+                 propagate = 0;
+             }
+         }
+     }
+     char *drop = calloc(n, 1);
+     if (propagate) {
+         for (int j = mul + 1; j < n; j++) {
+             ir_replace_use(&p->code[j], t, w);
+         }
+         drop[mul] = 1;
+     } else {
+         p->code[mul].op = OP_MOV;
+         p->code[mul].b  = w;
+         p->code[mul].c  = 0;
+     }
+ 
+     int *where = loop_insert_preheader(p, g->blocks[h].start, inside, drop, q.code, q.num);
+     Instr upd = { OP_ADD, w, w, sk, p->code[where[vd]].line, 0 };
+     ir_insert_after(p, where[vd], &upd, 1);
+ 
+     free(where);
+     free(drop);
+     free(q.code);
+     free(inside);
+     free(ndefs);
+     free(def_at);
+     return 1;
+ }
+ 
+ /**
+  * opt_induction(p):
+  *   Formas cerradas y reducción de fuerza, bucle a bucle, hasta que
+  *   no queda nada que cambiar. Devuelve cuántos cambios hizo.
+  */
+ static int opt_induction(IRProgram *p) {
+     int total = 0;
+     for (int pass = 0; pass < 2; pass++) {
+         int changed = 1;
+         while (changed) {
+             changed = 0;
+             CFG *g = cfg_build(p);
+             for (int b = 0; b < g->num_blocks && !changed; b++) {
+                 for (int k = 0; k < g->blocks[b].num_succ && !changed; k++) {
+                     int h = g->blocks[b].succ[k];
+                     if (h <= b) {
+                         changed = pass ? strength_reduce_loop(p, g, h, b)
+                                        : closed_form_loop(p, g, h, b);
+                     }
+                 }
+             }
+             cfg_free(g);
+             total += changed;
+         }
+     }
+     return total;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Vectorización de bucles.
+  *
+  * Un bucle "Mientras (v REL n) { ... v = v ± paso; }" de un solo
+  * bloque, sin saltos, sin imprimir, leer ni dividir, que solo
+  * escribe en vectores y en variables de inducción (una sola
+  * asignación "w = w ± x", x invariante), se puede ejecutar por
+  * carriles: la vuelta j en el carril j, muchas a la vez. El caso
+  * típico:
+  *
+  *     Mientras (i < n) { c[i] = a[i] * k + b[i]; i = i + 1; }
+  *
+  * Además hace falta que ninguna vuelta dependa de otra:
+  *   - cada temporal del cuerpo se escribe una vez y antes de leerse;
+  *   - el índice de cada acceso a un vector avanza 1 por vuelta (i,
+  *     i + 1, j - 3...), así que los carriles tocan elementos
+  *     seguidos;
+  *   - un vector en el que se escribe se lee y escribe siempre con
+  *     el mismo índice: ninguna vuelta ve lo que escribe otra.
+  *
+  * La pasada pone delante de la cabecera un OP_VLOOP, que ejecuta de
+  * una vez las vueltas enteras que quiera (quizá ninguna) y deja las
+  * variables de inducción como las dejarían ellas. El bucle escalar
+  * sigue detrás y hace el resto, así que cualquier nivel puede
+  * tomar VLOOP como un no-op. La VM lo ejecuta por tandas de
+  * VLOOP_CHUNK vueltas con los núcleos AVX2 o SSE4.2 (vloop_run) y el
+  * backend nativo por parejas con SSE2 (emit_native_vloop). Lo que
+  * escribe una tanda se guarda aparte y va a memoria al final: si
+  * una operación comprobada se desborda o un índice se sale, la
+  * tanda se abandona entera y el bucle escalar la repite y da el
+  * error en la vuelta que toca.
+  *
+  * Es la última pasada porque VLOOP guarda la longitud del cuerpo:
+  * después ya no se mueve nada.
+  *-------------------------------------------------------------*/
+ 
+ #define VLOOP_MAX_BODY  32     // instrucciones del cuerpo
+ #define VLOOP_MAX_SLOTS 48     // registros que lee o escribe
+ 
+ #define VL_INV   0             // invariante: lo escribe algo de fuera
+ #define VL_CONST 1             // CONST o FCONST del cuerpo
+ #define VL_IND   2             // de inducción: w = w ± x
+ #define VL_TEMP  3             // temporal del cuerpo (o copia, reg -1)
+ 
+ typedef struct {
+     OpCode op;
+     int    a, b, c;            // casillas (el vector, como en el Instr)
+     int    fwd;                // LOAD: el último STORE anterior al mismo
+                                // vector en la vuelta, o -1
+ } VLoopOp;
+ 
+ typedef struct {
+     int       num_ops, num_slots;
+     VLoopOp   ops[VLOOP_MAX_BODY * 2];
+     int       reg[VLOOP_MAX_SLOTS];      // registro de cada casilla
+     char      kind[VLOOP_MAX_SLOTS];     // VL_*
+     char      lin[VLOOP_MAX_SLOTS];      // 1 si avanza lo mismo en cada vuelta:
+     long long stride[VLOOP_MAX_SLOTS];   // cuánto (el paso en una VL_IND)
+     long long val[VLOOP_MAX_SLOTS];      // VL_CONST: los bits de la constante
+     int       iv, n, d;                  // la condición, como en OP_TRIPS
+     int       num_deps;                  // registros de regs consultados
+     int       dep[VLOOP_MAX_BODY];       //   (el análisis vale mientras
+     long long dep_val[VLOOP_MAX_BODY];   //   conserven estos valores)
+ } VLoop;
+ 
+ /* Casilla del registro r (la crea si hace falta); -1 si no caben */
+ static int vloop_slot(VLoop *L, int r) {
+     for (int s = 0; s < L->num_slots; s++) {
+         if (L->reg[s] == r) {
+             return s;
+         }
+     }
+     if (L->num_slots == VLOOP_MAX_SLOTS) {
+         return -1;
+     }
+     int s = L->num_slots++;
+     L->reg[s]  = r;
+     L->kind[s] = VL_INV;
+     L->lin[s]  = 1;
+     L->stride[s] = 0;
+     return s;
+ }
+ 
+ /* Valor de un invariante: el de regs (y lo apunta en L) o, al
+    compilar (regs NULL), el de su CONST si lo tiene */
+ static int vloop_value(const IRProgram *p, const long long *regs, VLoop *L, int r,
+                        long long *v) {
+     if (regs != NULL) {
+         if (L->num_deps == VLOOP_MAX_BODY) {
+             return 0;
+         }
+         L->dep[L->num_deps]       = r;
+         L->dep_val[L->num_deps++] = regs[r];
+         *v = regs[r];
+         return 1;
+     }
+     return temp_const(p, r, v);
+ }
+ 
+ static int vloop_body_op(OpCode op) {
+     switch (op) {
+         case OP_CONST: case OP_FCONST: case OP_MOV:
+         case OP_ADD: case OP_SUB: case OP_MUL: case OP_NEG:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_NEGO:
+         case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+         case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV: case OP_FNEG:
+         case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+         case OP_ITOF: case OP_FTOI: case OP_TOCHR:
+         case OP_LOAD: case OP_LOADC: case OP_STORE: case OP_STOREC: case OP_CHKIDX:
+             return 1;
+         default:
+             return 0;
+     }
+ }
+ 
+ /**
+  * vloop_scan(p, head, end, regs, L):
+  *   Comprueba que el bucle con la cabecera en code[head] y el JMP de
+  *   vuelta en code[end] se puede ejecutar por carriles y lo describe
+  *   en L. Con regs (en la VM) los invariantes tienen ya su valor; al
+  *   compilar (regs NULL) solo se conocen las constantes, así que un
+  *   índice que avanza un invariante no se acepta.
+  */
+ static int vloop_scan(const IRProgram *p, int head, int end, const long long *regs, VLoop *L) {
+     static const OpCode swapped[] = { OP_EQ, OP_NE, OP_GT, OP_GE, OP_LT, OP_LE };
+     int body = head + 2;
+     L->num_deps = 0;
+     if (head < 0 || end <= body || end - body > VLOOP_MAX_BODY || end >= p->num_code) {
+         return 0;
+     }
+     const Instr *cond = &p->code[head];
+     const Instr *jz   = &p->code[head + 1];
+     if (cond->op < OP_EQ || cond->op > OP_GE || jz->op != OP_JZ || jz->a != cond->a ||
+         jz->b != end + 1 || p->code[end].op != OP_JMP || p->code[end].a != head) {
+         return 0;
+     }
+ 
+     // Quién se escribe en el cuerpo, cuántas veces y dónde
+     int ndefs[VLOOP_MAX_SLOTS] = { 0 };
+     int def_at[VLOOP_MAX_SLOTS];
+     L->num_slots = 0;
+     L->num_ops   = 0;
+     for (int i = body; i < end; i++) {
+         const Instr *in = &p->code[i];
+         int uses[2];
+         int nu = ir_uses(in, uses);
+         int d  = ir_def(in);
+         if (!vloop_body_op(in->op)) {
+             return 0;
+         }
+         for (int k = 0; k < nu; k++) {
+             if (uses[k] == cond->a || vloop_slot(L, uses[k]) < 0) {
+                 return 0;
+             }
+         }
+         if (d >= 0) {
+             int s = vloop_slot(L, d);
+             if (s < 0 || d == cond->a) {
+                 return 0;
+             }
+             ndefs[s]++;
+             def_at[s] = i;
+         }
+     }
+ 
+     // Inducción, constante o temporal; una variable que no es de
+     // inducción puede seguir viva detrás del bucle
+     int nv = ir_num_vars(p);
+     int num_regs = L->num_slots;
+     for (int s = 0; s < num_regs; s++) {
+         if (ndefs[s] == 0) {
+             continue;
+         }
+         const Instr *in = &p->code[def_at[s]];
+         OpCode op = ir_unchecked(in->op);
+         int    r  = L->reg[s];
+         long long step;
+         if (ndefs[s] > 1) {
+             return 0;
+         }
+         if ((op == OP_ADD && (in->b == r) != (in->c == r)) ||
+             (op == OP_SUB && in->b == r && in->c != r)) {
+             int x = (in->b == r) ? in->c : in->b;
+             if (ndefs[vloop_slot(L, x)] != 0) {
+                 return 0;
+             }
+             L->kind[s]    = VL_IND;
+             L->lin[s]     = vloop_value(p, regs, L, x, &step);
+             L->stride[s]  = (op == OP_SUB) ? (long long)-(unsigned long long)step : step;
+         } else if (r < nv) {
+             return 0;
+         } else if (in->op == OP_CONST || in->op == OP_FCONST) {
+             L->kind[s] = VL_CONST;
+             L->val[s]  = p->consts[in->b];
+             if (in->op == OP_FCONST) {
+                 memcpy(&L->val[s], &p->fconsts[in->b], sizeof(double));
+             }
+         } else {
+             L->kind[s] = VL_TEMP;
+         }
+     }
+ 
+     // La condición: "v REL n" con v de inducción y n invariante
+     int xs = vloop_slot(L, cond->b), ys = vloop_slot(L, cond->c), vs = -1, ns = -1;
+     int rel = cond->op;
+     if (xs < 0 || ys < 0) {
+         return 0;
+     }
+     if (L->kind[xs] == VL_IND && L->kind[ys] == VL_INV) {
+         vs = xs, ns = ys;
+     } else if (L->kind[ys] == VL_IND && L->kind[xs] == VL_INV) {
+         vs = ys, ns = xs, rel = swapped[cond->op - OP_EQ];
+     }
+     if (vs < 0 || !L->lin[vs] || L->stride[vs] == 0 ||
+         L->stride[vs] <= -(1 << 27) || L->stride[vs] >= (1 << 27)) {
+         return 0;
+     }
+     L->iv = L->reg[vs];
+     L->n  = L->reg[ns];
+     L->d  = (int)L->stride[vs] * 8 + (rel - OP_EQ);
+ 
+     // Las operaciones, con lo que avanza cada temporal por vuelta
+     for (int i = body; i < end; i++) {
+         const Instr *in = &p->code[i];
+         int f[3] = { in->a, in->b, in->c };
+         int uses[2];
+         int nu = ir_uses(in, uses);
+         int d  = ir_def(in);
+         for (int k = 0; k < nu; k++) {
+             int s = vloop_slot(L, uses[k]);
+             if (L->kind[s] == VL_TEMP && def_at[s] >= i) {
+                 return 0;                           // viene de la vuelta anterior
+             }
+         }
+         if (in->op == OP_CONST || in->op == OP_FCONST) {
+             continue;
+         }
+         if (d >= 0) {                               // a, b y c pasan a casillas
+             f[0] = vloop_slot(L, d);
+         }
+         if (ir_reads_a(in->op)) {
+             f[0] = vloop_slot(L, uses[0]);
+         } else {
+             for (int k = 0; k < nu; k++) {
+                 f[k + 1] = vloop_slot(L, uses[k]);
+             }
+         }
+         if (nu == 1 && in->op != OP_LOAD && in->op != OP_LOADC) {
+             f[2] = 0;                               // sin c: que no apunte fuera
+         }
+         if (in->op == OP_CHKIDX) {
+             f[2] = in->d;                           // en c, la dimensión
+         }
+ 
+         // Lo que se guarda tiene que seguir igual hasta el final de
+         // la vuelta: si cambia después (i = i + 1), se guarda una copia
+         int st = (in->op == OP_STORE || in->op == OP_STOREC);
+         if (st && L->kind[f[2]] == VL_IND && def_at[f[2]] > i) {
+             int t = vloop_slot(L, -1 - i);
+             if (t < 0) {
+                 return 0;
+             }
+             VLoopOp copy = { OP_MOV, t, f[2], 0, -1 };
+             L->kind[t] = VL_TEMP;
+             L->ops[L->num_ops++] = copy;
+             f[2] = t;
+         }
+         VLoopOp o = { in->op, f[0], f[1], f[2], -1 };
+         L->ops[L->num_ops++] = o;
+ 
+         long long v;
+         int a = f[0], b = f[1], c = f[2];
+         switch (in->op) {
+             case OP_MOV:
+                 L->lin[a]    = L->lin[b];
+                 L->stride[a] = L->stride[b];
+                 break;
+             case OP_ADD: case OP_ADDO: case OP_SUB: case OP_SUBO:
+                 if (L->kind[a] != VL_IND) {
+                     L->lin[a]    = L->lin[b] && L->lin[c];
+                     L->stride[a] = (ir_unchecked(in->op) == OP_SUB)
+                                  ? L->stride[b] - L->stride[c] : L->stride[b] + L->stride[c];
+                 }
+                 break;
+             case OP_NEG: case OP_NEGO:
+                 L->lin[a]    = L->lin[b];
+                 L->stride[a] = -L->stride[b];
+                 break;
+             case OP_MUL: case OP_MULO:
+                 if (L->kind[b] == VL_INV && vloop_value(p, regs, L, in->b, &v)) {
+                     L->lin[a]    = L->lin[c];
+                     L->stride[a] = L->stride[c] * v;
+                 } else if (L->kind[c] == VL_INV && vloop_value(p, regs, L, in->c, &v)) {
+                     L->lin[a]    = L->lin[b];
+                     L->stride[a] = L->stride[b] * v;
+                 } else {
+                     L->lin[a] = 0;
+                 }
+                 break;
+             case OP_LOAD: case OP_LOADC: case OP_STORE: case OP_STOREC: case OP_CHKIDX: {
+                 // Un índice que no cambia (la fila de m[i][j] en el
+                 // bucle de j) solo se comprueba
+                 int x    = (in->op == OP_CHKIDX) ? a : b;
+                 int step = (L->stride[x] == 1 || (in->op == OP_CHKIDX && L->stride[x] == 0));
+                 if (!L->lin[x] || !step) {
+                     return 0;                       // elementos sueltos
+                 }
+                 if (in->op == OP_LOAD || in->op == OP_LOADC) {
+                     L->lin[a] = 0;
+                 }
+                 break;
+             }
+             default:
+                 L->lin[a] = 0;
+                 break;
+         }
+     }
+ 
+     // Un vector en el que se escribe se toca siempre con el mismo
+     // índice, que no cambia entre el primer acceso y el último; un
+     // LOAD detrás de un STORE lee lo que dejó el último
+     int stores = 0;
+     for (int k = 0; k < L->num_ops; k++) {
+         const VLoopOp *o = &L->ops[k];
+         if (o->op != OP_STORE && o->op != OP_STOREC) {
+             continue;
+         }
+         int lo = k, hi = k;
+         stores++;
+         for (int j = 0; j < L->num_ops; j++) {
+             VLoopOp *q = &L->ops[j];
+             int load = (q->op == OP_LOAD || q->op == OP_LOADC);
+             if ((load && q->c == o->a) || ((q->op == OP_STORE || q->op == OP_STOREC) && q->a == o->a)) {
+                 if (q->b != o->b) {
+                     return 0;
+                 }
+                 lo = (j < lo) ? j : lo;
+                 hi = (j > hi) ? j : hi;
+                 if (load && j > k) {
+                     q->fwd = k;
+                 }
+             }
+         }
+         for (int j = lo + 1; j <= hi; j++) {
+             const VLoopOp *q = &L->ops[j];
+             if (q->a == o->b && q->op != OP_STORE && q->op != OP_STOREC && q->op != OP_CHKIDX) {
+                 return 0;                           // i = i + 1 en medio
+             }
+         }
+     }
+     return stores > 0;
+ }
+ 
+ /**
+  * vectorize_loop(p, g, h, b):
+  *   Pone un OP_VLOOP delante del bucle b -> h si se puede ejecutar
+  *   por carriles. Devuelve 1 si cambió p.
+  */
+ static int vectorize_loop(IRProgram *p, const CFG *g, int h, int b) {
+     const BasicBlock *H = &g->blocks[h];
+     const BasicBlock *B = &g->blocks[b];
+     VLoop L;
+     if (b != h + 1 || H->end - H->start != 2 || B->num_preds != 1 ||
+         (H->start > 0 && p->code[H->start - 1].op == OP_VLOOP) ||
+         !vloop_scan(p, H->start, B->end - 1, NULL, &L)) {
+         return 0;
+     }
+ 
+     // VLOOP no deja los temporales del cuerpo: nadie los lee fuera
+     for (int i = 0; i < p->num_code; i++) {
+         int uses[2];
+         int nu = ir_uses(&p->code[i], uses);
+         if (i >= H->start && i < B->end) {
+             continue;
+         }
+         for (int k = 0; k < nu; k++) {
+             for (int s = 0; s < L.num_slots; s++) {
+                 if (L.reg[s] == uses[k] && L.kind[s] != VL_INV && L.kind[s] != VL_IND) {
+                     return 0;
+                 }
+             }
+         }
+     }
+ 
+     int   n      = p->num_code;
+     char *inside = calloc(n, 1);
+     memset(inside + H->start, 1, B->end - H->start);
+     Instr vl = { OP_VLOOP, B->end - H->start, L.iv, L.n, p->code[H->start + 1].line, L.d };
+     free(loop_insert_preheader(p, H->start, inside, NULL, &vl, 1));
+     free(inside);
+     return 1;
+ }
+ 
+ static int opt_vectorize(IRProgram *p) {
+     int total   = 0;
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         CFG *g = cfg_build(p);
+         for (int b = 0; b < g->num_blocks && !changed; b++) {
+             for (int k = 0; k < g->blocks[b].num_succ && !changed; k++) {
+                 int h = g->blocks[b].succ[k];
+                 if (h <= b) {
+                     changed = vectorize_loop(p, g, h, b);
+                 }
+             }
+         }
+         cfg_free(g);
+         total += changed;
+     }
+     return total;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Almacenamientos muertos y rebanado por la salida.
+  *
+  * Solo se observa lo que imprime o lee el programa, por dónde
+  * salta y si termina con error. Son críticas PRINT, READ, los
+  * saltos, HALT, CHKDEF, CHKDIV y CHKIDX (si fallaran, el programa
+  * acabaría con error) y lo que escribe en un vector (STORE, ZERO:
+  * lo que hay en los vectores no se sigue). El resto solo importa si
+  * su resultado acaba en una crítica.
+  *
+  * Vida "fuerte" hacia atrás sobre los bloques: una instrucción no
+  * crítica hace vivos sus operandos solo si su resultado está vivo,
+  * así que también caen los ciclos que solo se alimentan a sí
+  * mismos (un contador que nunca se imprime ni decide nada). En una
+  * región las variables están vivas a la salida (el intérprete
+  * sigue con ellas), salvo las que el programa entero no observa
+  * nunca (var_unobserved[]).
+  *
+  * Una instrucción no crítica cuyo resultado no está vivo se borra.
+  * Para el intérprete, la escritura de una asignación lleva en d el
+  * token de la sentencia (+1): si en el programa entero sin
+  * optimizar todas sus copias sobran, la variable ya tenía valor
+  * (DA_DEF) y evaluar la expresión no puede fallar, el intérprete
+  * se salta la sentencia (stmt_dead[]).
+  *-------------------------------------------------------------*/
+ 
+ /* Lo que quitó la pasada en el programa entero (para --dead-code) */
+ typedef struct {
+     int before;            // instrucciones antes de la pasada
+     int removed;           // instrucciones eliminadas
+     int stores;            // de ellas, escrituras en variables
+     int stmts;             // asignaciones que se salta el intérprete
+ } DeadReport;
+ 
+ static DeadReport dead_report;
+ 
+ /* var_unobserved[v]: ninguna instrucción del programa entero que
+  * sobreviva lee v, así que las regiones no tienen que devolverla */
+ static char var_unobserved[MAX_VARS];
+ 
+ /**
+  * dse_critical(p, in):
+  *   1 si la instrucción tiene efectos visibles por sí misma.
+  */
+ static int dse_critical(const Instr *in) {
+     switch (in->op) {
+         case OP_PRINT: case OP_READ: case OP_JMP: case OP_JZ:
+         case OP_CHKDEF: case OP_CHKDIV: case OP_HALT:
+         case OP_PRINTF: case OP_READF: case OP_PRINTC: case OP_READC:
+         case OP_ADDO: case OP_SUBO: case OP_MULO: case OP_DIVO: case OP_NEGO:
+         case OP_STORE: case OP_STOREC: case OP_CHKIDX: case OP_ZERO:
+         case OP_ASUM: case OP_ADOT: case OP_FILL: case OP_SORT:
+         case OP_MATMUL: case OP_TRANSP: case OP_VLOOP:
+         case OP_DNEW: case OP_DSET: case OP_DDEL: case OP_DKEYS:
+             return 1;
+         default:
+             return 0;
+     }
+ }
+ 
+ /**
+  * dse_step(p, in, critical, live):
+  *   Vida fuerte hacia atrás a través de in. Devuelve 1 si in se
+  *   queda (crítica o con el resultado vivo).
+  */
+ static int dse_step(const IRProgram *p, const Instr *in, int critical, char *live) {
+     int d = ir_def(in);
+     if (!critical && (d < 0 || !live[d])) {
+         return 0;
+     }
+     if (in->op == OP_HALT && !p->whole_program) {
+         for (int v = 0; v < ir_num_vars(p); v++) {
+             live[v] = !var_unobserved[v];
+         }
+     }
+     if (d >= 0) {
+         live[d] = 0;
+     }
+     int uses[2];
+     int nu = ir_uses(in, uses);
+     for (int k = 0; k < nu; k++) {
+         live[uses[k]] = 1;
+     }
+     return 1;
+ }
+ 
+ /**
+  * stmt_pure(t):
+  *   1 si la asignación del token t no puede fallar al evaluarse:
+  *   toda variable leída tiene valor seguro, toda división es entre
+  *   un número distinto de cero o tiene el divisor acotado lejos del
+  *   cero (div_is_safe[]) y, sin --wrap, no hay sumas, restas ni
+  *   productos (se podrían desbordar).
+  */
+ static int stmt_pure(int t) {
+     if (stmt_end[t] <= t) {
+         return 0;
+     }
+     for (int k = t + 2; k < stmt_end[t]; k++) {
+         if (tokens[k].type == TOK_IDENT && !read_is_safe[k]) {
+             return 0;
+         }
+         if (tokens[k].type == TOK_DIV && !div_is_safe[k] &&
+             (tokens[k + 1].type != TOK_NUM || strtoll(tokens[k + 1].lexeme, NULL, 10) == 0)) {
+             return 0;
+         }
+         if (!int_wrap && (tokens[k].type == TOK_PLUS || tokens[k].type == TOK_MINUS ||
+                           tokens[k].type == TOK_MULT)) {
+             return 0;
+         }
+     }
+     return 1;
+ }
+ 
+ /**
+  * dse_sweep(p, g, keep):
+  *   Vida fuerte hasta el punto fijo; deja en keep[i] si la
+  *   instrucción i se queda y devuelve cuántas sobran.
+  */
+ static int dse_sweep(const IRProgram *p, const CFG *g, char *keep) {
+     int    nb   = g->num_blocks;
+     int    nr   = p->num_regs;
+     int    n    = p->num_code;
+     char  *crit = malloc(n + 1);
+     char  *in_l = calloc((size_t)nb * nr + 1, 1);
+     char  *live = malloc(nr + 1);
+     for (int i = 0; i < n; i++) {
+         crit[i] = (char)dse_critical(&p->code[i]);
+     }
+ 
+     // Punto fijo, recorriendo los bloques de atrás hacia delante; la
+     // última vuelta (sin cambios) deja keep[] hecho
+     int changed = 1;
+     int removed = 0;
+     while (changed) {
+         changed = 0;
+         removed = 0;
+         for (int b = nb - 1; b >= 0; b--) {
+             const BasicBlock *bb = &g->blocks[b];
+             memset(live, 0, nr);
+             for (int k = 0; k < bb->num_succ; k++) {
+                 const char *s = &in_l[(size_t)bb->succ[k] * nr];
+                 for (int r = 0; r < nr; r++) {
+                     live[r] |= s[r];
+                 }
+             }
+             for (int i = bb->end - 1; i >= bb->start; i--) {
+                 keep[i] = (char)dse_step(p, &p->code[i], crit[i], live);
+                 removed += !keep[i];
+             }
+             if (memcmp(live, &in_l[(size_t)b * nr], nr) != 0) {
+                 memcpy(&in_l[(size_t)b * nr], live, nr);
+                 changed = 1;
+             }
+         }
+     }
+ 
+     free(live);
+     free(in_l);
+     free(crit);
+     return removed;
+ }
+ 
+ /**
+  * opt_dead_stores(p):
+  *   Borra las instrucciones cuyo resultado nunca se observa (ver
+  *   arriba). Devuelve cuántas borró.
+  */
+ static int opt_dead_stores(IRProgram *p) {
+     CFG  *g       = cfg_build(p);
+     char *keep    = malloc(p->num_code + 1);
+     int   removed = dse_sweep(p, g, keep);
+     if (p->whole_program) {
+         int nv = ir_num_vars(p);
+         dead_report.before  = p->num_code;
+         dead_report.removed = removed;
+         dead_report.stores  = 0;
+         for (int i = 0; i < p->num_code; i++) {
+             int d = ir_def(&p->code[i]);
+             dead_report.stores += (!keep[i] && d >= 0 && d < nv);
+         }
+     }
+     if (removed > 0) {
+         ir_compact(p, keep);
+     }
+     free(keep);
+     cfg_free(g);
+     return removed;
+ }
+ 
+ /**
+  * mark_dead_stmts(p):
+  *   Rellena stmt_dead[] y var_unobserved[] a partir del programa
+  *   entero SIN optimizar: el intérprete evalúa las expresiones tal
+  *   cual, así que una lectura que el plegado de constantes hizo
+  *   desaparecer sigue contando para él.
+  */
+ static void mark_dead_stmts(IRProgram *p) {
+     CFG  *g    = cfg_build(p);
+     int   nb   = g->num_blocks;
+     int   nv   = ir_num_vars(p);
+     char *keep = malloc(p->num_code + 1);
+     dse_sweep(p, g, keep);
+ 
+     // Por token: 1 = todas sus escrituras sobran y la variable ya
+     // tenía valor, 2 = alguna no
+     char *reached = calloc(nb + 1, 1);
+     unsigned char *in_st = da_analysis(p, g, reached);
+     unsigned char *cur   = malloc(nv + 1);
+     unsigned char *state = calloc(num_tokens + 1, 1);
+     for (int b = 0; b < nb; b++) {
+         memcpy(cur, &in_st[(size_t)b * nv], nv);
+         for (int i = g->blocks[b].start; i < g->blocks[b].end; i++) {
+             const Instr *in = &p->code[i];
+             int d = ir_def(in);
+             if (d >= 0 && d < nv && in->op != OP_TRIPS && in->d > 0) {
+                 int dead = reached[b] && !keep[i] && cur[d] == DA_DEF;
+                 if (state[in->d - 1] != 2) {
+                     state[in->d - 1] = dead ? 1 : 2;
+                 }
+             }
+             da_step(in, cur, nv);
+         }
+     }
+     dead_report.stmts = 0;
+     for (int t = 0; t < num_tokens; t++) {
+         stmt_dead[t] = (state[t] == 1 && stmt_pure(t));
+         dead_report.stmts += stmt_dead[t];
+     }
+ 
+     memset(var_unobserved, 1, nv);
+     for (int i = 0; i < p->num_code; i++) {
+         int uses[2];
+         int nu = keep[i] ? ir_uses(&p->code[i], uses) : 0;
+         for (int k = 0; k < nu; k++) {
+             if (uses[k] < nv) {
+                 var_unobserved[uses[k]] = 0;
+             }
+         }
+     }
+ 
+     free(state);
+     free(cur);
+     free(in_st);
+     free(reached);
+     free(keep);
+     cfg_free(g);
+ }
+ 
+ /*--------------------------------------------------------------
+  * Mirilla.
+  *
+  * Última pasada: mira las instrucciones de una en una (o de dos en
+  * dos) y arregla lo que las demás dejan a medias:
+  *   - identidades: x * 1, 1 * x, x + 0, 0 + x, x - 0 y x / 1 pasan a
+  *     MOV; MOV x, x desaparece;
+  *   - pares escritura/lectura: "op t, ...; MOV x, t" con t un
+  *     temporal que solo lee ese MOV pasa a "op x, ...", y
+  *     "MOV x, y; MOV y, x" pierde el segundo; quien lee el temporal
+  *     t de un "MOV t, y" lee y directamente si y no cambia nunca (un
+  *     solo sitio lo escribe);
+  *   - saltos encadenados (los Si/Sino anidados acaban en un JMP a
+  *     otro JMP): cada salto va directo al destino final, y un salto
+  *     a la instrucción siguiente sobra;
+  *   - los temporales sin efectos que así quedan sin leer.
+  * La comparación seguida del JZ que la lee (y solo ella) no se toca
+  * aquí: los backends la funden en un solo cmp + jcc (ver
+  * cmp_jz_fusable).
+  *
+  * En peep_saved[] queda, para cada instrucción, cuántas de las
+  * quitadas estaban en su mismo bloque: con --stats la VM suma cuántas
+  * instrucciones se ahorró al ejecutar.
+  *-------------------------------------------------------------*/
+ 
+ /* Lo que hizo la pasada en el programa entero (para --stats) */
+ typedef struct {
+     int before, after;     // instrucciones antes y después
+     int identities;        // x * 1, x + 0... y MOV x, x
+     int copies;            // pares escritura/lectura
+     int jumps;             // saltos redirigidos o quitados
+     int fusable;           // comparación + JZ que fundirán los backends
+ } PeepReport;
+ 
+ static PeepReport peep_report;
+ 
+ /**
+  * ir_use_counts(p):
+  *   Cuántas instrucciones leen cada registro (vector nuevo).
+  */
+ static int *ir_use_counts(const IRProgram *p) {
+     int *nuse = calloc(p->num_regs + 1, sizeof(int));
+     for (int i = 0; i < p->num_code; i++) {
+         int uses[2];
+         int n = ir_uses(&p->code[i], uses);
+         for (int k = 0; k < n; k++) {
+             nuse[uses[k]]++;
+         }
+     }
+     return nuse;
+ }
+ 
+ /**
+  * ir_jump_targets(p):
+  *   Vector nuevo con un 1 en cada instrucción a la que se salta.
+  */
+ static char *ir_jump_targets(const IRProgram *p) {
+     char *is_target = calloc(p->num_code + 1, 1);
+     for (int i = 0; i < p->num_code; i++) {
+         if (ir_is_jump(p->code[i].op)) {
+             is_target[ir_jump_target(&p->code[i])] = 1;
+         }
+     }
+     return is_target;
+ }
+ 
+ /**
+  * cmp_jz_fusable(p, i, nuse, is_target):
+  *   1 si code[i] es un JZ al que solo se llega desde la comparación
+  *   de justo antes y cuya condición es un temporal que calcula ella
+  *   y nadie más lee: el backend puede saltar con el resultado del
+  *   cmp sin guardarlo.
+  */
+ static int cmp_jz_fusable(const IRProgram *p, int i, const int *nuse, const char *is_target) {
+     if (i == 0 || p->code[i].op != OP_JZ || is_target[i]) {
+         return 0;
+     }
+     const Instr *cmp = &p->code[i - 1];
+     int c = p->code[i].a;
+     return cmp->op >= OP_EQ && cmp->op <= OP_GE && cmp->a == c &&
+            c >= ir_num_vars(p) && nuse[c] == 1;
+ }
+ 
+ /**
+  * peep_identity(in, is_const, cval):
+  *   Si in es una identidad aritmética, la deja como MOV y devuelve 1
+  *   (ninguna se puede desbordar: da igual que esté comprobada).
+  */
+ static int peep_identity(Instr *in, const char *is_const, const long long *cval) {
+     int    b  = in->b, c = in->c, keep_b;
+     OpCode op = ir_unchecked(in->op);
+     switch (op) {
+         case OP_ADD:
+             if (is_const[c] && cval[c] == 0) {
+                 keep_b = 1;
+             } else if (is_const[b] && cval[b] == 0) {
+                 keep_b = 0;
+             } else {
+                 return 0;
+             }
+             break;
+         case OP_MUL:
+             if (is_const[c] && cval[c] == 1) {
+                 keep_b = 1;
+             } else if (is_const[b] && cval[b] == 1) {
+                 keep_b = 0;
+             } else {
+                 return 0;
+             }
+             break;
+         case OP_SUB: case OP_DIV: case OP_DIV32:
+             if (!is_const[c] || cval[c] != (op != OP_SUB)) {
+                 return 0;
+             }
+             keep_b = 1;
+             break;
+         default:
+             return 0;
+     }
+     in->op = OP_MOV;
+     in->b  = keep_b ? b : c;
+     in->c  = 0;
+     return 1;
+ }
+ 
+ /**
+  * opt_peephole(p):
+  *   Ver arriba. Devuelve cuántas instrucciones quitó.
+  */
+ static int opt_peephole(IRProgram *p) {
+     int   n      = p->num_code;
+     int   nv     = ir_num_vars(p);
+     int   nr     = p->num_regs;
+     CFG  *g      = cfg_build(p);
+     char *keep   = malloc(n + 1);
+     int  *ndefs  = calloc(nr + 1, sizeof(int));
+     int  *def_at = calloc(nr + 1, sizeof(int));
+     char *is_const = calloc(nr + 1, 1);
+     long long *cval = calloc(nr + 1, sizeof(long long));
+     PeepReport rep = { n, 0, 0, 0, 0, 0 };
+ 
+     memset(keep, 1, n);
+     for (int i = 0; i < n; i++) {
+         int d = ir_def(&p->code[i]);
+         if (d >= 0) {
+             ndefs[d]++;
+             def_at[d] = i;
+         }
+     }
+     for (int r = nv; r < nr; r++) {
+         if (ndefs[r] == 1 && p->code[def_at[r]].op == OP_CONST) {
+             is_const[r] = 1;
+             cval[r]     = p->consts[p->code[def_at[r]].b];
+         }
+     }
+ 
+     // Identidades y saltos encadenados
+     for (int i = 0; i < n; i++) {
+         Instr *in = &p->code[i];
+         rep.identities += peep_identity(in, is_const, cval);
+         if (ir_is_jump(in->op)) {
+             int t = ir_jump_target(in), hops = 0;
+             while (t < n && p->code[t].op == OP_JMP && hops++ < n) {
+                 t = p->code[t].a;
+             }
+             if (t != ir_jump_target(in)) {
+                 *(in->op == OP_JMP ? &in->a : &in->b) = t;
+                 rep.jumps++;
+             }
+         }
+     }
+ 
+     // Copias de un registro que nunca cambia
+     int *fwd = malloc((nr + 1) * sizeof(int));
+     for (int r = 0; r < nr; r++) {
+         fwd[r] = -1;
+     }
+     for (int i = 0; i < n; i++) {
+         const Instr *in = &p->code[i];
+         if (in->op != OP_MOV || in->a < nv || ndefs[in->a] != 1 || ndefs[in->b] > 1) {
+             continue;
+         }
+         int r = in->b;
+         while (r >= 0 && r != in->a) {
+             r = fwd[r];
+         }
+         if (r < 0) {
+             fwd[in->a] = in->b;
+         }
+     }
+     for (int i = 0; i < n; i++) {
+         int uses[2];
+         int nu = ir_uses(&p->code[i], uses);
+         for (int k = 0; k < nu; k++) {
+             int r = uses[k];
+             while (fwd[r] >= 0) {
+                 r = fwd[r];
+             }
+             if (r != uses[k]) {
+                 ir_replace_use(&p->code[i], uses[k], r);
+                 rep.copies++;
+             }
+         }
+     }
+     free(fwd);
+ 
+     // Pares escritura/lectura, MOV x, x y saltos a la siguiente
+     int *nuse = ir_use_counts(p);
+     for (int i = 0; i < n; i++) {
+         Instr *in = &p->code[i];
+         int d = ir_def(in);
+         if (in->op == OP_MOV && in->a == in->b) {
+             keep[i] = 0;
+             nuse[in->b]--;
+             rep.identities++;
+         } else if (ir_is_jump(in->op) && ir_jump_target(in) == i + 1) {
+             keep[i] = 0;
+             if (in->op == OP_JZ) {
+                 nuse[in->a]--;
+             }
+             rep.jumps++;
+         } else if (d >= nv && i + 1 < n && ndefs[d] == 1 && nuse[d] == 1 &&
+                    p->code[i + 1].op == OP_MOV && p->code[i + 1].b == d &&
+                    g->block_of[i] == g->block_of[i + 1]) {
+             Instr *mov = &p->code[i + 1];
+             in->a = mov->a;
+             if (in->op != OP_TRIPS) {
+                 in->d = mov->d;
+             }
+             keep[i + 1] = 0;
+             nuse[d] = 0;
+             rep.copies++;
+             i++;
+         } else if (in->op == OP_MOV && i + 1 < n && p->code[i + 1].op == OP_MOV &&
+                    p->code[i + 1].a == in->b && p->code[i + 1].b == in->a &&
+                    g->block_of[i] == g->block_of[i + 1]) {
+             keep[i + 1] = 0;
+             nuse[in->a]--;
+             rep.copies++;
+             i++;
+         }
+     }
+ 
+     // Temporales sin efectos que ya nadie lee
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         for (int i = n - 1; i >= 0; i--) {
+             Instr *in = &p->code[i];
+             int d = ir_def(in);
+             if (!keep[i] || d < nv || nuse[d] > 0 || ir_may_fail(in->op)) {
+                 continue;
+             }
+             int uses[2];
+             int nu = ir_uses(in, uses);
+             for (int k = 0; k < nu; k++) {
+                 nuse[uses[k]]--;
+             }
+             keep[i] = 0;
+             changed = 1;
+         }
+     }
+ 
+     // Cada quitada se apunta a la siguiente que se queda en su bloque
+     // (o, si no hay, a la anterior)
+     if (p->peep_saved == NULL) {
+         p->peep_saved = calloc(p->cap_code + 1, sizeof(int));
+     }
+     for (int b = 0; b < g->num_blocks; b++) {
+         const BasicBlock *bb = &g->blocks[b];
+         int pending = 0, last = -1;
+         for (int i = bb->start; i < bb->end; i++) {
+             if (!keep[i]) {
+                 pending++;
+             } else {
+                 p->peep_saved[i] += pending;
+                 pending = 0;
+                 last = i;
+             }
+         }
+         if (last >= 0) {
+             p->peep_saved[last] += pending;
+         }
+     }
+ 
+     int removed = 0;
+     for (int i = 0; i < n; i++) {
+         removed += !keep[i];
+     }
+     if (removed > 0) {
+         ir_compact(p, keep);
+     }
+     if (p->whole_program) {
+         char *is_target = ir_jump_targets(p);
+         free(nuse);
+         nuse = ir_use_counts(p);
+         for (int i = 0; i < p->num_code; i++) {
+             rep.fusable += cmp_jz_fusable(p, i, nuse, is_target);
+         }
+         free(is_target);
+         rep.after   = p->num_code;
+         peep_report = rep;
+     }
+     free(nuse);
+     free(keep);
+     free(ndefs);
+     free(def_at);
+     free(is_const);
+     free(cval);
+     cfg_free(g);
+     return removed;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Gestor de pasadas.
+  *
+  * Las pasadas se ejecutan en el orden de la tabla. Cada una dice si
+  * trabaja sobre la forma SSA (PASS_SSA): el gestor construye la SSA
+  * al llegar a la primera que la pide y la deshace antes de la
+  * primera que no, de modo que varias pasadas SSA seguidas la
+  * comparten. Cada pasada devuelve cuántos cambios hizo; los del
+  * programa entero se guardan para --stats. Antes de ejecutar, el
+  * programa entero solo pasa por las que dan errores o avisos
+  * (PASS_CHECK); las demás solo hacen falta al promover un bucle, con
+  * -o y para la caché.
+  *
+  * Qué pasadas corren lo decide la línea de órdenes: -O<n> activa
+  * las de nivel <= n y --passes=a,b,... exactamente esas (por su
+  * nombre corto, pero siempre en el orden de la tabla):
+  *   -O0  ninguna: el IR se ejecuta tal cual sale del generador;
+  *   -O1  las baratas y locales (constantes, ramas, CHKDEF, temporales);
+  *   -O2  además rangos, GVN, LICM y almacenamientos muertos;
+  *   -O3  además variables de inducción y vectorización (por defecto).
+  * Con menos pasadas también se demuestra menos: con -O0 los errores
+  * de "división por cero" o "variable no inicializada" que se verían
+  * al compilar salen al ejecutar, y el intérprete no se salta nada.
+  * Solo son de compilación los de una instrucción que se ejecuta
+  * seguro; los de una rama que quizá no se toma son avisos, así que
+  * -O<n> nunca cambia si un programa termina bien.
+  *-------------------------------------------------------------*/
+ 
+ #define PASS_SSA   1   // necesita el IR en forma SSA
+ #define PASS_HOIST 2   // saca código a los preheaders: si cambia algo,
+                        // GVN y temporales muertos vuelven a correr
+ #define PASS_CHECK 4   // da errores o avisos: corre en check_program()
+ 
+ typedef struct {
+     const char *id;            // nombre en --passes
+     const char *name;          // nombre en --stats
+     int       (*run)(IRProgram *p);
+     int         flags;         // PASS_*
+     int         level;         // primer -O que la activa
+     const char *what;          // qué cuenta lo que devuelve run
+ } Pass;
+ 
+ static const Pass passes[] = {
+     { "const",  "constantes",                   opt_constants,           PASS_SSA | PASS_CHECK, 1,
+       "instrucción(es) plegada(s)" },
+     { "ranges", "rangos",                       opt_ranges,              0,        2,
+       "comprobación(es) de división, índice o desbordamiento eliminada(s)" },
+     { "branch", "ramas muertas",                opt_dead_branches,       PASS_SSA | PASS_CHECK, 1,
+       "instrucción(es) eliminada(s)" },
+     { "defined","asignación definitiva",        opt_definite_assignment, PASS_CHECK, 1,
+       "comprobación(es) eliminada(s)" },
+     { "gvn",    "subexpresiones comunes (GVN)", opt_gvn,                 PASS_SSA, 2,
+       "evaluación(es) reutilizada(s)" },
+     { "licm",   "código invariante (LICM)",     opt_licm,                PASS_HOIST, 2,
+       "instrucción(es) sacada(s) de bucles" },
+     { "iv",     "variables de inducción",       opt_induction,           PASS_HOIST, 3,
+       "bucle(s) transformado(s)" },
+     { "dse",    "almacenamientos muertos",      opt_dead_stores,         0,        2,
+       "instrucción(es) eliminada(s)" },
+     { "dce",    "temporales muertos",           opt_dead_temps,          0,        1,
+       "instrucción(es) eliminada(s)" },
+     { "peep",   "mirilla",                      opt_peephole,            0,        1,
+       "instrucción(es) eliminada(s)" },
+     { "vec",    "vectorización",                opt_vectorize,           0,        3,
+       "bucle(s) vectorizado(s)" },
+ };
+ 
+ #define NUM_PASSES ((int)(sizeof(passes) / sizeof(passes[0])))
+ #define MAX_OPT_LEVEL 3
+ 
+ static int  pass_changes[NUM_PASSES];  // programa entero, por pasada
+ static char pass_enabled[NUM_PASSES];  // lo que pidió -O / --passes
+ 
+ /* Lo que midió --time-passes, sumando todas las compilaciones (el
+  * programa entero y cada región); la fila NUM_PASSES es la SSA */
+ typedef struct {
+     int    runs;
+     double us;
+     long   before, after;      // instrucciones IR antes y después
+ } PassTime;
+ 
+ static int      time_passes = 0;            // --time-passes
+ static PassTime pass_time[NUM_PASSES + 1];
+ 
+ /**
+  * now_us():
+  *   Reloj monótono en microsegundos.
+  */
+ static double now_us(void) {
+ #if defined(_WIN32)
+     return (double)clock() * 1e6 / CLOCKS_PER_SEC;
+ #else
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+ #endif
+ }
+ 
+ /**
+  * select_passes(level, list):
+  *   Rellena pass_enabled[]: con list (lo de --passes=, separado por
+  *   comas) exactamente esas; si no, las de nivel <= level.
+  */
+ static void select_passes(int level, const char *list) {
+     for (int k = 0; k < NUM_PASSES; k++) {
+         pass_enabled[k] = (char)(list == NULL && passes[k].level <= level);
+     }
+     while (list != NULL && *list != '\0') {
+         size_t n = strcspn(list, ",");
+         int k = 0;
+         while (k < NUM_PASSES &&
+                (strlen(passes[k].id) != n || strncmp(passes[k].id, list, n) != 0)) {
+             k++;
+         }
+         if (k == NUM_PASSES) {
+             fprintf(stderr, "Error: pasada desconocida '%.*s' (hay:", (int)n, list);
+             for (k = 0; k < NUM_PASSES; k++) {
+                 fprintf(stderr, " %s", passes[k].id);
+             }
+             fprintf(stderr, ").\n");
+             exit(1);
+         }
+         pass_enabled[k] = 1;
+         list += n + (list[n] == ',');
+     }
+ }
+ 
+ /**
+  * pass_is_enabled(run):
+  *   1 si la pasada que hace run está activada.
+  */
+ static int pass_is_enabled(int (*run)(IRProgram *p)) {
+     for (int k = 0; k < NUM_PASSES; k++) {
+         if (passes[k].run == run) {
+             return pass_enabled[k];
+         }
+     }
+     return 0;
+ }
+ 
+ /**
+  * timed_ssa(p, build):
+  *   Construye (o deshace) la SSA de p, midiéndolo si --time-passes.
+  */
+ static void timed_ssa(IRProgram *p, int build) {
+     PassTime *pt = &pass_time[NUM_PASSES];
+     double t0 = time_passes ? now_us() : 0.0;
+     pt->before += p->num_code;
+     if (build) {
+         ssa_build(p);
+     } else {
+         ssa_destroy(p);
+     }
+     pt->after += p->num_code;
+     pt->us    += time_passes ? now_us() - t0 : 0.0;
+     pt->runs  += build;
+ }
+ 
+ /**
+  * run_pass(p, k):
+  *   Ejecuta la pasada k sobre p (entrando o saliendo de la SSA si
+  *   hace falta) y la cuenta en --time-passes y --stats.
+  */
+ static int run_pass(IRProgram *p, int k) {
+     if ((passes[k].flags & PASS_SSA) && p->ssa_var == NULL) {
+         timed_ssa(p, 1);
+     } else if (!(passes[k].flags & PASS_SSA) && p->ssa_var != NULL) {
+         timed_ssa(p, 0);
+     }
+     PassTime *pt = &pass_time[k];
+     int    before = p->num_code;
+     double t0     = time_passes ? now_us() : 0.0;
+     int changes = passes[k].run(p);
+     if (time_passes) {
+         pt->us += now_us() - t0;
+     }
+     pt->runs++;
+     pt->before += before;
+     pt->after  += p->num_code;
+     if (p->whole_program) {
+         pass_changes[k] += changes;
+     }
+     return changes;
+ }
+ 
+ /**
+  * optimize_ir(p):
+  *   Pasadas de optimización activadas sobre un IR ya finalizado. p
+  *   sale fuera de SSA. Lo que LICM y las variables de inducción dejan
+  *   en un preheader (p. ej. el mismo CONST una vez por expresión
+  *   sacada) lo limpian otra GVN y otra pasada de temporales muertos
+  *   justo después de la última de ellas.
+  */
+ static void optimize_ir(IRProgram *p) {
+     int hoisted = 0;
+     for (int k = 0; k <= NUM_PASSES; k++) {
+         if (hoisted > 0 && (k == NUM_PASSES || !(passes[k].flags & PASS_HOIST))) {
+             for (int j = 0; j < NUM_PASSES; j++) {
+                 if (pass_enabled[j] &&
+                     (passes[j].run == opt_gvn || passes[j].run == opt_dead_temps)) {
+                     run_pass(p, j);
+                 }
+             }
+             hoisted = 0;
+         }
+         if (k == NUM_PASSES || !pass_enabled[k]) {
+             continue;
+         }
+         int changes = run_pass(p, k);
+         if (passes[k].flags & PASS_HOIST) {
+             hoisted += changes;
+         }
+     }
+     if (p->ssa_var != NULL) {
+         timed_ssa(p, 0);
+     }
+ }
+ 
+ /**
+  * print_pass_times():
+  *   Informe de --time-passes: veces, tiempo y cambio de tamaño del
+  *   IR de cada pasada, en todas las compilaciones.
+  */
+ static void print_pass_times(void) {
+     double total = 0.0;
+     fflush(stdout);
+     fprintf(stderr, "=== Tiempo por pasada ===\n");
+     fprintf(stderr, "  %-30s %6s %10s  %s\n", "pasada", "veces", "ms", "instr. IR");
+     for (int k = 0; k <= NUM_PASSES; k++) {
+         const PassTime *pt = &pass_time[k];
+         if (pt->runs == 0) {
+             continue;
+         }
+         const char *name = k < NUM_PASSES ? passes[k].name : "SSA (construir y deshacer)";
+         int width = 30;
+         for (const char *c = name; *c != '\0'; c++) {
+             width += ((*c & 0xC0) == 0x80);        // el ancho %-30s cuenta bytes
+         }
+         fprintf(stderr, "  %-*s %6d %10.3f  %ld -> %ld\n", width, name,
+                 pt->runs, pt->us / 1000.0, pt->before, pt->after);
+         total += pt->us;
+     }
+     fprintf(stderr, "  %-30s %6s %10.3f\n", "total", "", total / 1000.0);
+ }
+ 
+ /**
+  * check_program(full):
+  *   Compila el programa entero (sin ejecutarlo) para que los errores
+  *   detectables en tiempo de compilación salgan antes de ejecutar
+  *   nada, y calcula lo que el intérprete puede saltarse. Solo corren
+  *   las pasadas PASS_CHECK, o todas con full (--stats, --dead-code y
+  *   --time-passes las cuentan). Devuelve el programa SIN optimizar;
+  *   la tabla de símbolos queda como estaba.
+  */
+ static IRProgram *check_program(int full) {
+     int saved_vars = num_vars;
+     cur_token = 0;
+     IRProgram *p = compile_program();
+     IRProgram *q = ir_copy(p);
+     if (full) {
+         optimize_ir(q);
+     } else {
+         for (int k = 0; k < NUM_PASSES; k++) {
+             if (pass_enabled[k] && (passes[k].flags & PASS_CHECK)) {
+                 run_pass(q, k);
+             }
+         }
+         if (q->ssa_var != NULL) {
+             timed_ssa(q, 0);
+         }
+     }
+     ir_free(q);
+ 
+     // Asignaciones que el intérprete puede saltarse. Antes se quitan
+     // las comprobaciones que ya se sabe que sobran, como si p se
+     // compilara ahora con read_is_safe[] y div_is_safe[] calculados
+     if (pass_is_enabled(opt_dead_stores)) {
+         char *keep = malloc(p->num_code + 1);
+         for (int i = 0; i < p->num_code; i++) {
+             const Instr *in = &p->code[i];
+             keep[i] = !((in->op == OP_CHKDEF && read_is_safe[in->c]) ||
+                         (in->op == OP_CHKDIV && div_is_safe[in->b]));
+         }
+         ir_compact(p, keep);
+         free(keep);
+         mark_dead_stmts(p);
+     }
+     num_vars = saved_vars;
+     ir = NULL;
+     warn_enabled = 0;
+     return p;
+ }
+ 
+ 
+ /*==============================================================
+  *              IR EN TEXTO (VOLCADO Y LECTURA)
+  *=============================================================*/
+ 
+ /*--------------------------------------------------------------
+  * --dump-ir y --dump-ssa imprimen el IR optimizado del programa
+  * entero; ir_parse() lee el mismo formato, de modo que volcar,
+  * leer y volver a volcar da el mismo texto (--ir-roundtrip lo
+  * comprueba). Ejemplo:
+  *
+  *   ; IR del programa: 18 instrucción(es), 16 registro(s)
+  *   .program
+  *   .vars i
+  *   .regs 16
+  *   .consts 0 10 1
+  *   .ssa
+  *   B0:
+  *        0  UNDEF   i.10                     ; línea 1
+  *        1  CONST   i.11, #0                 ; línea 1
+  *   ...
+  *   B2:  ; <- B0 B3
+  *       10  PHI     i.12, i.11, i.13         ; línea 2
+  *       11  LT      %3, i.12, %2             ; línea 2
+  *       12  JZ      %3, @15                  ; línea 2
+  *
+  * Registros: una variable por su nombre y un temporal como %N; sus
+  * versiones SSA llevan detrás ".N" (x.7, %3.9); "#v" es la constante v
+  * (entera o, en FCONST, real: esas van aparte en ".fconsts"), "@i" la
+  * instrucción i y un vector o un diccionario va por su nombre. Lo
+  * que sigue a ';' es comentario, salvo la línea de origen (y el
+  * token de la sentencia en la escritura de una asignación). Las
+  * variables, los vectores y los diccionarios tienen que ser los del
+  * programa cargado (los mensajes de error usan sus nombres).
+  *-------------------------------------------------------------*/
+ 
+ typedef struct {
+     const char *name;
+     const char *args;  // operandos a, b, c, d: r registro, k constante,
+                        // f constante real, j instrucción, n número,
+                        // v vector, m diccionario, * argumentos de PHI
+ } OpInfo;
+ 
+ static const OpInfo op_info[] = {
+     [OP_CONST]  = { "CONST",  "rk"   },
+     [OP_MOV]    = { "MOV",    "rr"   },
+     [OP_ADD]    = { "ADD",    "rrr"  },
+     [OP_SUB]    = { "SUB",    "rrr"  },
+     [OP_MUL]    = { "MUL",    "rrr"  },
+     [OP_DIV]    = { "DIV",    "rrr"  },
+     [OP_DIV32]  = { "DIV32",  "rrr"  },
+     [OP_NEG]    = { "NEG",    "rr"   },
+     [OP_EQ]     = { "EQ",     "rrr"  },
+     [OP_NE]     = { "NE",     "rrr"  },
+     [OP_LT]     = { "LT",     "rrr"  },
+     [OP_LE]     = { "LE",     "rrr"  },
+     [OP_GT]     = { "GT",     "rrr"  },
+     [OP_GE]     = { "GE",     "rrr"  },
+     [OP_JMP]    = { "JMP",    "j"    },
+     [OP_JZ]     = { "JZ",     "rj"   },
+     [OP_PRINT]  = { "PRINT",  "r"    },
+     [OP_READ]   = { "READ",   "r"    },
+     [OP_UNDEF]  = { "UNDEF",  "r"    },
+     [OP_CHKDEF] = { "CHKDEF", "rnn"  },
+     [OP_CHKDIV] = { "CHKDIV", "rn"   },
+     [OP_TRIPS]  = { "TRIPS",  "rrrn" },
+     [OP_POWSUM] = { "POWSUM", "rrn"  },
+     [OP_BOUND]  = { "BOUND",  "rrrn" },
+     [OP_FCONST] = { "FCONST", "rf"   },
+     [OP_FADD]   = { "FADD",   "rrr"  },
+     [OP_FSUB]   = { "FSUB",   "rrr"  },
+     [OP_FMUL]   = { "FMUL",   "rrr"  },
+     [OP_FDIV]   = { "FDIV",   "rrr"  },
+     [OP_FNEG]   = { "FNEG",   "rr"   },
+     [OP_FEQ]    = { "FEQ",    "rrr"  },
+     [OP_FNE]    = { "FNE",    "rrr"  },
+     [OP_FLT]    = { "FLT",    "rrr"  },
+     [OP_FLE]    = { "FLE",    "rrr"  },
+     [OP_FGT]    = { "FGT",    "rrr"  },
+     [OP_FGE]    = { "FGE",    "rrr"  },
+     [OP_ITOF]   = { "ITOF",   "rr"   },
+     [OP_FTOI]   = { "FTOI",   "rr"   },
+     [OP_PRINTF] = { "PRINTF", "r"    },
+     [OP_READF]  = { "READF",  "r"    },
+     [OP_TOCHR]  = { "TOCHR",  "rr"   },
+     [OP_PRINTC] = { "PRINTC", "r"    },
+     [OP_READC]  = { "READC",  "r"    },
+     [OP_ADDO]   = { "ADDO",   "rrr"  },
+     [OP_SUBO]   = { "SUBO",   "rrr"  },
+     [OP_MULO]   = { "MULO",   "rrr"  },
+     [OP_DIVO]   = { "DIVO",   "rrr"  },
+     [OP_NEGO]   = { "NEGO",   "rr"   },
+     [OP_LOAD]   = { "LOAD",   "rrv"  },
+     [OP_LOADC]  = { "LOADC",  "rrv"  },
+     [OP_STORE]  = { "STORE",  "vrr"  },
+     [OP_STOREC] = { "STOREC", "vrr"  },
+     [OP_CHKIDX] = { "CHKIDX", "rvnn" },
+     [OP_ZERO]   = { "ZERO",   "v"    },
+     [OP_ASUM]   = { "ASUM",   "rv"   },
+     [OP_ADOT]   = { "ADOT",   "rvv"  },
+     [OP_AMIN]   = { "AMIN",   "rv"   },
+     [OP_AMAX]   = { "AMAX",   "rv"   },
+     [OP_AFIND]  = { "AFIND",  "rrv"  },
+     [OP_FILL]   = { "FILL",   "vr"   },
+     [OP_SORT]   = { "SORT",   "v"    },
+     [OP_MATMUL] = { "MATMUL", "vvv"  },
+     [OP_TRANSP] = { "TRANSP", "vv"   },
+     [OP_DNEW]   = { "DNEW",   "m"    },
+     [OP_DGET]   = { "DGET",   "rrm"  },
+     [OP_DSET]   = { "DSET",   "mrr"  },
+     [OP_DHAS]   = { "DHAS",   "rrm"  },
+     [OP_DDEL]   = { "DDEL",   "mr"   },
+     [OP_DLEN]   = { "DLEN",   "rm"   },
+     [OP_DKEYS]  = { "DKEYS",  "vm"   },
+     [OP_VLOOP]  = { "VLOOP",  "nrrn" },
+     [OP_PHI]    = { "PHI",    "r*"   },
+     [OP_HALT]   = { "HALT",   ""     },
+ };
+ 
+ #define NUM_OPS ((int)(sizeof(op_info) / sizeof(op_info[0])))
+ 
+ /**
+  * ir_print_reg(p, r, out):
+  *   Escribe el registro r con la sintaxis del volcado y devuelve
+  *   cuántos caracteres ocupa.
+  */
+ static int ir_print_reg(const IRProgram *p, int r, FILE *out) {
+     if (r < ir_num_vars(p)) {
+         return fprintf(out, "%s", symtab[r].name);
+     }
+     if (p->ssa_var != NULL && p->ssa_var[r] >= 0) {
+         int v = p->ssa_var[r];
+         return v < ir_num_vars(p) ? fprintf(out, "%s.%d", symtab[v].name, r)
+                                   : fprintf(out, "%%%d.%d", v, r);
+     }
+     return fprintf(out, "%%%d", r);
+ }
+ 
+ /**
+  * ir_dump(p, out):
+  *   Vuelca p en texto, bloque a bloque.
+  */
+ static void ir_dump(const IRProgram *p, FILE *out) {
+     int  nv = ir_num_vars(p);
+     CFG *g  = cfg_build(p);
+ 
+     fprintf(out, "; IR %s: %d instrucción(es), %d registro(s)\n",
+             p->whole_program ? "del programa" : "de una región", p->num_code, p->num_regs);
+     fputs(p->whole_program ? ".program\n" : ".region\n", out);
+     fputs(".vars", out);
+     for (int v = 0; v < nv; v++) {
+         fprintf(out, " %s", symtab[v].name);
+     }
+     fprintf(out, "\n.regs %d\n.consts", p->num_regs);
+     for (int k = 0; k < p->num_consts; k++) {
+         fprintf(out, " %lld", p->consts[k]);
+     }
+     fputc('\n', out);
+     if (p->num_fconsts > 0) {
+         fputs(".fconsts", out);
+         for (int k = 0; k < p->num_fconsts; k++) {
+             fprintf(out, " %.17g", p->fconsts[k]);
+         }
+         fputc('\n', out);
+     }
+     if (p->ssa_var != NULL) {
+         fputs(".ssa\n", out);
+     }
+ 
+     for (int b = 0; b < g->num_blocks; b++) {
+         const BasicBlock *bb = &g->blocks[b];
+         fprintf(out, "B%d:", b);
+         for (int j = 0; j < bb->num_preds; j++) {
+             fprintf(out, "%s B%d", j == 0 ? "  ; <-" : "", bb->preds[j]);
+         }
+         fputc('\n', out);
+         for (int i = bb->start; i < bb->end; i++) {
+             const Instr *in  = &p->code[i];
+             const char  *arg = op_info[in->op].args;
+             int          f[4] = { in->a, in->b, in->c, in->d };
+             int          len  = fprintf(out, "%6d  %-7s", i, op_info[in->op].name);
+             for (int k = 0; arg[k] != '\0'; k++) {
+                 len += fprintf(out, k == 0 ? " " : ", ");
+                 switch (arg[k]) {
+                     case 'r':
+                         len += ir_print_reg(p, f[k], out);
+                         break;
+                     case 'k':
+                         len += fprintf(out, "#%lld", p->consts[f[k]]);
+                         break;
+                     case 'f':
+                         len += fprintf(out, "#%.17g", p->fconsts[f[k]]);
+                         break;
+                     case 'j':
+                         len += fprintf(out, "@%d", f[k]);
+                         break;
+                     case 'n':
+                         len += fprintf(out, "%d", f[k]);
+                         break;
+                     case 'v':
+                         len += fprintf(out, "%s", arrays[f[k]].name);
+                         break;
+                     case 'm':
+                         len += fprintf(out, "%s", dict_names[f[k]]);
+                         break;
+                     case '*':
+                         for (int j = 0; j < in->c; j++) {
+                             len += fprintf(out, j == 0 ? "" : ", ");
+                             len += ir_print_reg(p, p->phi_args[in->b + j], out);
+                         }
+                         break;
+                 }
+             }
+             fprintf(out, "%*s ; línea %d", len < 40 ? 40 - len : 0, "", in->line);
+             if (strlen(arg) < 4 && in->d != 0) {
+                 fprintf(out, ", token %d", in->d - 1);  // escritura de una asignación
+             }
+             fputc('\n', out);
+         }
+     }
+     cfg_free(g);
+ }
+ 
+ static int ir_text_line = 0;   // línea del texto que se está leyendo
+ 
+ static void ir_text_error(const char *msg) {
+     fprintf(stderr, "Error: IR mal formado (línea %d): %s.\n", ir_text_line, msg);
+     exit(1);
+ }
+ 
+ static const char *ir_text_space(const char *s) {
+     while (*s == ' ' || *s == '\t') {
+         s++;
+     }
+     return s;
+ }
+ 
+ /**
+  * ir_text_llong(s, val) / ir_text_int(s, val):
+  *   Lee un entero (con signo) de 64 o de 32 bits en s; devuelve lo
+  *   que sigue.
+  */
+ static const char *ir_text_llong(const char *s, long long *val) {
+     char *end;
+     errno = 0;
+     *val = strtoll(s, &end, 10);
+     if (end == s || !(*s == '-' || isdigit((unsigned char)*s)) || errno == ERANGE) {
+         ir_text_error("se esperaba un número");
+     }
+     return end;
+ }
+ 
+ static const char *ir_text_int(const char *s, int *val) {
+     long long v;
+     s = ir_text_llong(s, &v);
+     if (v < INT_MIN || v > INT_MAX) {
+         ir_text_error("se esperaba un número");
+     }
+     *val = (int)v;
+     return s;
+ }
+ 
+ /**
+  * ir_text_real(s, val):
+  *   Lee un real (lo que entienda strtod, "inf" y "nan" incluidos);
+  *   devuelve lo que sigue.
+  */
+ static const char *ir_text_real(const char *s, double *val) {
+     char *end;
+     *val = strtod(s, &end);
+     if (end == s) {
+         ir_text_error("se esperaba un número real");
+     }
+     return end;
+ }
+ 
+ /**
+  * ir_text_reg(p, s, r):
+  *   Lee un registro (nombre, %N o una versión SSA de cualquiera de
+  *   los dos, con ".N" detrás); devuelve lo que sigue.
+  */
+ static const char *ir_text_reg(IRProgram *p, const char *s, int *r) {
+     int nv = ir_num_vars(p);
+     int v;
+     if (*s == '%') {
+         s = ir_text_int(s + 1, &v);
+         if (v < nv || v >= p->num_regs) {
+             ir_text_error("temporal fuera de rango");
+         }
+     } else {
+         char name[MAX_LEXEME_LEN];
+         int  n = 0;
+         while (isalnum((unsigned char)*s) && n < MAX_LEXEME_LEN - 1) {
+             name[n++] = *s++;
+         }
+         name[n] = '\0';
+         v = lookup_symbol(name);
+         if (n == 0 || v < 0 || v >= nv) {
+             ir_text_error("se esperaba un registro");
+         }
+     }
+     *r = v;
+     if (*s != '.') {
+         return s;
+     }
+     s = ir_text_int(s + 1, r);
+     if (p->ssa_var == NULL || *r < nv || *r >= p->num_regs) {
+         ir_text_error("versión SSA fuera de rango");
+     }
+     if (p->ssa_var[v] >= 0 || (p->ssa_var[*r] >= 0 && p->ssa_var[*r] != v)) {
+         ir_text_error("la misma versión es de dos registros");
+     }
+     p->ssa_var[*r] = v;
+     return s;
+ }
+ 
+ /**
+  * ir_parse(in):
+  *   Lee un IR volcado por ir_dump(). Cualquier error de formato
+  *   termina el programa.
+  */
+ static IRProgram *ir_parse(FILE *in) {
+     IRProgram *p = ir_new();
+     IRProgram *saved_ir = ir;
+     int        nv    = -1;
+     char       text[8192];
+     ir_text_line = 0;
+     ir = p;
+ 
+     while (fgets(text, sizeof(text), in) != NULL) {
+         ir_text_line++;
+         if (strchr(text, '\n') == NULL && !feof(in)) {
+             ir_text_error("línea demasiado larga");
+         }
+         const char *s = ir_text_space(text);
+         if (*s == ';' || *s == '\n' || *s == '\0') {
+             continue;
+         }
+ 
+         // Cabeceras
+         if (*s == '.') {
+             if (strncmp(s, ".program", 8) == 0 || strncmp(s, ".region", 7) == 0) {
+                 p->whole_program = (s[1] == 'p');
+             } else if (strncmp(s, ".vars", 5) == 0) {
+                 s  = ir_text_space(s + 5);
+                 nv = 0;
+                 while (isalnum((unsigned char)*s)) {
+                     int n = 0;
+                     while (isalnum((unsigned char)s[n])) {
+                         n++;
+                     }
+                     if (nv >= num_vars || (int)strlen(symtab[nv].name) != n ||
+                         strncmp(symtab[nv].name, s, n) != 0) {
+                         ir_text_error("las variables no son las del programa");
+                     }
+                     nv++;
+                     s = ir_text_space(s + n);
+                 }
+                 if (nv != num_vars) {
+                     ir_text_error("las variables no son las del programa");
+                 }
+             } else if (strncmp(s, ".regs", 5) == 0) {
+                 ir_text_int(ir_text_space(s + 5), &p->num_regs);
+                 if (nv < 0 || p->num_regs < nv) {
+                     ir_text_error("'.regs' necesita antes '.vars'");
+                 }
+                 p->num_temps = p->num_regs - nv;
+             } else if (strncmp(s, ".fconsts", 8) == 0) {
+                 s = ir_text_space(s + 8);
+                 while (*s != '\n' && *s != '\0') {
+                     double val;
+                     s = ir_text_space(ir_text_real(s, &val));
+                     ir_fconst_in(p, val);
+                 }
+             } else if (strncmp(s, ".consts", 7) == 0) {
+                 s = ir_text_space(s + 7);
+                 while (*s != '\n' && *s != '\0') {
+                     long long val;
+                     s = ir_text_space(ir_text_llong(s, &val));
+                     ir_const_in(p, val);
+                 }
+             } else if (strncmp(s, ".ssa", 4) == 0) {
+                 if (nv < 0 || p->num_regs == 0) {
+                     ir_text_error("'.ssa' necesita antes '.regs'");
+                 }
+                 p->ssa_var = malloc(p->num_regs * sizeof(int));
+                 for (int r = 0; r < p->num_regs; r++) {
+                     p->ssa_var[r] = -1;
+                 }
+             } else {
+                 ir_text_error("cabecera desconocida");
+             }
+             continue;
+         }
+ 
+         // Etiquetas de bloque (los bloques se recalculan)
+         if (*s == 'B') {
+             continue;
+         }
+ 
+         // Instrucción: índice, operación y operandos
+         int idx;
+         s = ir_text_int(s, &idx);
+         if (idx != p->num_code) {
+             ir_text_error("índice de instrucción fuera de orden");
+         }
+         if (nv < 0 || p->num_regs == 0) {
+             ir_text_error("faltan las cabeceras '.vars' y '.regs'");
+         }
+         s = ir_text_space(s);
+         int op = 0;
+         int n  = 0;
+         while (isalnum((unsigned char)s[n])) {    // DIV32
+             n++;
+         }
+         while (op < NUM_OPS && ((int)strlen(op_info[op].name) != n ||
+                                 strncmp(op_info[op].name, s, n) != 0)) {
+             op++;
+         }
+         if (op == NUM_OPS) {
+             ir_text_error("operación desconocida");
+         }
+         s += n;
+         int f[4] = { 0, 0, 0, 0 };
+         const char *arg = op_info[op].args;
+         for (int k = 0; arg[k] != '\0'; k++) {
+             s = ir_text_space(s);
+             if (k > 0) {
+                 if (*s != ',') {
+                     ir_text_error("se esperaba ','");
+                 }
+                 s = ir_text_space(s + 1);
+             }
+             switch (arg[k]) {
+                 case 'r':
+                     s = ir_text_reg(p, s, &f[k]);
+                     break;
+                 case 'k': {
+                     long long val;
+                     if (*s != '#') {
+                         ir_text_error("se esperaba una constante '#'");
+                     }
+                     s    = ir_text_llong(s + 1, &val);
+                     f[k] = ir_const_in(p, val);
+                     break;
+                 }
+                 case 'f': {
+                     double val;
+                     if (*s != '#') {
+                         ir_text_error("se esperaba una constante '#'");
+                     }
+                     s    = ir_text_real(s + 1, &val);
+                     f[k] = ir_fconst_in(p, val);
+                     break;
+                 }
+                 case 'j':
+                     if (*s != '@') {
+                         ir_text_error("se esperaba un destino '@'");
+                     }
+                     s = ir_text_int(s + 1, &f[k]);
+                     break;
+                 case 'n':
+                     s = ir_text_int(s, &f[k]);
+                     break;
+                 case 'v': case 'm': {
+                     char name[MAX_LEXEME_LEN];
+                     int  n = 0;
+                     while (isalnum((unsigned char)*s) && n < MAX_LEXEME_LEN - 1) {
+                         name[n++] = *s++;
+                     }
+                     name[n] = '\0';
+                     f[k] = (arg[k] == 'v') ? lookup_array(name) : lookup_dict(name);
+                     if (n == 0 || f[k] < 0) {
+                         ir_text_error((arg[k] == 'v') ? "se esperaba un vector"
+                                                       : "se esperaba un diccionario");
+                     }
+                     break;
+                 }
+                 case '*':
+                     if (p->ssa_var == NULL) {
+                         ir_text_error("PHI fuera de forma SSA");
+                     }
+                     f[1] = p->num_phi_args;
+                     for (;;) {
+                         int r;
+                         s = ir_text_space(ir_text_reg(p, s, &r));
+                         if (p->num_phi_args >= p->cap_phi_args) {
+                             p->cap_phi_args = p->cap_phi_args ? p->cap_phi_args * 2 : 64;
+                             p->phi_args = realloc(p->phi_args, p->cap_phi_args * sizeof(int));
+                             if (p->phi_args == NULL) {
+                                 fprintf(stderr, "Error: memoria insuficiente.\n");
+                                 exit(1);
+                             }
+                         }
+                         p->phi_args[p->num_phi_args++] = r;
+                         if (*s != ',') {
+                             break;
+                         }
+                         s = ir_text_space(s + 1);
+                     }
+                     f[2] = p->num_phi_args - f[1];
+                     break;
+             }
+         }
+         s = ir_text_space(s);
+         gen_line = 0;
+         if (strncmp(s, "; línea", strlen("; línea")) == 0) {
+             s = ir_text_int(ir_text_space(s + strlen("; línea")), &gen_line);
+             if (strncmp(s, ", token", strlen(", token")) == 0 && strlen(arg) < 4) {
+                 ir_text_int(ir_text_space(s + strlen(", token")), &f[3]);
+                 f[3]++;
+             }
+         } else if (*s != ';' && *s != '\n' && *s != '\0') {
+             ir_text_error("sobra texto detrás de la instrucción");
+         }
+         ir_emit((OpCode)op, f[0], f[1], f[2]);
+         p->code[p->num_code - 1].d = f[3];
+     }
+     ir = saved_ir;
+ 
+     // Saltos dentro del código y una PHI por predecesor
+     for (int i = 0; i < p->num_code; i++) {
+         ir_text_line = 0;
+         if (ir_is_jump(p->code[i].op) &&
+             (ir_jump_target(&p->code[i]) < 0 || ir_jump_target(&p->code[i]) >= p->num_code)) {
+             ir_text_error("salto fuera del código");
+         }
+     }
+     if (p->num_code == 0 || p->code[p->num_code - 1].op != OP_HALT) {
+         ir_text_error("el código tiene que acabar en HALT");
+     }
+     CFG *g = cfg_build(p);
+     for (int b = 0; b < g->num_blocks; b++) {
+         for (int i = g->blocks[b].start; i < g->blocks[b].end; i++) {
+             if (p->code[i].op == OP_PHI &&
+                 (p->code[i].c != g->blocks[b].num_preds ||
+                  (i > g->blocks[b].start && p->code[i - 1].op != OP_PHI))) {
+                 ir_text_error("PHI que no cuadra con los predecesores de su bloque");
+             }
+         }
+     }
+     cfg_free(g);
+     return p;
+ }
+ 
+ /**
+  * ir_same(p, q):
+  *   1 si p y q tienen las mismas instrucciones, registros y
+  *   constantes (las PHI se comparan por sus argumentos; las reales,
+  *   bit a bit).
+  */
+ static int ir_same(const IRProgram *p, const IRProgram *q) {
+     if (p->num_code != q->num_code || p->num_regs != q->num_regs ||
+         p->num_temps != q->num_temps || p->whole_program != q->whole_program ||
+         p->num_consts != q->num_consts || p->num_fconsts != q->num_fconsts ||
+         (p->ssa_var == NULL) != (q->ssa_var == NULL)) {
+         return 0;
+     }
+     if (memcmp(p->consts, q->consts, p->num_consts * sizeof(long long)) != 0 ||
+         (p->num_fconsts > 0 &&
+          memcmp(p->fconsts, q->fconsts, p->num_fconsts * sizeof(double)) != 0)) {
+         return 0;
+     }
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *x = &p->code[i];
+         const Instr *y = &q->code[i];
+         if (x->op != y->op || x->a != y->a || x->c != y->c || x->d != y->d ||
+             x->line != y->line) {
+             return 0;
+         }
+         if (x->op != OP_PHI && x->b != y->b) {
+             return 0;
+         }
+         for (int k = 0; x->op == OP_PHI && k < x->c; k++) {
+             if (p->phi_args[x->b + k] != q->phi_args[y->b + k]) {
+                 return 0;
+             }
+         }
+     }
+     return 1;
+ }
+ 
+ /**
+  * ir_roundtrip(p, what):
+  *   Vuelca p, lo lee y lo vuelve a volcar; 1 si el texto y el IR
+  *   leído coinciden con el original.
+  */
+ static int ir_roundtrip(const IRProgram *p, const char *what) {
+     FILE *first  = tmpfile();
+     FILE *second = tmpfile();
+     if (first == NULL || second == NULL) {
+         fprintf(stderr, "Error: no se pudo crear un archivo temporal.\n");
+         exit(1);
+     }
+     ir_dump(p, first);
+     rewind(first);
+     IRProgram *q = ir_parse(first);
+     ir_dump(q, second);
+     rewind(first);
+     rewind(second);
+ 
+     int ok   = ir_same(p, q);
+     int line = 1;
+     int c1, c2;
+     do {
+         c1 = fgetc(first);
+         c2 = fgetc(second);
+         line += (c1 == '\n');
+     } while (ok && c1 == c2 && c1 != EOF);
+     if (!ok) {
+         fprintf(stderr, "Error: el IR %s leído no es igual al volcado.\n", what);
+     } else if (c1 != c2) {
+         fprintf(stderr, "Error: el IR %s cambia al volcarlo otra vez (línea %d).\n", what, line);
+         ok = 0;
+     }
+     fclose(first);
+     fclose(second);
+     ir_free(q);
+     return ok;
+ }
+ 
+ 
+ /*==============================================================
+  *            BACKEND NATIVO x86-64 (ENSAMBLADOR GNU)
+  *=============================================================*/
+ 
+ /*--------------------------------------------------------------
+  * Traduce el IR de un programa completo a ensamblador GNU (AT&T)
+  * para Linux x86-64. El resultado no depende de libc: lleva su
+  * propio runtime mínimo (entrada/salida con búfer mediante
+  * syscalls) y se enlaza estático con "as" + "ld", junto con el
+  * objeto de runtime.c (Ordenar, Multiplicar, los diccionarios...).
+  * Al arrancar no hay ni lexer ni parser: el programa ya es código
+  * máquina.
+  *
+  * Asignación de registros: linear scan (Poletto & Sarkar) sobre
+  * los intervalos de vida de cada registro virtual. Los que no caben
+  * en registros físicos van a la pila, en [rbp - 8*k].
+  *
+  * rax/rdx quedan reservados como registros de trabajo (idiv los
+  * necesita); las rutinas del runtime conservan todos los demás.
+  * Un Entero ocupa un registro de 64 bits entero; las operaciones
+  * comprobadas (OP_ADDO...) van seguidas de "jo __gama_err_ovf".
+  * Flotante no está: build_native rechaza los programas que lo usan.
+  *-------------------------------------------------------------*/
+ 
+ #define NUM_PHYS_REGS 12
+ 
+ static const char *phys_reg64[NUM_PHYS_REGS] = {
+     "%rbx", "%r12", "%r13", "%r14", "%r15", "%rsi",
+     "%rdi", "%r8",  "%r9",  "%r10", "%r11", "%rcx"
+ };
+ 
+ static const char *phys_reg32[NUM_PHYS_REGS] = {    // sus 32 bits bajos
+     "%ebx", "%r12d", "%r13d", "%r14d", "%r15d", "%esi",
+     "%edi", "%r8d",  "%r9d",  "%r10d", "%r11d", "%ecx"
+ };
+ 
+ typedef struct {
+     int reg;           // registro virtual
+     int start, end;    // primera y última instrucción donde vive
+ } LiveInterval;
+ 
+ typedef struct {
+     int *phys;         // phys[r]  = registro físico, o -1
+     int *slot;         // slot[r]  = hueco en la pila (si phys[r] == -1)
+     int  num_slots;
+ } RegAlloc;
+ 
+ /**
+  * compute_intervals(p, iv):
+  *   Calcula [start, end] de cada registro virtual recorriendo el IR
+  *   en orden. Como el código es lineal, un bucle (salto hacia atrás
+  *   de j a t) obliga a que todo registro vivo en algún punto de
+  *   [t, j] viva el bucle entero: su valor puede hacer falta en la
+  *   siguiente vuelta. Se repite hasta que no cambia nada (bucles
+  *   anidados). Devuelve cuántos intervalos no vacíos hay.
+  */
+ static int compute_intervals(const IRProgram *p, LiveInterval *iv) {
+     for (int r = 0; r < p->num_regs; r++) {
+         iv[r].reg   = r;
+         iv[r].start = -1;
+         iv[r].end   = -1;
+     }
+     for (int i = 0; i < p->num_code; i++) {
+         int regs[3];
+         int n = ir_uses(&p->code[i], regs);
+         int d = ir_def(&p->code[i]);
+         if (d >= 0) {
+             regs[n++] = d;
+         }
+         for (int k = 0; k < n; k++) {
+             LiveInterval *v = &iv[regs[k]];
+             if (v->start < 0) {
+                 v->start = i;
+             }
+             v->end = i;
+         }
+     }
+ 
+     int changed = 1;
+     while (changed) {
+         changed = 0;
+         for (int j = 0; j < p->num_code; j++) {
+             const Instr *in = &p->code[j];
+             if (!ir_is_jump(in->op) || ir_jump_target(in) > j) {
+                 continue;
+             }
+             int t = ir_jump_target(in);
+             for (int r = 0; r < p->num_regs; r++) {
+                 LiveInterval *v = &iv[r];
+                 if (v->start < 0 || v->end < t || v->start > j) {
+                     continue;
+                 }
+                 if (v->start > t || v->end < j) {
+                     v->start = (v->start < t) ? v->start : t;
+                     v->end   = (v->end > j)   ? v->end   : j;
+                     changed = 1;
+                 }
+             }
+         }
+     }
+ 
+     // Compactamos: solo los registros que se usan
+     int n = 0;
+     for (int r = 0; r < p->num_regs; r++) {
+         if (iv[r].start >= 0) {
+             iv[n++] = iv[r];
+         }
+     }
+     return n;
+ }
+ 
+ static int cmp_interval_start(const void *x, const void *y) {
+     const LiveInterval *a = x, *b = y;
+     return (a->start != b->start) ? a->start - b->start : a->reg - b->reg;
+ }
+ 
+ /**
+  * linear_scan(p, ra):
+  *   Recorre los intervalos por inicio creciente manteniendo la lista
+  *   "active" (ordenada por fin). Si no queda registro libre, se
+  *   derrama el intervalo que termina más tarde.
+  */
+ static void linear_scan(const IRProgram *p, RegAlloc *ra) {
+     LiveInterval *iv     = malloc((p->num_regs + 1) * sizeof(LiveInterval));
+     LiveInterval *active = malloc(NUM_PHYS_REGS * sizeof(LiveInterval));
+     ra->phys = malloc((p->num_regs + 1) * sizeof(int));
+     ra->slot = malloc((p->num_regs + 1) * sizeof(int));
+     if (iv == NULL || active == NULL || ra->phys == NULL || ra->slot == NULL) {
+         fprintf(stderr, "Error: memoria insuficiente.\n");
+         exit(1);
+     }
+     ra->num_slots = 0;
+     for (int r = 0; r < p->num_regs; r++) {
+         ra->phys[r] = -1;
+         ra->slot[r] = -1;
+     }
+ 
+     int n = compute_intervals(p, iv);
+     qsort(iv, n, sizeof(LiveInterval), cmp_interval_start);
+ 
+     int free_regs[NUM_PHYS_REGS];
+     int num_free = NUM_PHYS_REGS;
+     for (int k = 0; k < NUM_PHYS_REGS; k++) {
+         free_regs[k] = NUM_PHYS_REGS - 1 - k;   // ebx sale primero
+     }
+     int num_active = 0;
+ 
+     for (int i = 0; i < n; i++) {
+         LiveInterval cur = iv[i];
+ 
+         // 1) Expirar los intervalos que ya terminaron
+         int k = 0;
+         while (k < num_active && active[k].end < cur.start) {
+             free_regs[num_free++] = ra->phys[active[k].reg];
+             k++;
+         }
+         memmove(active, active + k, (num_active - k) * sizeof(LiveInterval));
+         num_active -= k;
+ 
+         // 2) Asignar registro, o derramar
+         if (num_free == 0) {
+             LiveInterval *last = &active[num_active - 1];
+             if (last->end > cur.end) {
+                 ra->phys[cur.reg] = ra->phys[last->reg];
+                 ra->phys[last->reg] = -1;
+                 ra->slot[last->reg] = ra->num_slots++;
+                 num_active--;
+             } else {
+                 ra->slot[cur.reg] = ra->num_slots++;
+                 continue;
+             }
+         } else {
+             ra->phys[cur.reg] = free_regs[--num_free];
+         }
+ 
+         // 3) Insertar en active manteniendo el orden por fin
+         int pos = num_active;
+         while (pos > 0 && active[pos - 1].end > cur.end) {
+             active[pos] = active[pos - 1];
+             pos--;
+         }
+         active[pos] = cur;
+         num_active++;
+     }
+ 
+     free(iv);
+     free(active);
+ }
+ 
+ /*--------------------------------------------------------------
+  * Runtime mínimo (sin libc). Convenciones:
+  *   __gama_print  imprime %rax y '\n'   (conserva todo salvo rax)
+  *   __gama_read   lee un entero en %rax (conserva todo salvo rax);
+  *                 si no cabe en 64 bits es un error de lectura
+  *   __gama_putc   imprime el carácter %al y '\n' (conserva todo)
+  *   __gama_readc  lee un carácter que no sea blanco en %rax, con
+  *                 signo (conserva todo salvo rax)
+  *   __gama_trips  vueltas de un bucle (OP_TRIPS): x en %rax, n en
+  *                 %rdx, d en la pila; resultado en %rax (pisa rdx)
+  *   __gama_powsum Σ k^e, k < %rax, con e en %edx (OP_POWSUM; pisa rdx)
+  *   __gama_badd / __gama_bmul   OP_BOUND de %rax y %rdx en %rax (pisa
+  *                 rdx)
+  *   __gama_vsum   Suma de los %rdx Entero desde %rax; resultado en
+  *                 %rax y %rdx != 0 si no cabe en 64 bits
+  *   __gama_vdot   Producto: como __gama_vsum, con el otro vector en
+  *                 la pila
+  *   __gama_vmin / __gama_vmax   Minimo / Maximo (pisa rdx)
+  *   __gama_vsumc, __gama_vdotc, __gama_vminc, __gama_vmaxc
+  *                 lo mismo de un vector de Caracter (no se desborda)
+  *
+  * Ordenar, Buscar, Multiplicar, Trasponer y los diccionarios son las
+  * funciones gama_* de runtime.c, las mismas de la VM, que
+  * build_native() compila aparte y enlaza. Sus entradas aquí guardan
+  * los registros que el programa puede tener vivos (las funciones de
+  * C conservan rbx y r12-r15), alinean la pila y pasan los argumentos
+  * como pide System V (GAMA_SAVE y GAMA_RESTORE); todas pisan rax y
+  * rdx:
+  *   __gama_vfind  Buscar: la posición de x (en la pila) en los %rdx
+  *                 Entero desde %rax, o -1 en %rax
+  *   __gama_vsort  Ordenar los %rdx Entero desde %rax
+  *   __gama_vfindc, __gama_vsortc   lo mismo de un Caracter
+  *   __gama_mmul   Multiplicar: c en %rax y a, b, N, K y M en la pila
+  *                 (a en el tope); %rdx != 0 si algún elemento no cabe
+  *                 en 64 bits (__gama_mmulw, con --wrap: nunca)
+  *   __gama_mtr / __gama_mtrc   Trasponer: t en %rax y a, sus
+  *                 columnas y sus filas en la pila
+  *   __gama_dget   d[k], con el diccionario (__gama_dict_N, un Dict de
+  *                 runtime.c) en %rax y k en %rdx; resultado en %rax
+  *   __gama_dhas   Contiene: como __gama_dget, 1 o 0
+  *   __gama_dset   d[k] = x, con x en la pila
+  *   __gama_ddel   Borrar; __gama_dnew vacía d
+  *   __gama_dkeys  Claves: las de %rax en el vector %rdx (el que llama
+  *                 ya ha visto que caben)
+  *
+  *   __gama_err_keys  "Error: las %rax" y (%rsi, %rdx) en stderr; sale
+  *   __gama_die    escribe (%rsi, %rdx) en stderr y sale con 1
+  *   __gama_exit   vacía la salida y termina con 0
+  *-------------------------------------------------------------*/
+ static const char *native_runtime =
+     "\t.section .note.GNU-stack, \"\", @progbits\n"
+     "\t.section .bss\n"
+     "\t.lcomm __gama_obuf, 4096\n"
+     "\t.lcomm __gama_olen, 8\n"
+     "\t.lcomm __gama_ibuf, 4096\n"
+     "\t.lcomm __gama_ipos, 8\n"
+     "\t.lcomm __gama_ilen, 8\n"
+     "\t.section .rodata\n"
+     "__gama_msg_div:\n"
+     "\t.ascii \"Error: divisi\\303\\263n por cero.\\n\"\n"
+     "__gama_msg_ovf:\n"
+     "\t.ascii \"Error: desbordamiento de Entero.\\n\"\n"
+     "__gama_msg_read:\n"
+     "\t.ascii \"Error de runtime: no se pudo leer un entero.\\n\"\n"
+     "__gama_msg_readc:\n"
+     "\t.ascii \"Error de runtime: no se pudo leer un car\\303\\241cter.\\n\"\n"
+     "__gama_msg_mem:\n"
+     "\t.ascii \"Error: memoria insuficiente.\\n\"\n"
+     "__gama_msg_keys:\n"
+     "\t.ascii \"Error: las \"\n"
+     "\t.text\n"
+     "\t.globl __gama_err_mem\n"
+     "\t.macro GAMA_SAVE\n"
+     "\tpush %rbp\n\tmov %rsp, %rbp\n"
+     "\tpush %rcx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tpush %r9\n\tpush %r10\n\tpush %r11\n"
+     "\tand $-16, %rsp\n"
+     "\t.endm\n"
+     "\t.macro GAMA_RESTORE\n"
+     "\tlea -56(%rbp), %rsp\n"
+     "\tpop %r11\n\tpop %r10\n\tpop %r9\n\tpop %r8\n"
+     "\tpop %rdi\n\tpop %rsi\n\tpop %rcx\n"
+     "\tpop %rbp\n\tret\n"
+     "\t.endm\n"
+     "__gama_flush:\n"
+     "\tpush %rax\n\tpush %rcx\n\tpush %rdx\n\tpush %rsi\n\tpush %rdi\n\tpush %r11\n"
+     "\tmov __gama_olen(%rip), %rdx\n"
+     "\tlea __gama_obuf(%rip), %rsi\n"
+     "1:\ttest %rdx, %rdx\n"
+     "\tjz 2f\n"
+     "\tmov $1, %edi\n"
+     "\tmov $1, %eax\n"
+     "\tsyscall\n"
+     "\ttest %rax, %rax\n"
+     "\tjle 2f\n"
+     "\tadd %rax, %rsi\n"
+     "\tsub %rax, %rdx\n"
+     "\tjmp 1b\n"
+     "2:\tmovq $0, __gama_olen(%rip)\n"
+     "\tpop %r11\n\tpop %rdi\n\tpop %rsi\n\tpop %rdx\n\tpop %rcx\n\tpop %rax\n"
+     "\tret\n"
+     "__gama_print:\n"
+     "\tpush %rax\n\tpush %rcx\n\tpush %rdx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tsub $32, %rsp\n"
+     "\tlea 31(%rsp), %rdi\n"
+     "\tmovb $10, (%rdi)\n"
+     "\tmov %rax, %r8\n"
+     "\ttest %rax, %rax\n"
+     "\tjns 1f\n"
+     "\tneg %rax\n"
+     "1:\tmov $10, %ecx\n"
+     "2:\txor %edx, %edx\n"
+     "\tdiv %rcx\n"
+     "\tadd $48, %dl\n"
+     "\tdec %rdi\n"
+     "\tmov %dl, (%rdi)\n"
+     "\ttest %rax, %rax\n"
+     "\tjnz 2b\n"
+     "\ttest %r8, %r8\n"
+     "\tjns 3f\n"
+     "\tdec %rdi\n"
+     "\tmovb $45, (%rdi)\n"
+     "3:\tlea 32(%rsp), %rcx\n"
+     "\tsub %rdi, %rcx\n"
+     "\tmov __gama_olen(%rip), %rdx\n"
+     "\tlea (%rdx,%rcx), %rax\n"
+     "\tcmp $4096, %rax\n"
+     "\tjbe 4f\n"
+     "\tcall __gama_flush\n"
+     "\txor %edx, %edx\n"
+     "4:\tlea __gama_obuf(%rip), %rsi\n"
+     "\tadd %rdx, %rsi\n"
+     "\tadd %rcx, %rdx\n"
+     "\tmov %rdx, __gama_olen(%rip)\n"
+     "5:\tmovb (%rdi), %al\n"
+     "\tmovb %al, (%rsi)\n"
+     "\tinc %rdi\n"
+     "\tinc %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 5b\n"
+     "\tadd $32, %rsp\n"
+     "\tpop %r8\n\tpop %rdi\n\tpop %rsi\n\tpop %rdx\n\tpop %rcx\n\tpop %rax\n"
+     "\tret\n"
+     "__gama_putc:\n"
+     "\tpush %rdx\n\tpush %rsi\n"
+     "\tmov __gama_olen(%rip), %rdx\n"
+     "\tcmp $4094, %rdx\n"
+     "\tjbe 1f\n"
+     "\tcall __gama_flush\n"
+     "\txor %edx, %edx\n"
+     "1:\tlea __gama_obuf(%rip), %rsi\n"
+     "\tmovb %al, (%rsi,%rdx)\n"
+     "\tmovb $10, 1(%rsi,%rdx)\n"
+     "\tadd $2, %rdx\n"
+     "\tmov %rdx, __gama_olen(%rip)\n"
+     "\tpop %rsi\n\tpop %rdx\n"
+     "\tret\n"
+     "__gama_getc:\n"
+     "\tpush %rcx\n\tpush %rdx\n\tpush %rsi\n\tpush %rdi\n\tpush %r11\n"
+     "\tmov __gama_ipos(%rip), %rcx\n"
+     "\tcmp __gama_ilen(%rip), %rcx\n"
+     "\tjb 1f\n"
+     "\txor %eax, %eax\n"
+     "\txor %edi, %edi\n"
+     "\tlea __gama_ibuf(%rip), %rsi\n"
+     "\tmov $4096, %edx\n"
+     "\tsyscall\n"
+     "\ttest %rax, %rax\n"
+     "\tjle 2f\n"
+     "\tmov %rax, __gama_ilen(%rip)\n"
+     "\txor %ecx, %ecx\n"
+     "1:\tlea __gama_ibuf(%rip), %rsi\n"
+     "\tmovzbl (%rsi,%rcx), %eax\n"
+     "\tinc %rcx\n"
+     "\tmov %rcx, __gama_ipos(%rip)\n"
+     "\tjmp 3f\n"
+     "2:\tmov $-1, %eax\n"
+     "3:\tpop %r11\n\tpop %rdi\n\tpop %rsi\n\tpop %rdx\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_read:\n"
+     "\tpush %rcx\n\tpush %rdx\n\tpush %r8\n"
+     "\tcall __gama_flush\n"
+     "1:\tcall __gama_getc\n"
+     "\tcmp $32, %eax\n"
+     "\tje 1b\n"
+     "\tlea -9(%rax), %edx\n"
+     "\tcmp $4, %edx\n"
+     "\tjbe 1b\n"
+     "\txor %r8d, %r8d\n"
+     "\tcmp $45, %eax\n"
+     "\tjne 2f\n"
+     "\tmov $1, %r8d\n"
+     "\tcall __gama_getc\n"
+     "\tjmp 3f\n"
+     "2:\tcmp $43, %eax\n"
+     "\tjne 3f\n"
+     "\tcall __gama_getc\n"
+     "3:\tlea -48(%rax), %edx\n"
+     "\tcmp $9, %edx\n"
+     "\tja __gama_err_read\n"
+     "\txor %ecx, %ecx\n"
+     "4:\timul $10, %rcx, %rcx\n"
+     "\tjo __gama_err_read\n"
+     "\tsub %rdx, %rcx\n"
+     "\tjo __gama_err_read\n"
+     "\tcall __gama_getc\n"
+     "\tlea -48(%rax), %edx\n"
+     "\tcmp $9, %edx\n"
+     "\tjbe 4b\n"
+     "\tcmp $-1, %eax\n"
+     "\tje 5f\n"
+     "\tdecq __gama_ipos(%rip)\n"
+     "5:\tmov %rcx, %rax\n"
+     "\ttest %r8d, %r8d\n"
+     "\tjnz 6f\n"
+     "\tneg %rax\n"
+     "\tjo __gama_err_read\n"
+     "6:\tpop %r8\n\tpop %rdx\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_readc:\n"
+     "\tpush %rdx\n"
+     "\tcall __gama_flush\n"
+     "1:\tcall __gama_getc\n"
+     "\tcmp $-1, %eax\n"
+     "\tje __gama_err_readc\n"
+     "\tcmp $32, %eax\n"
+     "\tje 1b\n"
+     "\tlea -9(%rax), %edx\n"
+     "\tcmp $4, %edx\n"
+     "\tjbe 1b\n"
+     "\tmovsbq %al, %rax\n"
+     "\tpop %rdx\n"
+     "\tret\n"
+     "__gama_die:\n"
+     "\tcall __gama_flush\n"
+     "\tmov $2, %edi\n"
+     "\tmov $1, %eax\n"
+     "\tsyscall\n"
+     "\tmov $1, %edi\n"
+     "\tmov $60, %eax\n"
+     "\tsyscall\n"
+     "__gama_err_div:\n"
+     "\tlea __gama_msg_div(%rip), %rsi\n"
+     "\tmov $27, %edx\n"
+     "\tjmp __gama_die\n"
+     "__gama_err_ovf:\n"
+     "\tlea __gama_msg_ovf(%rip), %rsi\n"
+     "\tmov $33, %edx\n"
+     "\tjmp __gama_die\n"
+     "__gama_err_read:\n"
+     "\tlea __gama_msg_read(%rip), %rsi\n"
+     "\tmov $45, %edx\n"
+     "\tjmp __gama_die\n"
+     "__gama_err_readc:\n"
+     "\tlea __gama_msg_readc(%rip), %rsi\n"
+     "\tmov $48, %edx\n"
+     "\tjmp __gama_die\n"
+     "__gama_err_mem:\n"
+     "\tlea __gama_msg_mem(%rip), %rsi\n"
+     "\tmov $29, %edx\n"
+     "\tjmp __gama_die\n"
+     "__gama_trips:\n"
+     "\tpush %rcx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tmov 40(%rsp), %r8\n"
+     "\tmov %r8d, %ecx\n"
+     "\tand $7, %ecx\n"
+     "\tsub %rcx, %r8\n"
+     "\tsar $3, %r8\n"
+     "\ttest %ecx, %ecx\n"
+     "\tjnz 1f\n"
+     "\txor %eax, %eax\n"
+     "\tcmp %rsi, %rdi\n"
+     "\tsete %al\n"
+     "\tjmp 9f\n"
+     "1:\tcmp $1, %ecx\n"
+     "\tjne 2f\n"
+     "\tcmp %rsi, %rdi\n"
+     "\tje 8f\n"
+     "\tlea 1(%r8), %rdx\n"
+     "\ttest $-3, %rdx\n"
+     "\tjnz 8f\n"
+     "\tmov %rsi, %rax\n"
+     "\tsub %rdi, %rax\n"
+     "\timul %r8, %rax\n"
+     "\tjmp 6f\n"
+     "2:\tcmp $3, %ecx\n"
+     "\tja 3f\n"
+     "\ttest %r8, %r8\n"
+     "\tjle 8f\n"
+     "\tcmp %rsi, %rdi\n"
+     "\tjg 8f\n"
+     "\tmov %rsi, %rax\n"
+     "\tsub %rdi, %rax\n"
+     "\tcmp $2, %ecx\n"
+     "\tjne 4f\n"
+     "\ttest %rax, %rax\n"
+     "\tjz 8f\n"
+     "\tdec %rax\n"
+     "4:\txor %edx, %edx\n"
+     "\tdiv %r8\n"
+     "\tinc %rax\n"
+     "\tjmp 6f\n"
+     "3:\ttest %r8, %r8\n"
+     "\tjge 8f\n"
+     "\tcmp %rsi, %rdi\n"
+     "\tjl 8f\n"
+     "\tmov %rdi, %rax\n"
+     "\tsub %rsi, %rax\n"
+     "\tneg %r8\n"
+     "\tcmp $4, %ecx\n"
+     "\tjne 5f\n"
+     "\ttest %rax, %rax\n"
+     "\tjz 8f\n"
+     "\tdec %rax\n"
+     "5:\txor %edx, %edx\n"
+     "\tdiv %r8\n"
+     "\tinc %rax\n"
+     "\tneg %r8\n"
+     "6:\ttest %rax, %rax\n"
+     "\tjs 8f\n"
+     "\tmov %rax, %rcx\n"
+     "\timul %r8, %rcx\n"
+     "\tjo 8f\n"
+     "\tadd %rdi, %rcx\n"
+     "\tjno 9f\n"
+     "8:\txor %eax, %eax\n"
+     "9:\tpop %r8\n\tpop %rdi\n\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_powsum:\n"
+     "\tpush %rcx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tmov %edx, %esi\n"
+     "\ttest %rax, %rax\n"
+     "\tjz 9f\n"
+     "\tlea -1(%rax,%rax), %r8\n"
+     "\tmov %rax, %rcx\n"
+     "\tlea -1(%rax), %rdi\n"
+     "\ttest $1, %cl\n"
+     "\tjnz 1f\n"
+     "\tshr $1, %rcx\n"
+     "\tjmp 2f\n"
+     "1:\tshr $1, %rdi\n"
+     "2:\tcmp $2, %esi\n"
+     "\tjne 6f\n"
+     "\tmov $3, %esi\n"
+     "\tmov %rcx, %rax\n"
+     "\txor %edx, %edx\n"
+     "\tdiv %rsi\n"
+     "\ttest %rdx, %rdx\n"
+     "\tjnz 3f\n"
+     "\tmov %rax, %rcx\n"
+     "\tjmp 5f\n"
+     "3:\tmov %rdi, %rax\n"
+     "\txor %edx, %edx\n"
+     "\tdiv %rsi\n"
+     "\ttest %rdx, %rdx\n"
+     "\tjnz 4f\n"
+     "\tmov %rax, %rdi\n"
+     "\tjmp 5f\n"
+     "4:\tmov %r8, %rax\n"
+     "\txor %edx, %edx\n"
+     "\tdiv %rsi\n"
+     "\tmov %rax, %r8\n"
+     "5:\tmov %rcx, %rax\n"
+     "\timul %rdi, %rax\n"
+     "\timul %r8, %rax\n"
+     "\tjmp 9f\n"
+     "6:\tmov %rcx, %rax\n"
+     "\timul %rdi, %rax\n"
+     "\tcmp $1, %esi\n"
+     "\tje 9f\n"
+     "\timul %rax, %rax\n"
+     "9:\tpop %r8\n\tpop %rdi\n\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_badd:\n"
+     "\tpush %rcx\n"
+     "\tcall __gama_babs\n"
+     "\tadd %rdx, %rax\n"
+     "\tjmp 1f\n"
+     "__gama_bmul:\n"
+     "\tpush %rcx\n"
+     "\tcall __gama_babs\n"
+     "\tmul %rdx\n"
+     "1:\tmovabs $0x8000000000000000, %rcx\n"
+     "\tjc 2f\n"
+     "\tcmp %rcx, %rax\n"
+     "\tjbe 3f\n"
+     "2:\tmov %rcx, %rax\n"
+     "3:\tpop %rcx\n"
+     "\tret\n"
+     "__gama_babs:\n"
+     "\tmov %rax, %rcx\n"
+     "\tsar $63, %rcx\n"
+     "\txor %rcx, %rax\n"
+     "\tsub %rcx, %rax\n"
+     "\tmov %rdx, %rcx\n"
+     "\tsar $63, %rcx\n"
+     "\txor %rcx, %rdx\n"
+     "\tsub %rcx, %rdx\n"
+     "\tret\n"
+     "__gama_vsum:\n"
+     "\tpush %rcx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\txor %eax, %eax\n"
+     "\txor %edi, %edi\n"
+     "1:\tmov (%rsi), %r8\n"
+     "\tmov %r8, %rdx\n"
+     "\tsar $63, %rdx\n"
+     "\tadd %r8, %rax\n"
+     "\tadc %rdx, %rdi\n"
+     "\tadd $8, %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tmov %rax, %rdx\n"
+     "\tsar $63, %rdx\n"
+     "\txor %rdi, %rdx\n"
+     "\tpop %r8\n\tpop %rdi\n\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vsumc:\n"
+     "\tpush %rcx\n\tpush %rsi\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\txor %eax, %eax\n"
+     "1:\tmovsbq (%rsi), %rdx\n"
+     "\tadd %rdx, %rax\n"
+     "\tinc %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vdot:\n"
+     "\tpush %rcx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tpush %r9\n\tpush %r10\n\tpush %r11\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\tmov 64(%rsp), %rdi\n"
+     "\txor %r8d, %r8d\n"
+     "\txor %r9d, %r9d\n"
+     "\txor %r10d, %r10d\n"
+     "1:\tmov (%rsi), %rax\n"
+     "\timulq (%rdi)\n"
+     "\tmov %rdx, %r11\n"
+     "\tsar $63, %r11\n"
+     "\tadd %rax, %r8\n"
+     "\tadc %rdx, %r9\n"
+     "\tadc %r11, %r10\n"
+     "\tadd $8, %rsi\n"
+     "\tadd $8, %rdi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tmov %r8, %rax\n"
+     "\tmov %r8, %rdx\n"
+     "\tsar $63, %rdx\n"
+     "\tmov %rdx, %r11\n"
+     "\txor %r9, %rdx\n"
+     "\txor %r10, %r11\n"
+     "\tor %r11, %rdx\n"
+     "\tpop %r11\n\tpop %r10\n\tpop %r9\n"
+     "\tpop %r8\n\tpop %rdi\n\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vdotc:\n"
+     "\tpush %rcx\n\tpush %rsi\n\tpush %rdi\n\tpush %r8\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\tmov 40(%rsp), %rdi\n"
+     "\txor %r8d, %r8d\n"
+     "1:\tmovsbq (%rsi), %rax\n"
+     "\tmovsbq (%rdi), %rdx\n"
+     "\timul %rdx, %rax\n"
+     "\tadd %rax, %r8\n"
+     "\tinc %rsi\n"
+     "\tinc %rdi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tmov %r8, %rax\n"
+     "\tpop %r8\n\tpop %rdi\n\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vmin:\n"
+     "\tpush %rcx\n\tpush %rsi\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\tmov (%rsi), %rax\n"
+     "1:\tmov (%rsi), %rdx\n"
+     "\tcmp %rax, %rdx\n"
+     "\tcmovl %rdx, %rax\n"
+     "\tadd $8, %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vmax:\n"
+     "\tpush %rcx\n\tpush %rsi\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\tmov (%rsi), %rax\n"
+     "1:\tmov (%rsi), %rdx\n"
+     "\tcmp %rax, %rdx\n"
+     "\tcmovg %rdx, %rax\n"
+     "\tadd $8, %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vminc:\n"
+     "\tpush %rcx\n\tpush %rsi\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\tmovsbq (%rsi), %rax\n"
+     "1:\tmovsbq (%rsi), %rdx\n"
+     "\tcmp %rax, %rdx\n"
+     "\tcmovl %rdx, %rax\n"
+     "\tadd $1, %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vmaxc:\n"
+     "\tpush %rcx\n\tpush %rsi\n"
+     "\tmov %rax, %rsi\n"
+     "\tmov %rdx, %rcx\n"
+     "\tmovsbq (%rsi), %rax\n"
+     "1:\tmovsbq (%rsi), %rdx\n"
+     "\tcmp %rax, %rdx\n"
+     "\tcmovg %rdx, %rax\n"
+     "\tadd $1, %rsi\n"
+     "\tdec %rcx\n"
+     "\tjnz 1b\n"
+     "\tpop %rsi\n\tpop %rcx\n"
+     "\tret\n"
+     "__gama_vsort:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tcall gama_vsort\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_vsortc:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tcall gama_vsortc\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_vfind:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tmov 16(%rbp), %rdx\n"
+     "\tcall gama_vfind\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_vfindc:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tmov 16(%rbp), %rdx\n"
+     "\tcall gama_vfindc\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_mmul:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov 16(%rbp), %rsi\n"
+     "\tmov 24(%rbp), %rdx\n"
+     "\tmov 32(%rbp), %rcx\n"
+     "\tmov 40(%rbp), %r8\n"
+     "\tmov 48(%rbp), %r9\n"
+     "\tcall gama_mmul\n"
+     "\tmov %rax, %rdx\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_mmulw:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov 16(%rbp), %rsi\n"
+     "\tmov 24(%rbp), %rdx\n"
+     "\tmov 32(%rbp), %rcx\n"
+     "\tmov 40(%rbp), %r8\n"
+     "\tmov 48(%rbp), %r9\n"
+     "\tcall gama_mmulw\n"
+     "\tmov %rax, %rdx\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_mtr:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov 16(%rbp), %rsi\n"
+     "\tmov 32(%rbp), %rdx\n"
+     "\tmov 24(%rbp), %rcx\n"
+     "\tcall gama_mtr\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_mtrc:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov 16(%rbp), %rsi\n"
+     "\tmov 32(%rbp), %rdx\n"
+     "\tmov 24(%rbp), %rcx\n"
+     "\tcall gama_mtrc\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_err_keys:\n"
+     "\tcall __gama_flush\n"
+     "\tpush %rsi\n\tpush %rdx\n"
+     "\tsub $48, %rsp\n"
+     "\tlea 48(%rsp), %r8\n"
+     "\tmov %r8, %rdi\n"
+     "\tmov $10, %ecx\n"
+     "1:\txor %edx, %edx\n"
+     "\tdiv %rcx\n"
+     "\tadd $48, %dl\n"
+     "\tdec %rdi\n"
+     "\tmov %dl, (%rdi)\n"
+     "\ttest %rax, %rax\n"
+     "\tjnz 1b\n"
+     "\tsub $11, %rdi\n"
+     "\tmov %rdi, %r9\n"
+     "\tlea __gama_msg_keys(%rip), %rsi\n"
+     "\tmov $11, %ecx\n"
+     "\trep movsb\n"
+     "\tmov %r9, %rsi\n"
+     "\tmov %r8, %rdx\n"
+     "\tsub %r9, %rdx\n"
+     "\tmov $2, %edi\n"
+     "\tmov $1, %eax\n"
+     "\tsyscall\n"
+     "\tadd $48, %rsp\n"
+     "\tpop %rdx\n\tpop %rsi\n"
+     "\tjmp __gama_die\n"
+     "__gama_dget:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tcall gama_dget\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_dhas:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tcall gama_dhas\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_dset:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tmov 16(%rbp), %rdx\n"
+     "\tcall gama_dset\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_ddel:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tcall gama_ddel\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_dnew:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tcall gama_dnew\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_dkeys:\n"
+     "\tGAMA_SAVE\n"
+     "\tmov %rax, %rdi\n"
+     "\tmov %rdx, %rsi\n"
+     "\tcall gama_dkeys\n"
+     "\tGAMA_RESTORE\n"
+     "__gama_exit:\n"
+     "\tcall __gama_flush\n"
+     "\txor %edi, %edi\n"
+     "\tmov $60, %eax\n"
+     "\tsyscall\n";
+ 
+ /**
+  * native_loc(ra, r, buf):
+  *   Escribe en buf el operando AT&T donde vive el registro virtual r
+  *   (registro físico de 64 bits o hueco en la pila).
+  */
+ static const char *native_loc(const RegAlloc *ra, int r, char *buf) {
+     if (ra->phys[r] >= 0) {
+         return phys_reg64[ra->phys[r]];
+     }
+     sprintf(buf, "%d(%%rbp)", -8 * (ra->slot[r] + 1));
+     return buf;
+ }
+ 
+ /**
+  * emit_ascii(out, s):
+  *   Emite s como cadena .ascii, escapando los bytes no imprimibles
+  *   (los acentos de los mensajes van en UTF-8).
+  */
+ static void emit_ascii(FILE *out, const char *s) {
+     fputs("\t.ascii \"", out);
+     for (const unsigned char *q = (const unsigned char *)s; *q; q++) {
+         if (*q >= 32 && *q < 127 && *q != '"' && *q != '\\') {
+             fputc(*q, out);
+         } else {
+             fprintf(out, "\\%03o", *q);
+         }
+     }
+     fputs("\"\n", out);
+ }
+ 
+ /**
+  * emit_native_vloop(p, pc, ra, out):
+  *   El OP_VLOOP de code[pc] en el backend nativo: las vueltas de dos
+  *   en dos, una en cada mitad de un registro xmm (SSE2, que tiene
+  *   cualquier x86-64). Cada casilla del bucle va en xmm0..xmm11;
+  *   xmm12..xmm15, rax y rdx son de paso. Lo guardado va a memoria al
+  *   final de la pareja; si algo se desborda o un índice se sale, la
+  *   pareja se deja para el bucle escalar. Solo Entero y lo que
+  *   SSE2 hace sin rodeos (+, -, *, cambio de signo y vectores); si
+  *   no, no emite nada y el bucle va entero en escalar.
+  */
+ static void emit_native_vloop(const IRProgram *p, int pc, const RegAlloc *ra, FILE *out) {
+     const Instr *in = &p->code[pc];
+     VLoop L;
+     int   num_st = 0;
+     char  buf[32];
+     if (!vloop_scan(p, pc + 1, pc + in->a, NULL, &L) || L.num_slots > 12) {
+         return;
+     }
+     for (int k = 0; k < L.num_ops; k++) {
+         switch (L.ops[k].op) {
+             case OP_MOV: case OP_ADD: case OP_SUB: case OP_NEG: case OP_MUL:
+             case OP_ADDO: case OP_SUBO: case OP_NEGO: case OP_MULO:
+             case OP_LOAD: case OP_CHKIDX:
+                 break;
+             case OP_STORE:
+                 num_st++;
+                 break;
+             default:
+                 return;
+         }
+     }
+     for (int s = 0; s < L.num_slots; s++) {
+         if (L.kind[s] == VL_IND && !L.lin[s]) {
+             return;
+         }
+     }
+ 
+     // Parejas: las vueltas / 2, en (%rsp); detrás, el índice de cada STORE
+     int frame = (8 + 8 * num_st + 15) & ~15;
+     fprintf(out, "\tmovq %s, %%rax\n", native_loc(ra, in->b, buf));
+     fprintf(out, "\tmovq %s, %%rdx\n\tpushq $%d\n\tcall __gama_trips\n\tadd $8, %%rsp\n"
+                  "\tshrq $1, %%rax\n\tjz .Lv%de\n\tsub $%d, %%rsp\n\tmovq %%rax, (%%rsp)\n",
+             native_loc(ra, in->c, buf), in->d, pc, frame);
+     for (int s = 0; s < L.num_slots; s++) {
+         if (L.kind[s] == VL_INV) {
+             fprintf(out, "\tmovq %s, %%xmm%d\n\tpunpcklqdq %%xmm%d, %%xmm%d\n",
+                     native_loc(ra, L.reg[s], buf), s, s, s);
+         } else if (L.kind[s] == VL_CONST) {
+             fprintf(out, "\tmovabsq $%lld, %%rax\n\tmovq %%rax, %%xmm%d\n"
+                          "\tpunpcklqdq %%xmm%d, %%xmm%d\n", L.val[s], s, s, s);
+         }
+     }
+ 
+     fprintf(out, ".Lv%d:\n", pc);
+     for (int s = 0; s < L.num_slots; s++) {         // {x, x + paso}
+         if (L.kind[s] == VL_IND) {
+             fprintf(out, "\tmovq %s, %%rax\n\tmovq %%rax, %%xmm%d\n\taddq $%lld, %%rax\n"
+                          "\tmovq %%rax, %%xmm12\n\tpunpcklqdq %%xmm12, %%xmm%d\n",
+                     native_loc(ra, L.reg[s], buf), s, L.stride[s], s);
+         }
+     }
+     int st = 0;
+     for (int k = 0; k < L.num_ops; k++) {
+         const VLoopOp *o = &L.ops[k];
+         int A = o->a, B = o->b, C = o->c;
+         switch (o->op) {
+             case OP_MOV:
+                 fprintf(out, "\tmovdqa %%xmm%d, %%xmm%d\n", B, A);
+                 break;
+             case OP_ADD: case OP_SUB: case OP_ADDO: case OP_SUBO: {
+                 int sub = (ir_unchecked(o->op) == OP_SUB);
+                 fprintf(out, "\tmovdqa %%xmm%d, %%xmm12\n\t%s %%xmm%d, %%xmm12\n",
+                         B, sub ? "psubq" : "paddq", C);
+                 if (ir_is_checked(o->op)) {         // el signo de (x^r)&(y^r) o (x^y)&(x^r)
+                     char x2[8], y1[8];
+                     snprintf(x2, sizeof(x2), "xmm%d", sub ? C : 12);
+                     snprintf(y1, sizeof(y1), "xmm%d", sub ? B : C);
+                     fprintf(out, "\tmovdqa %%xmm%d, %%xmm13\n\tpxor %%%s, %%xmm13\n"
+                                  "\tmovdqa %%%s, %%xmm14\n\tpxor %%xmm12, %%xmm14\n"
+                                  "\tpand %%xmm14, %%xmm13\n\tmovmskpd %%xmm13, %%eax\n"
+                                  "\ttestl %%eax, %%eax\n\tjnz .Lv%da\n",
+                             B, x2, y1, pc);
+                 }
+                 fprintf(out, "\tmovdqa %%xmm12, %%xmm%d\n", A);
+                 break;
+             }
+             case OP_NEG: case OP_NEGO:
+                 fprintf(out, "\tpxor %%xmm12, %%xmm12\n\tpsubq %%xmm%d, %%xmm12\n", B);
+                 if (o->op == OP_NEGO) {             // solo -MIN: los dos negativos
+                     fprintf(out, "\tmovdqa %%xmm12, %%xmm13\n\tpand %%xmm%d, %%xmm13\n"
+                                  "\tmovmskpd %%xmm13, %%eax\n\ttestl %%eax, %%eax\n"
+                                  "\tjnz .Lv%da\n", B, pc);
+                 }
+                 fprintf(out, "\tmovdqa %%xmm12, %%xmm%d\n", A);
+                 break;
+             case OP_MUL:                            // lo*lo + ((hi*lo + lo*hi) << 32)
+                 fprintf(out, "\tmovdqa %%xmm%d, %%xmm12\n\tpsrlq $32, %%xmm12\n"
+                              "\tpmuludq %%xmm%d, %%xmm12\n\tmovdqa %%xmm%d, %%xmm13\n"
+                              "\tpsrlq $32, %%xmm13\n\tpmuludq %%xmm%d, %%xmm13\n"
+                              "\tpaddq %%xmm13, %%xmm12\n\tpsllq $32, %%xmm12\n"
+                              "\tmovdqa %%xmm%d, %%xmm13\n\tpmuludq %%xmm%d, %%xmm13\n"
+                              "\tpaddq %%xmm13, %%xmm12\n\tmovdqa %%xmm12, %%xmm%d\n",
+                         B, C, C, B, B, C, A);
+                 break;
+             case OP_MULO:                           // de uno en uno, con imul y jo
+                 fprintf(out, "\tmovq %%xmm%d, %%rax\n\tmovq %%xmm%d, %%rdx\n"
+                              "\timulq %%rdx, %%rax\n\tjo .Lv%da\n\tmovq %%rax, %%xmm12\n"
+                              "\tpshufd $0xee, %%xmm%d, %%xmm13\n\tmovq %%xmm13, %%rax\n"
+                              "\tpshufd $0xee, %%xmm%d, %%xmm13\n\tmovq %%xmm13, %%rdx\n"
+                              "\timulq %%rdx, %%rax\n\tjo .Lv%da\n\tmovq %%rax, %%xmm13\n"
+                              "\tpunpcklqdq %%xmm13, %%xmm12\n\tmovdqa %%xmm12, %%xmm%d\n",
+                         B, C, pc, B, C, pc, A);
+                 break;
+             case OP_LOAD:                           // los dos elementos: i + 1 < len
+                 if (o->fwd >= 0) {
+                     fprintf(out, "\tmovdqa %%xmm%d, %%xmm%d\n", L.ops[o->fwd].c, A);
+                     break;
+                 }
+                 fprintf(out, "\tmovq %%xmm%d, %%rax\n\tcmpq $%lld, %%rax\n\tjae .Lv%da\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rdx\n"
+                              "\tmovdqu (%%rdx,%%rax,8), %%xmm%d\n",
+                         B, arrays[C].len - 1, pc, C, A);
+                 break;
+             case OP_STORE:
+                 fprintf(out, "\tmovq %%xmm%d, %%rax\n\tcmpq $%lld, %%rax\n\tjae .Lv%da\n"
+                              "\tmovq %%rax, %d(%%rsp)\n",
+                         B, arrays[A].len - 1, pc, 8 + 8 * st++);
+                 break;
+             case OP_CHKIDX:                         // el de los dos, o el mismo
+                 fprintf(out, "\tmovq %%xmm%d, %%rax\n\tcmpq $%lld, %%rax\n\tjae .Lv%da\n",
+                         A, array_dim(&arrays[B], C) - (L.stride[A] != 0), pc);
+                 break;
+             default:
+                 break;
+         }
+     }
+ 
+     // La pareja entera ha ido bien: a memoria, en orden, y las
+     // inducciones avanzan dos vueltas
+     st = 0;
+     for (int k = 0; k < L.num_ops; k++) {
+         const VLoopOp *o = &L.ops[k];
+         if (o->op == OP_STORE) {
+             fprintf(out, "\tmovq %d(%%rsp), %%rax\n\tleaq __gama_arr_%d(%%rip), %%rdx\n"
+                          "\tmovdqu %%xmm%d, (%%rdx,%%rax,8)\n", 8 + 8 * st++, o->a, o->c);
+         }
+     }
+     for (int s = 0; s < L.num_slots; s++) {
+         if (L.kind[s] == VL_IND) {
+             fprintf(out, "\taddq $%lld, %s\n", 2 * L.stride[s], native_loc(ra, L.reg[s], buf));
+         }
+     }
+     fprintf(out, "\tdecq (%%rsp)\n\tjnz .Lv%d\n.Lv%da:\n\tadd $%d, %%rsp\n.Lv%de:\n",
+             pc, pc, frame, pc);
+ }
+ 
+ /**
+  * emit_native(p, out):
+  *   Escribe en out el ensamblador del programa p.
+  */
+ static void emit_native(const IRProgram *p, FILE *out) {
+     RegAlloc ra;
+     linear_scan(p, &ra);
+ 
+     // Qué instrucciones son destino de salto (llevan etiqueta) y qué
+     // variables se comprueban con CHKDEF (necesitan bandera "definida").
+     char *is_target   = calloc(p->num_code + 1, 1);
+     char *needs_flag  = calloc(num_vars + 1, 1);
+     int  *nuse        = ir_use_counts(p);
+     char *undeclared  = calloc(num_vars + 1, 1);
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         if (ir_is_jump(in->op)) {
+             is_target[ir_jump_target(in)] = 1;
+         }
+         if (in->op == OP_CHKDEF) {
+             needs_flag[in->a] = 1;
+             if (in->b) {
+                 undeclared[in->a] = 1;
+             }
+         }
+     }
+ 
+     fputs("# Generado por analyzer.c (backend nativo x86-64)\n", out);
+     fputs(native_runtime, out);
+     fprintf(out, "\t.section .bss\n\t.lcomm __gama_def, %d\n", num_vars + 1);
+ 
+     for (int a = 0; a < num_arrays; a++) {
+         fprintf(out, "\t.local __gama_arr_%d\n\t.comm __gama_arr_%d, %zu, 16\n",
+                 a, a, array_bytes(&arrays[a]));
+     }
+     for (int d = 0; d < num_dicts; d++) {     // un Dict de runtime.c, a cero
+         fprintf(out, "\t.local __gama_dict_%d\n\t.comm __gama_dict_%d, %zu, 8\n",
+                 d, d, sizeof(Dict));
+     }
+ 
+     // Mensajes "variable no inicializada/declarada" e "índice fuera"
+     fputs("\t.section .rodata\n", out);
+     for (int a = 0; a < num_arrays; a++) {
+         char msg[MAX_LEXEME_LEN + 64];
+         snprintf(msg, sizeof(msg), "Error: índice fuera del vector '%.*s'.\n",
+                  MAX_LEXEME_LEN - 1, arrays[a].name);
+         fprintf(out, "__gama_msg_idx_%d:\n", a);
+         emit_ascii(out, msg);
+     }
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         if (in->op == OP_DKEYS) {
+             char msg[2 * MAX_LEXEME_LEN + 64];
+             snprintf(msg, sizeof(msg), " claves de '%s' no caben en el vector '%s'.\n",
+                      dict_names[in->b], arrays[in->a].name);
+             fprintf(out, "__gama_msg_keys_%d:\n", i);
+             emit_ascii(out, msg);
+         }
+     }
+     for (int v = 0; v < num_vars; v++) {
+         if (!needs_flag[v]) {
+             continue;
+         }
+         char msg[MAX_LEXEME_LEN + 64];
+         snprintf(msg, sizeof(msg), "Error: variable '%.*s' no inicializada.\n",
+                  MAX_LEXEME_LEN - 1, symtab[v].name);
+         fprintf(out, "__gama_msg_undef_%d:\n", v);
+         emit_ascii(out, msg);
+         if (undeclared[v]) {
+             snprintf(msg, sizeof(msg), "Error: variable '%.*s' no declarada.\n",
+                  MAX_LEXEME_LEN - 1, symtab[v].name);
+             fprintf(out, "__gama_msg_undecl_%d:\n", v);
+             emit_ascii(out, msg);
+         }
+     }
+ 
+     fputs("\t.text\n\t.globl _start\n_start:\n", out);
+     fputs("\tpush %rbp\n\tmov %rsp, %rbp\n", out);
+     if (ra.num_slots > 0) {
+         fprintf(out, "\tsub $%d, %%rsp\n", ((ra.num_slots * 8) + 15) & ~15);
+     }
+ 
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         char ba[32], bb[32], bc[32];
+         const char *A = NULL, *B = NULL, *C = NULL;
+ 
+         if (is_target[i]) {
+             fprintf(out, ".L%d:\n", i);
+         }
+         int d = ir_def(in);
+         if (d >= 0) {
+             A = native_loc(&ra, d, ba);
+         }
+         int uses[2];
+         int nu = ir_uses(in, uses);
+         if (ir_reads_a(in->op)) {
+             A = native_loc(&ra, uses[0], ba);
+         } else if (nu >= 1) {
+             B = native_loc(&ra, uses[0], bb);
+             if (nu == 2) {
+                 C = native_loc(&ra, uses[1], bc);
+             }
+         }
+ 
+         switch (in->op) {
+             case OP_CONST: {
+                 long long k = p->consts[in->b];
+                 if (k >= INT_MIN && k <= INT_MAX) {
+                     fprintf(out, "\tmovq $%lld, %s\n", k, A);
+                 } else {
+                     fprintf(out, "\tmovabsq $%lld, %%rax\n\tmovq %%rax, %s\n", k, A);
+                 }
+                 break;
+             }
+             case OP_MOV:
+                 if (strcmp(A, B) == 0) {
+                     break;
+                 }
+                 if (A[0] == '%' || B[0] == '%') {
+                     fprintf(out, "\tmovq %s, %s\n", B, A);
+                 } else {
+                     fprintf(out, "\tmovq %s, %%rax\n\tmovq %%rax, %s\n", B, A);
+                 }
+                 break;
+             case OP_ADD: case OP_ADDO:
+             case OP_SUB: case OP_SUBO:
+             case OP_MUL: case OP_MULO: {
+                 OpCode      op = ir_unchecked(in->op);
+                 const char *mn = (op == OP_ADD) ? "addq" : (op == OP_SUB) ? "subq" : "imulq";
+                 const char *jo = ir_is_checked(in->op) ? "\tjo __gama_err_ovf\n" : "";
+                 // Directo sobre el destino si es un registro que no
+                 // pisa al segundo operando; si no, a través de rax.
+                 if (A[0] == '%' && strcmp(A, C) != 0) {
+                     if (strcmp(A, B) != 0) {
+                         fprintf(out, "\tmovq %s, %s\n", B, A);
+                     }
+                     fprintf(out, "\t%s %s, %s\n%s", mn, C, A, jo);
+                 } else {
+                     fprintf(out, "\tmovq %s, %%rax\n\t%s %s, %%rax\n%s\tmovq %%rax, %s\n",
+                             B, mn, C, jo, A);
+                 }
+                 break;
+             }
+             case OP_DIV: case OP_DIVO:
+                 // Entre -1 es cambiar de signo: idiv daría #DE con
+                 // LLONG_MIN
+                 fprintf(out, "\tmovq %s, %%rax\n\tcmpq $-1, %s\n\tjne 1f\n\tnegq %%rax\n%s"
+                              "\tjmp 2f\n1:\tcqto\n\tidivq %s\n2:\tmovq %%rax, %s\n",
+                         B, C, in->op == OP_DIVO ? "\tjo __gama_err_ovf\n" : "", C, A);
+                 break;
+             case OP_DIV32:                              // ni -1 ni INT_MIN: ver opt_ranges
+                 fprintf(out, "\tmovq %s, %%rax\n\tcltd\n\tidivl %s\n\tcltq\n\tmovq %%rax, %s\n",
+                         B, C[0] == '%' ? phys_reg32[ra.phys[uses[1]]] : C, A);
+                 break;
+             case OP_NEG: case OP_NEGO:
+                 fprintf(out, "\tmovq %s, %%rax\n\tnegq %%rax\n%s\tmovq %%rax, %s\n", B,
+                         in->op == OP_NEGO ? "\tjo __gama_err_ovf\n" : "", A);
+                 break;
+             case OP_EQ: case OP_NE: case OP_LT:
+             case OP_LE: case OP_GT: case OP_GE: {
+                 static const char *const cc[] = { "e", "ne", "l", "le", "g", "ge" };
+                 static const char *const ncc[] = { "ne", "e", "ge", "g", "le", "l" };
+                 fprintf(out, "\tmovq %s, %%rax\n\tcmpq %s, %%rax\n", B, C);
+                 if (cmp_jz_fusable(p, i + 1, nuse, is_target)) {
+                     // Con el JZ siguiente: salta si no se cumple
+                     fprintf(out, "\tj%s .L%d\n", ncc[in->op - OP_EQ], p->code[i + 1].b);
+                     i++;
+                     break;
+                 }
+                 fprintf(out, "\tset%s %%al\n\tmovzbl %%al, %%eax\n\tmovq %%rax, %s\n",
+                         cc[in->op - OP_EQ], A);
+                 break;
+             }
+             case OP_JMP:
+                 fprintf(out, "\tjmp .L%d\n", in->a);
+                 break;
+             case OP_JZ:
+                 fprintf(out, "\tcmpq $0, %s\n\tje .L%d\n", A, in->b);
+                 break;
+             case OP_PRINT:
+                 fprintf(out, "\tmovq %s, %%rax\n\tcall __gama_print\n", A);
+                 break;
+             case OP_READ:
+                 fprintf(out, "\tcall __gama_read\n\tmovq %%rax, %s\n", A);
+                 break;
+             case OP_TOCHR:
+                 fprintf(out, "\tmovq %s, %%rax\n\tmovsbq %%al, %%rax\n\tmovq %%rax, %s\n", B, A);
+                 break;
+             case OP_PRINTC:
+                 fprintf(out, "\tmovq %s, %%rax\n\tcall __gama_putc\n", A);
+                 break;
+             case OP_READC:
+                 fprintf(out, "\tcall __gama_readc\n\tmovq %%rax, %s\n", A);
+                 break;
+             case OP_LOAD: case OP_LOADC:
+                 fprintf(out, "\tmovq %s, %%rax\n\tleaq __gama_arr_%d(%%rip), %%rdx\n"
+                              "\t%s (%%rdx,%%rax%s), %%rax\n\tmovq %%rax, %s\n",
+                         B, in->c, in->op == OP_LOAD ? "movq" : "movsbq",
+                         in->op == OP_LOAD ? ",8" : "", A);
+                 break;
+             case OP_STORE: case OP_STOREC:
+                 fprintf(out, "\tmovq %s, %%rax\n\tleaq __gama_arr_%d(%%rip), %%rdx\n"
+                              "\tleaq (%%rdx,%%rax%s), %%rdx\n\tmovq %s, %%rax\n\t%s, (%%rdx)\n",
+                         B, in->a, in->op == OP_STORE ? ",8" : "", C,
+                         in->op == OP_STORE ? "movq %rax" : "movb %al");
+                 break;
+             case OP_CHKIDX:                     // sin signo: un negativo también sale
+                 fprintf(out, "\tcmpq $%lld, %s\n\tjae __gama_idx_%d\n",
+                         array_dim(&arrays[in->b], in->d), A, in->b);
+                 break;
+             case OP_ZERO:                       // rdi y rcx pueden tener registros
+                 fprintf(out, "\tpush %%rdi\n\tpush %%rcx\n\tleaq __gama_arr_%d(%%rip), %%rdi\n"
+                              "\tmovabsq $%zu, %%rcx\n\txor %%eax, %%eax\n\trep stosb\n"
+                              "\tpop %%rcx\n\tpop %%rdi\n",
+                         in->a, array_bytes(&arrays[in->a]));
+                 break;
+             case OP_FILL:                       // el valor antes de pisar rdi y rcx
+                 fprintf(out, "\tmovq %s, %%rax\n\tpush %%rdi\n\tpush %%rcx\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rdi\n\tmovq $%lld, %%rcx\n"
+                              "\trep %s\n\tpop %%rcx\n\tpop %%rdi\n",
+                         B, in->a, arrays[in->a].len,
+                         arrays[in->a].type == TYPE_CHAR ? "stosb" : "stosq");
+                 break;
+             case OP_ASUM: case OP_ADOT: case OP_AMIN: case OP_AMAX: {
+                 static const char *const vec_fn[] = { "sum", "dot", "min", "max" };
+                 int chr = (arrays[in->b].type == TYPE_CHAR);
+                 if (in->op == OP_ADOT) {
+                     fprintf(out, "\tleaq __gama_arr_%d(%%rip), %%rax\n\tpush %%rax\n", in->c);
+                 }
+                 fprintf(out, "\tleaq __gama_arr_%d(%%rip), %%rax\n\tmovq $%lld, %%rdx\n"
+                              "\tcall __gama_v%s%s\n",
+                         in->b, arrays[in->b].len, vec_fn[in->op - OP_ASUM], chr ? "c" : "");
+                 if (in->op == OP_ADOT) {
+                     fputs("\tadd $8, %rsp\n", out);
+                 }
+                 if (!chr && !int_wrap && (in->op == OP_ASUM || in->op == OP_ADOT)) {
+                     fputs("\ttestq %rdx, %rdx\n\tjnz __gama_err_ovf\n", out);
+                 }
+                 fprintf(out, "\tmovq %%rax, %s\n", A);
+                 break;
+             }
+             case OP_AFIND:                      // x en la pila, como el otro vector de ADOT
+                 fprintf(out, "\tpushq %s\n\tleaq __gama_arr_%d(%%rip), %%rax\n"
+                              "\tmovq $%lld, %%rdx\n\tcall __gama_vfind%s\n"
+                              "\tadd $8, %%rsp\n\tmovq %%rax, %s\n",
+                         B, in->c, arrays[in->c].len,
+                         arrays[in->c].type == TYPE_CHAR ? "c" : "", A);
+                 break;
+             case OP_SORT:
+                 fprintf(out, "\tleaq __gama_arr_%d(%%rip), %%rax\n\tmovq $%lld, %%rdx\n"
+                              "\tcall __gama_vsort%s\n",
+                         in->a, arrays[in->a].len, arrays[in->a].type == TYPE_CHAR ? "c" : "");
+                 break;
+             case OP_MATMUL: {                   // c = a * b; a es N x K y b es K x M
+                 const Array *x = &arrays[in->b], *y = &arrays[in->c];
+                 fprintf(out, "\tpushq $%lld\n\tpushq $%lld\n\tpushq $%lld\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rax\n\tpush %%rax\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rax\n\tpush %%rax\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rax\n\tcall __gama_mmul%s\n"
+                              "\tadd $40, %%rsp\n",
+                         y->cols, x->cols, x->len / x->cols, in->c, in->b, in->a,
+                         int_wrap ? "w" : "");
+                 if (!int_wrap) {
+                     fputs("\ttestq %rdx, %rdx\n\tjnz __gama_err_ovf\n", out);
+                 }
+                 break;
+             }
+             case OP_TRANSP: {
+                 const Array *x = &arrays[in->b];
+                 fprintf(out, "\tpushq $%lld\n\tpushq $%lld\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rax\n\tpush %%rax\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rax\n\tcall __gama_mtr%s\n"
+                              "\tadd $24, %%rsp\n",
+                         x->len / x->cols, x->cols, in->b, in->a,
+                         x->type == TYPE_CHAR ? "c" : "");
+                 break;
+             }
+             case OP_DNEW:
+                 fprintf(out, "\tleaq __gama_dict_%d(%%rip), %%rax\n\tcall __gama_dnew\n", in->a);
+                 break;
+             case OP_DGET: case OP_DHAS:
+                 fprintf(out, "\tmovq %s, %%rdx\n\tleaq __gama_dict_%d(%%rip), %%rax\n"
+                              "\tcall __gama_d%s\n\tmovq %%rax, %s\n",
+                         B, in->c, in->op == OP_DGET ? "get" : "has", A);
+                 break;
+             case OP_DSET:                       // el valor en la pila
+                 fprintf(out, "\tpushq %s\n\tmovq %s, %%rdx\n\tleaq __gama_dict_%d(%%rip), %%rax\n"
+                              "\tcall __gama_dset\n\tadd $8, %%rsp\n",
+                         C, B, in->a);
+                 break;
+             case OP_DDEL:
+                 fprintf(out, "\tmovq %s, %%rdx\n\tleaq __gama_dict_%d(%%rip), %%rax\n"
+                              "\tcall __gama_ddel\n",
+                         B, in->a);
+                 break;
+             case OP_DLEN:
+                 fprintf(out, "\tmovq __gama_dict_%d+%zu(%%rip), %%rax\n\tmovq %%rax, %s\n",
+                         in->b, offsetof(Dict, len), A);
+                 break;
+             case OP_DKEYS:
+                 fprintf(out, "\tcmpq $%lld, __gama_dict_%d+%zu(%%rip)\n\tjg __gama_keys_%d\n"
+                              "\tleaq __gama_dict_%d(%%rip), %%rax\n"
+                              "\tleaq __gama_arr_%d(%%rip), %%rdx\n\tcall __gama_dkeys\n",
+                         arrays[in->a].len, in->b, offsetof(Dict, len), i, in->b, in->a);
+                 break;
+             default:                            // Flotante: lo rechaza build_native
+                 break;
+             case OP_UNDEF:
+                 if (needs_flag[in->a]) {
+                     fprintf(out, "\tmovb $0, __gama_def+%d(%%rip)\n", in->a);
+                 }
+                 break;
+             case OP_CHKDEF:
+                 fprintf(out, "\tcmpb $0, __gama_def+%d(%%rip)\n\tje __gama_%s_%d\n",
+                         in->a, in->b ? "undecl" : "undef", in->a);
+                 break;
+             case OP_CHKDIV:
+                 fprintf(out, "\tcmpq $0, %s\n\tje __gama_err_div\n", A);
+                 break;
+             case OP_TRIPS:
+                 fprintf(out, "\tmovq %s, %%rax\n\tmovq %s, %%rdx\n\tpushq $%d\n"
+                              "\tcall __gama_trips\n\tadd $8, %%rsp\n\tmovq %%rax, %s\n",
+                         B, C, in->d, A);
+                 break;
+             case OP_POWSUM:
+                 fprintf(out, "\tmovq %s, %%rax\n\tmovl $%d, %%edx\n"
+                              "\tcall __gama_powsum\n\tmovq %%rax, %s\n",
+                         B, in->c, A);
+                 break;
+             case OP_BOUND:
+                 fprintf(out, "\tmovq %s, %%rax\n\tmovq %s, %%rdx\n"
+                              "\tcall __gama_b%s\n\tmovq %%rax, %s\n",
+                         B, C, in->d ? "mul" : "add", A);
+                 break;
+             case OP_VLOOP:
+                 emit_native_vloop(p, i, &ra, out);
+                 break;
+             case OP_HALT:
+                 fputs("\tjmp __gama_exit\n", out);
+                 break;
+             case OP_PHI:                        // no llega: se sale antes de SSA
+                 break;
+         }
+ 
+         // Toda escritura en una variable comprobada la marca definida
+         if (d >= 0 && d < num_vars && in->op != OP_UNDEF && needs_flag[d]) {
+             fprintf(out, "\tmovb $1, __gama_def+%d(%%rip)\n", d);
+         }
+     }
+ 
+     // Salidas de error por variable y por vector
+     for (int v = 0; v < num_vars; v++) {
+         if (!needs_flag[v]) {
+             continue;
+         }
+         char msg[MAX_LEXEME_LEN + 64];
+         snprintf(msg, sizeof(msg), "Error: variable '%.*s' no inicializada.\n",
+                  MAX_LEXEME_LEN - 1, symtab[v].name);
+         fprintf(out, "__gama_undef_%d:\n\tlea __gama_msg_undef_%d(%%rip), %%rsi\n"
+                      "\tmov $%d, %%edx\n\tjmp __gama_die\n",
+                 v, v, (int)strlen(msg));
+         if (undeclared[v]) {
+             snprintf(msg, sizeof(msg), "Error: variable '%.*s' no declarada.\n",
+                  MAX_LEXEME_LEN - 1, symtab[v].name);
+             fprintf(out, "__gama_undecl_%d:\n\tlea __gama_msg_undecl_%d(%%rip), %%rsi\n"
+                          "\tmov $%d, %%edx\n\tjmp __gama_die\n",
+                     v, v, (int)strlen(msg));
+         }
+     }
+ 
+     for (int a = 0; a < num_arrays; a++) {
+         char msg[MAX_LEXEME_LEN + 64];
+         snprintf(msg, sizeof(msg), "Error: índice fuera del vector '%.*s'.\n",
+                  MAX_LEXEME_LEN - 1, arrays[a].name);
+         fprintf(out, "__gama_idx_%d:\n\tlea __gama_msg_idx_%d(%%rip), %%rsi\n"
+                      "\tmov $%d, %%edx\n\tjmp __gama_die\n",
+                 a, a, (int)strlen(msg));
+     }
+ 
+     // Y por cada Claves: "Error: las N" lo escribe __gama_err_keys
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         if (in->op != OP_DKEYS) {
+             continue;
+         }
+         char msg[2 * MAX_LEXEME_LEN + 64];
+         snprintf(msg, sizeof(msg), " claves de '%s' no caben en el vector '%s'.\n",
+                  dict_names[in->b], arrays[in->a].name);
+         fprintf(out, "__gama_keys_%d:\n\tmovq __gama_dict_%d+%zu(%%rip), %%rax\n"
+                      "\tlea __gama_msg_keys_%d(%%rip), %%rsi\n"
+                      "\tmov $%d, %%edx\n\tjmp __gama_err_keys\n",
+                 i, in->b, offsetof(Dict, len), i, (int)strlen(msg));
+     }
+ 
+     free(is_target);
+     free(nuse);
+     free(needs_flag);
+     free(undeclared);
+     free(ra.phys);
+     free(ra.slot);
+ }
+ 
+ 
+ /*==============================================================
+  *        MÁQUINA VIRTUAL DEL IR Y JIT DE TRAZAS (x86-64)
+  *=============================================================*/
+ 
+ /*--------------------------------------------------------------
+  * Ejecución por niveles:
+  *   nivel 0: el intérprete de tokens (arranque inmediato, sin
+  *            compilar nada); cuenta vueltas de cada Mientras y
+  *            resultados de cada Si.
+  *   nivel 1: la VM del IR, para los Mientras calientes.
+  *   nivel 2: trazas nativas, para los bucles internos calientes
+  *            dentro de la VM.
+  * Un programa corto nunca paga la compilación; "--stats" muestra
+  * qué se promovió, cuándo y cuánto costó.
+  *
+  * Un Mientras que el intérprete de tokens repite muchas veces se
+  * compila a IR (una "región" que contiene el bucle entero) y se
+  * ejecuta en esta máquina virtual, que ya no vuelve a parsear nada.
+  *
+  * Dentro de la VM cada salto hacia atrás cuenta una vuelta de su
+  * bucle. Pasado TRACE_THRESHOLD se graba una traza: la secuencia
+  * lineal de instrucciones de UNA vuelta, con el camino que tomó
+  * cada Si. La traza se compila a código x86-64 en el que cada
+  * decisión grabada es una guarda: si en otra vuelta la condición
+  * sale distinta (o hay división por cero, variable sin valor…),
+  * el código nativo devuelve el pc donde debe seguir la VM.
+  *
+  * El código nativo trabaja directamente sobre los registros de la
+  * VM, así que al salir por una guarda no hay estado que reconstruir:
+  * la VM continúa desde ese pc como si la traza no hubiera existido.
+  *
+  * Con --bigint la VM y las trazas siguen con 64 bits. Las
+  * operaciones comprobadas que se desbordan devuelven VM_DEOPT y la
+  * región vuelve al intérprete: las variables que escribe se dejan
+  * como estaban al empezar la vuelta del bucle exterior (las guarda
+  * la VM, y la traza de ese bucle si la hay, al pasar por su
+  * cabecera) y lo impreso en esa vuelta, que se retenía en
+  * out_held, se olvida. El intérprete repite la vuelta con BigInt y
+  * el bucle se puede volver a promover: si la VM ha aguantado pocas
+  * vueltas, el intérprete hace antes otras tantas (el doble cada vez
+  * que pasa, hasta MAX_BACKOFF). Si al entrar alguna variable de la
+  * región ya es un BigInt, se usa una segunda versión de la región
+  * (rg->variant) compilada con region_big: esas variables se quedan
+  * en symtab, la VM las ve como VM_UNDEF y su CHKDEF vuelve al
+  * intérprete si de verdad se leen. Un Leer no se puede repetir (ni
+  * deshacer lo escrito en un vector), así que con --bigint las
+  * regiones que leen o escriben en un vector se quedan en el
+  * intérprete.
+  *
+  * Los registros de la VM son long long: un Entero tal cual, los
+  * Flotante con los bits del double, y VM_UNDEF marca una variable
+  * sin valor. VM_UNDEF es un NaN "señalizador" que ninguna operación
+  * produce, así que no se confunde con ningún real (LLONG_MIN serían
+  * los bits de -0.0). Como Entero es 9219994337134247936: solo se
+  * mira en los CHKDEF de las variables que pueden no tener valor, y
+  * una que valga justo eso daría un falso "no inicializada".
+  *-------------------------------------------------------------*/
+ 
+ #define HOT_LOOP_THRESHOLD    8    // vueltas en el intérprete antes de compilar
+ #define TRACE_THRESHOLD      16    // vueltas en la VM antes de grabar una traza
+ #define MAX_TRACE_LEN       512    // instrucciones por traza
+ #define MAX_TRACE_ABORTS      3    // intentos fallidos antes de desistir
+ #define MAX_BACKOFF        1024    // vueltas en el intérprete tras volver de la VM
+ 
+ #define VM_UNDEF 0x7FF4000000000000LL
+ #define VM_DEOPT (-2)              // pc para volver al intérprete (--bigint)
+ 
+ typedef int (*TraceFn)(long long *regs);
+ 
+ typedef struct {
+     TraceFn fn;
+     void   *mem;          // memoria ejecutable (mmap)
+     size_t  size;
+     int     length;       // instrucciones IR grabadas
+     double  created_us;   // momento de la promoción (desde el arranque)
+     double  compile_us;
+     long    entries;      // veces que la VM entró en la traza
+     long    side_exits;   // salidas por una guarda que no es el fin del bucle
+ } JitTrace;
+ 
+ typedef struct LoopRegion {
+     IRProgram  *ir;
+     int         end_token;    // primer token después del bucle
+     int         num_vars;     // variables que comparte con symtab
+     long long  *regs;         // registros de la VM
+     int        *hits;         // vueltas por cabecera de bucle (índice = pc)
+     int        *aborts;       // grabaciones fallidas por cabecera
+     JitTrace  **traces;       // traza compilada por cabecera, o NULL
+     long       *jz_taken;     // perfil de saltos (solo con --stats)
+     long       *jz_fallthru;
+     long long   executed;     // instrucciones IR ejecutadas en la VM (--stats)
+     long long   peep_saved;   //   y las que se habría ejecutado sin la mirilla
+     double      created_us;   // momento de la promoción
+     double      compile_us;
+     double      run_us;       // tiempo total dentro de la VM
+     long        entries;
+     int         restart;      // --bigint: cabecera del bucle exterior, o -1
+     int        *saved;        //   variables que escribe la región
+     int         num_saved;    //   (su copia va en regs[num_regs + 1 + v];
+                               //   regs[num_regs] cuenta las vueltas)
+     char       *touched;      //   1 si la región lee o escribe la variable
+     long        deopts;       //   veces que no pudo seguir con 64 bits
+     int         interp_only;  //   lee o escribe vectores: no entra en la VM
+     long        wait;         //   vueltas que faltan en el intérprete
+     long        backoff;      //   y las que tocan tras otra vuelta rápida
+     char       *big;          //   region_big con el que se compiló, o NULL
+     struct LoopRegion *variant;  // versión con guardas para los BigInt
+ } LoopRegion;
+ 
+ static LoopRegion *loop_regions[MAX_TOKENS];  // índice = token 'Mientras'
+ static int         loop_hits[MAX_TOKENS];     // vueltas en el intérprete
+ static long        if_true[MAX_TOKENS];       // resultados de cada Si
+ static long        if_false[MAX_TOKENS];      //   en el intérprete
+ static int         jit_enabled   = 1;         // --no-jit lo desactiva
+ static int         stats_enabled = 0;         // --stats
+ static double      start_us;
+ 
+ /**
+  * loop_is_hot(while_pos):
+  *   Cuenta una vuelta del Mientras que empieza en while_pos y dice
+  *   si ya conviene ejecutarlo en la VM.
+  */
+ static int loop_is_hot(int while_pos) {
+     LoopRegion *rg = loop_regions[while_pos];
+     if (rg != NULL) {
+         if (rg->wait > 0) {
+             rg->wait--;
+             return 0;
+         }
+         return !rg->interp_only;
+     }
+     return ++loop_hits[while_pos] > HOT_LOOP_THRESHOLD && jit_enabled;
+ }
+ 
+ /**
+  * profile_branch(if_pos, cond):
+  *   Anota el resultado de un Si evaluado por el intérprete.
+  */
+ static void profile_branch(int if_pos, int cond) {
+     if (cond) {
+         if_true[if_pos]++;
+     } else {
+         if_false[if_pos]++;
+     }
+ }
+ 
+ /**
+  * vm_int(v):
+  *   Aritmética entera de 64 bits con desbordamiento "envolvente"
+  *   (como gcc -fwrapv, pero sin comportamiento indefinido).
+  */
+ static inline long long vm_int(unsigned long long v) {
+     return (long long)v;
+ }
+ 
+ /**
+  * vm_f(v), vm_bits(x):
+  *   Un registro de la VM visto como Flotante y al revés.
+  */
+ static inline double vm_f(long long v) {
+     double x;
+     memcpy(&x, &v, sizeof(x));
+     return x;
+ }
+ 
+ static inline long long vm_bits(double x) {
+     long long v;
+     memcpy(&v, &x, sizeof(v));
+     return v;
+ }
+ 
+ static void vm_error_undef(const Instr *in) {
+     fprintf(stderr, "Error: variable '%s' no %s.\n",
+             symtab[in->a].name, in->b ? "declarada" : "inicializada");
+     exit(1);
+ }
+ 
+ // Sin --bigint es un error; con él, la vuelta se repite en el
+ // intérprete
+ static int vm_overflow(void) {
+     if (!int_big) {
+         int_overflow();
+     }
+     return VM_DEOPT;
+ }
+ 
+ static void vm_print(long long v) {
+     out_printf("%lld\n", v);
+ }
+ 
+ // No pasa por read_value(): el Value de un Entero ancho ocuparía una
+ // celda de wide_cell[] que nadie recoge mientras se ejecuta la VM
+ static void vm_read(long long *dst) {
+     long long x;
+     errno = 0;
+     if (scanf("%lld", &x) != 1 || errno == ERANGE) {
+         fprintf(stderr, "Error de runtime: no se pudo leer un entero.\n");
+         exit(1);
+     }
+     *dst = x;
+ }
+ 
+ static void vm_print_float(long long v) {
+     print_value(val_from_float(vm_f(v)));
+ }
+ 
+ static void vm_print_char(long long v) {
+     print_value(val_from_char((int)v));
+ }
+ 
+ static void vm_read_float(long long *dst) {
+     *dst = vm_bits(val_float(read_value(TYPE_FLOAT)));
+ }
+ 
+ static void vm_read_char(long long *dst) {
+     *dst = val_int(read_value(TYPE_CHAR));
+ }
+ 
+ #if SIMD_AVAILABLE
+ 
+ /*
+  * Un OP_VLOOP en la VM (ver vloop_scan): el cuerpo por carriles, de
+  * VLOOP_CHUNK vueltas en VLOOP_CHUNK vueltas. Cada operación recorre
+  * sus carriles de 4 en 4 con los vectores de gcc; vloop_lanes() se
+  * compila una vez con AVX2 y otra con SSE4.2 y simd_level elige
+  * (con --simd=no, VLOOP no hace nada y todo va por el bucle escalar).
+  */
+ #define VLOOP_CHUNK 64     // vueltas por tanda
+ #define VLOOP_MIN   16     // con menos no compensa vloop_scan()
+ 
+ typedef long long          vl_i64 __attribute__((vector_size(32), may_alias, aligned(8)));
+ typedef unsigned long long vl_u64 __attribute__((vector_size(32), may_alias, aligned(8)));
+ typedef double             vl_f64 __attribute__((vector_size(32), may_alias, aligned(8)));
+ 
+ static long long vloop_lane[VLOOP_MAX_SLOTS][VLOOP_CHUNK] __attribute__((aligned(32)));
+ 
+ #define VL_I(x, j) (*(vl_i64 *)&(x)[j])
+ #define VL_U(x, j) (*(vl_u64 *)&(x)[j])
+ #define VL_F(x, j) (*(vl_f64 *)&(x)[j])
+ 
+ /* 1 si los carriles i0..i0+m-1 son índices del vector v */
+ static inline int vloop_in(long long len, long long i0, int m) {
+     return i0 >= 0 && i0 <= len - m;
+ }
+ 
+ static inline __attribute__((always_inline)) void vloop_copy(long long *dst, const long long *src,
+                                                             int m) {
+     for (int j = 0; j < m; j += 4) {
+         VL_U(dst, j) = VL_U(src, j);
+     }
+ }
+ 
+ /**
+  * vloop_chunk(L, m):
+  *   Una tanda de m vueltas (múltiplo de 4) sobre vloop_lane[].
+  *   Devuelve 0 si hay que abandonarla (un desbordamiento o un índice
+  *   fuera); entonces no ha escrito nada en los vectores.
+  *
+  *   Cada casilla se lee por lp[]: su fila de vloop_lane[] o, tras un
+  *   LOAD de Entero o Flotante, los elementos del vector mismo (no
+  *   cambian hasta el final de la tanda, así que no se copian).
+  */
+ static inline __attribute__((always_inline)) int vloop_chunk(const VLoop *L, int m) {
+     const long long *lp[VLOOP_MAX_SLOTS];
+     long long        at[VLOOP_MAX_BODY * 2];
+     for (int s = 0; s < L->num_slots; s++) {
+         lp[s] = vloop_lane[s];
+     }
+     for (int k = 0; k < L->num_ops; k++) {
+         const VLoopOp   *o   = &L->ops[k];
+         long long       *A   = vloop_lane[o->a];
+         const long long *B   = lp[o->b];
+         const long long *C   = lp[o->c];
+         vl_i64           ovf = { 0, 0, 0, 0 };
+         switch (o->op) {
+             case OP_MOV:
+                 vloop_copy(A, B, m);
+                 break;
+             case OP_ADD:
+                 for (int j = 0; j < m; j += 4) {
+                     VL_U(A, j) = VL_U(B, j) + VL_U(C, j);
+                 }
+                 break;
+             case OP_ADDO:
+                 for (int j = 0; j < m; j += 4) {
+                     vl_u64 x = VL_U(B, j), y = VL_U(C, j), r = x + y;
+                     ovf |= (vl_i64)((x ^ r) & (y ^ r));
+                     VL_U(A, j) = r;
+                 }
+                 break;
+             case OP_SUB:
+                 for (int j = 0; j < m; j += 4) {
+                     VL_U(A, j) = VL_U(B, j) - VL_U(C, j);
+                 }
+                 break;
+             case OP_SUBO:
+                 for (int j = 0; j < m; j += 4) {
+                     vl_u64 x = VL_U(B, j), y = VL_U(C, j), r = x - y;
+                     ovf |= (vl_i64)((x ^ y) & (x ^ r));
+                     VL_U(A, j) = r;
+                 }
+                 break;
+             case OP_NEG:
+                 for (int j = 0; j < m; j += 4) {
+                     VL_U(A, j) = -VL_U(B, j);
+                 }
+                 break;
+             case OP_NEGO:
+                 for (int j = 0; j < m; j += 4) {
+                     vl_u64 x = VL_U(B, j), r = -x;
+                     ovf |= (vl_i64)(x & r);
+                     VL_U(A, j) = r;
+                 }
+                 break;
+             case OP_MUL:
+                 for (int j = 0; j < m; j += 4) {
+                     VL_U(A, j) = VL_U(B, j) * VL_U(C, j);
+                 }
+                 break;
+             case OP_MULO: {
+                 // Si todos caben en 32 bits los productos caben en 64;
+                 // si no, de uno en uno con la comprobación de siempre
+                 vl_u64 w = { 0, 0, 0, 0 };
+                 for (int j = 0; j < m; j += 4) {
+                     w |= (VL_U(B, j) + 0x80000000ULL) | (VL_U(C, j) + 0x80000000ULL);
+                 }
+                 w >>= 32;
+                 if ((w[0] | w[1] | w[2] | w[3]) == 0) {
+                     for (int j = 0; j < m; j += 4) {
+                         VL_U(A, j) = VL_U(B, j) * VL_U(C, j);
+                     }
+                     break;
+                 }
+                 for (int j = 0; j < m; j++) {
+                     if (__builtin_mul_overflow(B[j], C[j], &A[j])) {
+                         return 0;
+                     }
+                 }
+                 break;
+             }
+             case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+                 for (int j = 0; j < m; j += 4) {
+                     vl_i64 x = VL_I(B, j), y = VL_I(C, j);
+                     vl_i64 r = (o->op == OP_EQ) ? (x == y) : (o->op == OP_NE) ? (x != y)
+                              : (o->op == OP_LT) ? (x <  y) : (o->op == OP_LE) ? (x <= y)
+                              : (o->op == OP_GT) ? (x >  y) : (x >= y);
+                     VL_I(A, j) = -r;
+                 }
+                 break;
+             case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV:
+                 for (int j = 0; j < m; j += 4) {
+                     vl_f64 x = VL_F(B, j), y = VL_F(C, j);
+                     VL_F(A, j) = (o->op == OP_FADD) ? x + y : (o->op == OP_FSUB) ? x - y
+                                : (o->op == OP_FMUL) ? x * y : x / y;
+                 }
+                 break;
+             case OP_FNEG:
+                 for (int j = 0; j < m; j += 4) {
+                     VL_F(A, j) = -VL_F(B, j);
+                 }
+                 break;
+             case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+                 for (int j = 0; j < m; j += 4) {
+                     vl_f64 x = VL_F(B, j), y = VL_F(C, j);
+                     vl_i64 r = (o->op == OP_FEQ) ? (x == y) : (o->op == OP_FNE) ? (x != y)
+                              : (o->op == OP_FLT) ? (x <  y) : (o->op == OP_FLE) ? (x <= y)
+                              : (o->op == OP_FGT) ? (x >  y) : (x >= y);
+                     VL_I(A, j) = -r;
+                 }
+                 break;
+             case OP_ITOF:
+                 for (int j = 0; j < m; j += 4) {
+                     VL_F(A, j) = __builtin_convertvector(VL_I(B, j), vl_f64);
+                 }
+                 break;
+             case OP_FTOI:
+                 for (int j = 0; j < m; j++) {
+                     A[j] = float_to_int(vm_f(B[j]));
+                 }
+                 break;
+             case OP_TOCHR:
+                 for (int j = 0; j < m; j++) {
+                     A[j] = (signed char)B[j];
+                 }
+                 break;
+             case OP_LOAD: case OP_LOADC: {
+                 const Array *v  = &arrays[o->c];
+                 long long    i0 = B[0];
+                 if (!vloop_in(v->len, i0, m)) {
+                     return 0;
+                 }
+                 if (o->fwd >= 0) {                  // lo que guardó el STORE
+                     const long long *w = lp[L->ops[o->fwd].c];
+                     if (o->op == OP_LOAD) {
+                         lp[o->a] = w;
+                         continue;
+                     }
+                     for (int j = 0; j < m; j++) {
+                         A[j] = (signed char)w[j];
+                     }
+                 } else if (o->op == OP_LOAD) {
+                     lp[o->a] = (const long long *)v->data + i0;
+                     continue;
+                 } else {
+                     for (int j = 0; j < m; j++) {
+                         A[j] = ((const signed char *)v->data)[i0 + j];
+                     }
+                 }
+                 break;
+             }
+             case OP_STORE: case OP_STOREC:
+                 // Lo que se guarda, en su fila: si apunta a un vector,
+                 // otro STORE podría pisarlo antes de llegar a memoria
+                 at[k] = lp[o->b][0];
+                 if (!vloop_in(arrays[o->a].len, at[k], m)) {
+                     return 0;
+                 }
+                 if (C != vloop_lane[o->c]) {
+                     vloop_copy(vloop_lane[o->c], C, m);
+                     lp[o->c] = vloop_lane[o->c];
+                 }
+                 continue;
+             case OP_CHKIDX:
+                 if (!vloop_in(array_dim(&arrays[o->b], o->c), lp[o->a][0],
+                               L->stride[o->a] ? m : 1)) {
+                     return 0;
+                 }
+                 continue;
+             default:
+                 break;
+         }
+         if (ir_is_checked(o->op) && (ovf[0] | ovf[1] | ovf[2] | ovf[3]) < 0) {
+             return 0;
+         }
+         lp[o->a] = A;
+     }
+ 
+     // La tanda entera ha ido bien: lo guardado va a memoria, en orden
+     for (int k = 0; k < L->num_ops; k++) {
+         const VLoopOp *o = &L->ops[k];
+         if (o->op == OP_STORE) {
+             vloop_copy((long long *)arrays[o->a].data + at[k], vloop_lane[o->c], m);
+         } else if (o->op == OP_STOREC) {
+             signed char *dst = (signed char *)arrays[o->a].data + at[k];
+             for (int j = 0; j < m; j++) {
+                 dst[j] = (signed char)vloop_lane[o->c][j];
+             }
+         }
+     }
+     return 1;
+ }
+ 
+ /**
+  * vloop_lanes(L, regs, t):
+  *   Hace por tandas hasta t vueltas del bucle L (mientras quedan
+  *   para una y ninguna falla) y deja en regs las variables de
+  *   inducción como las deja la última tanda entera.
+  */
+ static inline __attribute__((always_inline)) void vloop_lanes(const VLoop *L, long long *regs,
+                                                              long long t) {
+     for (int s = 0; s < L->num_slots; s++) {
+         if (L->kind[s] == VL_INV || L->kind[s] == VL_CONST) {
+             long long x = (L->kind[s] == VL_INV) ? regs[L->reg[s]] : L->val[s];
+             for (int j = 0; j < VLOOP_CHUNK; j++) {
+                 vloop_lane[s][j] = x;
+             }
+         }
+     }
+     while (t >= 4) {
+         int m = (t < VLOOP_CHUNK) ? (int)(t & ~3LL) : VLOOP_CHUNK;
+         // El carril j empieza con lo que vale la inducción en la
+         // vuelta j. Si eso se desborda, su ADDO del cuerpo también
+         for (int s = 0; s < L->num_slots; s++) {
+             if (L->kind[s] == VL_IND) {
+                 unsigned long long d = (unsigned long long)L->stride[s];
+                 unsigned long long x = (unsigned long long)regs[L->reg[s]];
+                 vl_u64             v = { x, x + d, x + 2 * d, x + 3 * d };
+                 for (int j = 0; j < m; j += 4) {
+                     VL_U(vloop_lane[s], j) = v;
+                     v += 4 * d;
+                 }
+             }
+         }
+         if (!vloop_chunk(L, m)) {
+             return;
+         }
+         for (int s = 0; s < L->num_slots; s++) {
+             if (L->kind[s] == VL_IND) {
+                 regs[L->reg[s]] = vloop_lane[s][m - 1];
+             }
+         }
+         t -= m;
+     }
+ }
+ 
+ __attribute__((target("avx2")))
+ static void vloop_lanes_avx2(const VLoop *L, long long *regs, long long t) {
+     vloop_lanes(L, regs, t);
+ }
+ 
+ __attribute__((target("sse4.2")))
+ static void vloop_lanes_sse(const VLoop *L, long long *regs, long long t) {
+     vloop_lanes(L, regs, t);
+ }
+ 
+ #define VLOOP_CACHE 16     // análisis guardados (por pc del VLOOP)
+ 
+ typedef struct {
+     const IRProgram *p;
+     int              pc, ok;
+     VLoop            L;
+ } VLoopCache;
+ 
+ static VLoopCache vloop_cache[VLOOP_CACHE];
+ 
+ /**
+  * vloop_run(p, pc, regs):
+  *   Ejecuta el OP_VLOOP de code[pc] con el núcleo de simd_level.
+  */
+ static void vloop_run(const IRProgram *p, int pc, long long *regs) {
+     const Instr *in = &p->code[pc];
+     long long    t  = ir_trips(regs[in->b], regs[in->c], in->d);
+     if (simd_level == SIMD_SCALAR || t < VLOOP_MIN) {
+         return;
+     }
+     // El análisis de la vez anterior sirve si los invariantes que
+     // consultó no han cambiado
+     VLoopCache *e = &vloop_cache[pc % VLOOP_CACHE];
+     int         k = 0;
+     if (e->p == p && e->pc == pc) {
+         while (k < e->L.num_deps && regs[e->L.dep[k]] == e->L.dep_val[k]) {
+             k++;
+         }
+     }
+     if (e->p != p || e->pc != pc || k < e->L.num_deps) {
+         e->p  = p;
+         e->pc = pc;
+         e->ok = vloop_scan(p, pc + 1, pc + in->a, regs, &e->L);
+     }
+     if (!e->ok) {
+         return;
+     }
+     if (simd_level == SIMD_AVX2) {
+         vloop_lanes_avx2(&e->L, regs, t);
+     } else {
+         vloop_lanes_sse(&e->L, regs, t);
+     }
+ }
+ 
+ #endif
+ 
+ /* Olvida los análisis de p (ir_free): otro programa podría acabar
+    en la misma dirección */
+ static void vloop_forget(const IRProgram *p) {
+ #if SIMD_AVAILABLE
+     for (int k = 0; k < VLOOP_CACHE; k++) {
+         if (vloop_cache[k].p == p) {
+             vloop_cache[k].p = NULL;
+         }
+     }
+ #else
+     (void)p;
+ #endif
+ }
+ 
+ /**
+  * vm_exec(p, pc, regs):
+  *   Ejecuta la instrucción p->code[pc] y devuelve el pc siguiente
+  *   (-1 tras HALT, VM_DEOPT si hay que volver al intérprete). La
+  *   usan tanto el bucle de la VM como la grabación de trazas, así la
+  *   semántica está en un solo sitio.
+  */
+ static inline int vm_exec(const IRProgram *p, int pc, long long *regs) {
+     const Instr *in = &p->code[pc];
+     switch (in->op) {
+         case OP_CONST:
+             regs[in->a] = p->consts[in->b];
+             break;
+         case OP_MOV:
+             regs[in->a] = regs[in->b];
+             break;
+         case OP_ADD:
+             regs[in->a] = vm_int((unsigned long long)regs[in->b] +
+                                  (unsigned long long)regs[in->c]);
+             break;
+         case OP_SUB:
+             regs[in->a] = vm_int((unsigned long long)regs[in->b] -
+                                  (unsigned long long)regs[in->c]);
+             break;
+         case OP_MUL:
+             regs[in->a] = vm_int((unsigned long long)regs[in->b] *
+                                  (unsigned long long)regs[in->c]);
+             break;
+         case OP_DIV:
+             regs[in->a] = (regs[in->c] == -1) ? vm_int(-(unsigned long long)regs[in->b])
+                                               : regs[in->b] / regs[in->c];
+             break;
+         case OP_DIV32:
+             regs[in->a] = regs[in->b] / regs[in->c];
+             break;
+         case OP_NEG:
+             regs[in->a] = vm_int(-(unsigned long long)regs[in->b]);
+             break;
+         case OP_ADDO:
+             if (__builtin_add_overflow(regs[in->b], regs[in->c], &regs[in->a])) {
+                 return vm_overflow();
+             }
+             break;
+         case OP_SUBO:
+             if (__builtin_sub_overflow(regs[in->b], regs[in->c], &regs[in->a])) {
+                 return vm_overflow();
+             }
+             break;
+         case OP_MULO:
+             if (__builtin_mul_overflow(regs[in->b], regs[in->c], &regs[in->a])) {
+                 return vm_overflow();
+             }
+             break;
+         case OP_DIVO:
+             if (regs[in->c] != -1) {
+                 regs[in->a] = regs[in->b] / regs[in->c];
+             } else if (__builtin_sub_overflow(0, regs[in->b], &regs[in->a])) {
+                 return vm_overflow();                 // LLONG_MIN / -1
+             }
+             break;
+         case OP_NEGO:
+             if (__builtin_sub_overflow(0, regs[in->b], &regs[in->a])) {
+                 return vm_overflow();
+             }
+             break;
+         case OP_EQ: regs[in->a] = (regs[in->b] == regs[in->c]); break;
+         case OP_NE: regs[in->a] = (regs[in->b] != regs[in->c]); break;
+         case OP_LT: regs[in->a] = (regs[in->b] <  regs[in->c]); break;
+         case OP_LE: regs[in->a] = (regs[in->b] <= regs[in->c]); break;
+         case OP_GT: regs[in->a] = (regs[in->b] >  regs[in->c]); break;
+         case OP_GE: regs[in->a] = (regs[in->b] >= regs[in->c]); break;
+         case OP_JMP:
+             return in->a;
+         case OP_JZ:
+             return (regs[in->a] == 0) ? in->b : pc + 1;
+         case OP_PRINT:
+             vm_print(regs[in->a]);
+             break;
+         case OP_READ:
+             vm_read(&regs[in->a]);
+             break;
+         case OP_UNDEF:
+             regs[in->a] = VM_UNDEF;
+             break;
+         case OP_CHKDEF:
+             if (regs[in->a] == VM_UNDEF) {
+                 if (int_big && val_is_big(sym_value[in->a])) {
+                     return VM_DEOPT;            // se quedó en symtab (region_big)
+                 }
+                 vm_error_undef(in);
+             }
+             break;
+         case OP_CHKDIV:
+             if (regs[in->a] == 0) {
+                 fprintf(stderr, "Error: división por cero.\n");
+                 exit(1);
+             }
+             break;
+         case OP_TRIPS:
+             regs[in->a] = ir_trips(regs[in->b], regs[in->c], in->d);
+             break;
+         case OP_POWSUM:
+             regs[in->a] = ir_powsum((unsigned long long)regs[in->b], in->c);
+             break;
+         case OP_BOUND:
+             regs[in->a] = ir_bound(regs[in->b], regs[in->c], in->d);
+             break;
+         case OP_FCONST:
+             regs[in->a] = vm_bits(p->fconsts[in->b]);
+             break;
+         case OP_FADD: regs[in->a] = vm_bits(vm_f(regs[in->b]) + vm_f(regs[in->c])); break;
+         case OP_FSUB: regs[in->a] = vm_bits(vm_f(regs[in->b]) - vm_f(regs[in->c])); break;
+         case OP_FMUL: regs[in->a] = vm_bits(vm_f(regs[in->b]) * vm_f(regs[in->c])); break;
+         case OP_FDIV: regs[in->a] = vm_bits(vm_f(regs[in->b]) / vm_f(regs[in->c])); break;
+         case OP_FNEG:
+             regs[in->a] = vm_bits(-vm_f(regs[in->b]));
+             break;
+         case OP_FEQ: regs[in->a] = (vm_f(regs[in->b]) == vm_f(regs[in->c])); break;
+         case OP_FNE: regs[in->a] = (vm_f(regs[in->b]) != vm_f(regs[in->c])); break;
+         case OP_FLT: regs[in->a] = (vm_f(regs[in->b]) <  vm_f(regs[in->c])); break;
+         case OP_FLE: regs[in->a] = (vm_f(regs[in->b]) <= vm_f(regs[in->c])); break;
+         case OP_FGT: regs[in->a] = (vm_f(regs[in->b]) >  vm_f(regs[in->c])); break;
+         case OP_FGE: regs[in->a] = (vm_f(regs[in->b]) >= vm_f(regs[in->c])); break;
+         case OP_ITOF:
+             regs[in->a] = vm_bits((double)regs[in->b]);
+             break;
+         case OP_FTOI:
+             regs[in->a] = float_to_int(vm_f(regs[in->b]));
+             break;
+         case OP_TOCHR:
+             regs[in->a] = (signed char)regs[in->b];
+             break;
+         case OP_PRINTF:
+             vm_print_float(regs[in->a]);
+             break;
+         case OP_READF:
+             vm_read_float(&regs[in->a]);
+             break;
+         case OP_PRINTC:
+             vm_print_char(regs[in->a]);
+             break;
+         case OP_READC:
+             vm_read_char(&regs[in->a]);
+             break;
+         case OP_LOAD:
+             regs[in->a] = ((const long long *)arrays[in->c].data)[regs[in->b]];
+             break;
+         case OP_LOADC:
+             regs[in->a] = ((const signed char *)arrays[in->c].data)[regs[in->b]];
+             break;
+         case OP_STORE:
+             ((long long *)arrays[in->a].data)[regs[in->b]] = regs[in->c];
+             break;
+         case OP_STOREC:
+             ((signed char *)arrays[in->a].data)[regs[in->b]] = (signed char)regs[in->c];
+             break;
+         case OP_CHKIDX:
+             if ((unsigned long long)regs[in->a] >=
+                 (unsigned long long)array_dim(&arrays[in->b], in->d)) {
+                 index_error(&arrays[in->b]);
+             }
+             break;
+         case OP_ZERO:
+             memset(arrays[in->a].data, 0, array_bytes(&arrays[in->a]));
+             break;
+         case OP_ASUM: case OP_ADOT: case OP_AMIN: case OP_AMAX: {
+             int ovf;
+             regs[in->a] = vec_reduce((VecFunc)(in->op - OP_ASUM), &arrays[in->b],
+                                      in->op == OP_ADOT ? &arrays[in->c] : NULL, &ovf);
+             if (ovf && !int_wrap) {
+                 return vm_overflow();
+             }
+             break;
+         }
+         case OP_AFIND:
+             regs[in->a] = vec_find(&arrays[in->c], regs[in->b]);
+             break;
+         case OP_FILL:
+             vec_fill(&arrays[in->a], regs[in->b]);
+             break;
+         case OP_SORT:
+             vec_sort(&arrays[in->a]);
+             break;
+         case OP_MATMUL:
+             if (mat_mul(&arrays[in->a], &arrays[in->b], &arrays[in->c])) {
+                 return vm_overflow();
+             }
+             break;
+         case OP_TRANSP:
+             mat_transpose(&arrays[in->a], &arrays[in->b]);
+             break;
+         case OP_DNEW:
+             dict_clear(&dicts[in->a]);
+             break;
+         case OP_DGET:
+             regs[in->a] = dict_get(&dicts[in->c], regs[in->b]);
+             break;
+         case OP_DSET:
+             dict_set(&dicts[in->a], regs[in->b], regs[in->c]);
+             break;
+         case OP_DHAS:
+             regs[in->a] = (dict_slot(&dicts[in->c], regs[in->b]) != NULL);
+             break;
+         case OP_DDEL:
+             dict_delete(&dicts[in->a], regs[in->b]);
+             break;
+         case OP_DLEN:
+             regs[in->a] = dicts[in->b].len;
+             break;
+         case OP_DKEYS:
+             dict_keys(&arrays[in->a], &dicts[in->b]);
+             break;
+         case OP_VLOOP:
+ #if SIMD_AVAILABLE
+             vloop_run(p, pc, regs);
+ #endif
+             break;
+         case OP_HALT:
+             return -1;
+         case OP_PHI:                            // no llega: se sale antes de SSA
+             break;
+     }
+     return pc + 1;
+ }
+ 
+ 
+ /*--------------------------------------------------------------
+  * Emisor de código máquina x86-64 (solo lo que usan las trazas).
+  * Convención dentro de una traza: rbx apunta a los registros de la
+  * VM; rax/rcx/rdx son de trabajo.
+  *-------------------------------------------------------------*/
+ 
+ typedef struct {
+     unsigned char *buf;
+     int            len, cap;
+ } CodeBuf;
+ 
+ static void cb_byte(CodeBuf *cb, int b) {
+     if (cb->len >= cb->cap) {
+         cb->cap = cb->cap ? cb->cap * 2 : 1024;
+         cb->buf = realloc(cb->buf, cb->cap);
+         if (cb->buf == NULL) {
+             fprintf(stderr, "Error: memoria insuficiente.\n");
+             exit(1);
+         }
+     }
+     cb->buf[cb->len++] = (unsigned char)b;
+ }
+ 
+ static void cb_bytes(CodeBuf *cb, const char *bytes, int n) {
+     for (int i = 0; i < n; i++) {
+         cb_byte(cb, (unsigned char)bytes[i]);
+     }
+ }
+ 
+ static void cb_u32(CodeBuf *cb, unsigned int v) {
+     for (int i = 0; i < 4; i++) {
+         cb_byte(cb, (v >> (8 * i)) & 0xFF);
+     }
+ }
+ 
+ static void cb_u64(CodeBuf *cb, unsigned long long v) {
+     for (int i = 0; i < 8; i++) {
+         cb_byte(cb, (int)((v >> (8 * i)) & 0xFF));
+     }
+ }
+ 
+ static void cb_patch32(CodeBuf *cb, int at, int v) {
+     for (int i = 0; i < 4; i++) {
+         cb->buf[at + i] = (unsigned char)(((unsigned)v >> (8 * i)) & 0xFF);
+     }
+ }
+ 
+ // op reg, [rbx + 8*r]   (modrm: mod=10, rm=rbx)
+ static void x86_mem(CodeBuf *cb, const char *opcode, int n, int reg, int r) {
+     cb_bytes(cb, opcode, n);
+     cb_byte(cb, 0x80 | (reg << 3) | 3);
+     cb_u32(cb, (unsigned)(8 * r));
+ }
+ 
+ #define X86_EAX 0
+ #define X86_ECX 1
+ #define X86_EDX 2
+ #define X86_EDI 7
+ 
+ static void x86_load64(CodeBuf *cb, int reg, int r) {      // mov r?x, [rbx+8r]
+     x86_mem(cb, "\x48\x8B", 2, reg, r);
+ }
+ 
+ static void x86_store_rax(CodeBuf *cb, int r) {            // mov [rbx+8r], rax
+     x86_mem(cb, "\x48\x89", 2, X86_EAX, r);
+ }
+ 
+ static void x86_call(CodeBuf *cb, void *fn) {              // mov rax, fn; call rax
+     cb_bytes(cb, "\x48\xB8", 2);
+     cb_u64(cb, (unsigned long long)(size_t)fn);
+     cb_bytes(cb, "\xFF\xD0", 2);
+ }
+ 
+ /* jcc/jmp hacia una salida: deja el rel32 pendiente de parchear */
+ typedef struct {
+     int at;       // posición del rel32
+     int pc;       // pc de la VM donde continuar
+ } TraceExit;
+ 
+ static int x86_jcc_exit(CodeBuf *cb, int cc, TraceExit *exits, int n, int pc) {
+     cb_byte(cb, 0x0F);
+     cb_byte(cb, 0x80 | cc);
+     exits[n].at = cb->len;
+     exits[n].pc = pc;
+     cb_u32(cb, 0);
+     return n + 1;
+ }
+ 
+ #define CC_O  0x0
+ #define CC_AE 0x3
+ #define CC_E  0x4
+ #define CC_NE 0x5
+ 
+ /*--------------------------------------------------------------
+  * Una entrada de la traza grabada: la instrucción, su pc y, para
+  * los JZ, qué camino se tomó.
+  *-------------------------------------------------------------*/
+ typedef struct {
+     int pc;
+     int taken;
+ } TraceEntry;
+ 
+ /**
+  * jit_compile_trace(rg, t, n):
+  *   Traduce la traza t[0..n-1] de la región rg (que empieza en la
+  *   cabecera del bucle y termina en su salto hacia atrás) a código
+  *   nativo.
+  *
+  *   int traza(long long *regs):
+  *       push rbx; mov rbx, rdi
+  *     L: ...instrucciones con guardas...
+  *       jmp L
+  *     salida_k: mov eax, pc_k; pop rbx; ret
+  *
+  *   Si el bucle es el exterior de una región con --bigint, cada
+  *   vuelta empieza guardando las variables que escribe la región y
+  *   dando por buena la salida retenida (como vm_save()).
+  */
+ static JitTrace *jit_compile_trace(const LoopRegion *rg, const TraceEntry *t, int n) {
+ #if JIT_AVAILABLE
+     const IRProgram *p = rg->ir;
+     double t0 = now_us();
+     CodeBuf cb = {0};
+     TraceExit *exits = malloc((2 * n + 1) * sizeof(TraceExit));
+     int num_exits = 0;
+     int  *nuse      = ir_use_counts(p);
+     char *is_target = ir_jump_targets(p);
+ 
+     cb_bytes(&cb, "\x53\x48\x89\xFB", 4);        // push rbx; mov rbx, rdi
+     int loop_start = cb.len;
+ 
+     if (t[0].pc == rg->restart) {
+         int prints = 0;
+         for (int k = 0; k < rg->num_saved; k++) {
+             x86_load64(&cb, X86_EAX, rg->saved[k]);
+             x86_store_rax(&cb, p->num_regs + 1 + rg->saved[k]);
+         }
+         x86_mem(&cb, "\x48\xFF", 2, 0, p->num_regs);     // inc qword [..]
+         for (int i = 0; i < n; i++) {
+             OpCode op = p->code[t[i].pc].op;
+             prints |= (op == OP_PRINT || op == OP_PRINTF || op == OP_PRINTC);
+         }
+         if (prints) {
+             x86_call(&cb, (void *)out_commit);
+         }
+     }
+ 
+     for (int i = 0; i < n; i++) {
+         const Instr *in = &p->code[t[i].pc];
+         switch (in->op) {
+             case OP_CONST:
+                 if (p->consts[in->b] >= INT_MIN && p->consts[in->b] <= INT_MAX) {
+                     x86_mem(&cb, "\x48\xC7", 2, 0, in->a);   // mov qword [..], imm32
+                     cb_u32(&cb, (unsigned)p->consts[in->b]);
+                 } else {
+                     cb_bytes(&cb, "\x48\xB8", 2);             // mov rax, imm64
+                     cb_u64(&cb, (unsigned long long)p->consts[in->b]);
+                     x86_store_rax(&cb, in->a);
+                 }
+                 break;
+             case OP_MOV:
+                 x86_mem(&cb, "\x48\x8B", 2, X86_EAX, in->b);
+                 x86_mem(&cb, "\x48\x89", 2, X86_EAX, in->a);
+                 break;
+             case OP_ADD: case OP_ADDO:
+             case OP_SUB: case OP_SUBO:
+             case OP_MUL: case OP_MULO: {
+                 OpCode op = ir_unchecked(in->op);
+                 x86_load64(&cb, X86_EAX, in->b);
+                 if (op == OP_ADD) {
+                     x86_mem(&cb, "\x48\x03", 2, X86_EAX, in->c);
+                 } else if (op == OP_SUB) {
+                     x86_mem(&cb, "\x48\x2B", 2, X86_EAX, in->c);
+                 } else {
+                     x86_mem(&cb, "\x48\x0F\xAF", 3, X86_EAX, in->c);
+                 }
+                 if (ir_is_checked(in->op)) {
+                     // Sin guardar nada: la VM repite la instrucción
+                     // y da el error
+                     num_exits = x86_jcc_exit(&cb, CC_O, exits, num_exits, t[i].pc);
+                 }
+                 x86_store_rax(&cb, in->a);
+                 break;
+             }
+             case OP_DIV: case OP_DIVO:
+                 x86_load64(&cb, X86_ECX, in->c);
+                 cb_bytes(&cb, "\x48\x83\xF9\xFF", 4);         // cmp rcx, -1
+                 num_exits = x86_jcc_exit(&cb, CC_E, exits, num_exits, t[i].pc);
+                 x86_load64(&cb, X86_EAX, in->b);
+                 cb_bytes(&cb, "\x48\x99\x48\xF7\xF9", 5);     // cqo; idiv rcx
+                 x86_store_rax(&cb, in->a);
+                 break;
+             case OP_DIV32:                              // ni -1 ni INT_MIN: ver opt_ranges
+                 x86_mem(&cb, "\x8B", 1, X86_EAX, in->b);     // mov eax, [..]
+                 cb_byte(&cb, 0x99);                           // cdq
+                 x86_mem(&cb, "\xF7", 1, X86_EDI, in->c);     // idiv dword [..]
+                 cb_bytes(&cb, "\x48\x63\xC0", 3);             // movsxd rax, eax
+                 x86_store_rax(&cb, in->a);
+                 break;
+             case OP_NEG: case OP_NEGO:
+                 x86_load64(&cb, X86_EAX, in->b);
+                 cb_bytes(&cb, "\x48\xF7\xD8", 3);             // neg rax
+                 if (in->op == OP_NEGO) {
+                     num_exits = x86_jcc_exit(&cb, CC_O, exits, num_exits, t[i].pc);
+                 }
+                 x86_store_rax(&cb, in->a);
+                 break;
+             case OP_EQ: case OP_NE: case OP_LT:
+             case OP_LE: case OP_GT: case OP_GE: {
+                 static const unsigned char setcc[] = {   // en el orden de OpCode
+                     0x94, 0x95, 0x9C, 0x9E, 0x9F, 0x9D
+                 };
+                 x86_load64(&cb, X86_EAX, in->b);
+                 x86_mem(&cb, "\x48\x3B", 2, X86_EAX, in->c);   // cmp rax, [..]
+                 if (i + 1 < n && t[i + 1].pc == t[i].pc + 1 &&
+                     cmp_jz_fusable(p, t[i + 1].pc, nuse, is_target)) {
+                     // Con el JZ siguiente: la guarda sale por donde
+                     // no fue la grabación
+                     int cc = setcc[in->op - OP_EQ] & 0xF;
+                     if (t[i + 1].taken) {
+                         num_exits = x86_jcc_exit(&cb, cc, exits, num_exits, t[i + 1].pc + 1);
+                     } else {
+                         num_exits = x86_jcc_exit(&cb, cc ^ 1, exits, num_exits,
+                                                  p->code[t[i + 1].pc].b);
+                     }
+                     i++;
+                     break;
+                 }
+                 cb_byte(&cb, 0x0F);
+                 cb_byte(&cb, setcc[in->op - OP_EQ]);
+                 cb_byte(&cb, 0xC0);                           // setcc al
+                 cb_bytes(&cb, "\x0F\xB6\xC0", 3);             // movzx eax, al
+                 x86_store_rax(&cb, in->a);
+                 break;
+             }
+             case OP_JMP:
+                 // Los saltos hacia delante ya están resueltos por la
+                 // grabación; el último (hacia la cabecera) cierra el bucle.
+                 break;
+             case OP_JZ:
+                 x86_mem(&cb, "\x48\x83", 2, 7, in->a);         // cmp qword [..], 0
+                 cb_byte(&cb, 0);
+                 if (t[i].taken) {
+                     num_exits = x86_jcc_exit(&cb, CC_NE, exits, num_exits, t[i].pc + 1);
+                 } else {
+                     num_exits = x86_jcc_exit(&cb, CC_E, exits, num_exits, in->b);
+                 }
+                 break;
+             case OP_PRINT:
+                 x86_mem(&cb, "\x48\x8B", 2, X86_EDI, in->a);  // mov rdi, [..]
+                 x86_call(&cb, (void *)vm_print);
+                 break;
+             case OP_READ:
+                 x86_mem(&cb, "\x48\x8D", 2, X86_EDI, in->a);  // lea rdi, [..]
+                 x86_call(&cb, (void *)vm_read);
+                 break;
+             case OP_UNDEF:
+                 cb_bytes(&cb, "\x48\xB8", 2);                 // mov rax, VM_UNDEF
+                 cb_u64(&cb, (unsigned long long)VM_UNDEF);
+                 x86_mem(&cb, "\x48\x89", 2, X86_EAX, in->a);
+                 break;
+             case OP_CHKDEF:
+                 cb_bytes(&cb, "\x48\xB9", 2);                 // mov rcx, VM_UNDEF
+                 cb_u64(&cb, (unsigned long long)VM_UNDEF);
+                 x86_mem(&cb, "\x48\x3B", 2, X86_ECX, in->a);  // cmp rcx, [..]
+                 num_exits = x86_jcc_exit(&cb, CC_E, exits, num_exits, t[i].pc);
+                 break;
+             case OP_CHKDIV:
+                 x86_mem(&cb, "\x48\x83", 2, 7, in->a);         // cmp qword [..], 0
+                 cb_byte(&cb, 0);
+                 num_exits = x86_jcc_exit(&cb, CC_E, exits, num_exits, t[i].pc);
+                 break;
+             case OP_FCONST:
+                 cb_bytes(&cb, "\x48\xB8", 2);                 // mov rax, imm64
+                 cb_u64(&cb, (unsigned long long)vm_bits(p->fconsts[in->b]));
+                 x86_mem(&cb, "\x48\x89", 2, X86_EAX, in->a);
+                 break;
+             case OP_FADD: case OP_FSUB: case OP_FMUL: case OP_FDIV: {
+                 static const char sse_op[][3] = {            // addsd, subsd, mulsd, divsd
+                     "\xF2\x0F\x58", "\xF2\x0F\x5C", "\xF2\x0F\x59", "\xF2\x0F\x5E"
+                 };
+                 x86_mem(&cb, "\xF2\x0F\x10", 3, 0, in->b);     // movsd xmm0, [..]
+                 x86_mem(&cb, sse_op[in->op - OP_FADD], 3, 0, in->c);
+                 x86_mem(&cb, "\xF2\x0F\x11", 3, 0, in->a);     // movsd [..], xmm0
+                 break;
+             }
+             case OP_ITOF:
+                 x86_mem(&cb, "\xF2\x48\x0F\x2A", 4, 0, in->b); // cvtsi2sd xmm0, qword [..]
+                 x86_mem(&cb, "\xF2\x0F\x11", 3, 0, in->a);
+                 break;
+             case OP_TOCHR:
+                 x86_mem(&cb, "\x48\x0F\xBE", 3, X86_EAX, in->b); // movsx rax, byte [..]
+                 x86_store_rax(&cb, in->a);
+                 break;
+             case OP_LOAD: case OP_LOADC:
+                 // El vector no se mueve: su dirección va en el código
+                 x86_load64(&cb, X86_ECX, in->b);               // mov rcx, [índice]
+                 cb_bytes(&cb, "\x48\xB8", 2);                 // mov rax, base
+                 cb_u64(&cb, (unsigned long long)(size_t)arrays[in->c].data);
+                 if (in->op == OP_LOAD) {
+                     cb_bytes(&cb, "\x48\x8B\x04\xC8", 4);     // mov rax, [rax+8*rcx]
+                 } else {
+                     cb_bytes(&cb, "\x48\x0F\xBE\x04\x08", 5); // movsx rax, byte [rax+rcx]
+                 }
+                 x86_store_rax(&cb, in->a);
+                 break;
+             case OP_STORE: case OP_STOREC:
+                 x86_load64(&cb, X86_ECX, in->b);               // mov rcx, [índice]
+                 x86_load64(&cb, X86_EDX, in->c);               // mov rdx, [valor]
+                 cb_bytes(&cb, "\x48\xB8", 2);                 // mov rax, base
+                 cb_u64(&cb, (unsigned long long)(size_t)arrays[in->a].data);
+                 if (in->op == OP_STORE) {
+                     cb_bytes(&cb, "\x48\x89\x14\xC8", 4);     // mov [rax+8*rcx], rdx
+                 } else {
+                     cb_bytes(&cb, "\x88\x14\x08", 3);         // mov [rax+rcx], dl
+                 }
+                 break;
+             case OP_CHKIDX:
+                 // Sin signo: un índice negativo también sale; la VM
+                 // repite el CHKIDX y da el error
+                 x86_load64(&cb, X86_EAX, in->a);
+                 cb_bytes(&cb, "\x48\x3D", 2);                 // cmp rax, imm32
+                 cb_u32(&cb, (unsigned)array_dim(&arrays[in->b], in->d));
+                 num_exits = x86_jcc_exit(&cb, CC_AE, exits, num_exits, t[i].pc);
+                 break;
+             case OP_ZERO:
+             case OP_TRIPS:
+             case OP_POWSUM: case OP_BOUND:
+             case OP_FNEG: case OP_FTOI:
+             case OP_FEQ: case OP_FNE: case OP_FLT: case OP_FLE: case OP_FGT: case OP_FGE:
+             case OP_PRINTF: case OP_READF: case OP_PRINTC: case OP_READC:
+             case OP_ASUM: case OP_ADOT: case OP_AMIN: case OP_AMAX: case OP_AFIND:
+             case OP_FILL: case OP_SORT: case OP_MATMUL: case OP_TRANSP: case OP_VLOOP:
+             case OP_DNEW: case OP_DGET: case OP_DSET: case OP_DHAS: case OP_DDEL:
+             case OP_DLEN: case OP_DKEYS:
+                 // TRIPS, POWSUM y VLOOP solo salen en preheaders; lo poco
+                 // frecuente de Flotante y Caracter tampoco merece
+                 // código propio, ni poner a 0 un vector (memset),
+                 // recorrerlo entero u ordenarlo (ya van con sus
+                 // núcleos SIMD, por bloques o por radix) o buscar en
+                 // él, ni los diccionarios (una llamada a su núcleo
+                 // cuesta menos que el sondeo). Todo eso lo resuelve
+                 // vm_exec().
+                 cb_bytes(&cb, "\x48\xBF", 2);                 // mov rdi, p
+                 cb_u64(&cb, (unsigned long long)(size_t)p);
+                 cb_byte(&cb, 0xBE);                           // mov esi, pc
+                 cb_u32(&cb, (unsigned)t[i].pc);
+                 cb_bytes(&cb, "\x48\x89\xDA", 3);             // mov rdx, rbx
+                 x86_call(&cb, (void *)vm_exec);
+                 if (in->op == OP_ASUM || in->op == OP_ADOT || in->op == OP_MATMUL) {
+                     // Con --bigint, un desbordamiento: la VM repite
+                     // la instrucción y vuelve al intérprete
+                     cb_bytes(&cb, "\x83\xF8", 2);             // cmp eax, VM_DEOPT
+                     cb_byte(&cb, (unsigned char)VM_DEOPT);
+                     num_exits = x86_jcc_exit(&cb, CC_E, exits, num_exits, t[i].pc);
+                 }
+                 break;
+             case OP_HALT:
+             case OP_PHI:
+                 break;
+         }
+     }
+     cb_byte(&cb, 0xE9);                                       // jmp loop_start
+     cb_u32(&cb, (unsigned)(loop_start - (cb.len + 4)));
+ 
+     for (int k = 0; k < num_exits; k++) {
+         cb_patch32(&cb, exits[k].at, cb.len - (exits[k].at + 4));
+         cb_byte(&cb, 0xB8);                                   // mov eax, pc
+         cb_u32(&cb, (unsigned)exits[k].pc);
+         cb_bytes(&cb, "\x5B\xC3", 2);                         // pop rbx; ret
+     }
+     free(exits);
+     free(nuse);
+     free(is_target);
+ 
+     size_t size = (size_t)cb.len;
+     void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+     if (mem == MAP_FAILED) {
+         free(cb.buf);
+         return NULL;
+     }
+     memcpy(mem, cb.buf, size);
+     free(cb.buf);
+     if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+         munmap(mem, size);
+         return NULL;
+     }
+     JitTrace *jt = calloc(1, sizeof(JitTrace));
+     jt->mem        = mem;
+     jt->size       = size;
+     jt->fn         = (TraceFn)mem;
+     jt->length     = n;
+     jt->created_us = t0 - start_us;
+     jt->compile_us = now_us() - t0;
+     return jt;
+ #else
+     (void)rg; (void)t; (void)n;
+     return NULL;
+ #endif
+ }
+ 
+ /**
+  * jit_record(rg, head, tail, regs):
+  *   Ejecuta (y graba) una vuelta del bucle cuya cabecera es head y
+  *   cuyo salto hacia atrás está en tail. Si la vuelta termina en ese
+  *   salto, compila la traza. Devuelve el pc donde debe seguir la VM.
+  *
+  *   Se abandona la grabación si la vuelta sale del bucle, entra en
+  *   otro bucle (solo trazamos los más internos) o es demasiado larga.
+  */
+ static int jit_record(LoopRegion *rg, int head, int tail, long long *regs) {
+     const IRProgram *p = rg->ir;
+     TraceEntry *t = malloc(MAX_TRACE_LEN * sizeof(TraceEntry));
+     int n  = 0;
+     int pc = head;
+ 
+     while (1) {
+         const Instr *in = &p->code[pc];
+         if (pc < head || pc > tail || n >= MAX_TRACE_LEN ||
+             (in->op == OP_JMP && in->a <= pc && pc != tail)) {
+             rg->aborts[head]++;
+             free(t);
+             return pc;
+         }
+         t[n].pc    = pc;
+         t[n].taken = 0;
+         int next = vm_exec(p, pc, regs);
+         if (in->op == OP_JZ) {
+             t[n].taken = (next == in->b);
+         }
+         n++;
+         if (pc == tail) {
+             break;
+         }
+         pc = next;
+     }
+ 
+     rg->traces[head] = jit_compile_trace(rg, t, n);
+     if (rg->traces[head] == NULL) {
+         rg->aborts[head] = MAX_TRACE_ABORTS;
+     }
+     free(t);
+     return head;
+ }
+ 
+ /**
+  * vm_save(rg):
+  *   Con --bigint, al empezar una vuelta del bucle exterior: guarda
+  *   las variables que escribe la región, cuenta la vuelta y da por
+  *   buena la salida retenida.
+  */
+ static void vm_save(LoopRegion *rg) {
+     long long *regs  = rg->regs;
+     long long *saved = regs + rg->ir->num_regs + 1;
+     for (int k = 0; k < rg->num_saved; k++) {
+         saved[rg->saved[k]] = regs[rg->saved[k]];
+     }
+     regs[rg->ir->num_regs]++;
+     out_commit();
+ }
+ 
+ /**
+  * vm_loop(rg, profile):
+  *   Ejecuta la región hasta su HALT (devuelve -1) o hasta que tiene
+  *   que volver al intérprete (VM_DEOPT). En cada salto hacia atrás:
+  *   si el bucle ya tiene traza, se ejecuta la traza; si no, se
+  *   cuenta la vuelta y, al llegar al umbral, se graba. Con profile se
+  *   cuentan además los JZ (se llama con una constante, así la versión
+  *   sin perfil no paga la comprobación).
+  */
+ static inline int vm_loop(LoopRegion *rg, const int profile) {
+     const IRProgram *p = rg->ir;
+     long long *regs = rg->regs;
+     int pc = 0;
+ 
+     while (pc >= 0) {
+         const Instr *in = &p->code[pc];
+         if (in->op == OP_JMP && in->a <= pc) {
+             int head = in->a;
+             JitTrace *jt = rg->traces[head];
+             if (head == rg->restart) {
+                 vm_save(rg);
+             }
+             if (jt != NULL) {
+                 jt->entries++;
+                 int exit_pc = jt->fn(regs);
+                 if (exit_pc != pc + 1) {
+                     jt->side_exits++;
+                 }
+                 pc = exit_pc;
+                 continue;
+             }
+             if (rg->aborts[head] < MAX_TRACE_ABORTS &&
+                 ++rg->hits[head] >= TRACE_THRESHOLD) {
+                 rg->hits[head] = 0;
+                 pc = jit_record(rg, head, pc, regs);
+                 continue;
+             }
+         }
+         if (profile) {
+             rg->executed++;
+             rg->peep_saved += (p->peep_saved != NULL) ? p->peep_saved[pc] : 0;
+             if (in->op == OP_JZ && regs[in->a] == 0) {
+                 rg->jz_taken[pc]++;
+             } else if (in->op == OP_JZ) {
+                 rg->jz_fallthru[pc]++;
+             }
+         }
+         pc = vm_exec(p, pc, regs);
+     }
+     return pc;
+ }
+ 
+ static int vm_run(LoopRegion *rg) {
+     double t0 = now_us();
+     int pc;
+     rg->entries++;
+     if (stats_enabled) {
+         pc = vm_loop(rg, 1);
+     } else {
+         pc = vm_loop(rg, 0);
+     }
+     rg->run_us += now_us() - t0;
+     return pc;
+ }
+ 
+ /**
+  * region_bigint(rg):
+  *   Prepara la región para --bigint: qué variables toca y escribe y
+  *   cuál es la cabecera del bucle exterior (el destino más bajo de un
+  *   salto hacia atrás). Si la región lee algo o escribe en un vector
+  *   o en un diccionario no puede repetir una vuelta, así que se
+  *   queda en el intérprete (interp_only); también la versión con
+  *   guardas si declara otra vez una de sus variables BigInt (su
+  *   VM_UNDEF se tomaría por "sigue en symtab").
+  */
+ static void region_bigint(LoopRegion *rg) {
+     const IRProgram *p = rg->ir;
+     char *writes = calloc(rg->num_vars + 1, 1);
+     rg->touched = calloc(rg->num_vars + 1, 1);
+     rg->saved   = malloc((rg->num_vars + 1) * sizeof(int));
+     rg->restart = -1;
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         int uses[2];
+         int nu = ir_uses(in, uses);
+         int d  = ir_def(in);
+         for (int k = 0; k < nu; k++) {
+             if (uses[k] < rg->num_vars) {
+                 rg->touched[uses[k]] = 1;
+             }
+         }
+         if (d >= 0 && d < rg->num_vars) {
+             rg->touched[d] = writes[d] = 1;
+         }
+         if (in->op == OP_JMP && in->a <= i && (rg->restart < 0 || in->a < rg->restart)) {
+             rg->restart = in->a;
+         }
+         if (ir_is_read(in->op) || in->op == OP_STORE || in->op == OP_STOREC ||
+             in->op == OP_ZERO || in->op == OP_FILL || in->op == OP_SORT ||
+             in->op == OP_MATMUL || in->op == OP_TRANSP || in->op == OP_DNEW ||
+             in->op == OP_DSET || in->op == OP_DDEL || in->op == OP_DKEYS) {
+             rg->interp_only = 1;
+         }
+         if (in->op == OP_UNDEF && rg->big != NULL && rg->big[in->a]) {
+             rg->interp_only = 1;
+         }
+     }
+     for (int v = 0; v < rg->num_vars; v++) {
+         if (writes[v]) {
+             rg->saved[rg->num_saved++] = v;
+         }
+     }
+     free(writes);
  }
  
  /**
-  * expect_ident():
-  *   Verifica que el token actual sea TOK_IDENT. Si lo es, devuelve
-  *   el lexema (tokens[cur_token].lexeme) y avanza cur_token++. Si no,
-  *   error.
+  * region_compile(while_pos, big):
+  *   Compila como región de la VM el Mientras que empieza en
+  *   while_pos. Con big (--bigint), la versión en la que esas
+  *   variables se quedan en symtab (ver region_big); la región se
+  *   queda con big.
   */
- static char *expect_ident(void) {
-     if (lookahead() == TOK_IDENT) {
-         char *name = tokens[cur_token].lexeme;
-         cur_token++;
-         return name;
-     } else {
-         fprintf(stderr,
-                 "Error de sintaxis: se esperaba IDENT, "
-                 "pero vino '%s'.\n",
-                 tokens[cur_token].lexeme);
-         exit(1);
-     }
-     return NULL; // solo para evitar warning
- }
+ static LoopRegion *region_compile(int while_pos, char *big) {
+     double t0 = now_us();
+     int saved_token = cur_token;
+     IRProgram *saved_ir = ir;
  
+     ir = ir_new();
+     cur_token = while_pos;
+     region_big = big;
+     gen_stmt();
+     region_big = NULL;
+     ir_emit(OP_HALT, 0, 0, 0);
+     ir_finalize();
+     optimize_ir(ir);
  
- /*==============================================================
-  *          PARSER DE EXPRESIONES (EVALUACIÓN EN TIEMPO REAL)
-  *=============================================================*/
+     LoopRegion *rg = calloc(1, sizeof(LoopRegion));
+     rg->ir        = ir;
+     rg->end_token = cur_token;
+     rg->num_vars  = ir->num_regs - ir->num_temps;
+     rg->regs      = calloc(ir->num_regs + 1 + rg->num_vars, sizeof(long long));
+     rg->hits      = calloc(ir->num_code, sizeof(int));
+     rg->aborts    = calloc(ir->num_code, sizeof(int));
+     rg->traces    = calloc(ir->num_code, sizeof(JitTrace *));
+     rg->restart   = -1;
+     rg->big       = big;
+     if (stats_enabled) {
+         rg->jz_taken    = calloc(ir->num_code, sizeof(long));
+         rg->jz_fallthru = calloc(ir->num_code, sizeof(long));
+     }
+     if (int_big) {
+         region_bigint(rg);
+     }
+     rg->created_us = t0 - start_us;
+     rg->compile_us = now_us() - t0;
+ 
+     ir = saved_ir;
+     cur_token = saved_token;
+     return rg;
+ }
  
  /**
-  * Prototipos (se definen más abajo):
+  * region_free(rg):
+  *   Libera una región y sus trazas.
   */
- static int parse_expr(void);
- static int parse_rel_expr(void);
- static int parse_add_expr(void);
- static int parse_mul_expr(void);
- static int parse_unary_expr(void);
- static int parse_primary(void);
+ static void region_free(LoopRegion *rg) {
+     if (rg == NULL) {
+         return;
+     }
+     for (int i = 0; i < rg->ir->num_code; i++) {
+         if (rg->traces[i] != NULL) {
+ #if JIT_AVAILABLE
+             munmap(rg->traces[i]->mem, rg->traces[i]->size);
+ #endif
+             free(rg->traces[i]);
+         }
+     }
+     ir_free(rg->ir);
+     free(rg->regs);
+     free(rg->hits);
+     free(rg->aborts);
+     free(rg->traces);
+     free(rg->jz_taken);
+     free(rg->jz_fallthru);
+     free(rg->saved);
+     free(rg->touched);
+     free(rg->big);
+     free(rg);
+ }
  
- /*
-  * parse_expr():
-  *   En esta gramática, <expr> ::= <rel_expr>
+ /**
+  * region_backoff(rg, laps):
+  *   Con --bigint, tras volver al intérprete después de laps vueltas
+  *   en la VM: si han sido pocas, el bucle espera en el intérprete el
+  *   doble que la vez anterior (hasta MAX_BACKOFF) antes de volver a
+  *   entrar; si no, puede volver en la próxima vuelta.
   */
- static int parse_expr(void) {
-     return parse_rel_expr();
+ static void region_backoff(LoopRegion *rg, long long laps) {
+     if (laps >= HOT_LOOP_THRESHOLD) {
+         rg->backoff = 0;
+     } else if (rg->backoff < MAX_BACKOFF) {
+         rg->backoff = (rg->backoff == 0) ? HOT_LOOP_THRESHOLD : 2 * rg->backoff;
+     }
+     rg->wait = rg->backoff;
  }
  
- /*
-  * <rel_expr> ::= <add_expr> { ( '==' | '!=' | '<' | '>' | '<=' | '>=' ) <add_expr> }
+ /**
+  * run_hot_loop(while_pos):
+  *   Llamada desde parse_while_stmt() cuando un bucle supera
+  *   HOT_LOOP_THRESHOLD vueltas. Compila el bucle (la primera vez),
+  *   pasa las variables de symtab a la VM, ejecuta lo que queda del
+  *   bucle y las devuelve. Devuelve el token siguiente al bucle, o -1
+  *   si con --bigint la VM no puede seguir (algo se ha desbordado o
+  *   se lee una variable que es un BigInt): las variables quedan como
+  *   al empezar una vuelta y el intérprete sigue desde la condición.
   */
- static int parse_rel_expr(void) {
-     int left = parse_add_expr();
+ static int run_hot_loop(int while_pos) {
+     LoopRegion *head = loop_regions[while_pos];
+     if (head == NULL) {
+         head = loop_regions[while_pos] = region_compile(while_pos, NULL);
+     }
+     if (head->interp_only) {
+         return -1;                              // Leer con --bigint
+     }
  
-     while (1) {
-         TokenType t = lookahead();
-         if (t == TOK_EQ || t == TOK_NEQ || t == TOK_LT ||
-             t == TOK_GT || t == TOK_LE || t == TOK_GE) {
-             cur_token++;
-             int right = parse_add_expr();
-             switch (t) {
-                 case TOK_EQ:  left = (left == right); break;
-                 case TOK_NEQ: left = (left != right); break;
-                 case TOK_LT:  left = (left < right);  break;
-                 case TOK_GT:  left = (left > right);  break;
-                 case TOK_LE:  left = (left <= right); break;
-                 case TOK_GE:  left = (left >= right); break;
-                 default: break;
+     // Con --bigint, si la región toca variables que ya son BigInt se
+     // usa la versión que las deja en symtab; si no las cubre todas,
+     // se rehace con las de antes y las nuevas
+     LoopRegion *rg = head;
+     if (int_big) {
+         int need = 0, covered = 1;
+         for (int v = 0; v < head->num_vars; v++) {
+             if (head->touched[v] && val_is_big(sym_value[v])) {
+                 need = 1;
+                 covered &= (head->variant != NULL && head->variant->big[v]);
              }
-         } else {
-             break;
+         }
+         if (!covered) {
+             char *big = calloc(MAX_VARS, 1);
+             for (int v = 0; v < head->num_vars; v++) {
+                 big[v] = (head->variant != NULL && head->variant->big[v]) ||
+                          (head->touched[v] && val_is_big(sym_value[v]));
+             }
+             region_free(head->variant);
+             head->variant = region_compile(while_pos, big);
+         }
+         if (need) {
+             rg = head->variant;
+         }
+         if (rg->interp_only) {
+             rg->deopts++;
+             region_backoff(head, 0);
+             return -1;
          }
      }
-     return left;
+ 
+     // Los registros de la VM van sin etiqueta: el tipo lo sabe el IR
+     long long *regs = rg->regs;
+     for (int v = 0; v < rg->num_vars; v++) {
+         Value val = sym_value[v];
+         regs[v] = (val == VAL_UNDEF || val_is_big(val)) ? VM_UNDEF
+                 : val_is_float(val) ? vm_bits(val_float(val)) : val_int(val);
+     }
+     out_hold = int_big;
+     if (int_big) {
+         vm_save(rg);
+         regs[rg->ir->num_regs] = 0;             // vueltas completas en la VM
+     }
+     int deopt = (vm_run(rg) == VM_DEOPT);
+     out_hold = 0;
+     if (deopt) {
+         long long *saved = regs + rg->ir->num_regs + 1;
+         for (int k = 0; k < rg->num_saved; k++) {
+             regs[rg->saved[k]] = saved[rg->saved[k]];
+         }
+         out_discard();
+         rg->deopts++;
+         region_backoff(head, regs[rg->ir->num_regs]);
+     } else {
+         out_commit();
+     }
+     for (int v = 0; v < rg->num_vars; v++) {
+         long long r = regs[v];
+         if (val_is_big(sym_value[v]) && (!rg->touched[v] || r == VM_UNDEF)) {
+             continue;                           // sigue en symtab
+         }
+         sym_value[v] = (r == VM_UNDEF)                 ? VAL_UNDEF
+                      : (symtab[v].type == TYPE_FLOAT) ? val_from_float(vm_f(r))
+                      : (symtab[v].type == TYPE_CHAR)  ? val_from_char((int)r)
+                                                        : val_from_int(r);
+     }
+     return deopt ? -1 : rg->end_token;
  }
  
- /*
-  * <add_expr> ::= <mul_expr> { ( '+' | '-' ) <mul_expr> }
+ /**
+  * print_stats():
+  *   Informe de "--stats" (por stderr, también si el programa termina
+  *   con error): qué se ejecutó en cada nivel, qué se promovió y
+  *   cuánto costó.
   */
- static int parse_add_expr(void) {
-     int left = parse_mul_expr();
- 
-     while (1) {
-         TokenType t = lookahead();
-         if (t == TOK_PLUS || t == TOK_MINUS) {
-             cur_token++;
-             int right = parse_mul_expr();
-             if (t == TOK_PLUS) {
-                 left = left + right;
-             } else {
-                 left = left - right;
+ static void print_stats(void) {
+     fflush(stdout);
+     fprintf(stderr, "=== Estadísticas de ejecución ===\n");
+     fprintf(stderr, "Tiempo total: %.3f ms\n", (now_us() - start_us) / 1000.0);
+     fprintf(stderr, "Funciones de vectores: núcleos %s\n", simd_name[simd_level]);
+     fprintf(stderr, "Optimizador (programa completo):\n");
+     for (int k = 0; k < NUM_PASSES; k++) {
+         if (!pass_enabled[k]) {
+             fprintf(stderr, "  %s: desactivada\n", passes[k].name);
+             continue;
+         }
+         fprintf(stderr, "  %s: %d %s\n", passes[k].name, pass_changes[k], passes[k].what);
+         if (passes[k].run == opt_peephole) {
+             fprintf(stderr, "    %d -> %d instr. IR; %d identidad(es), %d par(es) "
+                             "escritura/lectura, %d salto(s), %d comparación(es) + JZ "
+                             "fundida(s) por los backends\n",
+                     peep_report.before, peep_report.after, peep_report.identities,
+                     peep_report.copies, peep_report.jumps, peep_report.fusable);
+         } else if (passes[k].run == opt_ranges) {
+             fprintf(stderr, "    %d de %d operación(es) aritmética(s) sin desbordamiento "
+                             "de 64 bits (%d sin comprobar ya), %d comparación(es) "
+                             "decidida(s)\n",
+                     range_report.no_overflow, range_report.arith, range_report.unchecked,
+                     range_report.decided);
+             if (range_report.indices > 0) {
+                 fprintf(stderr, "    %d de %d índice(s) de vector siempre dentro (sin "
+                                 "comprobar)\n", range_report.safe_indices,
+                         range_report.indices);
+             }
+             if (range_report.narrow > 0) {
+                 fprintf(stderr, "    %d división(es) con los operandos en 32 bits\n",
+                         range_report.narrow);
              }
-         } else {
-             break;
          }
      }
-     return left;
- }
  
- /*
-  * <mul_expr> ::= <unary_expr> { ( '*' | '/' ) <unary_expr> }
-  */
- static int parse_mul_expr(void) {
-     int left = parse_unary_expr();
+     fprintf(stderr, "Nivel 0 (intérprete de tokens):\n");
+     for (int i = 0; i < num_tokens; i++) {
+         if (tokens[i].type == TOK_WHILE && loop_hits[i] > 0) {
+             fprintf(stderr, "  Mientras línea %d: %d vuelta(s)%s\n", tokens[i].line,
+                     loop_hits[i] > HOT_LOOP_THRESHOLD ? HOT_LOOP_THRESHOLD : loop_hits[i],
+                     loop_regions[i] != NULL ? " -> promovido al nivel 1" : "");
+         } else if (tokens[i].type == TOK_IF && if_true[i] + if_false[i] > 0) {
+             fprintf(stderr, "  Si línea %d: %ld verdadero / %ld falso\n",
+                     tokens[i].line, if_true[i], if_false[i]);
+         }
+     }
  
-     while (1) {
-         TokenType t = lookahead();
-         if (t == TOK_MULT || t == TOK_DIV) {
-             cur_token++;
-             int right = parse_unary_expr();
-             if (t == TOK_MULT) {
-                 left = left * right;
-             } else {
-                 if (right == 0) {
-                     fprintf(stderr, "Error: división por cero.\n");
-                     exit(1);
-                 }
-                 left = left / right;
+     fprintf(stderr, "Nivel 1 (VM del IR):\n");
+     for (int i = 0; i < num_tokens; i++) {
+         LoopRegion *rg = loop_regions[i];
+         if (rg == NULL) {
+             continue;
+         }
+         fprintf(stderr, "  Mientras línea %d: promovido a los %.3f ms, "
+                 "compilado en %.3f ms (%d instr. IR); %ld entrada(s), %.3f ms en VM\n",
+                 tokens[i].line, rg->created_us / 1000.0, rg->compile_us / 1000.0,
+                 rg->ir->num_code, rg->entries, rg->run_us / 1000.0);
+         fprintf(stderr, "    %lld instr. IR ejecutada(s) en la VM (sin la mirilla: %lld)\n",
+                 rg->executed, rg->executed + rg->peep_saved);
+         if (rg->interp_only) {
+             fprintf(stderr, "    con --bigint se queda en el intérprete (lee datos o "
+                             "escribe en vectores)\n");
+         }
+         if (rg->deopts > 0) {
+             fprintf(stderr, "    %ld vuelta(s) devuelta(s) al intérprete (--bigint)\n",
+                     rg->deopts);
+         }
+         if (rg->variant != NULL) {
+             const LoopRegion *vr = rg->variant;
+             int num_big = 0;
+             for (int v = 0; v < vr->num_vars; v++) {
+                 num_big += vr->big[v];
+             }
+             fprintf(stderr, "    versión con %d BigInt en symtab (%d instr. IR): %ld "
+                             "entrada(s), %.3f ms en VM, %ld vuelta(s) devuelta(s)\n",
+                     num_big, vr->ir->num_code, vr->entries, vr->run_us / 1000.0,
+                     vr->deopts);
+         }
+         for (int pc = 0; pc < rg->ir->num_code; pc++) {
+             if (rg->ir->code[pc].op == OP_JZ &&
+                 rg->jz_taken[pc] + rg->jz_fallthru[pc] > 0) {
+                 fprintf(stderr, "    salto línea %d (pc %d): %ld verdadero / %ld falso\n",
+                         rg->ir->code[pc].line, pc, rg->jz_fallthru[pc], rg->jz_taken[pc]);
              }
-         } else {
-             break;
          }
      }
-     return left;
- }
  
- /*
-  * <unary_expr> ::= [ '-' ] <primary>
-  */
- static int parse_unary_expr(void) {
-     if (lookahead() == TOK_MINUS) {
-         cur_token++;
-         int val = parse_primary();
-         return -val;
+     fprintf(stderr, "Nivel 2 (trazas nativas%s):\n", JIT_AVAILABLE ? "" : ", no disponible");
+     for (int i = 0; i < num_tokens; i++) {
+         LoopRegion *rg = loop_regions[i];
+         if (rg == NULL) {
+             continue;
+         }
+         for (int pc = 0; pc < rg->ir->num_code; pc++) {
+             JitTrace *jt = rg->traces[pc];
+             if (jt != NULL) {
+                 fprintf(stderr, "  bucle línea %d (pc %d): promovido a los %.3f ms, "
+                         "%d instr. IR -> %zu bytes en %.3f ms; "
+                         "%ld entrada(s), %ld salida(s) laterales\n",
+                         rg->ir->code[pc].line, pc, jt->created_us / 1000.0,
+                         jt->length, jt->size, jt->compile_us / 1000.0,
+                         jt->entries, jt->side_exits);
+             } else if (rg->aborts[pc] > 0) {
+                 fprintf(stderr, "  bucle línea %d (pc %d): %d grabación(es) abandonada(s)%s\n",
+                         rg->ir->code[pc].line, pc, rg->aborts[pc],
+                         rg->aborts[pc] >= MAX_TRACE_ABORTS ? ", se queda en la VM" : "");
+             }
+         }
      }
-     return parse_primary();
  }
  
- /*
-  * <primary> ::= '(' <expr> ')' | NUM | IDENT
+ /**
+  * print_dead_code():
+  *   Resumen de --dead-code: cuánto del programa quitó
+  *   opt_dead_stores() y cuántas asignaciones se saltó el intérprete.
   */
- static int parse_primary(void) {
-     if (lookahead() == TOK_LPAREN) {
-         match(TOK_LPAREN);
-         int val = parse_expr();
-         match(TOK_RPAREN);
-         return val;
-     } else if (lookahead() == TOK_NUM) {
-         int val = atoi(tokens[cur_token].lexeme);
-         cur_token++;
-         return val;
-     } else if (lookahead() == TOK_IDENT) {
-         // Variable: obtenemos su valor de la tabla de símbolos
-         char *name = tokens[cur_token].lexeme;
-         cur_token++;
-         return get_symbol_value(name);
-     } else {
-         fprintf(stderr,
-                 "Error de sintaxis en <primary>: se esperaba "
-                 "NUM, IDENT o '(', pero vino '%s'.\n",
-                 tokens[cur_token].lexeme);
-         exit(1);
-     }
-     return 0; // para evitar warning
+ static void print_dead_code(void) {
+     fflush(stdout);
+     fprintf(stderr, "=== Código muerto (programa completo) ===\n");
+     fprintf(stderr, "IR: %d de %d instrucción(es) eliminada(s) (%.1f%%), "
+                     "%d escritura(s) en variables\n",
+             dead_report.removed, dead_report.before,
+             dead_report.before > 0 ? 100.0 * dead_report.removed / dead_report.before : 0.0,
+             dead_report.stores);
+     fprintf(stderr, "Intérprete: %d asignación(es) que nunca se observan, "
+                     "saltadas %lld vez/veces\n",
+             dead_report.stmts, stmt_dead_skips);
  }
  
  
  /*==============================================================
-  *         PARSER DE DECLARACIONES (DECL_STMT)
+  *          CACHÉ DE PROGRAMAS COMPILADOS (.gbc)
   *=============================================================*/
  
- /*
-  * <decl_stmt> ::= <type> <var_list> ';'
-  * <type>       ::= 'Entero' | 'Caracter' | 'Flotante'
-  * <var_list>   ::= <var_decl> ( ',' <var_decl> )*
-  * <var_decl>   ::= IDENT [ '=' <expr> ]
+ /*--------------------------------------------------------------
+  * Un .gbc es el IR optimizado del programa entero tal como lo usa
+  * la VM, para no volver a tokenizar, analizar ni optimizar un
+  * fuente que no ha cambiado. Se carga con un solo mmap y se ejecuta
+  * desde ahí: code[] y consts[] apuntan dentro del archivo, así que
+  * todo va por desplazamientos desde el principio y con el mismo
+  * formato que en memoria.
   *
-  * Semántica:
-  *    - Cada identificador se agrega a la tabla de símbolos con 
-  *      is_defined=0 por defecto.
-  *    - Si hay “= <expr>”, entonces evaluamos <expr> y asignamos el
-  *      valor a la variable, marcando is_defined=1.
-  *    - Si no hay “=”, la variable queda definida con valor 0 e
-  *      is_defined=0 (error si se usa antes de asignar).
+  *     GbcHeader
+  *     Instr        code[num_code]      (alineado a 8)
+  *     double       fconsts[num_fconsts] (alineado a 8)
+  *     long long    consts[num_consts]
+  *     unsigned int names[num_vars]     desplazamiento de cada nombre
+  *     GbcArray     arrays[num_arrays]  (alineado a 8)
+  *     unsigned int dicts[num_dicts]    desplazamiento de cada nombre
+  *     char         ...                 nombres terminados en '\0'
+  *
+  * De cada vector se guarda el tipo, el tamaño y, si es una matriz,
+  * sus columnas; sus elementos se reservan (a 0) al cargarlo. De un
+  * diccionario basta el nombre: empieza vacío.
+  *
+  * El nombre del archivo es la clave: un hash del fuente, de
+  * GBC_VERSION, de GBC_BUILD (cuándo se compiló este analyzer: otro
+  * optimizador puede dar otro IR para el mismo fuente), de las
+  * pasadas activadas y de --wrap. GBC_VERSION cambia cada
+  * vez que cambian OpCode o Instr; la cabecera lo repite junto con
+  * sizeof(Instr) y el tamaño del archivo, y si algo no cuadra el
+  * archivo se ignora y se vuelve a escribir. Lo mismo si no cuadra la
+  * suma del contenido o alguna instrucción tiene un operando fuera
+  * de lo que hay (gbc_instr_ok): la VM y el JIT no comprueban nada
+  * de eso. Se escribe en un temporal y se renombra, así que nunca se
+  * lee a medias.
+  *
+  * La caché no crece sin límite: cargar un .gbc le pone la fecha de
+  * ahora y, al guardar uno nuevo, si hay más de GBC_MAX_FILES se
+  * borran los de fecha más antigua (los que llevan más tiempo sin
+  * usarse, entre ellos los de otras compilaciones de analyzer).
+  *-------------------------------------------------------------*/
+ 
+ #define GBC_VERSION   12
+ #define GBC_MAX_FILES 256
+ #ifndef GBC_BUILD
+ #define GBC_BUILD __DATE__ " " __TIME__     // -DGBC_BUILD=... para fijarlo
+ #endif
+ 
+ typedef struct {
+     char               magic[4];     // "GBC\0"
+     unsigned int       version;      // GBC_VERSION
+     unsigned int       instr_size;   // sizeof(Instr)
+     unsigned int       file_size;
+     unsigned long long key;          // la del nombre del archivo
+     unsigned long long sum;          // fnv1a de lo que sigue a la cabecera
+     unsigned int       num_code, num_consts, num_fconsts, num_regs, num_temps, num_vars;
+     unsigned int       code_off, fconsts_off, consts_off, names_off;
+     unsigned int       num_arrays, arrays_off;
+     unsigned int       num_dicts, dicts_off;
+ } GbcHeader;
+ 
+ typedef struct {
+     long long          len;
+     long long          cols;         // las de una matriz (0 en un vector)
+     unsigned int       type;         // VarType de los elementos
+     unsigned int       name_off;
+ } GbcArray;
+ 
+ static int no_cache = 0;             // --no-cache
+ 
+ static unsigned long long fnv1a(unsigned long long h, const void *data, size_t n) {
+     const unsigned char *b = data;
+     for (size_t i = 0; i < n; i++) {
+         h = (h ^ b[i]) * 1099511628211ULL;
+     }
+     return h;
+ }
+ 
+ /**
+  * gbc_key(f):
+  *   Clave del programa que hay en f (lo lee entero y lo rebobina
+  *   para el lexer) con las pasadas activadas y el modo de los Entero.
   */
- static void parse_decl_stmt(void) {
-     // 1) <type>
-     TokenType t = lookahead();
-     if (t == TOK_INT || t == TOK_CHAR || t == TOK_FLOAT) {
-         cur_token++;
+ static unsigned long long gbc_key(FILE *f) {
+     unsigned long long h = 14695981039346656037ULL;
+     unsigned int version = GBC_VERSION;
+     char buf[4096];
+     size_t n;
+     while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+         h = fnv1a(h, buf, n);
+     }
+     rewind(f);
+     h = fnv1a(h, &version, sizeof(version));
+     h = fnv1a(h, GBC_BUILD, sizeof(GBC_BUILD));
+     h = fnv1a(h, &int_wrap, sizeof(int_wrap));
+     return fnv1a(h, pass_enabled, sizeof(pass_enabled));
+ }
+ 
+ /**
+  * cache_dir(dir, size):
+  *   Directorio de la caché ($GAMA_CACHE, o ~/.cache/gama), creándolo
+  *   si hace falta. Devuelve 0 si no hay dónde guardar nada.
+  */
+ static int cache_dir(char *dir, size_t size) {
+ #if GBC_AVAILABLE
+     const char *env  = getenv("GAMA_CACHE");
+     const char *home = getenv("HOME");
+     if (env != NULL && env[0] != '\0') {
+         snprintf(dir, size, "%s", env);
+     } else if (home != NULL && home[0] != '\0') {
+         snprintf(dir, size, "%s/.cache", home);
+         mkdir(dir, 0755);
+         snprintf(dir, size, "%s/.cache/gama", home);
      } else {
-         fprintf(stderr,
-                 "Error de sintaxis en <decl_stmt>: se esperaba tipo 'Entero', 'Caracter' o 'Flotante', "
-                 "pero vino '%s'.\n",
-                 tokens[cur_token].lexeme);
-         exit(1);
+         return 0;
      }
+     mkdir(dir, 0755);
+     return 1;
+ #else
+     (void)dir, (void)size;
+     return 0;
+ #endif
+ }
  
-     // 2) <var_list> ::= <var_decl> (',' <var_decl> )*
-     while (1) {
-         // <var_decl> ::= IDENT [ '=' <expr> ]
-         if (lookahead() == TOK_IDENT) {
-             char *varname = tokens[cur_token].lexeme;
-             int idx = add_symbol(varname);  // crea o recupera índice
-             symtab[idx].is_defined = 0;     // aún no asignado
+ /**
+  * gbc_path(key, out, size):
+  *   Ruta del .gbc de key en la caché. Devuelve 0 si no hay dónde
+  *   guardarlo.
+  */
+ static int gbc_path(unsigned long long key, char *out, size_t size) {
+     char dir[1024];
+     if (!cache_dir(dir, sizeof(dir))) {
+         return 0;
+     }
+     int n = snprintf(out, size, "%s/%016llx.gbc", dir, key);
+     return n > 0 && (size_t)n < size;
+ }
  
-             cur_token++;
-             if (lookahead() == TOK_ASSIGN) {
-                 match(TOK_ASSIGN);
-                 int val = parse_expr();
-                 set_symbol_value(varname, val);
+ /**
+  * gbc_evict(path):
+  *   Si el directorio de path tiene más de GBC_MAX_FILES .gbc, borra
+  *   los de fecha de modificación más antigua hasta dejar ese número.
+  */
+ static void gbc_evict(const char *path) {
+ #if GBC_AVAILABLE
+     char dir[1024], file[1300];
+     const char *slash = strrchr(path, '/');
+     if (slash == NULL || (size_t)(slash - path) >= sizeof(dir)) {
+         return;
+     }
+     memcpy(dir, path, (size_t)(slash - path));
+     dir[slash - path] = '\0';
+     while (1) {
+         DIR *d = opendir(dir);
+         if (d == NULL) {
+             return;
+         }
+         int    count = 0;
+         time_t oldest = 0;
+         char   victim[300] = "";
+         struct dirent *e;
+         while ((e = readdir(d)) != NULL) {
+             size_t      len = strlen(e->d_name);
+             struct stat st;
+             if (len < 5 || len >= sizeof(victim) || strcmp(e->d_name + len - 4, ".gbc") != 0) {
+                 continue;
+             }
+             snprintf(file, sizeof(file), "%s/%s", dir, e->d_name);
+             if (stat(file, &st) != 0) {
+                 continue;
+             }
+             if (count++ == 0 || st.st_mtime < oldest) {
+                 oldest = st.st_mtime;
+                 strcpy(victim, e->d_name);
              }
-         } else {
-             fprintf(stderr,
-                     "Error de sintaxis en <var_list>: se esperaba IDENT, "
-                     "pero vino '%s'.\n",
-                     tokens[cur_token].lexeme);
-             exit(1);
          }
- 
-         // Si viene coma, se repite el var_decl
-         if (lookahead() == TOK_COMMA) {
-             match(TOK_COMMA);
-         } else {
-             break;
+         closedir(d);
+         if (count <= GBC_MAX_FILES) {
+             return;
+         }
+         snprintf(file, sizeof(file), "%s/%s", dir, victim);
+         if (remove(file) != 0) {
+             return;
          }
      }
+ #else
+     (void)path;
+ #endif
+ }
  
-     // 3) Consumir ';'
-     match(TOK_SEMI);
+ /**
+  * gbc_save(p, path, key):
+  *   Escribe p (programa entero, fuera de SSA) en path. Si no puede,
+  *   no pasa nada: la próxima vez se compila otra vez.
+  */
+ static void gbc_save(const IRProgram *p, const char *path, unsigned long long key) {
+ #if GBC_AVAILABLE
+     int nv = ir_num_vars(p);
+     GbcHeader h;
+     memset(&h, 0, sizeof(h));
+     memcpy(h.magic, "GBC", 4);
+     h.version    = GBC_VERSION;
+     h.instr_size = sizeof(Instr);
+     h.key        = key;
+     h.num_code   = (unsigned)p->num_code;
+     h.num_consts = (unsigned)p->num_consts;
+     h.num_fconsts = (unsigned)p->num_fconsts;
+     h.num_regs   = (unsigned)p->num_regs;
+     h.num_temps  = (unsigned)p->num_temps;
+     h.num_vars   = (unsigned)nv;
+     h.code_off   = (sizeof(GbcHeader) + 7) & ~7u;
+     h.fconsts_off = (h.code_off + h.num_code * sizeof(Instr) + 7) & ~7u;
+     h.consts_off = h.fconsts_off + h.num_fconsts * sizeof(double);
+     h.names_off  = h.consts_off + h.num_consts * sizeof(long long);
+     h.num_arrays = (unsigned)num_arrays;
+     h.arrays_off = (h.names_off + h.num_vars * sizeof(unsigned int) + 7) & ~7u;
+     h.num_dicts  = (unsigned)num_dicts;
+     h.dicts_off  = h.arrays_off + h.num_arrays * sizeof(GbcArray);
+     unsigned int str_off = h.dicts_off + h.num_dicts * sizeof(unsigned int);
+     h.file_size = str_off + 1;                  // y un '\0' final
+     for (int v = 0; v < nv; v++) {
+         h.file_size += (unsigned)strlen(symtab[v].name) + 1;
+     }
+     for (int a = 0; a < num_arrays; a++) {
+         h.file_size += (unsigned)strlen(arrays[a].name) + 1;
+     }
+     for (int d = 0; d < num_dicts; d++) {
+         h.file_size += (unsigned)strlen(dict_names[d]) + 1;
+     }
+ 
+     char *buf = calloc(h.file_size, 1);
+     if (buf == NULL) {
+         return;
+     }
+     if (h.num_code > 0) {                       // las tablas vacías son NULL
+         memcpy(buf + h.code_off, p->code, h.num_code * sizeof(Instr));
+     }
+     if (h.num_fconsts > 0) {
+         memcpy(buf + h.fconsts_off, p->fconsts, h.num_fconsts * sizeof(double));
+     }
+     if (h.num_consts > 0) {
+         memcpy(buf + h.consts_off, p->consts, h.num_consts * sizeof(long long));
+     }
+     for (int v = 0; v < nv; v++) {
+         size_t len = strlen(symtab[v].name) + 1;
+         memcpy(buf + h.names_off + v * sizeof(unsigned int), &str_off, sizeof(str_off));
+         memcpy(buf + str_off, symtab[v].name, len);
+         str_off += (unsigned)len;
+     }
+     for (int a = 0; a < num_arrays; a++) {
+         GbcArray ga = { arrays[a].len, arrays[a].cols, (unsigned)arrays[a].type, str_off };
+         size_t   len = strlen(arrays[a].name) + 1;
+         memcpy(buf + h.arrays_off + a * sizeof(GbcArray), &ga, sizeof(ga));
+         memcpy(buf + str_off, arrays[a].name, len);
+         str_off += (unsigned)len;
+     }
+     for (int d = 0; d < num_dicts; d++) {
+         size_t len = strlen(dict_names[d]) + 1;
+         memcpy(buf + h.dicts_off + d * sizeof(unsigned int), &str_off, sizeof(str_off));
+         memcpy(buf + str_off, dict_names[d], len);
+         str_off += (unsigned)len;
+     }
+     h.sum = fnv1a(14695981039346656037ULL, buf + sizeof(h), h.file_size - sizeof(h));
+     memcpy(buf, &h, sizeof(h));
+ 
+     char tmp[1100];
+     snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+     FILE *f = fopen(tmp, "wb");
+     if (f != NULL) {
+         int ok = fwrite(buf, 1, h.file_size, f) == h.file_size;
+         ok = (fclose(f) == 0) && ok;
+         if (!ok || rename(tmp, path) != 0) {
+             remove(tmp);
+         }
+     }
+     free(buf);
+     gbc_evict(path);
+ #else
+     (void)p, (void)path, (void)key;
+ #endif
  }
  
+ #if SPAWN_AVAILABLE
+ static pid_t gbc_child = -1;   // proceso que está optimizando para la caché
  
- /*==============================================================
-  *            PARSER DE INSTRUCCIONES (STMT)
-  *=============================================================*/
+ /**
+  * gbc_wait():
+  *   Espera (al salir) a que gbc_save_background() termine, para que
+  *   la próxima ejecución ya encuentre el .gbc.
+  */
+ static void gbc_wait(void) {
+     while (gbc_child > 0 && waitpid(gbc_child, NULL, 0) < 0 && errno == EINTR) {
+     }
+     gbc_child = -1;
+ }
+ #endif
  
- /*
-  * Prototipos recursivos:
+ /**
+  * gbc_save_background(p, path, key):
+  *   Optimiza p (recién compilado) y lo guarda con gbc_save(). Lo
+  *   hace un proceso hijo mientras el intérprete ya ejecuta el
+  *   programa: el nivel 0 no necesita el IR optimizado y así las
+  *   pasadas caras no retrasan el arranque. Sin fork(), aquí mismo.
   */
- static void parse_stmt(void);
- static void parse_print_stmt(void);
- static void parse_read_stmt(void);
- static void parse_assign_stmt(void);
- static void parse_if_stmt(void);
- static void parse_while_stmt(void);
- static void parse_block_stmt(void);
+ static void gbc_save_background(IRProgram *p, const char *path, unsigned long long key) {
+ #if SPAWN_AVAILABLE
+     fflush(stdout);
+     fflush(stderr);
+     pid_t pid = fork();
+     if (pid > 0) {
+         gbc_child = pid;
+         atexit(gbc_wait);
+         return;
+     }
+     if (pid == 0) {
+         optimize_ir(p);
+         gbc_save(p, path, key);
+         _exit(0);
+     }
+ #endif
+     optimize_ir(p);
+     gbc_save(p, path, key);
+ }
  
- /*
-  * <stmt> ::= <decl_stmt>
-  *          | <print_stmt>
-  *          | <read_stmt>
-  *          | <assign_stmt>
-  *          | <if_stmt>
-  *          | <while_stmt>
-  *          | <block_stmt>
+ /**
+  * gbc_instr_ok(base, pc):
+  *   1 si los operandos de la instrucción pc del archivo proyectado en
+  *   base caben en lo que este declara, según su forma en op_info[]:
+  *   registros, destinos de salto, constantes, vectores y
+  *   diccionarios, y los números que la VM usa como índice (la
+  *   dimensión de CHKIDX, el final de un VLOOP).
   */
- static void parse_stmt(void) {
-     switch (lookahead()) {
-         case TOK_INT:
-         case TOK_CHAR:
-         case TOK_FLOAT:
-             parse_decl_stmt();
-             break;
+ static int gbc_instr_ok(const char *base, int pc) {
+     const GbcHeader *h  = (const GbcHeader *)base;
+     const Instr     *in = (const Instr *)(base + h->code_off) + pc;
+     if ((unsigned)in->op >= (unsigned)NUM_OPS || op_info[in->op].name == NULL ||
+         in->op == OP_PHI) {
+         return 0;
+     }
+     const int *opnd[4] = { &in->a, &in->b, &in->c, &in->d };
+     const char *args   = op_info[in->op].args;
+     for (int k = 0; args[k] != '\0'; k++) {
+         unsigned int x = (unsigned int)*opnd[k];
+         unsigned int n = (args[k] == 'r') ? h->num_regs
+                        : (args[k] == 'j') ? h->num_code
+                        : (args[k] == 'k') ? h->num_consts
+                        : (args[k] == 'f') ? h->num_fconsts
+                        : (args[k] == 'v') ? h->num_arrays
+                        : (args[k] == 'm') ? h->num_dicts : UINT_MAX;
+         if (x >= n) {
+             return 0;
+         }
+     }
+     switch (in->op) {
+         case OP_CHKDEF:                 // el mensaje de error usa su nombre
+             return (unsigned)in->a < h->num_vars;
+         case OP_CHKIDX: {               // una dimensión que no sea 0 es de matriz
+             GbcArray ga;
+             memcpy(&ga, base + h->arrays_off + in->b * sizeof(GbcArray), sizeof(ga));
+             return in->d >= 0 && in->d <= 2 && (in->d == 0 || ga.cols > 0);
+         }
+         case OP_VLOOP:
+             return in->a >= 1 && (unsigned)(pc + in->a) < h->num_code;
+         default:
+             return 1;
+     }
+ }
  
-         case TOK_PRINT:
-             parse_print_stmt();
-             break;
+ /**
+  * gbc_load(path, key):
+  *   Proyecta path en memoria y devuelve un IRProgram cuyo código y
+  *   constantes están dentro de la proyección (solo lectura; no se
+  *   libera nunca), con los nombres de las variables ya en symtab y
+  *   los vectores y diccionarios dados de alta.
+  *   NULL si no está o no vale.
+  */
+ static IRProgram *gbc_load(const char *path, unsigned long long key) {
+ #if GBC_AVAILABLE
+     int fd = open(path, O_RDONLY);
+     if (fd < 0) {
+         return NULL;
+     }
+     struct stat st;
+     if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(GbcHeader)) {
+         close(fd);
+         return NULL;
+     }
+     size_t size = (size_t)st.st_size;
+     const char *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+     close(fd);
+     if (base == MAP_FAILED) {
+         return NULL;
+     }
  
-         case TOK_READ:
-             parse_read_stmt();
-             break;
+     const GbcHeader *h = (const GbcHeader *)base;
+     int ok = memcmp(h->magic, "GBC", 4) == 0 && h->version == GBC_VERSION &&
+              h->instr_size == sizeof(Instr) && h->file_size == size && h->key == key &&
+              h->num_vars <= MAX_VARS && h->num_vars <= h->num_regs && h->num_code > 0 &&
+              h->code_off % 8 == 0 &&
+              h->code_off + (size_t)h->num_code * sizeof(Instr) <= h->fconsts_off &&
+              h->fconsts_off % 8 == 0 &&
+              h->fconsts_off + (size_t)h->num_fconsts * sizeof(double) <= h->consts_off &&
+              h->consts_off + (size_t)h->num_consts * sizeof(long long) <= h->names_off &&
+              h->names_off + (size_t)h->num_vars * sizeof(unsigned int) <= h->arrays_off &&
+              h->arrays_off % 8 == 0 && h->num_arrays <= MAX_VARS &&
+              h->arrays_off + (size_t)h->num_arrays * sizeof(GbcArray) <= h->dicts_off &&
+              h->num_dicts <= MAX_VARS &&
+              h->dicts_off + (size_t)h->num_dicts * sizeof(unsigned int) <= size &&
+              base[size - 1] == '\0' &&
+              h->sum == fnv1a(14695981039346656037ULL, base + sizeof(GbcHeader),
+                              size - sizeof(GbcHeader));
+     for (unsigned int v = 0; ok && v < h->num_vars; v++) {
+         unsigned int off;
+         memcpy(&off, base + h->names_off + v * sizeof(unsigned int), sizeof(off));
+         ok = off < size && strlen(base + off) < MAX_LEXEME_LEN;
+         if (ok) {
+             strcpy(symtab[v].name, base + off);
+         }
+     }
+     for (unsigned int a = 0; ok && a < h->num_arrays; a++) {
+         GbcArray ga;
+         memcpy(&ga, base + h->arrays_off + a * sizeof(GbcArray), sizeof(ga));
+         ok = ga.name_off < size && strlen(base + ga.name_off) < MAX_LEXEME_LEN &&
+              ga.type <= TYPE_FLOAT && ga.len >= 1 && ga.len <= MAX_ARRAY_LEN &&
+              ga.cols >= 0 && (ga.cols == 0 || ga.len % ga.cols == 0);
+     }
+     for (unsigned int d = 0; ok && d < h->num_dicts; d++) {
+         unsigned int off;
+         memcpy(&off, base + h->dicts_off + d * sizeof(unsigned int), sizeof(off));
+         ok = off < size && strlen(base + off) < MAX_LEXEME_LEN;
+     }
+     for (unsigned int i = 0; ok && i < h->num_code; i++) {
+         ok = gbc_instr_ok(base, (int)i);
+     }
+     ok = ok && ((const Instr *)(base + h->code_off))[h->num_code - 1].op == OP_HALT;
+     if (!ok) {
+         munmap((void *)base, size);
+         return NULL;
+     }
+     utimensat(AT_FDCWD, path, NULL, 0);         // usado ahora: gbc_evict lo deja
+     for (unsigned int a = 0; a < h->num_arrays; a++) {
+         GbcArray ga;
+         memcpy(&ga, base + h->arrays_off + a * sizeof(GbcArray), sizeof(ga));
+         add_array(base + ga.name_off, (VarType)ga.type, ga.len, ga.cols);
+     }
+     for (unsigned int d = 0; d < h->num_dicts; d++) {
+         unsigned int off;
+         memcpy(&off, base + h->dicts_off + d * sizeof(unsigned int), sizeof(off));
+         add_dict(base + off);
+     }
  
-         case TOK_IDENT:
-             parse_assign_stmt();
-             break;
+     IRProgram *p = calloc(1, sizeof(IRProgram));
+     p->code          = (Instr *)(base + h->code_off);
+     p->num_code      = p->cap_code = (int)h->num_code;
+     p->consts        = (long long *)(base + h->consts_off);
+     p->num_consts    = p->cap_consts = (int)h->num_consts;
+     p->fconsts       = (double *)(base + h->fconsts_off);
+     p->num_fconsts   = p->cap_fconsts = (int)h->num_fconsts;
+     p->num_regs      = (int)h->num_regs;
+     p->num_temps     = (int)h->num_temps;
+     p->whole_program = 1;
+     num_vars = (int)h->num_vars;
+     return p;
+ #else
+     (void)path, (void)key;
+     return NULL;
+ #endif
+ }
  
-         case TOK_IF:
-             parse_if_stmt();
-             break;
+ /**
+  * gbc_run(p):
+  *   Ejecuta un programa entero en la VM (con el JIT de trazas para
+  *   sus bucles), como si fuera una región que empieza sin ninguna
+  *   variable.
+  */
+ static void gbc_run(IRProgram *p) {
+     LoopRegion rg;
+     memset(&rg, 0, sizeof(rg));
+     rg.ir       = p;
+     rg.num_vars = ir_num_vars(p);
+     rg.regs     = calloc(p->num_regs + 1, sizeof(long long));
+     rg.hits     = calloc(p->num_code, sizeof(int));
+     rg.aborts   = calloc(p->num_code, sizeof(int));
+     rg.traces   = calloc(p->num_code, sizeof(JitTrace *));
+     rg.restart  = -1;
+     for (int v = 0; v < rg.num_vars; v++) {
+         rg.regs[v] = VM_UNDEF;
+     }
+     vm_run(&rg);
+     free(rg.regs);
+     free(rg.hits);
+     free(rg.aborts);
+     free(rg.traces);
+ }
  
-         case TOK_WHILE:
-             parse_while_stmt();
-             break;
+
+ /*==============================================================
+  *                          MAIN
+  *=============================================================*/
  
-         case TOK_LBRACE:
-             parse_block_stmt();
-             break;
+ /* Temporales de build_native (ruta, o "" si no hay): se borran al
+  * salir del programa, también cuando se sale con un error */
+ static char native_tmp[3][1024];
  
-         default:
-             fprintf(stderr,
-                     "Error de sintaxis en <stmt>: token inesperado '%s'.\n",
-                     tokens[cur_token].lexeme);
-             exit(1);
+ static void native_cleanup(void) {
+     for (int k = 0; k < 3; k++) {
+         if (native_tmp[k][0] != '\0') {
+             remove(native_tmp[k]);
+             native_tmp[k][0] = '\0';
+         }
      }
  }
  
- /*
-  * <print_stmt> ::= 'Imprimir' '(' <expr> ')' ';'
-  * Semántica: evalúa <expr> y muestra su valor por stdout (seguido de newline).
+ /**
+  * native_temp(k, dir):
+  *   Crea un archivo vacío con nombre único en dir (NULL: $TMPDIR o
+  *   /tmp), lo apunta en native_tmp[k] para borrarlo al salir y
+  *   devuelve su ruta.
   */
- static void parse_print_stmt(void) {
-     match(TOK_PRINT);
-     match(TOK_LPAREN);
-     int val = parse_expr();
-     match(TOK_RPAREN);
-     match(TOK_SEMI);
-     printf("%d\n", val);
+ static const char *native_temp(int k, const char *dir) {
+ #if SPAWN_AVAILABLE
+     if (dir == NULL) {
+         dir = getenv("TMPDIR");
+     }
+     if (dir == NULL || dir[0] == '\0') {
+         dir = "/tmp";
+     }
+     int n  = snprintf(native_tmp[k], sizeof(native_tmp[k]), "%s/gama-XXXXXX", dir);
+     int fd = (n > 0 && (size_t)n < sizeof(native_tmp[k])) ? mkstemp(native_tmp[k]) : -1;
+     if (fd >= 0) {
+         close(fd);
+         return native_tmp[k];
+     }
+     native_tmp[k][0] = '\0';
+     fprintf(stderr, "Error: no se pudo crear un archivo temporal en '%s'.\n", dir);
+ #else
+     (void)k, (void)dir;
+     fprintf(stderr, "Error: -o no está disponible en esta plataforma.\n");
+ #endif
+     exit(1);
  }
  
- /*
-  * <read_stmt> ::= 'Leer' '(' IDENT ')' ';'
-  * Semántica: lee un entero de stdin y lo asigna a la variable IDENT. 
+ /**
+  * run_tool(argv):
+  *   Ejecuta argv[0] (buscándolo en el PATH) con esos argumentos, sin
+  *   pasar por el shell, y espera a que acabe. Devuelve 1 si terminó
+  *   bien (código 0).
   */
- static void parse_read_stmt(void) {
-     match(TOK_READ);
-     match(TOK_LPAREN);
-     char *varname = expect_ident();
-     match(TOK_RPAREN);
-     match(TOK_SEMI);
- 
-     int x;
-     if (scanf("%d", &x) != 1) {
-         fprintf(stderr, "Error de runtime: no se pudo leer un entero.\n");
-         exit(1);
+ static int run_tool(char *const argv[]) {
+ #if SPAWN_AVAILABLE
+     int   status;
+     pid_t pid = fork();
+     if (pid == 0) {
+         execvp(argv[0], argv);
+         fprintf(stderr, "Error: no se pudo ejecutar '%s'.\n", argv[0]);
+         _exit(127);
+     }
+     if (pid < 0) {
+         return 0;
+     }
+     while (waitpid(pid, &status, 0) < 0) {
+         if (errno != EINTR) {
+             return 0;
+         }
      }
-     set_symbol_value(varname, x);
+     return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+ #else
+     (void)argv;
+     return 0;
+ #endif
  }
  
- /*
-  * <assign_stmt> ::= IDENT '=' <expr> ';'
-  * Semántica: evalúa <expr> y asigna el resultado a la variable.
+ /* Cómo se compila runtime.c para el ejecutable nativo: sin libc, sin
+  * llamadas a memcpy/memset que no sean las suyas y sin nada que pida
+  * el enlazador dinámico o un TLS (la protección de pila) */
+ static const char *const runtime_cflags[] = {
+     "-O2", "-ffreestanding", "-fno-builtin", "-fno-tree-loop-distribute-patterns",
+     "-fno-stack-protector", "-fno-pic", "-fno-asynchronous-unwind-tables",
+     "-DGAMA_NATIVE", NULL
+ };
+ 
+ /**
+  * runtime_source(path, size):
+  *   Ruta de runtime.c: $GAMA_RUNTIME o, si no está, la de al lado
+  *   del analyzer.c con el que se compiló este programa o, si esa no
+  *   existe (se compiló con una ruta relativa y se ejecuta desde otro
+  *   sitio), la de al lado del ejecutable.
   */
- static void parse_assign_stmt(void) {
-     char *varname = expect_ident();
-     match(TOK_ASSIGN);
-     int val = parse_expr();
-     match(TOK_SEMI);
-     set_symbol_value(varname, val);
+ static void runtime_source(char *path, size_t size) {
+     const char *env = getenv("GAMA_RUNTIME");
+     if (env != NULL && env[0] != '\0') {
+         snprintf(path, size, "%s", env);
+         return;
+     }
+     const char *slash = strrchr(__FILE__, '/');
+     int         dir   = (slash != NULL) ? (int)(slash - __FILE__) + 1 : 0;
+     snprintf(path, size, "%.*sruntime.c", dir, __FILE__);
+     FILE *f = fopen(path, "rb");
+     if (f != NULL) {
+         fclose(f);
+         return;
+     }
+ #if GBC_AVAILABLE
+     char    exe[1024];
+     ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+     if (n > 0) {
+         exe[n] = '\0';
+         slash  = strrchr(exe, '/');
+         dir    = (slash != NULL) ? (int)(slash - exe) + 1 : 0;
+         snprintf(path, size, "%.*sruntime.c", dir, exe);
+     }
+ #endif
  }
  
- /*
-  * <if_stmt> ::= 'Si' '(' <expr> ')' <stmt> [ 'Sino' <stmt> ]
-  *
-  * Semántica:
-  *   - Si cond ≠ 0: ejecutar <stmt> de la rama THEN y descartar la rama 'Sino'.
-  *   - Si cond == 0: descartar <stmt> de la rama THEN y, si existe 'Sino', ejecutar la rama ELSE.
+ /**
+  * runtime_object():
+  *   Compila runtime.c con "cc" y runtime_cflags y devuelve la ruta
+  *   del objeto. Se queda en la caché como runtime-<hash>.o (el hash
+  *   del fuente y de las opciones), así que solo se compila la
+  *   primera vez; con --no-cache, o sin caché, va a un temporal.
   */
- static void parse_if_stmt(void) {
-     match(TOK_IF);           // consume 'Si'
-     match(TOK_LPAREN);       // consume '('
-     int cond = parse_expr(); // evalúa la condición
-     match(TOK_RPAREN);       // consume ')'
+ static const char *runtime_object(void) {
+     static char obj[1024];
+     char        src_path[1024], dir[1024], buf[4096];
+     runtime_source(src_path, sizeof(src_path));
+     FILE *f = fopen(src_path, "rb");
+     if (f == NULL) {
+         fprintf(stderr, "Error: no se encontró el runtime '%s' (ver GAMA_RUNTIME).\n", src_path);
+         exit(1);
+     }
+     unsigned long long h = 14695981039346656037ULL;
+     size_t n;
+     while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+         h = fnv1a(h, buf, n);
+     }
+     fclose(f);
+     for (int k = 0; runtime_cflags[k] != NULL; k++) {
+         h = fnv1a(h, runtime_cflags[k], strlen(runtime_cflags[k]) + 1);
+     }
  
-     if (cond) {
-         // === rama THEN ===
-         parse_stmt();
-         // Si hay 'Sino', descartamos sintácticamente la rama ELSE
-         if (lookahead() == TOK_ELSE) {
-             match(TOK_ELSE);
-             // Ignorar sintácticamente el <stmt> de la rama ELSE:
-             if (lookahead() == TOK_INT || lookahead() == TOK_CHAR || lookahead() == TOK_FLOAT) {
-                 // decl_stmt → tipo var_list ;
-                 cur_token++;
-                 do {
-                     if (lookahead() == TOK_IDENT) {
-                         cur_token++;
-                         if (lookahead() == TOK_ASSIGN) {
-                             cur_token++;
-                             int nivel_p = 0;
-                             do {
-                                 TokenType tt = lookahead();
-                                 if (tt == TOK_LPAREN) nivel_p++;
-                                 else if (tt == TOK_RPAREN) nivel_p--;
-                                 cur_token++;
-                             } while (!(nivel_p == 0 && (lookahead() == TOK_COMMA || lookahead() == TOK_SEMI)));
-                         }
-                     } else {
-                         fprintf(stderr,
-                                 "Error de sintaxis al ignorar <decl_stmt> en ELSE: '%s'.\n",
-                                 tokens[cur_token].lexeme);
-                         exit(1);
-                     }
-                     if (lookahead() == TOK_COMMA) {
-                         match(TOK_COMMA);
-                     } else {
-                         break;
-                     }
-                 } while (1);
-                 match(TOK_SEMI);
-             }
-             else if (lookahead() == TOK_PRINT) {
-                 // print_stmt → Imprimir ( expr ) ;
-                 match(TOK_PRINT);
-                 match(TOK_LPAREN);
-                 int nivel_p = 0;
-                 do {
-                     if (lookahead() == TOK_LPAREN) nivel_p++;
-                     else if (lookahead() == TOK_RPAREN) nivel_p--;
-                     cur_token++;
-                 } while (!(nivel_p == 0 && lookahead() == TOK_RPAREN));
-                 match(TOK_RPAREN);
-                 match(TOK_SEMI);
-             }
-             else if (lookahead() == TOK_READ) {
-                 // read_stmt → Leer ( IDENT ) ;
-                 match(TOK_READ);
-                 match(TOK_LPAREN);
-                 if (lookahead() == TOK_IDENT) cur_token++;
-                 match(TOK_RPAREN);
-                 match(TOK_SEMI);
-             }
-             else if (lookahead() == TOK_IDENT) {
-                 // assign_stmt → IDENT = expr ;
-                 cur_token++;
-                 match(TOK_ASSIGN);
-                 int nivel_p = 0;
-                 do {
-                     if (lookahead() == TOK_LPAREN) nivel_p++;
-                     else if (lookahead() == TOK_RPAREN) nivel_p--;
-                     cur_token++;
-                 } while (!(nivel_p == 0 && lookahead() == TOK_SEMI));
-                 match(TOK_SEMI);
-             }
-             else if (lookahead() == TOK_IF) {
-                 // if_stmt anidado
-                 cur_token++;
-                 match(TOK_LPAREN);
-                 int nivel_p = 0;
-                 do {
-                     if (lookahead() == TOK_LPAREN) nivel_p++;
-                     else if (lookahead() == TOK_RPAREN) nivel_p--;
-                     cur_token++;
-                 } while (!(nivel_p == 0 && lookahead() == TOK_RPAREN));
-                 match(TOK_RPAREN);
-                 parse_if_stmt(); // ignora recursivamente
-             }
-             else if (lookahead() == TOK_WHILE) {
-                 // while_stmt anidado
-                 cur_token++;
-                 match(TOK_LPAREN);
-                 int nivel_p = 0;
-                 do {
-                     if (lookahead() == TOK_LPAREN) nivel_p++;
-                     else if (lookahead() == TOK_RPAREN) nivel_p--;
-                     cur_token++;
-                 } while (!(nivel_p == 0 && lookahead() == TOK_RPAREN));
-                 match(TOK_RPAREN);
-                 // Ignorar cuerpo (puede ser bloque o sentencia única)
-                 if (lookahead() == TOK_LBRACE) {
-                     int brace_nivel = 0;
-                     do {
-                         if (lookahead() == TOK_LBRACE) brace_nivel++;
-                         else if (lookahead() == TOK_RBRACE) brace_nivel--;
-                         cur_token++;
-                     } while (brace_nivel > 0 && lookahead() != TOK_EOF);
-                 } else {
-                     parse_stmt(); // descarta la sentencia única
-                 }
-             }
-             else if (lookahead() == TOK_LBRACE) {
-                 // bloque_stmt → ignorar todo hasta cerrar '}'
-                 int brace_nivel = 0;
-                 do {
-                     if (lookahead() == TOK_LBRACE) brace_nivel++;
-                     else if (lookahead() == TOK_RBRACE) brace_nivel--;
-                     cur_token++;
-                 } while (brace_nivel > 0 && lookahead() != TOK_EOF);
-             }
-             else {
-                 fprintf(stderr,
-                         "Error de sintaxis al ignorar rama ‘Sino’: token '%s'.\n",
-                         tokens[cur_token].lexeme);
-                 exit(1);
-             }
+     const char *out;
+     obj[0] = '\0';
+     if (!no_cache && cache_dir(dir, sizeof(dir))) {
+         int len = snprintf(obj, sizeof(obj), "%s/runtime-%016llx.o", dir, h);
+         if (len <= 0 || (size_t)len >= sizeof(obj)) {
+             obj[0] = '\0';
+         } else if ((f = fopen(obj, "rb")) != NULL) {
+             fclose(f);
+             return obj;
          }
      }
-     else {
-         // cond == 0 → descartamos la rama THEN y, si hay "Sino", ejecutamos la rama ELSE
-         //int saved = cur_token;
-         // Ignorar sintácticamente la <sentencia> THEN
-         if (lookahead() == TOK_INT || lookahead() == TOK_CHAR || lookahead() == TOK_FLOAT) {
-             // decl_stmt
-             cur_token++;
-             do {
-                 if (lookahead() == TOK_IDENT) {
-                     cur_token++;
-                     if (lookahead() == TOK_ASSIGN) {
-                         cur_token++;
-                         int nivel_p = 0;
-                         do {
-                             if (lookahead() == TOK_LPAREN) nivel_p++;
-                             else if (lookahead() == TOK_RPAREN) nivel_p--;
-                             cur_token++;
-                         } while (!(nivel_p == 0 && (lookahead() == TOK_COMMA || lookahead() == TOK_SEMI)));
-                     }
-                 } else {
-                     fprintf(stderr,
-                             "Error de sintaxis al ignorar <decl_stmt>: '%s'.\n",
-                             tokens[cur_token].lexeme);
-                     exit(1);
-                 }
-                 if (lookahead() == TOK_COMMA) {
-                     match(TOK_COMMA);
-                 } else {
-                     break;
-                 }
-             } while (1);
-             match(TOK_SEMI);
-         }
-         else if (lookahead() == TOK_PRINT) {
-             // print_stmt
-             match(TOK_PRINT);
-             match(TOK_LPAREN);
-             int nivel_p = 0;
-             do {
-                 if (lookahead() == TOK_LPAREN) nivel_p++;
-                 else if (lookahead() == TOK_RPAREN) nivel_p--;
-                 cur_token++;
-             } while (!(nivel_p == 0 && lookahead() == TOK_RPAREN));
-             match(TOK_RPAREN);
-             match(TOK_SEMI);
-         }
-         else if (lookahead() == TOK_READ) {
-             // read_stmt
-             match(TOK_READ);
-             match(TOK_LPAREN);
-             if (lookahead() == TOK_IDENT) cur_token++;
-             match(TOK_RPAREN);
-             match(TOK_SEMI);
-         }
-         else if (lookahead() == TOK_IDENT) {
-             // assign_stmt
-             cur_token++;
-             match(TOK_ASSIGN);
-             int nivel_p = 0;
-             do {
-                 if (lookahead() == TOK_LPAREN) nivel_p++;
-                 else if (lookahead() == TOK_RPAREN) nivel_p--;
-                 cur_token++;
-             } while (!(nivel_p == 0 && lookahead() == TOK_SEMI));
-             match(TOK_SEMI);
-         }
-         else if (lookahead() == TOK_IF) {
-             // if_stmt anidado
-             cur_token++;
-             match(TOK_LPAREN);
-             int nivel_p = 0;
-             do {
-                 if (lookahead() == TOK_LPAREN) nivel_p++;
-                 else if (lookahead() == TOK_RPAREN) nivel_p--;
-                 cur_token++;
-             } while (!(nivel_p == 0 && lookahead() == TOK_RPAREN));
-             match(TOK_RPAREN);
-             parse_if_stmt();  // ignora recursivamente
-         }
-         else if (lookahead() == TOK_WHILE) {
-             // while_stmt anidado
-             cur_token++;
-             match(TOK_LPAREN);
-             int nivel_p = 0;
-             do {
-                 if (lookahead() == TOK_LPAREN) nivel_p++;
-                 else if (lookahead() == TOK_RPAREN) nivel_p--;
-                 cur_token++;
-             } while (!(nivel_p == 0 && lookahead() == TOK_RPAREN));
-             match(TOK_RPAREN);
-             // ignorar cuerpo
-             if (lookahead() == TOK_LBRACE) {
-                 int brace_nivel = 0;
-                 do {
-                     if (lookahead() == TOK_LBRACE) brace_nivel++;
-                     else if (lookahead() == TOK_RBRACE) brace_nivel--;
-                     cur_token++;
-                 } while (brace_nivel > 0 && lookahead() != TOK_EOF);
-             } else {
-                 parse_stmt();
-             }
-         }
-         else if (lookahead() == TOK_LBRACE) {
-             int brace_nivel = 0;
-             do {
-                 if (lookahead() == TOK_LBRACE) brace_nivel++;
-                 else if (lookahead() == TOK_RBRACE) brace_nivel--;
-                 cur_token++;
-             } while (brace_nivel > 0 && lookahead() != TOK_EOF);
-         }
-         else {
-             fprintf(stderr,
-                     "Error de sintaxis al ignorar <sentencia>: '%s'.\n",
-                     tokens[cur_token].lexeme);
+     // Al lado del definitivo, para cambiarle el nombre cuando esté
+     // entero: dos compilaciones a la vez no ven un objeto a medias
+     out = native_temp(2, (obj[0] != '\0') ? dir : NULL);
+ 
+     char *argv[16];
+     int   argc = 0;
+     argv[argc++] = "cc";
+     for (int k = 0; runtime_cflags[k] != NULL; k++) {
+         argv[argc++] = (char *)runtime_cflags[k];
+     }
+     argv[argc++] = "-c";
+     argv[argc++] = "-o";
+     argv[argc++] = (char *)out;
+     argv[argc++] = src_path;
+     argv[argc]   = NULL;
+     if (!run_tool(argv)) {
+         fprintf(stderr, "Error: fallo al compilar el runtime '%s'.\n", src_path);
+         exit(1);
+     }
+     if (obj[0] == '\0' || rename(out, obj) != 0) {
+         return out;                         // se borra al salir
+     }
+     native_tmp[2][0] = '\0';
+     return obj;
+ }
+ 
+ /**
+  * build_native(p, asm_path, exe_path):
+  *   Escribe el ensamblador de p en asm_path y, si exe_path no es NULL,
+  *   lo ensambla con "as" y lo enlaza estático con "ld" junto con el
+  *   objeto de runtime.c (runtime_object()). Sin asm_path (solo -o),
+  *   el ensamblador y el objeto van a temporales que no pisan nada y
+  *   se borran pase lo que pase.
+  */
+ static void build_native(const IRProgram *p, const char *asm_path, const char *exe_path) {
+     // El backend solo tiene registros enteros y el runtime no sabe
+     // escribir reales: los programas con Flotante se quedan en la VM
+     // (también las funciones de vectores de Flotante, que no siempre
+     // llevan una operación de tipo Flotante al lado).
+     for (int i = 0; i < p->num_code; i++) {
+         const Instr *in = &p->code[i];
+         int vec = (in->op >= OP_FILL && in->op <= OP_TRANSP) ? in->a
+                 : (in->op >= OP_ASUM && in->op <= OP_AMAX)   ? in->b : -1;
+         if ((in->op >= OP_FCONST && in->op <= OP_READF) ||
+             (vec >= 0 && arrays[vec].type == TYPE_FLOAT)) {
+             fprintf(stderr, "Error: el backend nativo no admite el tipo Flotante "
+                             "(ejecute el programa sin -o ni -S).\n");
              exit(1);
          }
+     }
+     atexit(native_cleanup);
+     if (asm_path == NULL) {
+         asm_path = native_temp(0, NULL);
+     }
+     FILE *out = fopen(asm_path, "w");
+     if (out == NULL) {
+         fprintf(stderr, "Error: no se pudo crear '%s'.\n", asm_path);
+         exit(1);
+     }
+     emit_native(p, out);
+     int failed = ferror(out);
+     if (fclose(out) != 0 || failed) {           // p. ej. disco lleno: no ensamblar
+         fprintf(stderr, "Error: no se pudo escribir '%s'.\n", asm_path);
+         exit(1);
+     }
+     if (exe_path == NULL) {
+         return;
+     }
  
-         // Una vez ignorada la rama THEN, comprobamos si hay 'Sino'
-         if (lookahead() == TOK_ELSE) {
-             match(TOK_ELSE);
-             // Ahora sí ejecutamos la rama ELSE:
-             parse_stmt();
-         }
-         // Si no hay 'Sino', continuamos adelante
+     const char *rt        = runtime_object();
+     const char *obj       = native_temp(1, NULL);
+     char *const as_argv[] = { "as", "-o", (char *)obj, (char *)asm_path, NULL };
+     char *const ld_argv[] = { "ld", "-static", "-o", (char *)exe_path, (char *)obj,
+                               (char *)rt, NULL };
+     if (!run_tool(as_argv) || !run_tool(ld_argv)) {
+         fprintf(stderr, "Error: fallo al ensamblar/enlazar '%s'.\n", exe_path);
+         exit(1);
      }
  }
  
  /*
-  * <while_stmt> ::= 'Mientras' '(' <expr> ')' <stmt>
-  * Semántica: evalúa <expr>; mientras ≠0, ejecuta <stmt> y repite.
+  * Uso:
+  *   analyzer [programa.txt]                 interpreta el programa
+  *   analyzer -S salida.s [programa.txt]     genera ensamblador x86-64
+  *   analyzer -o ejecutable [programa.txt]   genera un ELF estático
+  *                                           (-S y -o: sin Flotante)
+  *
+  * Sin archivo, el programa se lee de stdin.
   */
- static void parse_while_stmt(void) {
-     match(TOK_WHILE);
-     match(TOK_LPAREN);
- 
-     // Para “repetir” el bucle, guardamos la posición de cur_token justo después de '('
-     int cond_pos = cur_token;
-     int valor_cond = parse_expr();
-     match(TOK_RPAREN);
+ int main(int argc, char **argv) {
+     const char *src_path = NULL;
+     const char *asm_path = NULL;
+     const char *exe_path = NULL;
+     int         dump_ir  = 0;     // 1: --dump-ir, 2: --dump-ssa, 3: --ir-roundtrip
+     int         dead     = 0;     // --dead-code
+     int         level    = MAX_OPT_LEVEL;
+     const char *pass_list = NULL;   // --passes=
+     int         simd_max  = SIMD_AVX2;  // --simd=
  
-     if (valor_cond) {
-         // Ejecutamos cuerpo (stmt) mientras expr ≠ 0
-         int body_pos = cur_token;
-         parse_stmt();
-         while (1) {
-             cur_token = cond_pos;
-             int nuevo = parse_expr();
-             if (!nuevo) {
-                 break;
+     for (int i = 1; i < argc; i++) {
+         if ((strcmp(argv[i], "-S") == 0 || strcmp(argv[i], "-o") == 0) && i + 1 < argc) {
+             if (argv[i][1] == 'S') {
+                 asm_path = argv[++i];
+             } else {
+                 exe_path = argv[++i];
              }
-             match(TOK_RPAREN);
-             cur_token = body_pos;
-             parse_stmt();
+         } else if (strcmp(argv[i], "--no-jit") == 0) {
+             jit_enabled = 0;
+         } else if (strcmp(argv[i], "--stats") == 0) {
+             stats_enabled = 1;
+         } else if (strcmp(argv[i], "--dead-code") == 0) {
+             dead = 1;
+         } else if (strcmp(argv[i], "--dump-ir") == 0) {
+             dump_ir = 1;
+         } else if (strcmp(argv[i], "--dump-ssa") == 0) {
+             dump_ir = 2;
+         } else if (strcmp(argv[i], "--ir-roundtrip") == 0) {
+             dump_ir = 3;
+         } else if (argv[i][0] == '-' && argv[i][1] == 'O' && argv[i][2] >= '0' &&
+                    argv[i][2] <= '0' + MAX_OPT_LEVEL && argv[i][3] == '\0') {
+             level     = argv[i][2] - '0';
+             pass_list = NULL;
+         } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+             pass_list = argv[i] + 9;
+         } else if (strcmp(argv[i], "--time-passes") == 0) {
+             time_passes = 1;
+         } else if (strcmp(argv[i], "--no-cache") == 0) {
+             no_cache = 1;
+         } else if (strcmp(argv[i], "--wrap") == 0) {
+             int_wrap = 1;
+         } else if (strcmp(argv[i], "--bigint") == 0) {
+             int_big = 1;
+         } else if (strcmp(argv[i], "--simd=avx2") == 0) {
+             simd_max = SIMD_AVX2;
+         } else if (strcmp(argv[i], "--simd=sse4.2") == 0) {
+             simd_max = SIMD_SSE42;
+         } else if (strcmp(argv[i], "--simd=no") == 0) {
+             simd_max = SIMD_SCALAR;
+         } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+             fprintf(stderr, "Uso: %s [-O0 | -O1 | -O2 | -O3 | --passes=a,b,...]"
+                             " [--time-passes] [--wrap | --bigint] [--no-jit] [--no-cache] [--stats]"
+                             " [--dead-code] [--simd=avx2 | --simd=sse4.2 | --simd=no]"
+                             " [--dump-ir | --dump-ssa | --ir-roundtrip]"
+                             " [-S salida.s] [-o ejecutable] [programa]\n"
+                             "(-S y -o: solo Linux x86-64 y programas sin Flotante)\n", argv[0]);
+             return 1;
+         } else {
+             src_path = argv[i];
          }
-         // ——————————————————————
-         // IMPORTANTE: aquí falta consumir el último ')'
-         match(TOK_RPAREN);
-         // ——————————————————————
-     } else {
-         // cond == 0 → descartamos el <stmt> que sigue
-         int saved = cur_token;
-         parse_stmt();      // ignora sintácticamente
-         cur_token = saved; // regresamos a después de ')'
-         parse_stmt();      // consumimos esa <stmt> (pero no la ejecutamos)
      }
- }
  
- /*
-  * <block_stmt> ::= '{' <stmt_list> '}'
-  * Semántica: simplemente ejecuta cada stmt hasta cerrar llave
-  */
- static void parse_block_stmt(void) {
-     match(TOK_LBRACE);
-     while (lookahead() != TOK_RBRACE && lookahead() != TOK_EOF) {
-         parse_stmt();
+     src = stdin;
+     if (src_path != NULL) {
+         src = fopen(src_path, "r");
+         if (src == NULL) {
+             fprintf(stderr, "Error: no se pudo abrir '%s'.\n", src_path);
+             return 1;
+         }
      }
-     match(TOK_RBRACE);
- }
- 
  
- /*==============================================================
-  *               PARSER PRINCIPAL DE <program>
-  *=============================================================*/
- 
- /*
-  * <program> ::= <stmt_list> EOF
-  */
- static void parse_program(void) {
-     while (lookahead() != TOK_EOF) {
-         parse_stmt();
+     if (int_big && int_wrap) {
+         fprintf(stderr, "Error: --wrap y --bigint no se pueden usar juntos.\n");
+         return 1;
+     }
+     if (int_big && (asm_path != NULL || exe_path != NULL)) {
+         fprintf(stderr, "Error: el backend nativo no tiene --bigint.\n");
+         return 1;
      }
-     match(TOK_EOF);
- }
  
+     start_us = now_us();
+     select_passes(level, pass_list);
+     simd_init(simd_max);
+     if (int_big) {
+         atexit(out_commit);                     // lo retenido, si la VM da un error
+     }
+     if (dead) {
+         atexit(print_dead_code);
+     }
+     if (time_passes) {
+         atexit(print_pass_times);
+     }
  
- /*==============================================================
-  *                          MAIN
-  *=============================================================*/
+     // 0) Programa ya compilado en la caché (solo para ejecutarlo tal
+     //    cual: las opciones que miran la compilación no la usan, y
+     //    --bigint necesita el intérprete)
+     int  use_cache = (src_path != NULL && !no_cache && jit_enabled && !stats_enabled &&
+                       !dead && !time_passes && !dump_ir && asm_path == NULL &&
+                       exe_path == NULL && !int_big);
+     char cache_path[1024];
+     unsigned long long cache_key = 0;
+     if (use_cache) {
+         cache_key = gbc_key(src);
+         use_cache = gbc_path(cache_key, cache_path, sizeof(cache_path));
+     }
+     if (use_cache) {
+         IRProgram *p = gbc_load(cache_path, cache_key);
+         if (p != NULL) {
+             arrays_alloc();
+             gbc_run(p);
+             printf("OK\n");
+             return 0;
+         }
+     }
  
- int main(void) {
      // 1) Tokenizar toda la entrada (en CMD, pulsa Ctrl+Z ⏎ para EOF)
      tokenize_input();
  
-     // 2) Iniciar el parser
+     // 2a) Volcado del IR optimizado (y comprobación de ida y vuelta)
+     if (dump_ir) {
+         cur_token = 0;
+         IRProgram *p = compile_program();
+         optimize_ir(p);
+         int ok = 1;
+         if (dump_ir == 1) {
+             ir_dump(p, stdout);
+         } else if (dump_ir == 2) {
+             ssa_build(p);
+             ir_dump(p, stdout);
+         } else {
+             int n = p->num_code;
+             ok = ir_roundtrip(p, "optimizado");
+             ssa_build(p);
+             ok = ok && ir_roundtrip(p, "en SSA");
+             if (ok) {
+                 printf("IR: ida y vuelta correcta (%d instrucción(es); %d en SSA)\n",
+                        n, p->num_code);
+             }
+         }
+         ir_free(p);
+         return ok ? 0 : 1;
+     }
+ 
+     // 2b) Compilación a código nativo
+     if (asm_path != NULL || exe_path != NULL) {
+         cur_token = 0;
+         IRProgram *p = compile_program();
+         optimize_ir(p);
+         build_native(p, asm_path, exe_path);
+         ir_free(p);
+         return 0;
+     }
+ 
+     // 2c) Errores de compilación (sintaxis, división por cero constante…)
+     IRProgram *checked = check_program(stats_enabled || dead || time_passes);
+     if (use_cache) {
+         gbc_save_background(checked, cache_path, cache_key);
+     }
+     ir_free(checked);
+ 
+     // 2d) Iniciar el parser (nivel 0; los bucles calientes suben de nivel)
+     if (stats_enabled) {
+         atexit(print_stats);
+     }
+     arrays_alloc();
      cur_token = 0;
      parse_program();
  
@@ -1214,4 +14042,3 @@
      printf("OK\n");
      return 0;
  }
- 
\ No newline at end of file
@@ -0,0 +1,88 @@
+#!/bin/bash
+#
+# bench/run.sh [analyzer] [NOMBRE...]
+#
+# Mide los programas de bench/ (todos, o los NOMBRE que se den) con
+# cada configuración de su NOMBRE.cfg e imprime, por configuración,
+# el mínimo de $REPS ejecuciones (7 por defecto) en segundos. Sin
+# analyzer (o con "-") compila ../analyzer.c con gcc -O2.
+#
+# Cada línea de NOMBRE.cfg es "etiqueta entrada opciones...":
+#   entrada    números para stdin separados por comas, o "-"
+#   opciones   las de analyzer; si empiezan por "nativo", el resto se
+#              pasa a analyzer -o y se mide el ejecutable; si empiezan
+#              por "cache", se ejecuta una vez para llenar una caché
+#              vacía y se mide con ella
+# Las líneas que empiezan por '#' son comentarios.
+#
+# Qué mide cada uno:
+#   entero_1e8           Entero de 64 bits comprobado frente a --wrap
+#   vectores_N           Suma, Producto, Maximo y Llenar con cada nivel
+#                        de SIMD frente al Mientras equivalente
+#   vectorizar_b1..b3    bucles vectorizados frente a sin la pasada vec
+#   ordenar_N            relleno, Ordenar y n·Buscar; burbuja_1e4 es un
+#                        ordenamiento escrito en el lenguaje
+#   diccionario_*, si_*  Diccionario frente a una cadena de Si
+#
+# Los de 1e8 necesitan 1-2 GB de memoria y minutos; para una pasada
+# rápida: REPS=1 bench/run.sh - NOMBRE...
+
+dir=$(cd "$(dirname "$0")" && pwd)
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/gama-bench.XXXXXX") || exit 1
+trap 'rm -rf "$tmp"' EXIT
+reps=${REPS:-7}
+
+an=${1:--}
+[ $# -ge 1 ] && shift
+if [ "$an" = - ]; then
+    an=$tmp/analyzer
+    gcc -O2 -o "$an" "$dir/../analyzer.c" || exit 1
+fi
+
+names=("$@")
+if [ ${#names[@]} = 0 ]; then
+    for f in "$dir"/*.cfg; do
+        names+=("$(basename "$f" .cfg)")
+    done
+fi
+
+# best CMD...: mínimo de $reps ejecuciones de CMD con stdin de $tmp/in
+best() {
+    local b= s e t
+    for ((k = 0; k < reps; k++)); do
+        s=$(date +%s%N)
+        "$@" < "$tmp/in" > /dev/null 2>&1
+        e=$(date +%s%N)
+        t=$((e - s))
+        if [ -z "$b" ] || [ $t -lt $b ]; then
+            b=$t
+        fi
+    done
+    printf '%d.%03d' $((b / 1000000000)) $((b / 1000000 % 1000))
+}
+
+for name in "${names[@]}"; do
+    prog=$dir/$name.txt
+    while read -r label input mode rest; do
+        case $label in ''|'#'*) continue ;; esac
+        if [ "$input" = - ]; then
+            : > "$tmp/in"
+        else
+            echo "${input//,/ }" > "$tmp/in"
+        fi
+        case $mode in
+            nativo)
+                "$an" $rest -o "$tmp/prog" "$prog" || continue
+                t=$(best "$tmp/prog") ;;
+            cache)
+                rm -rf "$tmp/cache"
+                export GAMA_CACHE=$tmp/cache
+                "$an" $rest "$prog" < "$tmp/in" > /dev/null 2>&1
+                t=$(best "$an" $rest "$prog")
+                unset GAMA_CACHE ;;
+            *)
+                t=$(best "$an" $mode $rest "$prog") ;;
+        esac
+        printf '%-24s %-18s %8s\n' "$name" "$label" "$t"
+    done < "$dir/$name.cfg"
+done
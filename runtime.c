@@ -0,0 +1,775 @@
+/**************************************************************
+ * runtime.c
+ *
+ * Los núcleos de Ordenar y Buscar, de Multiplicar y Trasponer y de
+ * los diccionarios, una sola vez para todos los niveles:
+ *
+ *   - analyzer.c lo incluye ("#include "runtime.c"") y la VM, el JIT
+ *     y el intérprete llaman a estas funciones directamente;
+ *   - el backend nativo lo compila aparte con -DGAMA_NATIVE (ver
+ *     build_native()) y enlaza el objeto con el programa: entonces
+ *     se compilan también las entradas gama_*, que el runtime en
+ *     ensamblador llama desde __gama_vsort, __gama_dget...
+ *
+ * No usa libc ni sus cabeceras (el ejecutable nativo no la tiene).
+ * La memoria la piden rt_alloc() y rt_free(), y rt_simd() dice si
+ * se pueden usar instrucciones SSE2: las define analyzer.c (malloc,
+ * free y --simd) o, con GAMA_NATIVE, el final de este archivo (mmap,
+ * munmap y siempre que sí). rt_alloc() no vuelve si no hay memoria.
+ *
+ **************************************************************/
+ 
+ static void *rt_alloc(long long bytes);
+ static void  rt_free(void *p, long long bytes);
+ static int   rt_simd(void);
+ 
+ /*--------------------------------------------------------------
+  * Acumulador exacto de Suma, Producto y Multiplicar: 192 bits en
+  * complemento a dos.
+  *-------------------------------------------------------------*/
+ typedef struct {
+     unsigned long long w[3];    // w[0] es el de menor peso
+ } VecAcc;
+ 
+ /* s += (hi:lo), un entero de 128 bits con signo */
+ static void acc_add(VecAcc *s, unsigned long long lo, unsigned long long hi) {
+     unsigned long long ext = ((long long)hi < 0) ? ~0ULL : 0;
+     unsigned long long c0  = __builtin_add_overflow(s->w[0], lo, &s->w[0]);
+     unsigned long long c1  = __builtin_add_overflow(s->w[1], hi, &s->w[1]);
+     c1 += __builtin_add_overflow(s->w[1], c0, &s->w[1]);
+     s->w[2] += ext + c1;
+ }
+ 
+ static void acc_add_int(VecAcc *s, long long x) {
+     acc_add(s, (unsigned long long)x, (x < 0) ? ~0ULL : 0);
+ }
+ 
+ /* s += x * y; si no cabe en 64 bits, con los 128 del producto */
+ static void acc_add_mul(VecAcc *s, long long x, long long y) {
+     long long p;
+     if (!__builtin_mul_overflow(x, y, &p)) {
+         acc_add_int(s, p);
+         return;
+     }
+     unsigned long long a  = (x < 0) ? -(unsigned long long)x : (unsigned long long)x;
+     unsigned long long b  = (y < 0) ? -(unsigned long long)y : (unsigned long long)y;
+     unsigned long long a0 = a & 0xFFFFFFFFULL, a1 = a >> 32;
+     unsigned long long b0 = b & 0xFFFFFFFFULL, b1 = b >> 32;
+     unsigned long long p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+     unsigned long long mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) + (p10 & 0xFFFFFFFFULL);
+     unsigned long long lo  = (mid << 32) | (p00 & 0xFFFFFFFFULL);
+     unsigned long long hi  = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+     if ((x < 0) != (y < 0)) {
+         lo = ~lo + 1;
+         hi = ~hi + (lo == 0);
+     }
+     acc_add(s, lo, hi);
+ }
+ 
+ /* El valor módulo 2^64; *ovf = 1 si el exacto no cabe en 64 bits */
+ static long long acc_result(const VecAcc *s, int *ovf) {
+     unsigned long long ext = ((long long)s->w[0] < 0) ? ~0ULL : 0;
+     *ovf = (s->w[1] != ext || s->w[2] != ext);
+     return (long long)s->w[0];
+ }
+ 
+ /*--------------------------------------------------------------
+  * Multiplicar(c, a, b); deja en c (N×M) el producto de a (N×K) por
+  * b (K×M) y Trasponer(t, m); en t (M×N) la traspuesta de m (N×M).
+  *
+  * Una matriz grande recorrida por columnas toca una línea de caché
+  * por elemento, así que las dos van por bloques. Multiplicar hace
+  * c[i][j] += a[i][k] * b[k][j] con j en el bucle de dentro (las
+  * filas de b y de c se leen seguidas) y parte b en bloques de
+  * MAT_BLOCK_K filas por MAT_BLOCK_J columnas: cada bloque se usa
+  * con todas las filas de a sin salir de la caché. Aun así cada
+  * c[i][j] suma sus términos en el orden de k, como el bucle de
+  * siempre, y un Flotante redondea igual que él (tampoco hay FMA).
+  * Trasponer copia por baldosas de MAT_TILE × MAT_TILE.
+  *
+  * Entero: como en Producto, vale el resultado exacto; si alguno no
+  * cabe en 64 bits es el error de siempre (con --wrap, módulo 2^64).
+  * Se suma módulo 2^64 apuntando si algo se desborda por el camino y
+  * solo en ese caso se cuenta otra vez cada elemento con VecAcc.
+  *
+  * Lo que se hace con cada fila lo elige quien llama (MatRow): aquí
+  * están las de Entero; la de Flotante, con AVX2 o SSE4.2, es de
+  * analyzer.c (el nativo no tiene Flotante).
+  *-------------------------------------------------------------*/
+ 
+ #define MAT_BLOCK_K   64      // filas de b por bloque
+ #define MAT_BLOCK_J  256      // columnas de b por bloque (128 KiB de Entero)
+ #define MAT_TILE      32      // lado de las baldosas de Trasponer
+ 
+ /* c[j] += x * b[j] para j < n; 1 si algún Entero se desbordó */
+ typedef int (*MatRow)(long long *c, long long x, const long long *b, long long n);
+ 
+ static int mat_row_checked(long long *c, long long x, const long long *b, long long n) {
+     if (x == 0) {
+         return 0;
+     }
+     int ovf = 0;
+     for (long long j = 0; j < n; j++) {
+         long long p;
+         ovf |= __builtin_mul_overflow(x, b[j], &p);
+         ovf |= __builtin_add_overflow(c[j], p, &c[j]);
+     }
+     return ovf;
+ }
+ 
+ /* --wrap: módulo 2^64, sin mirar nada */
+ static int mat_row_wrap(long long *c, long long x, const long long *b, long long n) {
+     for (long long j = 0; j < n; j++) {
+         c[j] = (long long)((unsigned long long)c[j] +
+                            (unsigned long long)x * (unsigned long long)b[j]);
+     }
+     return 0;
+ }
+ 
+ /**
+  * mat_mul_rows(z, x, y, n, kn, m, row):
+  *   z (n×m) = x (n×kn) × y (kn×m), por bloques y fila a fila con row.
+  *   Devuelve 1 si algún elemento Entero no cabe en 64 bits (según
+  *   row; z se queda con el resultado módulo 2^64).
+  */
+ static int mat_mul_rows(long long *z, const long long *x, const long long *y,
+                         long long n, long long kn, long long m, MatRow row) {
+     int ovf = 0;
+     __builtin_memset(z, 0, (unsigned long)(n * m) * sizeof(long long));
+     for (long long j0 = 0; j0 < m; j0 += MAT_BLOCK_J) {
+         long long jn = (m - j0 < MAT_BLOCK_J) ? m - j0 : MAT_BLOCK_J;
+         for (long long k0 = 0; k0 < kn; k0 += MAT_BLOCK_K) {
+             long long k1 = (kn - k0 < MAT_BLOCK_K) ? kn : k0 + MAT_BLOCK_K;
+             for (long long i = 0; i < n; i++) {
+                 for (long long k = k0; k < k1; k++) {
+                     ovf |= row(z + i * m + j0, x[i * kn + k], y + k * m + j0, jn);
+                 }
+             }
+         }
+     }
+     if (!ovf) {
+         return 0;
+     }
+ 
+     // Algo se desbordó por el camino: el exacto de cada elemento
+     for (long long i = 0; i < n; i++) {
+         for (long long j = 0; j < m; j++) {
+             VecAcc s = { { 0, 0, 0 } };
+             for (long long k = 0; k < kn; k++) {
+                 acc_add_mul(&s, x[i * kn + k], y[k * m + j]);
+             }
+             acc_result(&s, &ovf);
+             if (ovf) {
+                 return 1;
+             }
+         }
+     }
+     return 0;
+ }
+ 
+ /**
+  * mat_transpose_cells(t, a, n, m, size):
+  *   t (m×n) = la traspuesta de a (n×m), con elementos de size bytes
+  *   (1, Caracter, u 8), por baldosas.
+  */
+ static void mat_transpose_cells(void *t, const void *a, long long n, long long m, int size) {
+     for (long long i0 = 0; i0 < n; i0 += MAT_TILE) {
+         long long i1 = (n - i0 < MAT_TILE) ? n : i0 + MAT_TILE;
+         for (long long j0 = 0; j0 < m; j0 += MAT_TILE) {
+             long long j1 = (m - j0 < MAT_TILE) ? m : j0 + MAT_TILE;
+             for (long long i = i0; i < i1; i++) {
+                 if (size == 1) {
+                     const signed char *x = (const signed char *)a + i * m;
+                     signed char       *y = (signed char *)t + i;
+                     for (long long j = j0; j < j1; j++) {
+                         y[j * n] = x[j];
+                     }
+                 } else {
+                     const long long *x = (const long long *)a + i * m;
+                     long long       *y = (long long *)t + i;
+                     for (long long j = j0; j < j1; j++) {
+                         y[j * n] = x[j];
+                     }
+                 }
+             }
+         }
+     }
+ }
+ 
+ /*--------------------------------------------------------------
+  * Ordenar(v); y Buscar(v, x), de vectores de Entero o Caracter (y
+  * de matrices, como el vector de todos sus elementos). Ninguno pide
+  * memoria: Ordenar trabaja sobre el propio vector y Buscar solo lo
+  * lee.
+  *
+  * Caracter tiene 256 valores: se cuentan y se vuelven a escribir en
+  * orden. Entero va por radix, byte a byte desde el más alto: cada
+  * pasada reparte los elementos en 256 cubos contándolos primero y
+  * cambiándolos de sitio después (sin vector auxiliar, que con cien
+  * millones de elementos serían 800 MB), y luego ordena cada cubo por
+  * el byte siguiente. Los bytes que son iguales en todos (la mitad
+  * alta de unos valores pequeños) no cuestan una pasada: se empieza
+  * por el primero en el que difieren el mínimo y el máximo. Por
+  * debajo de SORT_SMALL elementos 256 cubos son más trabajo que
+  * comparar, así que un vector o un cubo pequeño va por introsort
+  * (quicksort que, si se tuerce, termina con heapsort, y por
+  * inserción los trozos de menos de SORT_INSERTION).
+  *
+  * Buscar es una búsqueda binaria sin saltos: en cada paso la mitad
+  * que queda se elige con un cmov en vez de con un salto que la CPU
+  * fallaría una de cada dos veces. Si v no está ordenado el resultado
+  * no tiene sentido, pero no es un error.
+  *-------------------------------------------------------------*/
+ 
+ #define SORT_SMALL       32     // menos elementos: introsort
+ #define SORT_INSERTION   16     // menos elementos: inserción
+ 
+ /* Entero como sin signo, en el mismo orden: el bit de signo, al revés */
+ static unsigned long long sort_key(long long x) {
+     return (unsigned long long)x ^ (1ULL << 63);
+ }
+ 
+ static void sort_insertion(long long *x, long long n) {
+     for (long long i = 1; i < n; i++) {
+         long long v = x[i], j = i;
+         for (; j > 0 && x[j - 1] > v; j--) {
+             x[j] = x[j - 1];
+         }
+         x[j] = v;
+     }
+ }
+ 
+ /* Hunde x[root] en el montículo x[0, end) */
+ static void sort_sift(long long *x, long long root, long long end) {
+     long long v = x[root];
+     for (long long c = 2 * root + 1; c < end; c = 2 * root + 1) {
+         c += (c + 1 < end && x[c + 1] > x[c]);
+         if (x[c] <= v) {
+             break;
+         }
+         x[root] = x[c];
+         root = c;
+     }
+     x[root] = v;
+ }
+ 
+ static void sort_heap(long long *x, long long n) {
+     for (long long i = n / 2; i-- > 0; ) {
+         sort_sift(x, i, n);
+     }
+     for (long long end = n - 1; end > 0; end--) {
+         long long t = x[0];
+         x[0]   = x[end];
+         x[end] = t;
+         sort_sift(x, 0, end);
+     }
+ }
+ 
+ /**
+  * sort_intro(x, n, depth):
+  *   Introsort de x[0, n): quicksort con la mediana de tres; pasadas
+  *   depth particiones, heapsort (así nunca es cuadrático).
+  */
+ static void sort_intro(long long *x, long long n, int depth) {
+     while (n > SORT_INSERTION) {
+         if (depth-- == 0) {
+             sort_heap(x, n);
+             return;
+         }
+         long long a = x[0], b = x[n / 2], c = x[n - 1];
+         long long p = (a < b) ? ((b < c) ? b : (a < c) ? c : a)
+                               : ((a < c) ? a : (b < c) ? c : b);
+         long long i = 0, j = n - 1;
+         for (;;) {
+             while (x[i] < p) {
+                 i++;
+             }
+             while (x[j] > p) {
+                 j--;
+             }
+             if (i >= j) {
+                 break;
+             }
+             long long t = x[i];
+             x[i++] = x[j];
+             x[j--] = t;
+         }
+         // [0, j] <= p <= [j + 1, n): la parte pequeña por recursión
+         if (j + 1 < n - j - 1) {
+             sort_intro(x, j + 1, depth);
+             x += j + 1;
+             n -= j + 1;
+         } else {
+             sort_intro(x + j + 1, n - j - 1, depth);
+             n = j + 1;
+         }
+     }
+     sort_insertion(x, n);
+ }
+ 
+ /**
+  * sort_radix(x, n, shift):
+  *   Ordena x[0, n) por los bytes de sort_key() desde el que empieza
+  *   en el bit shift hacia abajo (ver arriba).
+  */
+ static void sort_radix(long long *x, long long n, int shift) {
+     long long count[256], next[256], end[256];
+     for (;;) {
+         __builtin_memset(count, 0, sizeof(count));
+         for (long long i = 0; i < n; i++) {
+             count[(sort_key(x[i]) >> shift) & 0xFF]++;
+         }
+         if (count[(sort_key(x[0]) >> shift) & 0xFF] < n) {
+             break;
+         }
+         if (shift == 0) {
+             return;                         // todos iguales
+         }
+         shift -= 8;                         // un solo cubo: el byte siguiente
+     }
+     long long s = 0;
+     for (int b = 0; b < 256; b++) {
+         next[b] = s;
+         s += count[b];
+         end[b] = s;
+     }
+ 
+     // Cada elemento que no está en su cubo va al siguiente hueco libre
+     // del suyo, y el que estaba allí pasa a ser el que hay que colocar
+     for (int b = 0; b < 256; b++) {
+         while (next[b] < end[b]) {
+             long long v = x[next[b]];
+             int d = (int)((sort_key(v) >> shift) & 0xFF);
+             while (d != b) {
+                 long long t = x[next[d]];
+                 x[next[d]++] = v;
+                 v = t;
+                 d = (int)((sort_key(v) >> shift) & 0xFF);
+             }
+             x[next[b]++] = v;
+         }
+     }
+     if (shift == 0) {
+         return;
+     }
+     for (int b = 0; b < 256; b++) {
+         long long *y = x + end[b] - count[b];
+         if (count[b] < SORT_SMALL) {
+             sort_intro(y, count[b], 2 * 64);
+         } else {
+             sort_radix(y, count[b], shift - 8);
+         }
+     }
+ }
+ 
+ /* Ordenar de los n Entero de x */
+ static void sort_ints(long long *x, long long n) {
+     if (n < SORT_SMALL) {
+         sort_intro(x, n, 2 * 64);
+         return;
+     }
+     unsigned long long lo = sort_key(x[0]), hi = lo;
+     for (long long i = 1; i < n; i++) {
+         unsigned long long k = sort_key(x[i]);
+         lo = (k < lo) ? k : lo;
+         hi = (k > hi) ? k : hi;
+     }
+     if (lo != hi) {
+         sort_radix(x, n, (63 - __builtin_clzll(lo ^ hi)) / 8 * 8);
+     }
+ }
+ 
+ /* Ordenar de los n Caracter de x: se cuentan y se reescriben */
+ static void sort_chars(signed char *x, long long n) {
+     long long count[256] = { 0 };
+     for (long long i = 0; i < n; i++) {
+         count[x[i] & 0xFF]++;
+     }
+     for (int v = -128; v <= 127; v++) {
+         __builtin_memset(x, v, (unsigned long)count[v & 0xFF]);
+         x += count[v & 0xFF];
+     }
+ }
+ 
+ /**
+  * find_int(v, n, x):
+  *   Buscar: la posición del primer elemento igual a x de los n Entero
+  *   ordenados de v, o -1 si no hay ninguno.
+  */
+ static long long find_int(const long long *v, long long n, long long x) {
+     const long long *b = v;
+     long long        len = n, i;
+     while (len > 1) {
+         long long h = len / 2;
+         b = (b[h - 1] < x) ? b + h : b;
+         len -= h;
+     }
+     i = (b - v) + (*b < x);
+     return (i < n && v[i] == x) ? i : -1;
+ }
+ 
+ /* Lo mismo de n Caracter */
+ static long long find_char(const signed char *v, long long n, long long x) {
+     const signed char *b = v;
+     long long          len = n, i;
+     while (len > 1) {
+         long long h = len / 2;
+         b = (b[h - 1] < x) ? b + h : b;
+         len -= h;
+     }
+     i = (b - v) + (*b < x);
+     return (i < n && v[i] == x) ? i : -1;
+ }
+ 
+ /*--------------------------------------------------------------
+  * Diccionarios: tablas hash de direccionamiento abierto al estilo
+  * de SwissTable. Cada casilla (clave y valor, 16 bytes) tiene un
+  * byte de control: DICT_EMPTY, DICT_DELETED o, si está ocupada, los
+  * 7 bits bajos de su hash (h2). Los bits altos (h1) eligen el grupo
+  * de DICT_GROUP casillas por el que empieza la búsqueda de una
+  * clave. Con SSE2 los 16 bytes de control del grupo se comparan con
+  * h2 de una vez (pcmpeqb y pmovmskb) y solo se mira la clave de las
+  * casillas que coinciden, que con 7 bits es una de cada 128 que no
+  * son la buena. Si el grupo tiene alguna casilla vacía, la clave no
+  * está; si no, se sigue por el grupo 1, 3, 6... más allá (sondeo
+  * triangular, que con un número de grupos potencia de 2 pasa por
+  * todos).
+  *
+  * La tabla se llena hasta 7/8 y entonces crece al doble: una clave
+  * ocupa entre 20 y 39 bytes, sin punteros ni nodos sueltos (cien
+  * millones caben en 2,3 GB). Los controles y, detrás, las casillas
+  * van en un solo bloque de rt_alloc(). Borrar deja una lápida
+  * (DICT_DELETED, que la búsqueda se salta) salvo que el grupo tenga
+  * aún una casilla vacía: entonces ninguna búsqueda ha pasado nunca
+  * de él y la casilla puede volver a estar vacía. Las lápidas cuentan
+  * para llenar la tabla y desaparecen al rehacerla, del mismo tamaño
+  * si eran casi todo lápidas.
+  *
+  * Las casillas quedan en un orden (el de Claves) que solo depende
+  * de qué claves se metieron y borraron y en qué orden, así que es
+  * el mismo en todos los niveles de ejecución, con SSE2 o sin él.
+  *-------------------------------------------------------------*/
+ 
+ #define DICT_GROUP     16
+ #define DICT_EMPTY     (-128)      // control de una casilla vacía
+ #define DICT_DELETED   (-2)        // y de una borrada (lápida)
+ 
+ typedef struct {
+     long long    key, val;
+ } DictSlot;
+ 
+ /* Todo a cero es un diccionario vacío y sin casillas (así lo deja
+    .comm en el nativo, que lee len en offsetof(Dict, len)) */
+ typedef struct {
+     signed char *ctrl;              // un byte de control por casilla
+     DictSlot    *slots;             // cap casillas, detrás de ctrl
+     long long    cap;               // 0 (sin reservar) o potencia de 2
+     long long    len;               // claves
+     long long    left;              // casillas vacías que aún se pueden ocupar
+ } Dict;
+ 
+ /* Mezcla los bits de la clave (el final de MurmurHash3): las claves
+    seguidas (0, 1, 2...) caen repartidas por los grupos */
+ static unsigned long long dict_hash(long long k) {
+     unsigned long long h = (unsigned long long)k;
+     h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDULL;
+     h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+     return h ^ (h >> 33);
+ }
+ 
+ #if defined(__SSE2__)
+ /* Los 16 controles de un grupo, sin exigir alineación */
+ typedef char DictGroup __attribute__((vector_size(DICT_GROUP), aligned(1), may_alias));
+ #endif
+ 
+ /* Bit j a 1 si el control j del grupo g es b */
+ static inline unsigned dict_match(const signed char *g, int b) {
+ #if defined(__SSE2__)
+     if (rt_simd()) {
+         DictGroup x = *(const DictGroup *)g;
+         DictGroup y = { 0 };
+         y += (char)b;
+         return (unsigned)__builtin_ia32_pmovmskb128((DictGroup)(x == y));
+     }
+ #endif
+     unsigned m = 0;
+     for (int j = 0; j < DICT_GROUP; j++) {
+         m |= (unsigned)(g[j] == b) << j;
+     }
+     return m;
+ }
+ 
+ /* Bit j a 1 si la casilla j del grupo g está libre (vacía o borrada:
+    los dos controles con el bit alto) */
+ static inline unsigned dict_match_free(const signed char *g) {
+ #if defined(__SSE2__)
+     if (rt_simd()) {
+         return (unsigned)__builtin_ia32_pmovmskb128(*(const DictGroup *)g);
+     }
+ #endif
+     unsigned m = 0;
+     for (int j = 0; j < DICT_GROUP; j++) {
+         m |= (unsigned)(g[j] < 0) << j;
+     }
+     return m;
+ }
+ 
+ /* Casilla de la clave k, de hash h, en d (que tiene casillas), o
+    NULL si no está */
+ static DictSlot *dict_find(const Dict *d, long long k, unsigned long long h) {
+     unsigned long long mask = (unsigned long long)d->cap / DICT_GROUP - 1;
+     unsigned long long g    = (h >> 7) & mask;
+     for (unsigned long long step = 1; ; step++) {
+         const signed char *c = d->ctrl + g * DICT_GROUP;
+         for (unsigned m = dict_match(c, (int)(h & 0x7F)); m != 0; m &= m - 1) {
+             DictSlot *s = &d->slots[g * DICT_GROUP + __builtin_ctz(m)];
+             if (s->key == k) {
+                 return s;
+             }
+         }
+         if (dict_match(c, DICT_EMPTY) != 0) {
+             return 0;
+         }
+         g = (g + step) & mask;
+     }
+ }
+ 
+ /**
+  * dict_slot(d, k):
+  *   Casilla de la clave k en d, o NULL si no está.
+  */
+ static DictSlot *dict_slot(const Dict *d, long long k) {
+     return (d->cap > 0) ? dict_find(d, k, dict_hash(k)) : 0;
+ }
+ 
+ /* Primera casilla libre del recorrido de h (siempre hay alguna: la
+    tabla nunca se llena del todo) */
+ static long long dict_free_slot(const Dict *d, unsigned long long h) {
+     unsigned long long mask = (unsigned long long)d->cap / DICT_GROUP - 1;
+     unsigned long long g    = (h >> 7) & mask;
+     for (unsigned long long step = 1; ; step++) {
+         unsigned m = dict_match_free(d->ctrl + g * DICT_GROUP);
+         if (m != 0) {
+             return (long long)(g * DICT_GROUP) + __builtin_ctz(m);
+         }
+         g = (g + step) & mask;
+     }
+ }
+ 
+ /* Lo que ocupan los controles y las casillas de una tabla de cap */
+ static long long dict_bytes(long long cap) {
+     return cap * (long long)(1 + sizeof(DictSlot));
+ }
+ 
+ /**
+  * dict_rehash(d, cap):
+  *   Pasa las claves de d a una tabla de cap casillas, sin lápidas.
+  */
+ static void dict_rehash(Dict *d, long long cap) {
+     Dict old = *d;
+     d->ctrl  = rt_alloc(dict_bytes(cap));
+     d->slots = (DictSlot *)(d->ctrl + cap);
+     __builtin_memset(d->ctrl, DICT_EMPTY, (unsigned long)cap);
+     d->cap  = cap;
+     d->left = cap - cap / 8 - d->len;
+     for (long long i = 0; i < old.cap; i++) {
+         if (old.ctrl[i] >= 0) {
+             long long j = dict_free_slot(d, dict_hash(old.slots[i].key));
+             d->ctrl[j]  = old.ctrl[i];
+             d->slots[j] = old.slots[i];
+         }
+     }
+     if (old.cap > 0) {
+         rt_free(old.ctrl, dict_bytes(old.cap));
+     }
+ }
+ 
+ /**
+  * dict_set(d, k, x):
+  *   d[k] = x, con la clave nueva si no estaba. Si para meterla hay
+  *   que gastar una casilla vacía y ya no quedan, la tabla crece al
+  *   doble (o, si las claves no llegan a la mitad de lo que cabe y
+  *   lo demás son lápidas, se rehace del mismo tamaño).
+  */
+ static void dict_set(Dict *d, long long k, long long x) {
+     unsigned long long h = dict_hash(k);
+     DictSlot          *s = (d->cap > 0) ? dict_find(d, k, h) : 0;
+     if (s != 0) {
+         s->val = x;
+         return;
+     }
+     long long i = (d->cap > 0) ? dict_free_slot(d, h) : -1;
+     if (i < 0 || (d->ctrl[i] == DICT_EMPTY && d->left == 0)) {
+         long long cap = (d->cap == 0) ? DICT_GROUP
+                       : (d->len >= (d->cap - d->cap / 8) / 2) ? 2 * d->cap : d->cap;
+         dict_rehash(d, cap);
+         i = dict_free_slot(d, h);
+     }
+     d->left -= (d->ctrl[i] == DICT_EMPTY);
+     d->ctrl[i]      = (signed char)(h & 0x7F);
+     d->slots[i].key = k;
+     d->slots[i].val = x;
+     d->len++;
+ }
+ 
+ /* d[k]: su valor, o 0 si no está */
+ static long long dict_get(const Dict *d, long long k) {
+     const DictSlot *s = dict_slot(d, k);
+     return (s != 0) ? s->val : 0;
+ }
+ 
+ /**
+  * dict_delete(d, k):
+  *   Borrar(d, k); (si k no está, no hace nada).
+  */
+ static void dict_delete(Dict *d, long long k) {
+     DictSlot *s = dict_slot(d, k);
+     if (s == 0) {
+         return;
+     }
+     long long i = s - d->slots;
+     if (dict_match(d->ctrl + (i & -DICT_GROUP), DICT_EMPTY) != 0) {
+         d->ctrl[i] = DICT_EMPTY;
+         d->left++;
+     } else {
+         d->ctrl[i] = DICT_DELETED;
+     }
+     d->len--;
+ }
+ 
+ /* Declaración: d queda vacío y sin casillas */
+ static void dict_clear(Dict *d) {
+     if (d->cap > 0) {
+         rt_free(d->ctrl, dict_bytes(d->cap));
+     }
+     d->ctrl  = 0;
+     d->slots = 0;
+     d->cap   = d->len = d->left = 0;
+ }
+ 
+ /**
+  * dict_copy_keys(v, d):
+  *   Claves(v, d);: las claves de d en v[0], v[1]..., en el orden de
+  *   sus casillas, de grupo en grupo (las libres se saltan con un
+  *   solo pmovmskb). Quien llama ya ha visto que caben.
+  */
+ static void dict_copy_keys(long long *v, const Dict *d) {
+     for (long long g = 0; g < d->cap; g += DICT_GROUP) {
+         for (unsigned m = ~dict_match_free(d->ctrl + g) & 0xFFFF; m != 0; m &= m - 1) {
+             *v++ = d->slots[g + __builtin_ctz(m)].key;
+         }
+     }
+ }
+ 
+ #ifdef GAMA_NATIVE
+ 
+ /*--------------------------------------------------------------
+  * Backend nativo: sin libc, la memoria va con mmap y munmap, y el
+  * runtime en ensamblador (que guarda los registros del programa y
+  * alinea la pila) llama a las entradas gama_* con la convención de
+  * System V. Sin memoria salta a __gama_err_mem, que no vuelve.
+  *-------------------------------------------------------------*/
+ 
+ extern void __gama_err_mem(void) __attribute__((noreturn));
+ 
+ static void *rt_alloc(long long bytes) {
+     register long r10 __asm__("r10") = 0x22;        // MAP_PRIVATE | MAP_ANONYMOUS
+     register long r8  __asm__("r8")  = -1;
+     register long r9  __asm__("r9")  = 0;
+     long p;
+     __asm__ volatile ("syscall"
+                       : "=a"(p)
+                       : "0"(9L), "D"(0L), "S"(bytes), "d"(3L), "r"(r10), "r"(r8), "r"(r9)
+                       : "rcx", "r11", "memory");
+     if ((unsigned long)p > -4096UL) {
+         __gama_err_mem();
+     }
+     return (void *)p;
+ }
+ 
+ static void rt_free(void *p, long long bytes) {
+     long r;
+     __asm__ volatile ("syscall"
+                       : "=a"(r)
+                       : "0"(11L), "D"(p), "S"(bytes)
+                       : "rcx", "r11", "memory");
+     (void)r;
+ }
+ 
+ static int rt_simd(void) {
+     return 1;
+ }
+ 
+ /* Las que gcc puede llamar por su cuenta aun con -ffreestanding; con
+    rep stosb/movsb, que en las CPU de ahora van de línea en línea */
+ void *memset(void *p, int c, unsigned long n) {
+     void *d = p;
+     __asm__ volatile ("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+     return p;
+ }
+ 
+ void *memcpy(void *p, const void *q, unsigned long n) {
+     void *d = p;
+     __asm__ volatile ("rep movsb" : "+D"(d), "+S"(q), "+c"(n) : : "memory");
+     return p;
+ }
+ 
+ void gama_vsort(long long *v, long long n) {
+     sort_ints(v, n);
+ }
+ 
+ void gama_vsortc(signed char *v, long long n) {
+     sort_chars(v, n);
+ }
+ 
+ long long gama_vfind(const long long *v, long long n, long long x) {
+     return find_int(v, n, x);
+ }
+ 
+ long long gama_vfindc(const signed char *v, long long n, long long x) {
+     return find_char(v, n, x);
+ }
+ 
+ long long gama_mmul(long long *c, const long long *a, const long long *b,
+                     long long n, long long k, long long m) {
+     return mat_mul_rows(c, a, b, n, k, m, mat_row_checked);
+ }
+ 
+ long long gama_mmulw(long long *c, const long long *a, const long long *b,
+                      long long n, long long k, long long m) {
+     return mat_mul_rows(c, a, b, n, k, m, mat_row_wrap);
+ }
+ 
+ void gama_mtr(long long *t, const long long *a, long long n, long long m) {
+     mat_transpose_cells(t, a, n, m, 8);
+ }
+ 
+ void gama_mtrc(signed char *t, const signed char *a, long long n, long long m) {
+     mat_transpose_cells(t, a, n, m, 1);
+ }
+ 
+ long long gama_dget(const Dict *d, long long k) {
+     return dict_get(d, k);
+ }
+ 
+ long long gama_dhas(const Dict *d, long long k) {
+     return dict_slot(d, k) != 0;
+ }
+ 
+ void gama_dset(Dict *d, long long k, long long x) {
+     dict_set(d, k, x);
+ }
+ 
+ void gama_ddel(Dict *d, long long k) {
+     dict_delete(d, k);
+ }
+ 
+ void gama_dnew(Dict *d) {
+     dict_clear(d);
+ }
+ 
+ void gama_dkeys(const Dict *d, long long *v) {
+     dict_copy_keys(v, d);
+ }
+ 
+ #endif
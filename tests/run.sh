@@ -0,0 +1,148 @@
+#!/bin/bash
+#
+# tests/run.sh [analyzer]
+#
+# Ejecuta cada programa tests/NOMBRE.txt en todos los modos y compara
+# su salida con la esperada. Sin argumento compila ../analyzer.c con
+# gcc en un directorio temporal.
+#
+# Por cada programa:
+#   NOMBRE.in          entrada (stdin); si no está, la entrada es vacía
+#   NOMBRE.out         salida esperada (stdout)
+#   NOMBRE.err         errores y avisos esperados (stderr)
+#   NOMBRE.rc          código de salida esperado
+#   NOMBRE.MODO.out    (y .err, .rc) lo esperado en MODO, si cambia
+#                      (p. ej. desbordamiento.wrap.out)
+#   NOMBRE.skip        modos que no se prueban, separados por blancos
+#                      (p. ej. "native" para un programa con Flotante)
+#   NOMBRE.stats       expresiones regulares (grep -E), una por línea,
+#                      que tienen que salir en lo que escribe --stats:
+#                      que la pasada que prueba el programa se aplicó;
+#                      con '!' delante, una que no puede salir
+#   NOMBRE.ir          lo mismo, en lo que escribe --dump-ir
+#
+# Modos:
+#   O0, O3, nojit, wrap, bigint   analyzer --no-cache con -O0, -O3,
+#                                 --no-jit, --wrap o --bigint
+#   cache      dos veces con una caché vacía: la primera la llena y la
+#              segunda ejecuta el .gbc (que no repite los avisos)
+#   native     analyzer -o y el ejecutable; los errores de compilar
+#              van delante, y el "OK" final lo pone aquí el script
+#              (runtime.c se compila una vez, en una caché propia)
+#   roundtrip  analyzer --ir-roundtrip: tiene que acabar con código 0
+#   stats      analyzer --no-cache -O3 --stats, solo si hay NOMBRE.stats
+#              o NOMBRE.ir: la salida y el código como en O3, NOMBRE.stats
+#              en los errores y NOMBRE.ir en el IR de -O3 --dump-ir
+#
+# Para regenerar lo esperado de un programa nuevo:
+#   analyzer --no-cache -O3 p.txt < p.in > p.out 2> p.err; echo $? > p.rc
+#
+# Devuelve 0 si todo coincide.
+
+dir=$(cd "$(dirname "$0")" && pwd)
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/gama-tests.XXXXXX") || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+if [ $# -ge 1 ]; then
+    an=$1
+else
+    an=$tmp/analyzer
+    gcc -O2 -Wall -Wextra -o "$an" "$dir/../analyzer.c" || exit 1
+fi
+
+modes="O0 O3 nojit wrap bigint cache native roundtrip stats"
+passed=0
+failed=0
+skipped=0
+
+# expected NOMBRE MODO EXT: archivo con lo esperado
+expected() {
+    if [ -f "$dir/$1.$2.$3" ]; then
+        echo "$dir/$1.$2.$3"
+    else
+        echo "$dir/$1.$3"
+    fi
+}
+
+# run_mode PROGRAMA ENTRADA MODO: deja stdout, stderr y el código en $tmp
+run_mode() {
+    local prog=$1 in=$2 mode=$3
+    case $mode in
+        O0)     "$an" --no-cache -O0 "$prog" ;;
+        O3)     "$an" --no-cache -O3 "$prog" ;;
+        nojit)  "$an" --no-cache --no-jit "$prog" ;;
+        wrap)   "$an" --no-cache --wrap "$prog" ;;
+        bigint) "$an" --no-cache --bigint "$prog" ;;
+        cache)
+            rm -rf "$tmp/cache"
+            GAMA_CACHE=$tmp/cache "$an" "$prog" < "$in" > /dev/null 2>&1
+            GAMA_CACHE=$tmp/cache "$an" "$prog" ;;
+        native)
+            GAMA_CACHE=$tmp/native "$an" -o "$tmp/prog" "$prog" 2> "$tmp/cc.err" < /dev/null || {
+                local rc=$?
+                cat "$tmp/cc.err" >&2
+                return $rc
+            }
+            cat "$tmp/cc.err" >&2
+            "$tmp/prog" && echo OK ;;
+        roundtrip) "$an" --no-cache --ir-roundtrip "$prog" ;;
+        stats)  "$an" --no-cache -O3 --stats "$prog" ;;
+    esac < "$in" > "$tmp/got.out" 2> "$tmp/got.err"
+}
+
+# patterns_match PATRONES SALIDA: cada línea de PATRONES sale en SALIDA
+# (o, si empieza por '!', no sale); sin PATRONES, bien
+patterns_match() {
+    local re
+    [ -f "$1" ] || return 0
+    while IFS= read -r re; do
+        case $re in
+            !*) ! grep -Eq -- "${re#!}" "$2" || { echo "  sale: ${re#!}" >&2; return 1; } ;;
+            *)  grep -Eq -- "$re" "$2" || { echo "  no sale: $re" >&2; return 1; } ;;
+        esac
+    done < "$1"
+}
+
+for prog in "$dir"/*.txt; do
+    name=$(basename "$prog" .txt)
+    in=$dir/$name.in
+    [ -f "$in" ] || in=/dev/null
+    skip=$(cat "$dir/$name.skip" 2>/dev/null)
+    for mode in $modes; do
+        case " $skip " in
+            *" $mode "*) skipped=$((skipped + 1)); continue ;;
+        esac
+        [ "$mode" = stats ] && [ ! -f "$dir/$name.stats" ] && [ ! -f "$dir/$name.ir" ] && continue
+        run_mode "$prog" "$in" "$mode"
+        rc=$?
+        if [ "$mode" = roundtrip ]; then
+            ok=$([ $rc = 0 ] && echo 1)
+        elif [ "$mode" = stats ]; then
+            ok=$(cmp -s "$(expected "$name" O3 out)" "$tmp/got.out" &&
+                 [ "$rc" = "$(cat "$(expected "$name" O3 rc)")" ] &&
+                 patterns_match "$dir/$name.stats" "$tmp/got.err" &&
+                 "$an" --no-cache -O3 --dump-ir "$prog" > "$tmp/ir.txt" &&
+                 patterns_match "$dir/$name.ir" "$tmp/ir.txt" && echo 1)
+        else
+            if [ "$mode" = cache ]; then
+                grep -v '^Aviso' "$(expected "$name" "$mode" err)" > "$tmp/exp.err"
+            else
+                cp "$(expected "$name" "$mode" err)" "$tmp/exp.err"
+            fi
+            ok=$(cmp -s "$(expected "$name" "$mode" out)" "$tmp/got.out" &&
+                 cmp -s "$tmp/exp.err" "$tmp/got.err" &&
+                 [ "$rc" = "$(cat "$(expected "$name" "$mode" rc)")" ] && echo 1)
+        fi
+        if [ -n "$ok" ]; then
+            passed=$((passed + 1))
+        else
+            failed=$((failed + 1))
+            echo "FALLA: $name ($mode), código $rc"
+            diff "$(expected "$name" "$mode" out)" "$tmp/got.out" | head -5
+            head -3 "$tmp/got.err"
+        fi
+    done
+done
+
+echo "$passed bien, $failed mal, $skipped sin probar"
+[ $failed = 0 ]